@@ -116,5 +116,7 @@ if pbaseenv['PLATFORM'] == 'darwin':
 
 analyzer = pbaseenv.Program(target = 'hcana', source = 'src/main.o')
 pbaseenv.Install('./bin',analyzer)
+replay = pbaseenv.Program(target = 'hcana-replay', source = 'src/replay_main.o')
+pbaseenv.Install('./bin',replay)
 pbaseenv.Alias('install',['./bin'])
 #pbaseenv.Clean(analyzer,)
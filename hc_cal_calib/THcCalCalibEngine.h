@@ -0,0 +1,559 @@
+#ifndef ROOT_THcCalCalibEngine
+#define ROOT_THcCalCalibEngine
+
+#include "TH1F.h"
+#include "TVectorD.h"
+#include "TMatrixD.h"
+#include "TMatrixDSym.h"
+#include "TDecompChol.h"
+#include "TDecompLU.h"
+#include "TMath.h"
+#include "RVersion.h"
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <iostream>
+
+#include "TROOT.h"
+#include "TFile.h"
+#include "TTree.h"
+
+using namespace std;
+
+//
+// Calorimeter calibration engine, common to the HMS and SHMS calibrations.
+//
+// The calibration tree is read once, by a pool of threads, into a compact
+// in-memory store of the unit gain PMT signals of every track. The store is
+// split into a fixed number of slices of consecutive entries; the vectors
+// and the correlation matrix are accumulated per slice, keeping only the
+// upper triangle of Q and only the pairs of PMTs fired in an event, then
+// summed in slice order. The result therefore does not depend on the
+// number of threads. The constrained minimization is solved by Cholesky
+// decomposition of Q.
+//
+
+//------------------------------------------------------------------------------
+
+// Events of one slice of the input tree, and the partial sums over them.
+
+class THcCalCalibSlice {
+
+ public:
+
+  THcCalCalibSlice() : fFirst(0), fLast(0), fNev(0), fe0(0.) {};
+
+  void AddEvent(Double_t p, Double_t delta, Double_t x, Double_t y) {
+    fP.push_back(p);
+    fDelta.push_back(delta);
+    fX.push_back(x);
+    fY.push_back(y);
+    fHit0.push_back(fChan.size());
+  }
+
+  void AddSignal(UInt_t channel, Double_t signal) {
+    fChan.push_back(channel);
+    fSig.push_back(signal);
+  }
+
+  UInt_t GetNevents() const {return fP.size();}
+
+  // Normalized to the track momentum energy deposition of event iev for
+  // gains alpha. Summed in hit order, as THcShTrack/THcPShTrack::Enorm do.
+
+  Double_t Enorm(UInt_t iev, const Double_t* alpha) const {
+    UInt_t end = (iev+1 < fP.size()) ? fHit0[iev+1] : fChan.size();
+    Double_t sum = 0;
+    for (UInt_t k=fHit0[iev]; k<end; k++)
+      sum += fSig[k]*alpha[fChan[k]];
+    return sum/fP[iev]/1000.;
+  }
+
+  Long64_t fFirst;          // Entry range of the slice
+  Long64_t fLast;
+
+  vector<Double_t> fP;      // Track momentum (GeV)
+  vector<Double_t> fDelta;  // Track delta
+  vector<Double_t> fX;      // Track coordinates at the calorimeter face
+  vector<Double_t> fY;
+  vector<UInt_t> fHit0;     // First signal of each event
+  vector<UShort_t> fChan;   // PMT channel, 0 based
+  vector<Double_t> fSig;    // Unit gain signal of the PMT
+
+  // Partial sums of the selected events.
+
+  UInt_t fNev;
+  Double_t fe0;
+  vector<Double_t> fqe;
+  vector<Double_t> fq0;
+  vector<Double_t> fQ;      // Packed upper triangle
+  vector<UInt_t> fHitCount;
+
+};
+
+//------------------------------------------------------------------------------
+
+// Geometry specific part of a calibration: connects the tree branches and
+// decodes the current entry into a slice. One copy is used per thread.
+
+class THcCalCalibReader {
+
+ public:
+
+  virtual ~THcCalCalibReader() {};
+
+  virtual THcCalCalibReader* Clone() const = 0;
+  virtual void SetBranches(TTree* tree) = 0;
+  virtual void Decode(THcCalCalibSlice& slice) = 0;
+
+ protected:
+
+  // Enable and connect a single branch; all others are disabled by
+  // THcCalCalibEngine::ReadTree before SetBranches is called.
+
+  void Connect(TTree* tree, const char* name, void* addr) {
+    tree->SetBranchStatus(name, 1);
+    tree->SetBranchAddress(name, addr);
+  }
+
+};
+
+//------------------------------------------------------------------------------
+
+class THcCalCalibEngine {
+
+ public:
+
+  THcCalCalibEngine(UInt_t npmts);
+  ~THcCalCalibEngine();
+
+  void SetNThreads(UInt_t n) {fNThreads = n;}   // 0: one per core
+
+  UInt_t ReadTree(const char* fname, const char* tname,
+		  const THcCalCalibReader& reader);
+  void ComposeVMs(const Double_t* alpha0, Double_t lo, Double_t hi);
+  void SolveAlphas(UInt_t minhits, Double_t* alphaU, Double_t* alphaC);
+
+  UInt_t GetNslices() const {return fSlices.size();}
+  const THcCalCalibSlice& GetSlice(UInt_t i) const {return fSlices[i];}
+
+  UInt_t GetNev() const {return fNev;}
+  Double_t GetE0() const {return fe0;}
+  Double_t GetQe(UInt_t i) const {return fqe[i];}
+  Double_t GetQ0(UInt_t i) const {return fq0[i];}
+  Double_t GetQ(UInt_t i, UInt_t j) const {return fQ[Index(i,j)];}
+  UInt_t GetHitCount(UInt_t i) const {return fHitCount[i];}
+
+  static const UInt_t fMaxSlices = 64;       // Independent of thread count
+  static const UInt_t fMinSliceSize = 1000;  // entries
+
+ private:
+
+  // Index of Q(i,j) in the packed upper triangle.
+
+  UInt_t Index(UInt_t i, UInt_t j) const {
+    if (i > j) {UInt_t t = i; i = j; j = t;}
+    return i*(2*fNpmts-i-1)/2 + j;
+  }
+
+  UInt_t GetNThreads() const;
+  void ReadSlices(const char* fname, const char* tname,
+		  const THcCalCalibReader* proto, atomic<UInt_t>* next);
+  void ComposeSlices(const Double_t* alpha0, Double_t lo, Double_t hi,
+		     atomic<UInt_t>* next);
+  void ComposeSlice(THcCalCalibSlice& s, const Double_t* alpha0,
+		    Double_t lo, Double_t hi) const;
+
+  UInt_t fNpmts;
+  UInt_t fNThreads;
+
+  vector<THcCalCalibSlice> fSlices;
+
+  UInt_t fNev;                 // Number of selected events
+  Double_t fe0;
+  vector<Double_t> fqe;
+  vector<Double_t> fq0;
+  vector<Double_t> fQ;         // Packed upper triangle of the symmetric Q
+  vector<UInt_t> fHitCount;
+
+};
+
+//------------------------------------------------------------------------------
+
+THcCalCalibEngine::THcCalCalibEngine(UInt_t npmts) :
+  fNpmts(npmts), fNThreads(0), fNev(0), fe0(0.) {
+  fqe.assign(fNpmts, 0.);
+  fq0.assign(fNpmts, 0.);
+  fQ.assign(fNpmts*(fNpmts+1)/2, 0.);
+  fHitCount.assign(fNpmts, 0);
+};
+
+//------------------------------------------------------------------------------
+
+THcCalCalibEngine::~THcCalCalibEngine() {
+};
+
+//------------------------------------------------------------------------------
+
+UInt_t THcCalCalibEngine::GetNThreads() const {
+
+  UInt_t nthreads = fNThreads;
+  if (nthreads == 0) nthreads = thread::hardware_concurrency();
+  if (nthreads == 0) nthreads = 1;
+  if (nthreads > fSlices.size()) nthreads = fSlices.size();
+  return (nthreads > 0 ? nthreads : 1);
+}
+
+//------------------------------------------------------------------------------
+
+UInt_t THcCalCalibEngine::ReadTree(const char* fname, const char* tname,
+				   const THcCalCalibReader& reader) {
+
+  // Read all entries of the tree into the in-memory store, one slice at
+  // a time by each thread. Every thread opens its own copy of the file.
+
+  TFile* f = TFile::Open(fname);
+  if (!f || f->IsZombie()) {
+    cout << "*** THcCalCalibEngine::ReadTree: cannot open " << fname
+	 << " ***" << endl;
+    delete f;
+    return 0;
+  }
+  TTree* tree = 0;
+  f->GetObject(tname, tree);
+  Long64_t nentries = tree ? tree->GetEntries() : 0;
+  delete f;
+
+  UInt_t nslices = (nentries + fMinSliceSize - 1) / fMinSliceSize;
+  if (nslices > fMaxSlices) nslices = fMaxSlices;
+  if (nslices == 0) nslices = 1;
+
+  fSlices.clear();
+  fSlices.resize(nslices);
+  for (UInt_t i=0; i<nslices; i++) {
+    fSlices[i].fFirst = nentries*i/nslices;
+    fSlices[i].fLast = nentries*(i+1)/nslices;
+  }
+
+  UInt_t nthreads = GetNThreads();
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,6,0)
+  if (nthreads > 1) ROOT::EnableThreadSafety();
+#else
+  nthreads = 1;
+#endif
+  cout << "THcCalCalibEngine::ReadTree: " << nentries << " entries, "
+       << nslices << " slices, " << nthreads << " threads" << endl;
+
+  atomic<UInt_t> next(0);
+  vector<thread> pool;
+  for (UInt_t i=1; i<nthreads; i++)
+    pool.push_back(thread(&THcCalCalibEngine::ReadSlices, this,
+			  fname, tname, &reader, &next));
+  ReadSlices(fname, tname, &reader, &next);
+  for (UInt_t i=0; i<pool.size(); i++) pool[i].join();
+
+  UInt_t nev = 0;
+  for (UInt_t i=0; i<nslices; i++) nev += fSlices[i].GetNevents();
+
+  return nev;
+}
+
+//------------------------------------------------------------------------------
+
+void THcCalCalibEngine::ReadSlices(const char* fname, const char* tname,
+				   const THcCalCalibReader* proto,
+				   atomic<UInt_t>* next) {
+
+  TFile* f = TFile::Open(fname);
+  TTree* tree = 0;
+  if (f) f->GetObject(tname, tree);
+  if (!tree) {
+    cout << "*** THcCalCalibEngine::ReadSlices: no tree " << tname
+	 << " in " << fname << " ***" << endl;
+    delete f;
+    return;
+  }
+
+  THcCalCalibReader* reader = proto->Clone();
+  tree->SetBranchStatus("*", 0);
+  reader->SetBranches(tree);
+
+  UInt_t islice;
+  while ((islice = (*next)++) < fSlices.size()) {
+    THcCalCalibSlice& s = fSlices[islice];
+    for (Long64_t ientry=s.fFirst; ientry<s.fLast; ientry++) {
+      tree->GetEntry(ientry);
+      reader->Decode(s);
+    }
+  }
+
+  delete reader;
+  delete f;
+}
+
+//------------------------------------------------------------------------------
+
+void THcCalCalibEngine::ComposeSlices(const Double_t* alpha0,
+				      Double_t lo, Double_t hi,
+				      atomic<UInt_t>* next) {
+
+  // Worker of ComposeVMs: take free slices until all are done.
+
+  UInt_t islice;
+  while ((islice = (*next)++) < fSlices.size())
+    ComposeSlice(fSlices[islice], alpha0, lo, hi);
+}
+
+//------------------------------------------------------------------------------
+
+void THcCalCalibEngine::ComposeSlice(THcCalCalibSlice& s,
+				     const Double_t* alpha0,
+				     Double_t lo, Double_t hi) const {
+
+  // Accumulate the partial sums of the slice for events within the
+  // thresholds on the normalized energy deposition with gains alpha0.
+
+  s.fNev = 0;
+  s.fe0 = 0.;
+  s.fqe.assign(fNpmts, 0.);
+  s.fq0.assign(fNpmts, 0.);
+  s.fQ.assign(fQ.size(), 0.);
+  s.fHitCount.assign(fNpmts, 0);
+
+  UInt_t nevents = s.GetNevents();
+
+  for (UInt_t iev=0; iev<nevents; iev++) {
+
+    Double_t Enorm = s.Enorm(iev, alpha0);
+    if (!(Enorm>lo && Enorm<hi)) continue;
+
+    Double_t P = s.fP[iev]*1000.;     //MeV
+    s.fe0 += P;
+
+    UInt_t beg = s.fHit0[iev];
+    UInt_t end = (iev+1 < nevents) ? s.fHit0[iev+1] : s.fChan.size();
+
+    for (UInt_t k=beg; k<end; k++) {
+
+      UInt_t ic = s.fChan[k];
+      Double_t is = s.fSig[k];
+
+      s.fqe[ic] += is * P;
+      s.fq0[ic] += is;
+      s.fHitCount[ic]++;
+
+      // Only the pairs of PMTs fired in this event contribute to Q.
+
+      for (UInt_t l=k; l<end; l++)
+	s.fQ[Index(ic,s.fChan[l])] += is*s.fSig[l];
+    }
+
+    s.fNev++;
+  }
+
+}
+
+//------------------------------------------------------------------------------
+
+void THcCalCalibEngine::ComposeVMs(const Double_t* alpha0,
+				   Double_t lo, Double_t hi) {
+
+  // Fill in vectors and matrix for the gain constant calculations, in
+  // parallel over the slices, then sum the slices in order.
+
+  atomic<UInt_t> next(0);
+  vector<thread> pool;
+  UInt_t nthreads = GetNThreads();
+  for (UInt_t i=1; i<nthreads; i++)
+    pool.push_back(thread(&THcCalCalibEngine::ComposeSlices, this,
+			  alpha0, lo, hi, &next));
+  ComposeSlices(alpha0, lo, hi, &next);
+  for (UInt_t i=0; i<pool.size(); i++) pool[i].join();
+
+  fNev = 0;
+  fe0 = 0.;
+  fqe.assign(fNpmts, 0.);
+  fq0.assign(fNpmts, 0.);
+  fQ.assign(fQ.size(), 0.);
+  fHitCount.assign(fNpmts, 0);
+
+  for (UInt_t islice=0; islice<fSlices.size(); islice++) {
+
+    THcCalCalibSlice& s = fSlices[islice];
+
+    fNev += s.fNev;
+    fe0 += s.fe0;
+    for (UInt_t i=0; i<fNpmts; i++) {
+      fqe[i] += s.fqe[i];
+      fq0[i] += s.fq0[i];
+      fHitCount[i] += s.fHitCount[i];
+    }
+    for (UInt_t i=0; i<fQ.size(); i++) fQ[i] += s.fQ[i];
+
+    // Release the partial sums.
+
+    vector<Double_t>().swap(s.fqe);
+    vector<Double_t>().swap(s.fq0);
+    vector<Double_t>().swap(s.fQ);
+    vector<UInt_t>().swap(s.fHitCount);
+  }
+
+  // Take averages.
+
+  if (fNev == 0) {
+    cout << "*** THcCalCalibEngine::ComposeVMs: no events within thresholds"
+	 << " ***" << endl;
+    return;
+  }
+
+  fe0 /= fNev;
+  for (UInt_t i=0; i<fNpmts; i++) {
+    fqe[i] /= fNev;
+    fq0[i] /= fNev;
+  }
+  for (UInt_t i=0; i<fQ.size(); i++) fQ[i] /= fNev;
+
+}
+
+//------------------------------------------------------------------------------
+
+void THcCalCalibEngine::SolveAlphas(UInt_t minhits,
+				    Double_t* alphaU, Double_t* alphaC) {
+
+  //
+  // Solve for the sought calibration constants, by use of the Root
+  // matrix algebra package.
+  //
+
+  TMatrixDSym Q(fNpmts);
+  TVectorD q0(fNpmts);
+  TVectorD qe(fNpmts);
+
+  // Initialize the vectors and the matrix of the Root algebra package.
+
+  for (UInt_t i=0; i<fNpmts; i++) {
+    q0[i] = fq0[i];
+    qe[i] = fqe[i];
+    for (UInt_t k=i; k<fNpmts; k++) {
+      Q(i,k) = fQ[Index(i,k)];
+      Q(k,i) = Q(i,k);
+    }
+  }
+
+  // Sanity check.
+
+  for (UInt_t i=0; i<fNpmts; i++) {
+
+    // Check zero hit channels: the vector and matrix elements should be 0.
+
+    if (fHitCount[i] == 0) {
+
+      if (q0[i] != 0. || qe[i] != 0.) {
+
+	cout << "*** Inconsistency in chanel " << i << ": # of hits  "
+	     << fHitCount[i] << ", q0=" << q0[i] << ", qe=" << qe[i];
+
+	for (UInt_t k=0; k<fNpmts; k++) {
+	  if (Q(i,k) !=0.)
+	    cout << ", Q[" << i << "," << k << "]=" << Q(i,k);
+	}
+
+	cout << " ***" << endl;
+      }
+    }
+
+    // The hit channels: the vector elements should be non zero.
+
+    if ( (fHitCount[i] != 0) && (q0[i] == 0. || qe[i] == 0.) ) {
+      cout << "*** Inconsistency in chanel " << i << ": # of hits  "
+	   << fHitCount[i] << ", q0=" << q0[i] << ", qe=" << qe[i]
+	   << " ***" << endl;
+    }
+
+  } //sanity check
+
+  // Low hit number channels: exclude from calculation. Assign all the
+  // correspondent elements 0, except self-correlation Q(i,i)=1.
+
+  cout << endl;
+  cout << "Channels with hit number less than " << minhits
+       << " will not be calibrated." << endl;
+  cout << endl;
+
+  for (UInt_t i=0; i<fNpmts; i++) {
+
+    if (fHitCount[i] < minhits) {
+      cout << "Channel " << i << ", " << fHitCount[i]
+	   << " hits, will not be calibrated." << endl;
+      q0[i] = 0.;
+      qe[i] = 0.;
+      for (UInt_t k=0; k<fNpmts; k++) {
+	Q(i,k) = 0.;
+	Q(k,i) = 0.;
+      }
+      Q(i,i) = 1.;
+    }
+
+  }
+
+  // Q is symmetric and positive definite once the dead channels are
+  // excluded: use Cholesky decomposition. Fall back to LU decomposition,
+  // as the calibrations did before, if Q turns out to be singular.
+
+  TVectorD au(qe);
+  TVectorD Qiq0(q0);        // an intermittent result
+  Double_t d1,d2;
+  Bool_t ok;
+
+  TDecompChol chol(Q);
+  if (chol.Decompose()) {
+
+    chol.Det(d1,d2);
+    cout << "Cholesky decomposition" << endl;
+    cout << "cond:" << chol.Condition() << endl;
+    cout << "det :" << d1*TMath::Power(2.,d2) << endl;
+    cout << "tol :" << chol.GetTol() << endl;
+
+    // Solve equation Q x au = qe for the 'unconstrained' calibration (gain)
+    // constants au.
+
+    ok = chol.Solve(au);
+    cout << "au: ok=" << ok << endl;
+    ok = chol.Solve(Qiq0);
+    cout << "Qiq0: ok=" << ok << endl;
+  }
+  else {
+
+    cout << "*** Cholesky decomposition failed, using LU ***" << endl;
+
+    TMatrixD Qlu(Q);
+    TDecompLU lu(Qlu);
+    lu.Det(d1,d2);
+    cout << "cond:" << lu.Condition() << endl;
+    cout << "det :" << d1*TMath::Power(2.,d2) << endl;
+    cout << "tol :" << lu.GetTol() << endl;
+
+    au = lu.Solve(qe,ok);
+    cout << "au: ok=" << ok << endl;
+    Qiq0 = lu.Solve(q0,ok);
+    cout << "Qiq0: ok=" << ok << endl;
+  }
+
+  // Find the sought 'constrained' calibration constants next.
+
+  Double_t t1 = fe0 - au * q0;         // temporary variable.
+  Double_t t2 = q0 * Qiq0;             // another temporary variable
+
+  TVectorD ac(fNpmts);
+  ac = (t1/t2) *Qiq0 + au;             // the sought gain constants
+
+  // Assign the gain arrays.
+
+  for (UInt_t i=0; i<fNpmts; i++) {
+    alphaU[i] = au[i];
+    alphaC[i] = ac[i];
+  }
+
+}
+
+#endif
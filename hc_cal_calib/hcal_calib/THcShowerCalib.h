@@ -2,11 +2,9 @@
 #define ROOT_THcShowerCalib
 
 #include "THcShTrack.h"
+#include "../THcCalCalibEngine.h"
 #include "TH1F.h"
 #include "TH2F.h"
-#include "TVectorD.h"
-#include "TMatrixD.h"
-#include "TDecompLU.h"
 #include "TMath.h"
 #include <iostream>
 #include <fstream>
@@ -20,6 +18,41 @@
 
 using namespace std;
 
+//
+// Decoder of the HMS Shower Counter calibration tree for THcCalCalibEngine.
+// Unit gain signals are those of THcShTrack::SetEs. PMT channels are
+// block number - 1 for the positive side, fNblks + block number - 1 for
+// the negative side.
+//
+
+class THcShCalibReader : public THcCalCalibReader {
+
+ public:
+
+  THcCalCalibReader* Clone() const {return new THcShCalibReader;}
+  void SetBranches(TTree* tree);
+  void Decode(THcCalCalibSlice& slice);
+
+ private:
+
+  // Calorimeter ADC signals.
+
+  Double_t        H_cal_aneg_p[THcShTrack::fNcols][THcShTrack::fNrows];
+  Double_t        H_cal_apos_p[THcShTrack::fNcols][THcShTrack::fNrows];
+
+  // Track parameters.
+
+  Double_t        H_tr_p;
+  Double_t        H_tr_x;   //X FP
+  Double_t        H_tr_xp;
+  Double_t        H_tr_y;   //Y FP
+  Double_t        H_tr_yp;
+  Double_t        H_tr_tg_dp;
+
+  THcShTrack      fTrk;     // Provides the coordinate corrections
+
+};
+
 //
 // HMS Shower Counter calibration class.
 //
@@ -40,6 +73,8 @@ class THcShowerCalib {
   void SaveAlphas();
   void SaveRawData();
 
+  void SetNThreads(UInt_t n) {fEngine.SetNThreads(n);}   // 0: one per core
+
   TH1F* hEunc;
   TH1F* hEuncSel;
   TH1F* hEcal;
@@ -56,28 +91,82 @@ class THcShowerCalib {
   TTree* fTree;
   UInt_t fNentries;
 
-  // Quantities for calculations of the calibration constants.
+  // Vectors and matrix for calculations of the calibration constants,
+  // accumulated from a single parallel read of the tree.
+
+  THcCalCalibEngine fEngine;
 
-  Double_t fe0;
-  Double_t fqe[THcShTrack::fNpmts];
-  Double_t fq0[THcShTrack::fNpmts];
-  Double_t fQ[THcShTrack::fNpmts][THcShTrack::fNpmts];
   Double_t falphaU[THcShTrack::fNpmts];   // 'unconstrained' calib. constants
   Double_t falphaC[THcShTrack::fNpmts];   // the sought calibration constants
   Double_t falpha0[THcShTrack::fNpmts];   // initial gains
-  Double_t falpha1[THcShTrack::fNpmts];   // unit gains
-
-  UInt_t fHitCount[THcShTrack::fNpmts];
 
 };
 
 //------------------------------------------------------------------------------
 
-THcShowerCalib::THcShowerCalib() {};
+void THcShCalibReader::SetBranches(TTree* tree) {
+
+  const char* planes[THcShTrack::fNcols] = {"1pr", "2ta", "3ta", "4ta"};
+
+  for (UInt_t k=0; k<THcShTrack::fNcols; k++) {
+    TString prefix = TString("H.cal.") + planes[k];
+    Connect(tree, prefix + ".aneg_p", H_cal_aneg_p[k]);
+    Connect(tree, prefix + ".apos_p", H_cal_apos_p[k]);
+  }
+
+  Connect(tree, "H.tr.x",&H_tr_x);
+  Connect(tree, "H.tr.y",&H_tr_y);
+  Connect(tree, "H.tr.th",&H_tr_xp);
+  Connect(tree, "H.tr.ph",&H_tr_yp);
+  Connect(tree, "H.tr.p",&H_tr_p);
+  Connect(tree, "H.tr.tg_dp",&H_tr_tg_dp);
+}
+
+//------------------------------------------------------------------------------
+
+void THcShCalibReader::Decode(THcCalCalibSlice& slice) {
+
+  // Same hit selection as THcShowerCalib::ReadShRawTrack.
+
+  // Track coordinates at the calorimeter face.
+
+  Double_t X = H_tr_x+D_CALO_FP*H_tr_xp;
+  Double_t Y = H_tr_y+D_CALO_FP*H_tr_yp;
+
+  slice.AddEvent(H_tr_p, H_tr_tg_dp, X, Y);
+
+  for (UInt_t j=0; j<THcShTrack::fNrows; j++) {
+    for (UInt_t k=0; k<THcShTrack::fNcols; k++) {
+
+      Double_t adc_pos = H_cal_apos_p[k][j];
+      Double_t adc_neg = H_cal_aneg_p[k][j];
+
+      if (adc_pos>0. || adc_neg>0.) {
+
+	UInt_t nb = j+1 + k*THcShTrack::fNrows;
+	Double_t yh = Y+H_tr_yp*(k+0.5)*THcShTrack::fZbl;
+
+	if (nb <= THcShTrack::fNnegs) {
+	  slice.AddSignal(nb-1, adc_pos*fTrk.Ycor(yh,0));
+	  slice.AddSignal(THcShTrack::fNblks+nb-1, adc_neg*fTrk.Ycor(yh,1));
+	}
+	else
+	  slice.AddSignal(nb-1, adc_pos*fTrk.Ycor(yh));
+      }
+
+    }
+  }
+
+}
+
+//------------------------------------------------------------------------------
+
+THcShowerCalib::THcShowerCalib() : fEngine(THcShTrack::fNpmts) {};
 
 //------------------------------------------------------------------------------
 
-THcShowerCalib::THcShowerCalib(Int_t RunNumber) {
+THcShowerCalib::THcShowerCalib(Int_t RunNumber) :
+  fEngine(THcShTrack::fNpmts) {
   fRunNumber = RunNumber;
 };
 
@@ -118,7 +207,7 @@ void THcShowerCalib::Init() {
 
   gROOT->Reset();
 
-  char* fname = Form("Root_files/hcal_calib_%d.root",fRunNumber);
+  TString fname = Form("Root_files/hcal_calib_%d.root",fRunNumber);
   cout << "THcShowerCalib::Init: Root file name = " << fname << endl;
 
   TFile *f = new TFile(fname);
@@ -134,20 +223,9 @@ void THcShowerCalib::Init() {
   hDPvsEcal = new TH2F("hDPvsEcal", "#DeltaP versus Edep/P ",
 		       150,0.,1.5, 250,-12.5,12.5);
 
-  // Initialize qumulative quantities.
-  
-  for (UInt_t i=0; i<THcShTrack::fNpmts; i++) fHitCount[i] = 0;
-
-  fe0 = 0.;
-
   for (UInt_t i=0; i<THcShTrack::fNpmts; i++) {
-    fqe[i] = 0.;
-    fq0[i] = 0.;
     falphaU[i] = 0.;
     falphaC[i] = 0.;
-    for (UInt_t j=0; j<THcShTrack::fNpmts; j++) {
-      fQ[i][j] = 0.;
-    }
   }
 
   // Initial gains (0.5 for the 2 first columns, 1 for others).
@@ -162,11 +240,11 @@ void THcShowerCalib::Init() {
     }
   };
 
-  // Unit gains.
+  // Read the track events of the tree in memory, once for all the steps
+  // of the calibration.
 
-  for (UInt_t ipmt=0; ipmt<THcShTrack::fNpmts; ipmt++) {
-    falpha1[ipmt] = 1.;
-  }
+  UInt_t nev = fEngine.ReadTree(fname, "T", THcShCalibReader());
+  cout << "THcShowerCalib::Init: " << nev << " events read" << endl;
 
 };
 
@@ -182,22 +260,19 @@ void THcShowerCalib::CalcThresholds() {
   // histogram, establish +/-3 * RMS thresholds.
 
   Int_t nev = 0;
-  THcShTrack trk;
-
-  for (UInt_t ientry=0; ientry<fNentries; ientry++) {
 
-    ReadShRawTrack(trk, ientry);
+  for (UInt_t islice=0; islice<fEngine.GetNslices(); islice++) {
 
-    //    trk.Print(cout);
-    //    getchar();
+    const THcCalCalibSlice& slice = fEngine.GetSlice(islice);
 
-    trk.SetEs(falpha0);             //Use initial gain constants here.
-    Double_t Enorm = trk.Enorm();
+    for (UInt_t iev=0; iev<slice.GetNevents(); iev++) {
 
-    nev++;
-    //    cout << "CalcThreshods: nev=" << nev << "  Enorm=" << Enorm << endl;
+      //Use initial gain constants here.
+      Double_t Enorm = slice.Enorm(iev, falpha0);
 
-    hEunc->Fill(Enorm);    
+      nev++;
+      hEunc->Fill(Enorm);
+    }
   };
 
   Double_t mean = hEunc->GetMean();
@@ -327,122 +402,32 @@ void THcShowerCalib::ComposeVMs() {
 
   //
   // Fill in vectors and matrixes for the gain constant calculations.
+  // Set energy depositions with default gains, use the events with the
+  // normalized energy deposition within the thresholds.
   //
 
-  fNev = 0;
-  THcShTrack trk;
-
-  // Loop over the shower track events in the ntuples.
-
-  for (UInt_t ientry=0; ientry<fNentries; ientry++) {
-
-    ReadShRawTrack(trk, ientry);
-
-    // Set energy depositions with default gains.
-    // Calculate normalized to the track momentum total energy deposition,
-    // check it against the thresholds.
-
-    trk.SetEs(falpha0);
-    Double_t Enorm = trk.Enorm();
-    if (Enorm>fLoThr && Enorm<fHiThr) {
-
-      trk.SetEs(falpha1);   // Set energies with unit gains for now.
-      // trk.Print(cout);
-
-      fe0 += trk.GetP();    // Accumulate track momenta.
-
-      vector<pmt_hit> pmt_hit_list;     // Container to save PMT hits
-
-      // Loop over hits.
-
-      for (UInt_t i=0; i<trk.GetNhits(); i++) {
-
-	THcShHit* hit = trk.GetHit(i);
-	// hit->Print(cout);
-
-	UInt_t nb = hit->GetBlkNumber();
-
-	// Fill the qe and q0 vectors (for positive side PMT).
-
-	fqe[nb-1] += hit->GetEpos() * trk.GetP();
-	fq0[nb-1] += hit->GetEpos();
-
-	// Save the PMT hit.
-
-	pmt_hit_list.push_back( pmt_hit{hit->GetEpos(), nb} );
-
-	fHitCount[nb-1]++;   //Accrue the hit counter.
-
-	// Do same for the negative side PMTs.
-
-	if (nb <= THcShTrack::fNnegs) {
-	  fqe[THcShTrack::fNblks+nb-1] += hit->GetEneg() * trk.GetP();
-	  fq0[THcShTrack::fNblks+nb-1] += hit->GetEneg();
-
-	  pmt_hit_list.push_back(pmt_hit{hit->GetEneg(),
-		THcShTrack::fNblks+nb} );
-
-	  fHitCount[THcShTrack::fNblks+nb-1]++;
-	};
-
-      }      //over hits
-
-      // Fill in the correlation matrix Q by retrieving the PMT hits.
-
-      for (vector<pmt_hit>::iterator i=pmt_hit_list.begin();
-	   i < pmt_hit_list.end(); i++) {
-
-	UInt_t ic = (*i).channel;
-	Double_t is = (*i).signal;
-
-	for (vector<pmt_hit>::iterator j=i;
-	     j < pmt_hit_list.end(); j++) {
-
-	  UInt_t jc = (*j).channel;
-	  Double_t js = (*j).signal;
-
-	  fQ[ic-1][jc-1] += is*js;
-	  if (jc != ic) fQ[jc-1][ic-1] += is*js;
-	}
-      }
-
-      fNev++;
-
-    };   // if within the thresholds
-
-  };     // over entries
-
-  // Take averages.
-
-  fe0 /= fNev;
-  for (UInt_t i=0; i<THcShTrack::fNpmts; i++) {
-    fqe[i] /= fNev;
-    fq0[i] /= fNev;
-  }
-
-  for (UInt_t i=0; i<THcShTrack::fNpmts; i++)
-    for (UInt_t j=0; j<THcShTrack::fNpmts; j++)
-      fQ[i][j] /= fNev;
+  fEngine.ComposeVMs(falpha0, fLoThr, fHiThr);
+  fNev = fEngine.GetNev();
 
   // Output vectors and matrixes, for debug purposes.
 
   ofstream q0out;
   q0out.open("q0.deb",ios::out);
   for (UInt_t i=0; i<THcShTrack::fNpmts; i++)
-    q0out << fq0[i] << " " << i << endl;
+    q0out << fEngine.GetQ0(i) << " " << i << endl;
   q0out.close();
 
   ofstream qeout;
   qeout.open("qe.deb",ios::out);
   for (UInt_t i=0; i<THcShTrack::fNpmts; i++)
-    qeout << fqe[i] << " " << i << endl;
+    qeout << fEngine.GetQe(i) << " " << i << endl;
   qeout.close();
 
   ofstream Qout;
   Qout.open("Q.deb",ios::out);
   for (UInt_t i=0; i<THcShTrack::fNpmts; i++)
     for (UInt_t j=0; j<THcShTrack::fNpmts; j++)
-      Qout << fQ[i][j] << " " << i << " " << j << endl;
+      Qout << fEngine.GetQ(i,j) << " " << i << " " << j << endl;
   Qout.close();
 
 };
@@ -456,13 +441,6 @@ void THcShowerCalib::SolveAlphas() {
   // matrix algebra package.
   //
 
-  TMatrixD Q(THcShTrack::fNpmts,THcShTrack::fNpmts);
-  TVectorD q0(THcShTrack::fNpmts);
-  TVectorD qe(THcShTrack::fNpmts);
-  TVectorD au(THcShTrack::fNpmts);
-  TVectorD ac(THcShTrack::fNpmts);
-  Bool_t ok;
-
   cout << "Solving Alphas..." << endl;
   cout << endl;
 
@@ -472,129 +450,26 @@ void THcShowerCalib::SolveAlphas() {
   UInt_t j = 0;
   cout << "Positives:";
   for (UInt_t i=0; i<THcShTrack::fNrows; i++)
-    cout << setw(6) << fHitCount[j++] << ",";
+    cout << setw(6) << fEngine.GetHitCount(j++) << ",";
   cout << endl;
   for (Int_t k=0; k<3; k++) {
     cout << "          ";
     for (UInt_t i=0; i<THcShTrack::fNrows; i++)
-      cout << setw(6) << fHitCount[j++] << ",";
+      cout << setw(6) << fEngine.GetHitCount(j++) << ",";
     cout << endl;
   }
   cout << "Negatives:";
   for (UInt_t i=0; i<THcShTrack::fNrows; i++)
-    cout << setw(6) << fHitCount[j++] << ",";
+    cout << setw(6) << fEngine.GetHitCount(j++) << ",";
   cout << endl;
   cout << "          ";
   for (UInt_t i=0; i<THcShTrack::fNrows; i++)
-    cout << setw(6) << fHitCount[j++] << ",";
-  cout << endl;
-
-  // Initialize the vectors and the matrix of the Root algebra package.
-
-  for (UInt_t i=0; i<THcShTrack::fNpmts; i++) {
-    q0[i] = fq0[i];
-    qe[i] = fqe[i];
-    for (UInt_t k=0; k<THcShTrack::fNpmts; k++) {
-      Q[i][k] = fQ[i][k];
-    }
-  }
-
-  // Sanity check.
-
-  for (UInt_t i=0; i<THcShTrack::fNpmts; i++) {
-
-    // Check zero hit channels: the vector and matrix elements should be 0.
-
-    if (fHitCount[i] == 0) {
-
-      if (q0[i] != 0. || qe[i] != 0.) {
-
-	cout << "*** Inconsistency in chanel " << i << ": # of hits  "
-	     << fHitCount[i] << ", q0=" << q0[i] << ", qe=" << qe[i];
-
-	for (UInt_t k=0; k<THcShTrack::fNpmts; k++) {
-	  if (Q[i][k] !=0. || Q[k][i] !=0.)
-	    cout << ", Q[" << i << "," << k << "]=" << Q[i][k]
-		 << ", Q[" << k << "," << i << "]=" << Q[k][i];
-	}
-
-	cout << " ***" << endl;
-      }
-    }
-
-    // The hit channels: the vector elements should be non zero.
-
-    if ( (fHitCount[i] != 0) && (q0[i] == 0. || qe[i] == 0.) ) {
-      cout << "*** Inconsistency in chanel " << i << ": # of hits  "
-	   << fHitCount[i] << ", q0=" << q0[i] << ", qe=" << qe[i]
-	   << " ***" << endl;
-    }
-
-  } //sanity check
-
-  // Low hit number channels: exclude from calculation. Assign all the
-  // correspondent elements 0, except self-correlation Q(i,i)=1.
-
-  cout << endl;
-  cout << "Channels with hit number less than " << fMinHitCount 
-       << " will not be calibrated." << endl;
+    cout << setw(6) << fEngine.GetHitCount(j++) << ",";
   cout << endl;
 
-  for (UInt_t i=0; i<THcShTrack::fNpmts; i++) {
-
-    if (fHitCount[i] < fMinHitCount) {
-      cout << "Channel " << i << ", " << fHitCount[i]
-	   << " hits, will not be calibrated." << endl;
-      q0[i] = 0.;
-      qe[i] = 0.;
-      for (UInt_t k=0; k<THcShTrack::fNpmts; k++) {
-	Q[i][k] = 0.;
-	Q[k][i] = 0.;
-      }
-      Q[i][i] = 1.;
-    }
-
-  }
-
-  // Declare LU decomposition method for the correlation matrix Q.
-
-  TDecompLU lu(Q);
-  Double_t d1,d2;
-  lu.Det(d1,d2);
-  cout << "cond:" << lu.Condition() << endl;
-  cout << "det :" << d1*TMath::Power(2.,d2) << endl;
-  cout << "tol :" << lu.GetTol() << endl;
-
-  // Solve equation Q x au = qe for the 'unconstrained' calibration (gain)
-  // constants au.
-
-  au = lu.Solve(qe,ok);
-  cout << "au: ok=" << ok << endl;
-  //  au.Print();
-
-  // Find the sought 'constrained' calibration constants next.
-
-  Double_t t1 = fe0 - au * q0;         // temporary variable.
-  //  cout << "t1 =" << t1 << endl;
-
-  TVectorD Qiq0(THcShTrack::fNpmts);   // an intermittent result
-  Qiq0 = lu.Solve(q0,ok);
-  cout << "Qiq0: ok=" << ok << endl;
-  //  Qiq0.Print();
+  // Exclude low hit number channels and solve by Cholesky decomposition.
 
-  Double_t t2 = q0 * Qiq0;             // another temporary variable
-  //  cout << "t2 =" << t2 << endl;
-
-  ac = (t1/t2) *Qiq0 + au;             // the sought gain constants
-  //  cout << "ac:" << endl;
-  //  ac.Print();
-
-  // Assign the gain arrays.
-
-  for (UInt_t i=0; i<THcShTrack::fNpmts; i++) {
-    falphaU[i] = au[i];
-    falphaC[i] = ac[i];
-  }
+  fEngine.SolveAlphas(fMinHitCount, falphaU, falphaC);
 
 }
 
@@ -612,26 +487,23 @@ void THcShowerCalib::FillHEcal() {
 
   Int_t nev = 0;
 
-  THcShTrack trk;
+  for (UInt_t islice=0; islice<fEngine.GetNslices(); islice++) {
 
-  for (UInt_t ientry=0; ientry<fNentries; ientry++) {
+    const THcCalCalibSlice& slice = fEngine.GetSlice(islice);
 
-    ReadShRawTrack(trk, ientry);
-    //    trk.Print(cout);
+    for (UInt_t iev=0; iev<slice.GetNevents(); iev++) {
 
-    trk.SetEs(falphaC);          // use the 'constrained' calibration constants
-    Double_t P = trk.GetP();
-    Double_t Enorm = trk.Enorm();
+      // use the 'constrained' calibration constants
+      Double_t P = slice.fP[iev]*1000.;
+      Double_t Enorm = slice.Enorm(iev, falphaC);
 
-    hEcal->Fill(Enorm);
+      hEcal->Fill(Enorm);
+      hDPvsEcal->Fill(Enorm,slice.fDelta[iev],1.);
 
-    Double_t delta;
-    fTree->SetBranchAddress("H.tr.tg_dp",&delta);
-    hDPvsEcal->Fill(Enorm,delta,1.);
+      output << Enorm*P/1000. << " " << P/1000. << endl;
 
-    output << Enorm*P/1000. << " " << P/1000. << endl;
-
-    nev++;
+      nev++;
+    }
   };
 
   output.close();
@@ -2,11 +2,9 @@
 #define ROOT_THcPShowerCalib
 
 #include "THcPShTrack.h"
+#include "../THcCalCalibEngine.h"
 #include "TH1F.h"
 #include "TH2F.h"
-#include "TVectorD.h"
-#include "TMatrixD.h"
-#include "TDecompLU.h"
 #include "TMath.h"
 #include <iostream>
 #include <fstream>
@@ -20,6 +18,40 @@
 
 using namespace std;
 
+//
+// Decoder of the SHMS calorimeter calibration tree for THcCalCalibEngine.
+// Unit gain signals are those of THcPShTrack::SetEs, PMT channel is
+// block number - 1.
+//
+
+class THcPShCalibReader : public THcCalCalibReader {
+
+ public:
+
+  THcCalCalibReader* Clone() const {return new THcPShCalibReader;}
+  void SetBranches(TTree* tree);
+  void Decode(THcCalCalibSlice& slice);
+
+ private:
+
+  // Preshower and Shower ADC signals.
+
+  Double_t        P_pr_a_p[THcPShTrack::fNrows_pr][THcPShTrack::fNcols_pr];
+  Double_t        P_sh_a_p[THcPShTrack::fNrows_sh][THcPShTrack::fNcols_sh];
+
+  // Track parameters.
+
+  Double_t        P_tr_p;
+  Double_t        P_tr_x;   //X FP
+  Double_t        P_tr_xp;
+  Double_t        P_tr_y;   //Y FP
+  Double_t        P_tr_yp;
+  Double_t        P_tr_tg_dp;
+
+  THcPShTrack     fTrk;     // Provides the coordinate correction
+
+};
+
 //
 // SHMS Calorimeter calibration class.
 //
@@ -41,6 +73,8 @@ class THcPShowerCalib {
   void SaveAlphas();
   void SaveRawData();
 
+  void SetNThreads(UInt_t n) {fEngine.SetNThreads(n);}   // 0: one per core
+
   TH1F* hEunc;
   TH1F* hEuncSel;
   TH1F* hEcal;
@@ -59,28 +93,86 @@ class THcPShowerCalib {
   TTree* fTree;
   UInt_t fNentries;
 
-  // Quantities for calculations of the calibration constants.
+  // Vectors and matrix for calculations of the calibration constants,
+  // accumulated from a single parallel read of the tree.
+
+  THcCalCalibEngine fEngine;
 
-  Double_t fe0;
-  Double_t fqe[THcPShTrack::fNpmts];
-  Double_t fq0[THcPShTrack::fNpmts];
-  Double_t fQ[THcPShTrack::fNpmts][THcPShTrack::fNpmts];
   Double_t falphaU[THcPShTrack::fNpmts];   // 'unconstrained' calib. constants
   Double_t falphaC[THcPShTrack::fNpmts];   // the sought calibration constants
   Double_t falpha0[THcPShTrack::fNpmts];   // initial gains
-  Double_t falpha1[THcPShTrack::fNpmts];   // unit gains
-
-  UInt_t fHitCount[THcPShTrack::fNpmts];
 
 };
 
 //------------------------------------------------------------------------------
 
-THcPShowerCalib::THcPShowerCalib() {};
+void THcPShCalibReader::SetBranches(TTree* tree) {
+
+  Connect(tree, "P.pr.a_p", P_pr_a_p);
+  Connect(tree, "P.sh.a_p", P_sh_a_p);
+
+  Connect(tree, "P.tr.x", &P_tr_x);
+  Connect(tree, "P.tr.y", &P_tr_y);
+  Connect(tree, "P.tr.th",&P_tr_xp);
+  Connect(tree, "P.tr.ph",&P_tr_yp);
+  Connect(tree, "P.tr.p", &P_tr_p);
+  Connect(tree, "P.tr.tg_dp", &P_tr_tg_dp);
+}
+
+//------------------------------------------------------------------------------
+
+void THcPShCalibReader::Decode(THcCalCalibSlice& slice) {
+
+  // Same hit selection as THcPShowerCalib::ReadShRawTrack.
+
+  const Double_t adc_thr = 15.;   //Low threshold on the ADC signals.
+
+  // Track coordinates at the face of Preshower.
+
+  Double_t Y = P_tr_y+D_CALO_FP*P_tr_yp;
+
+  slice.AddEvent(P_tr_p, P_tr_tg_dp, P_tr_x+D_CALO_FP*P_tr_xp, Y);
+
+  // Preshower hits, corrected for Y coordinate.
+
+  for (UInt_t k=0; k<THcPShTrack::fNcols_pr; k++) {
+    for (UInt_t j=0; j<THcPShTrack::fNrows_pr; j++) {
+
+      Double_t adc = P_pr_a_p[j][k];
+
+      if (adc > adc_thr) {
+	UInt_t nb = j+1 + k*THcPShTrack::fNrows_pr;
+	slice.AddSignal(nb-1, adc*fTrk.Ycor(Y,k+1));
+      }
+
+    }
+  }
+
+  // Shower hits, no coordinate correction.
+
+  for (UInt_t k=0; k<THcPShTrack::fNcols_sh; k++) {
+    for (UInt_t j=0; j<THcPShTrack::fNrows_sh; j++) {
+
+      Double_t adc = P_sh_a_p[j][k];
+
+      if (adc > adc_thr) {
+	UInt_t nb = THcPShTrack::fNpmts_pr + j+1 + k*THcPShTrack::fNrows_sh;
+	slice.AddSignal(nb-1, adc);
+      }
+
+    }
+  }
+
+}
+
+//------------------------------------------------------------------------------
+
+THcPShowerCalib::THcPShowerCalib() : fEngine(THcPShTrack::fNpmts) {};
 
 //------------------------------------------------------------------------------
 
-THcPShowerCalib::THcPShowerCalib(Int_t RunNumber) {
+THcPShowerCalib::THcPShowerCalib(Int_t RunNumber) :
+  fEngine(THcPShTrack::fNpmts) {
   fRunNumber = RunNumber;
 };
 
@@ -121,7 +213,7 @@ void THcPShowerCalib::Init() {
 
   gROOT->Reset();
 
-  char* fname = Form("Root_files/Pcal_calib_%d.root",fRunNumber);
+  TString fname = Form("Root_files/Pcal_calib_%d.root",fRunNumber);
   cout << "THcPShowerCalib::Init: Root file name = " << fname << endl;
 
   TFile *f = new TFile(fname);
@@ -137,20 +229,9 @@ void THcPShowerCalib::Init() {
   hDPvsEcal = new TH2F("hDPvsEcal", "#DeltaP versus Edep/P ",
 		       350,0.,1.5, 250,-12.5,22.5);
 
-  // Initialize cumulative quantities.
-  
-  for (UInt_t i=0; i<THcPShTrack::fNpmts; i++) fHitCount[i] = 0;
-
-  fe0 = 0.;
-
   for (UInt_t i=0; i<THcPShTrack::fNpmts; i++) {
-    fqe[i] = 0.;
-    fq0[i] = 0.;
     falphaU[i] = 0.;
     falphaC[i] = 0.;
-    for (UInt_t j=0; j<THcPShTrack::fNpmts; j++) {
-      fQ[i][j] = 0.;
-    }
   }
 
   // Initial gains, 1 for all.
@@ -159,11 +240,11 @@ void THcPShowerCalib::Init() {
     falpha0[ipmt] = 1.;
   };
 
-  // Unit gains.
+  // Read the track events of the tree in memory, once for all the steps
+  // of the calibration.
 
-  for (UInt_t ipmt=0; ipmt<THcPShTrack::fNpmts; ipmt++) {
-    falpha1[ipmt] = 1.;
-  }
+  UInt_t nev = fEngine.ReadTree(fname, "T", THcPShCalibReader());
+  cout << "THcPShowerCalib::Init: " << nev << " events read" << endl;
 
 };
 
@@ -179,22 +260,19 @@ void THcPShowerCalib::CalcThresholds() {
   // histogram, establish +/-3 * RMS thresholds.
 
   Int_t nev = 0;
-  THcPShTrack trk;
-
-  for (UInt_t ientry=0; ientry<fNentries; ientry++) {
 
-    ReadShRawTrack(trk, ientry);
+  for (UInt_t islice=0; islice<fEngine.GetNslices(); islice++) {
 
-    //    trk.Print(cout);
-    //    getchar();
+    const THcCalCalibSlice& slice = fEngine.GetSlice(islice);
 
-    trk.SetEs(falpha0);             //Use initial gain constants here.
-    Double_t Enorm = trk.Enorm();
+    for (UInt_t iev=0; iev<slice.GetNevents(); iev++) {
 
-    nev++;
-    //    cout << "CalcThreshods: nev=" << nev << "  Enorm=" << Enorm << endl;
+      //Use initial gain constants here.
+      Double_t Enorm = slice.Enorm(iev, falpha0);
 
-    hEunc->Fill(Enorm);    
+      nev++;
+      hEunc->Fill(Enorm);
+    }
   };
 
   Double_t mean = hEunc->GetMean();
@@ -306,110 +384,33 @@ void THcPShowerCalib::ComposeVMs() {
 
   //
   // Fill in vectors and matrixes for the gain constant calculations.
+  // Set energy depositions with default gains, use the events with the
+  // normalized energy deposition within the thresholds.
   //
 
-  fNev = 0;
-  THcPShTrack trk;
-
-  // Loop over the shower track events in the ntuples.
-
-  for (UInt_t ientry=0; ientry<fNentries; ientry++) {
-
-    ReadShRawTrack(trk, ientry);
-
-    // Set energy depositions with default gains.
-    // Calculate normalized to the track momentum total energy deposition,
-    // check it against the thresholds.
-
-    trk.SetEs(falpha0);
-    Double_t Enorm = trk.Enorm();
-    if (Enorm>fLoThr && Enorm<fHiThr) {
-
-      trk.SetEs(falpha1);   // Set energies with unit gains for now.
-      // trk.Print(cout);
-
-      fe0 += trk.GetP();    // Accumulate track momenta.
-
-      vector<pmt_hit> pmt_hit_list;     // Container to save PMT hits
-
-      // Loop over hits.
-
-      for (UInt_t i=0; i<trk.GetNhits(); i++) {
-
-	THcPShHit* hit = trk.GetHit(i);
-	// hit->Print(cout);
-
-	UInt_t nb = hit->GetBlkNumber();
-
-	// Fill the qe and q0 vectors.
-
-	fqe[nb-1] += hit->GetEdep() * trk.GetP();
-	fq0[nb-1] += hit->GetEdep();
-
-	// Save the PMT hit.
-
-	pmt_hit_list.push_back( pmt_hit{hit->GetEdep(), nb} );
-
-	fHitCount[nb-1]++;   //Accrue the hit counter.
-
-      }      //over hits
-
-      // Fill in the correlation matrix Q by retrieving the PMT hits.
-
-      for (vector<pmt_hit>::iterator i=pmt_hit_list.begin();
-	   i < pmt_hit_list.end(); i++) {
-
-	UInt_t ic = (*i).channel;
-	Double_t is = (*i).signal;
-
-	for (vector<pmt_hit>::iterator j=i;
-	     j < pmt_hit_list.end(); j++) {
-
-	  UInt_t jc = (*j).channel;
-	  Double_t js = (*j).signal;
-
-	  fQ[ic-1][jc-1] += is*js;
-	  if (jc != ic) fQ[jc-1][ic-1] += is*js;
-	}
-      }
-
-      fNev++;
-
-    };   // if within the thresholds
-
-  };     // over entries
-
-  // Take averages.
-
-  fe0 /= fNev;
-  for (UInt_t i=0; i<THcPShTrack::fNpmts; i++) {
-    fqe[i] /= fNev;
-    fq0[i] /= fNev;
-  }
-
-  for (UInt_t i=0; i<THcPShTrack::fNpmts; i++)
-    for (UInt_t j=0; j<THcPShTrack::fNpmts; j++)
-      fQ[i][j] /= fNev;
+  fEngine.ComposeVMs(falpha0, fLoThr, fHiThr);
+  fNev = fEngine.GetNev();
 
   // Output vectors and matrixes, for debug purposes.
 
   ofstream q0out;
   q0out.open("q0.deb",ios::out);
   for (UInt_t i=0; i<THcPShTrack::fNpmts; i++)
-    q0out << setprecision(20) << fq0[i] << " " << i << endl;
+    q0out << setprecision(20) << fEngine.GetQ0(i) << " " << i << endl;
   q0out.close();
 
   ofstream qeout;
   qeout.open("qe.deb",ios::out);
   for (UInt_t i=0; i<THcPShTrack::fNpmts; i++)
-    qeout << setprecision(20) << fqe[i] << " " << i << endl;
+    qeout << setprecision(20) << fEngine.GetQe(i) << " " << i << endl;
   qeout.close();
 
   ofstream Qout;
   Qout.open("Q.deb",ios::out);
   for (UInt_t i=0; i<THcPShTrack::fNpmts; i++)
     for (UInt_t j=0; j<THcPShTrack::fNpmts; j++)
-      Qout << setprecision(20) << fQ[i][j] << " " << i << " " << j << endl;
+      Qout << setprecision(20) << fEngine.GetQ(i,j) << " " << i << " " << j
+	   << endl;
   Qout.close();
 
 };
@@ -423,13 +424,6 @@ void THcPShowerCalib::SolveAlphas() {
   // matrix algebra package.
   //
 
-  TMatrixD Q(THcPShTrack::fNpmts,THcPShTrack::fNpmts);
-  TVectorD q0(THcPShTrack::fNpmts);
-  TVectorD qe(THcPShTrack::fNpmts);
-  TVectorD au(THcPShTrack::fNpmts);
-  TVectorD ac(THcPShTrack::fNpmts);
-  Bool_t ok;
-
   cout << "Solving Alphas..." << endl;
   cout << endl;
 
@@ -441,123 +435,20 @@ void THcPShowerCalib::SolveAlphas() {
   for (UInt_t k=0; k<THcPShTrack::fNcols_pr; k++) {
     k==0 ? cout << "Preshower:" : cout << "        :";
     for (UInt_t i=0; i<THcPShTrack::fNrows_pr; i++)
-      cout << setw(6) << fHitCount[j++] << ",";
+      cout << setw(6) << fEngine.GetHitCount(j++) << ",";
     cout << endl;
   }
 
   for (UInt_t k=0; k<THcPShTrack::fNcols_sh; k++) {
     k==0 ? cout << "Shower   :" : cout << "        :";
     for (UInt_t i=0; i<THcPShTrack::fNrows_sh; i++)
-      cout << setw(6) << fHitCount[j++] << ",";
+      cout << setw(6) << fEngine.GetHitCount(j++) << ",";
     cout << endl;
   }
 
-  // Initialize the vectors and the matrix of the Root algebra package.
-
-  for (UInt_t i=0; i<THcPShTrack::fNpmts; i++) {
-    q0[i] = fq0[i];
-    qe[i] = fqe[i];
-    for (UInt_t k=0; k<THcPShTrack::fNpmts; k++) {
-      Q[i][k] = fQ[i][k];
-    }
-  }
-
-  // Sanity check.
+  // Exclude low hit number channels and solve by Cholesky decomposition.
 
-  for (UInt_t i=0; i<THcPShTrack::fNpmts; i++) {
-
-    // Check zero hit channels: the vector and matrix elements should be 0.
-
-    if (fHitCount[i] == 0) {
-
-      if (q0[i] != 0. || qe[i] != 0.) {
-
-	cout << "*** Inconsistency in chanel " << i << ": # of hits  "
-	     << fHitCount[i] << ", q0=" << q0[i] << ", qe=" << qe[i];
-
-	for (UInt_t k=0; k<THcPShTrack::fNpmts; k++) {
-	  if (Q[i][k] !=0. || Q[k][i] !=0.)
-	    cout << ", Q[" << i << "," << k << "]=" << Q[i][k]
-		 << ", Q[" << k << "," << i << "]=" << Q[k][i];
-	}
-
-	cout << " ***" << endl;
-      }
-    }
-
-    // The hit channels: the vector elements should be non zero.
-
-    if ( (fHitCount[i] != 0) && (q0[i] == 0. || qe[i] == 0.) ) {
-      cout << "*** Inconsistency in chanel " << i << ": # of hits  "
-	   << fHitCount[i] << ", q0=" << q0[i] << ", qe=" << qe[i]
-	   << " ***" << endl;
-    }
-
-  } //sanity check
-
-  // Low hit number channels: exclude from calculation. Assign all the
-  // correspondent elements 0, except self-correlation Q(i,i)=1.
-
-  cout << endl;
-  cout << "Channels with hit number less than " << fMinHitCount 
-       << " will not be calibrated." << endl;
-  cout << endl;
-
-  for (UInt_t i=0; i<THcPShTrack::fNpmts; i++) {
-
-    if (fHitCount[i] < fMinHitCount) {
-      cout << "Channel " << i << ", " << fHitCount[i]
-	   << " hits, will not be calibrated." << endl;
-      q0[i] = 0.;
-      qe[i] = 0.;
-      for (UInt_t k=0; k<THcPShTrack::fNpmts; k++) {
-	Q[i][k] = 0.;
-	Q[k][i] = 0.;
-      }
-      Q[i][i] = 1.;
-    }
-
-  }
-
-  // Declare LU decomposition method for the correlation matrix Q.
-
-  TDecompLU lu(Q);
-  Double_t d1,d2;
-  lu.Det(d1,d2);
-  cout << "cond:" << lu.Condition() << endl;
-  cout << "det :" << d1*TMath::Power(2.,d2) << endl;
-  cout << "tol :" << lu.GetTol() << endl;
-
-  // Solve equation Q x au = qe for the 'unconstrained' calibration (gain)
-  // constants au.
-
-  au = lu.Solve(qe,ok);
-  cout << "au: ok=" << ok << endl;
-  //  au.Print();
-
-  // Find the sought 'constrained' calibration constants next.
-
-  Double_t t1 = fe0 - au * q0;         // temporary variable.
-  //  cout << "t1 =" << t1 << endl;
-
-  TVectorD Qiq0(THcPShTrack::fNpmts);   // an intermittent result
-  Qiq0 = lu.Solve(q0,ok);
-  cout << "Qiq0: ok=" << ok << endl;
-  //  Qiq0.Print();
-
-  Double_t t2 = q0 * Qiq0;             // another temporary variable
-  //  cout << "t2 =" << t2 << endl;
-
-  ac = (t1/t2) *Qiq0 + au;             // the sought gain constants
-  // cout << "ac:" << endl;
-  //  ac.Print();
-
-  // Assign the gain arrays.
-
-  for (UInt_t i=0; i<THcPShTrack::fNpmts; i++) {
-    falphaU[i] = au[i];
-    falphaC[i] = ac[i];
-  }
+  fEngine.SolveAlphas(fMinHitCount, falphaU, falphaC);
 
 }
 
@@ -576,27 +467,24 @@ void THcPShowerCalib::FillHEcal() {
 
   Int_t nev = 0;
 
-  THcPShTrack trk;
+  for (UInt_t islice=0; islice<fEngine.GetNslices(); islice++) {
 
-  for (UInt_t ientry=0; ientry<fNentries; ientry++) {
+    const THcCalCalibSlice& slice = fEngine.GetSlice(islice);
 
-    ReadShRawTrack(trk, ientry);
-    //    trk.Print(cout);
+    for (UInt_t iev=0; iev<slice.GetNevents(); iev++) {
 
-    trk.SetEs(falphaC);          // use the 'constrained' calibration constants
-    Double_t P = trk.GetP();
-    Double_t Enorm = trk.Enorm();
+      // use the 'constrained' calibration constants
+      Double_t P = slice.fP[iev]*1000.;
+      Double_t Enorm = slice.Enorm(iev, falphaC);
 
-    hEcal->Fill(Enorm);
+      hEcal->Fill(Enorm);
+      hDPvsEcal->Fill(Enorm,slice.fDelta[iev],1.);
 
-    Double_t delta;
-    fTree->SetBranchAddress("P.tr.tg_dp",&delta);
-    hDPvsEcal->Fill(Enorm,delta,1.);
+      output << Enorm*P/1000. << " " << P/1000. << " " << slice.fX[iev] << " "
+	     << slice.fY[iev] << endl;
 
-    output << Enorm*P/1000. << " " << P/1000. << " " << trk.GetX() << " "
-	   << trk.GetY() << endl;
-
-    nev++;
+      nev++;
+    }
   };
 
   output.close();
@@ -9,6 +9,7 @@ Import('pbaseenv')
 list = Glob('*.cxx', exclude=['main.C'])
 
 pbaseenv.Object('main.C')
+pbaseenv.Object('replay_main.C')
 
 sotarget = 'HallC'
 
@@ -16,6 +16,7 @@
 #include "THaCutList.h"
 #include "THcParmList.h"
 #include "THcHitList.h"
+#include "THcMemoryReport.h"
 #include "THaApparatus.h"
 #include "VarDef.h"
 #include "VarType.h"
@@ -25,6 +26,7 @@
 #include "THaTrackProj.h"
 #include "THcRawAdcHit.h"
 #include "THcHallCSpectrometer.h"
+#include "THcAnalyzer.h"
 
 #include <cstring>
 #include <cstdio>
@@ -53,6 +55,7 @@ THcAerogel::THcAerogel( const char* name, const char* description,
   fNegThresh(0), fPosPedMean(0), fNegPedMean(0),
   fPosTDCHits(0), fNegTDCHits(0), fPosADCHits(0), fNegADCHits(0)
 {
+  fFillErrorFlags = kTRUE;
 }
 
 //_____________________________________________________________________________
@@ -74,6 +77,7 @@ THcAerogel::THcAerogel( ) :
   fNegThresh(0), fPosPedMean(0), fNegPedMean(0),
   fPosTDCHits(0), fNegTDCHits(0), fPosADCHits(0), fNegADCHits(0)
 {
+  fFillErrorFlags = kTRUE;
 }
 
 //_____________________________________________________________________________
@@ -193,6 +197,11 @@ THaAnalysisObject::EStatus THcAerogel::Init( const TDatime& date )
   if(vpresent) {
     fPresentP = (Bool_t *) vpresent->GetValuePointer();
   }
+
+  // The ADC error flag arrays are only used by global variables
+  fFillErrorFlags =
+    THcAnalyzer::IsOutputRequested(Form("%sposAdcErrorFlag",GetPrefix()))
+    || THcAnalyzer::IsOutputRequested(Form("%snegAdcErrorFlag",GetPrefix()));
   return fStatus = kOK;
 }
 
@@ -652,8 +661,10 @@ Int_t THcAerogel::Decode( const THaEvData& evdata )
       ((THcSignalHit*) frPosAdcPulseTimeRaw->ConstructedAt(nrPosAdcHits))->Set(npmt, rawPosAdcHit.GetPulseTimeRaw(thit));
       ((THcSignalHit*) frPosAdcPulseTime->ConstructedAt(nrPosAdcHits))->Set(npmt, rawPosAdcHit.GetPulseTime(thit)+fAdcTdcOffset);
 
-      if (rawPosAdcHit.GetPulseAmpRaw(thit) > 0)  ((THcSignalHit*) fPosAdcErrorFlag->ConstructedAt(nrPosAdcHits))->Set(npmt, 0);
-      if (rawPosAdcHit.GetPulseAmpRaw(thit) <= 0) ((THcSignalHit*) fPosAdcErrorFlag->ConstructedAt(nrPosAdcHits))->Set(npmt, 1);
+      if (fFillErrorFlags) {
+	if (rawPosAdcHit.GetPulseAmpRaw(thit) > 0)  ((THcSignalHit*) fPosAdcErrorFlag->ConstructedAt(nrPosAdcHits))->Set(npmt, 0);
+	if (rawPosAdcHit.GetPulseAmpRaw(thit) <= 0) ((THcSignalHit*) fPosAdcErrorFlag->ConstructedAt(nrPosAdcHits))->Set(npmt, 1);
+      }
  
      if (rawPosAdcHit.GetPulseAmpRaw(thit) <= 0) {
 	Double_t PeakPedRatio= rawPosAdcHit.GetF250_PeakPedestalRatio();
@@ -689,8 +700,10 @@ Int_t THcAerogel::Decode( const THaEvData& evdata )
       ((THcSignalHit*) frNegAdcPulseTimeRaw->ConstructedAt(nrNegAdcHits))->Set(npmt, rawNegAdcHit.GetPulseTimeRaw(thit));
       ((THcSignalHit*) frNegAdcPulseTime->ConstructedAt(nrNegAdcHits))->Set(npmt, rawNegAdcHit.GetPulseTime(thit));
 
-      if (rawNegAdcHit.GetPulseAmpRaw(thit) > 0)  ((THcSignalHit*) fNegAdcErrorFlag->ConstructedAt(nrNegAdcHits))->Set(npmt, 0);
-      if (rawNegAdcHit.GetPulseAmpRaw(thit) <= 0) ((THcSignalHit*) fNegAdcErrorFlag->ConstructedAt(nrNegAdcHits))->Set(npmt, 1);
+      if (fFillErrorFlags) {
+	if (rawNegAdcHit.GetPulseAmpRaw(thit) > 0)  ((THcSignalHit*) fNegAdcErrorFlag->ConstructedAt(nrNegAdcHits))->Set(npmt, 0);
+	if (rawNegAdcHit.GetPulseAmpRaw(thit) <= 0) ((THcSignalHit*) fNegAdcErrorFlag->ConstructedAt(nrNegAdcHits))->Set(npmt, 1);
+      }
 
      if (rawNegAdcHit.GetPulseAmpRaw(thit) <= 0) {
 	Double_t PeakPedRatio= rawNegAdcHit.GetF250_PeakPedestalRatio();
@@ -1093,5 +1106,40 @@ Int_t THcAerogel::End(THaRunBase* run)
   MissReport(Form("%s.%s", GetApparatus()->GetName(), GetName()));
   return 0;
 }
+
+//_____________________________________________________________________________
+void THcAerogel::AccountMemory( THcMemoryReport& report ) const
+{
+  // Raw hits, the signal hit arrays, which grow with the largest
+  // event, and the per PMT arrays sized at Init
+  THcHitList::AccountMemory(report);
+  const TClonesArray* signals[] = {
+    frPosAdcPedRaw, frPosAdcPulseIntRaw, frPosAdcPulseAmpRaw, frPosAdcPulseTimeRaw,
+    frPosAdcPed, frPosAdcPulseInt, frPosAdcPulseAmp, frPosAdcPulseTime,
+    frNegAdcPedRaw, frNegAdcPulseIntRaw, frNegAdcPulseAmpRaw, frNegAdcPulseTimeRaw,
+    frNegAdcPed, frNegAdcPulseInt, frNegAdcPulseAmp, frNegAdcPulseTime,
+    fPosAdcErrorFlag, fNegAdcErrorFlag,
+    fPosTDCHits, fNegTDCHits, fPosADCHits, fNegADCHits
+  };
+  Long64_t bytes = 0;
+  for(UInt_t i=0;i<sizeof(signals)/sizeof(signals[0]);i++) {
+    bytes += THcMemoryReport::Bytes(signals[i]);
+  }
+  report.Add("signal hits", bytes, THcMemoryReport::kDynamic);
+  bytes = THcMemoryReport::Bytes(fNumPosAdcHits) + THcMemoryReport::Bytes(fNumNegAdcHits)
+    + THcMemoryReport::Bytes(fNumGoodPosAdcHits) + THcMemoryReport::Bytes(fNumGoodNegAdcHits)
+    + THcMemoryReport::Bytes(fNumTracksMatched) + THcMemoryReport::Bytes(fNumTracksFired)
+    + THcMemoryReport::Bytes(fPosNpe) + THcMemoryReport::Bytes(fNegNpe)
+    + THcMemoryReport::Bytes(fGoodPosAdcPed) + THcMemoryReport::Bytes(fGoodPosAdcMult)
+    + THcMemoryReport::Bytes(fGoodPosAdcPulseInt) + THcMemoryReport::Bytes(fGoodPosAdcPulseIntRaw)
+    + THcMemoryReport::Bytes(fGoodPosAdcPulseAmp) + THcMemoryReport::Bytes(fGoodPosAdcPulseTime)
+    + THcMemoryReport::Bytes(fGoodPosAdcTdcDiffTime) + THcMemoryReport::Bytes(fGoodNegAdcPed)
+    + THcMemoryReport::Bytes(fGoodNegAdcMult) + THcMemoryReport::Bytes(fGoodNegAdcPulseInt)
+    + THcMemoryReport::Bytes(fGoodNegAdcPulseIntRaw) + THcMemoryReport::Bytes(fGoodNegAdcPulseAmp)
+    + THcMemoryReport::Bytes(fGoodNegAdcPulseTime) + THcMemoryReport::Bytes(fGoodNegAdcTdcDiffTime)
+    + THcMemoryReport::Bytes(fPosNpeSixGev) + THcMemoryReport::Bytes(fNegNpeSixGev);
+  report.Add("good hits", bytes, THcMemoryReport::kStatic);
+}
+
 ClassImp(THcAerogel)
 ////////////////////////////////////////////////////////////////////////////////
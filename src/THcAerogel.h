@@ -28,6 +28,7 @@ class THcAerogel : public THaNonTrackingDetector, public THcHitList {
   virtual Int_t   DefineVariables(EMode mode = kDefine);
   virtual Int_t   CoarseProcess(TClonesArray& tracks);
   virtual Int_t   FineProcess(TClonesArray& tracks);
+  virtual void    AccountMemory(THcMemoryReport& report) const;
   virtual Int_t   ApplyCorrections(void);
   virtual EStatus Init(const TDatime& run_time);
   Int_t           End(THaRunBase* run=0);
@@ -51,6 +52,7 @@ class THcAerogel : public THaNonTrackingDetector, public THcHitList {
   Int_t     fNRegions;
   Int_t     fRegionsValueMax;
   Int_t     fDebugAdc;
+  Bool_t    fFillErrorFlags;  // Fill ADC error flag arrays (only if used)
   Double_t  fRedChi2Min;
   Double_t  fRedChi2Max;
   Double_t  fBetaMin;
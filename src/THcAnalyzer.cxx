@@ -9,6 +9,34 @@ Adds the following to the Hall A analyzer base class.
 
 2.  Retrieve run number and startind and ending event from parameter DB
 
+3.  Optional "lazy" output mode (SetLazyOutput).  At Init, the output
+    definition file, the cut definition file and any files added with
+    AddRequestFile are scanned for global variable names.  Detectors can
+    then ask IsOutputRequested whether an optional output is used and
+    skip filling it if not.
+
+4.  FlushOutput method to write the output file during the replay,
+    used by THcLiveRun
+
+5.  Optional block filling of the output definition histograms
+    (SetBatchHistograms), see THcHistBatch
+
+6.  Optional columnar output of global variables (SetColumnOutput),
+    see THcColumnWriter
+
+7.  Optional periodic checkpoints of the run level state, and resuming
+    from them with hcana --resume (SetCheckpoint), see THcCheckpoint
+
+8.  Optional reading of the events in a separate thread, ahead of the
+    analysis (SetReadAhead), see THcReadAhead
+
+9.  Optional concurrent initialization of the spectrometer detectors
+    (SetInitThreads), see THcInitScheduler
+
+10. Optional report of the memory of the analysis objects by
+    apparatus at the end of each run, and periodically during it
+    (SetMemoryReport), see THcMemoryReport
+
 \author S. A. Wood,  13-March-2012
 
 */
@@ -16,15 +44,30 @@ Adds the following to the Hall A analyzer base class.
 #include "THaRunBase.h"
 #include "THaBenchmark.h"
 #include "TList.h"
+#include "TFile.h"
+#include "TTree.h"
+#include "TSystem.h"
+#include "TStopwatch.h"
+#include "THcHistBatch.h"
+#include "THcColumnWriter.h"
+#include "THcCheckpoint.h"
+#include "THcInitScheduler.h"
+#include "THcMemoryReport.h"
+#include "THcRun.h"
 #include "THcParmList.h"
 #include "THcFormula.h"
 #include "THcGlobals.h"
+#include "THcRunStats.h"
 #include "TMath.h"
+#include "TRegexp.h"
 
 #include <fstream>
 #include <algorithm>
 #include <iomanip>
+#include <cstdio>
 #include <cstring>
+#include <cctype>
+#include <exception>
 #include <iostream>
 
 using namespace std;
@@ -37,7 +80,11 @@ using namespace std;
 // do we need to "close" scalers/EPICS analysis if we reach the event limit?
 
 //_____________________________________________________________________________
-THcAnalyzer::THcAnalyzer()
+THcAnalyzer::THcAnalyzer() : fLazyOutput(kFALSE), fHistBatch(0),
+			     fColumnWriter(0), fReadAheadDepth(0),
+			     fInitScheduler(0), fMemoryReport(0),
+			     fNevOffset(0), fResuming(kFALSE),
+			     fStartupTimer(0)
 {
 
 }
@@ -47,6 +94,370 @@ THcAnalyzer::~THcAnalyzer()
 {
   // Destructor.
 
+  ClearReportFormulas();
+  delete fHistBatch;
+  delete fColumnWriter;
+  delete fInitScheduler;
+  delete fMemoryReport;
+}
+
+//_____________________________________________________________________________
+Int_t THcAnalyzer::Init( THaRunBase* run )
+{
+  /// Collect the global variable names referenced by the output and cut
+  /// definitions before the detectors are initialized, so that they
+  /// can configure which optional outputs to fill.
+  fRequestedNames.clear();
+  fRequestedPatterns.clear();
+  ClearReportFormulas();	// Variables may be redefined
+  THcRun* hcrun = dynamic_cast<THcRun*>(run);
+  if(hcrun && fReadAheadDepth > 0) hcrun->SetReadAhead(fReadAheadDepth);
+  if(fLazyOutput) {
+    ScanRequestFile(fOdefFileName.Data());
+    ScanRequestFile(fCutFileName.Data());
+    for(UInt_t i=0;i<fRequestFiles.size();i++) {
+      ScanRequestFile(fRequestFiles[i].Data());
+    }
+    cout << "THcAnalyzer: lazy output enabled, " << fRequestedNames.size()
+	 << " variable names and " << fRequestedPatterns.size()
+	 << " wildcard patterns requested" << endl;
+  }
+  // Initialize the spectrometers before THaAnalyzer gets to them; their
+  // Init then returns at once.  Needs the run date.  If an Init throws,
+  // THaAnalyzer initializes all of them again, serially, and reports
+  // the error as usual.
+  if(fInitScheduler && run && (run->IsInit() || run->Init() == 0)) {
+    try {
+      fInitScheduler->Run(run->GetDate());
+    } catch(const exception& e) {
+      THcInitScheduler::ClearInitialized();
+      Warning("Init", "Concurrent Init failed (%s), initializing serially", e.what());
+    } catch(...) {
+      THcInitScheduler::ClearInitialized();
+      Warning("Init", "Concurrent Init failed, initializing serially");
+    }
+  }
+  if(!fHistBatch || fOdefFileName.IsNull()) {
+    Int_t status = InitRun(run);
+    THcInitScheduler::ClearInitialized();
+    if(status == 0 && fColumnWriter && fColumnWriter->Init() != 0) status = -1;
+    return status;
+  }
+
+  // Let THaOutput read the output definition without the histograms
+  // filled by fHistBatch
+  TString odef = fOdefFileName;
+  TString restfile = "hcana_odef_";
+  FILE* tmp = gSystem->TempFileName(restfile);
+  if(tmp) fclose(tmp);
+  if(fHistBatch->SplitOutputDef(odef.Data(), restfile.Data()) > 0) {
+    fOdefFileName = restfile;
+  }
+  Int_t status = InitRun(run);
+  THcInitScheduler::ClearInitialized();
+  fOdefFileName = odef;
+  gSystem->Unlink(restfile);
+  if(status == 0) fHistBatch->Init(fFile);
+  if(status == 0 && fColumnWriter && fColumnWriter->Init() != 0) status = -1;
+  return status;
+}
+
+//_____________________________________________________________________________
+void THcAnalyzer::Close()
+{
+  /// The output file deletes the histograms of fHistBatch when it is
+  /// closed; the next Init books them again.
+  if(fHistBatch) fHistBatch->Detach();
+  THaAnalyzer::Close();
+}
+
+//_____________________________________________________________________________
+Int_t THcAnalyzer::InitRun( THaRunBase* run )
+{
+  /// THaAnalyzer::Init, which copies run to fRun, with the event range
+  /// of the copy shifted by the events counted before the checkpoint
+  /// when resuming.
+  PrepareResume(run);
+  if(!fResuming) return THaAnalyzer::Init(run);
+  UInt_t first = run->GetFirstEvent(), last = run->GetLastEvent();
+  run->SetFirstEvent(first > fNevOffset ? first - fNevOffset : 1);
+  if(last != kMaxUInt) run->SetLastEvent(last > fNevOffset ? last - fNevOffset : 0);
+  Int_t status = THaAnalyzer::Init(run);
+  run->SetFirstEvent(first);	// The caller's run keeps its range
+  run->SetLastEvent(last);
+  return status;
+}
+
+//_____________________________________________________________________________
+void THcAnalyzer::PrepareResume( THaRunBase* run )
+{
+  /// Read the checkpoint, before the output file of the resumed replay
+  /// is opened.  The output file of the checkpoint is cut back to the
+  /// tree entries it had at the checkpoint; if the resumed replay would
+  /// overwrite it, the cut file is written to <name>_part1.root
+  /// instead.  The events the analyzer counted before the checkpoint,
+  /// less the control events it reads again while skipping, are
+  /// counted against the event range.
+  fNevOffset = 0;
+  fResuming = kFALSE;
+  if(!gHcCheckpoint || !THcCheckpoint::IsResume() || !run) return;
+  if(!dynamic_cast<THcRun*>(run)) {
+    Warning("Init", "Resuming needs a THcRun, starting from the first event");
+    return;
+  }
+  if(!run->IsInit() && run->Init() != 0) return;
+  if(gHcCheckpoint->Read() != 0) {
+    cout << "THcAnalyzer: no checkpoint in " << gHcCheckpoint->GetFileName()
+	 << ", starting from the first event" << endl;
+    return;
+  }
+  if(gHcCheckpoint->GetRunNumber() != run->GetNumber()) {
+    cout << "THcAnalyzer: checkpoint is for run " << gHcCheckpoint->GetRunNumber()
+	 << ", starting run " << run->GetNumber() << " from the first event" << endl;
+    return;
+  }
+  TString output = gHcCheckpoint->GetOutputFile();
+  if(!output.IsNull()) {
+    TString target = output;
+    if(target == fOutFileName) {
+      if(target.EndsWith(".root")) target.Remove(target.Length()-5);
+      target += "_part1.root";
+    }
+    if(gHcCheckpoint->TruncateOutput(target) == 0) {
+      cout << "THcAnalyzer: events before the checkpoint are in " << target
+	   << ", combine it with " << fOutFileName << " using hadd" << endl;
+    } else {
+      Warning("Init", "Could not cut %s back to the checkpoint", output.Data());
+    }
+  }
+  Long64_t shift = 0;
+  if(fCountMode == kCountAll) {
+    shift = gHcCheckpoint->GetNCounted() - gHcCheckpoint->GetNControl();
+  } else if(fCountMode == kCountPhysics) {
+    shift = gHcCheckpoint->GetNCounted();
+  }				// kCountRaw: event numbers continue
+  fNevOffset = shift > 0 ? shift : 0;
+  fResuming = kTRUE;
+}
+
+//_____________________________________________________________________________
+void THcAnalyzer::SetBatchHistograms( Int_t blocksize, Int_t nthreads )
+{
+  /// Fill the histograms of the output definition file in blocks of
+  /// blocksize events, with nthreads threads (0: one per core), instead
+  /// of after every event.  The histograms are the same either way.
+  /// Must be called before Init.
+  if(!fHistBatch) fHistBatch = new THcHistBatch(blocksize, nthreads);
+  fHistBatch->SetBlockSize(blocksize);
+  fHistBatch->SetNThreads(nthreads);
+}
+
+//_____________________________________________________________________________
+Int_t THcAnalyzer::SetColumnOutput( const char* filename, const char* deffile,
+				    Int_t chunksize, Int_t nthreads )
+{
+  /// Also write the global variables selected by deffile to the
+  /// columnar file filename, in chunks of chunksize events encoded by
+  /// nthreads threads (0: one per core).  The file is kept open for all
+  /// runs of this analyzer.  Must be called before Init.
+  delete fColumnWriter;
+  fColumnWriter = new THcColumnWriter(filename, chunksize, nthreads);
+  AddRequestFile(deffile);	// For lazy output
+  return fColumnWriter->LoadDefinitions(deffile);
+}
+
+//_____________________________________________________________________________
+void THcAnalyzer::SetCheckpoint( const char* filename, Int_t interval )
+{
+  /// Save the run level state of the analysis to filename every
+  /// interval seconds, and resume from it when hcana is started with
+  /// --resume.  Must be called before Init, since the detectors define
+  /// their state in gHcCheckpoint when they are initialized.
+  delete gHcCheckpoint;
+  gHcCheckpoint = new THcCheckpoint(filename);
+  gHcCheckpoint->SetInterval(interval);
+}
+
+//_____________________________________________________________________________
+void THcAnalyzer::SetInitThreads( Int_t nthreads )
+{
+  /// Initialize the detectors of the spectrometers with nthreads threads
+  /// (0: one per core) at the start of each run, see THcInitScheduler.
+  /// 1 initializes them serially, as THaAnalyzer does.
+  if(nthreads == 1) {
+    delete fInitScheduler;
+    fInitScheduler = 0;
+    return;
+  }
+  if(!fInitScheduler) fInitScheduler = new THcInitScheduler;
+  fInitScheduler->SetNThreads(nthreads);
+}
+
+//_____________________________________________________________________________
+void THcAnalyzer::SetMemoryReport( Int_t interval )
+{
+  /// Print the memory of the apparatus, detectors, physics modules and
+  /// event type handlers, by category, at the end of each run, and
+  /// also every interval seconds if interval > 0.  Hit arrays keep
+  /// their size, so the end of run values are the largest of the run.
+  /// See THcMemoryReport.
+  if(!fMemoryReport) fMemoryReport = new THcMemoryReport;
+  fMemoryReport->SetInterval(interval);
+}
+
+//_____________________________________________________________________________
+Int_t THcAnalyzer::BeginAnalysis()
+{
+  /// After the Begin of all modules, which reset their run counters,
+  /// restore the state of the checkpoint read by Init when resuming.
+  /// The read-ahead depth is set on fRun, the copy of the run that
+  /// THaAnalyzer reads.  The startup timer, if any, stops here, after
+  /// the detector Init and just before the first event.
+  Int_t status = THaAnalyzer::BeginAnalysis();
+  THcRun* run = dynamic_cast<THcRun*>(fRun);
+  if(run && fReadAheadDepth > 0) run->SetReadAhead(fReadAheadDepth);
+  if(fStartupTimer) {
+    // Time to the first event, in the format of the benchmark summary
+    fStartupTimer->Stop();
+    printf("%-10s: Real Time = %6.2f seconds Cpu Time = %6.2f seconds\n",
+	   "Startup", fStartupTimer->RealTime(), fStartupTimer->CpuTime());
+    fStartupTimer = 0;
+  }
+  if(status != 0 || !fResuming || !run) return status;
+  fResuming = kFALSE;
+  if(gHcCheckpoint->Restore() != 0) {
+    Warning("BeginAnalysis", "Checkpoint state does not match the setup");
+  }
+  run->SkipEvents(gHcCheckpoint->GetNEvents());
+  return status;
+}
+
+//_____________________________________________________________________________
+Int_t THcAnalyzer::MainAnalysis()
+{
+  Int_t status = THaAnalyzer::MainAnalysis();
+  if(gHcCheckpoint && gHcCheckpoint->IsDue()) WriteCheckpoint();
+  if(fMemoryReport && fMemoryReport->IsDue()) {
+    fMemoryReport->Collect();
+    fMemoryReport->Print();
+  }
+  return status;
+}
+
+//_____________________________________________________________________________
+void THcAnalyzer::WriteCheckpoint()
+{
+  /// Write the output file, then the run level state, the number of
+  /// events read and the entries of the output trees, so that the
+  /// checkpoint never claims events the output does not have.  The
+  /// event count includes those counted before a resumed checkpoint.
+  THcRun* run = dynamic_cast<THcRun*>(fRun);
+  if(!gHcCheckpoint || !run || !fFile) return;
+  FlushOutput();
+  gHcCheckpoint->SetOutput(fFile->GetName());
+  TIter next(fFile->GetList());
+  while(TObject* obj = next()) {
+    TTree* tree = dynamic_cast<TTree*>(obj);
+    if(tree) gHcCheckpoint->SetTreeEntries(tree->GetName(), tree->GetEntries());
+  }
+  gHcCheckpoint->Write(run->GetNumber(), run->GetNEventsRead(),
+		       fNev + fNevOffset, run->GetNControlRead());
+}
+
+//_____________________________________________________________________________
+Int_t THcAnalyzer::PhysicsAnalysis( Int_t code )
+{
+  Int_t status = THaAnalyzer::PhysicsAnalysis(code);
+  if(fHistBatch && status == kOK) fHistBatch->Process();
+  if(fColumnWriter && status == kOK) fColumnWriter->Process();
+  return status;
+}
+
+//_____________________________________________________________________________
+Int_t THcAnalyzer::EndAnalysis()
+{
+  if(fHistBatch) fHistBatch->End();
+  if(fColumnWriter) fColumnWriter->End();
+  if(gHcCheckpoint) gHcCheckpoint->Remove(); // Run complete
+  THcRun* run = dynamic_cast<THcRun*>(fRun);
+  if(fReadAheadDepth > 0 && (!run || !run->IsReadAheadStarted())) {
+    Warning("EndAnalysis", "Read-ahead was requested, but no reader thread ran");
+  }
+  if(fMemoryReport) {		// Before the handlers drop their delayed events
+    fMemoryReport->Collect();
+    fMemoryReport->Print("all");
+  }
+  return THaAnalyzer::EndAnalysis();
+}
+
+//_____________________________________________________________________________
+void THcAnalyzer::AddRequestFile( const char* filename )
+{
+  /// Add a file (e.g. a report template) whose variable references
+  /// should be considered live in lazy output mode.
+  if(filename && *filename) fRequestFiles.push_back(filename);
+}
+
+//_____________________________________________________________________________
+void THcAnalyzer::ScanRequestFile( const char* filename )
+{
+  /// Extract everything that looks like a variable name from a
+  /// definition file.  Keywords, numbers and titles end up in the
+  /// list too, which is harmless.  Tokens containing * or ? (block
+  /// lines of the output definition) are kept as wildcard patterns.
+  if(!filename || !*filename) return;
+  ifstream ifile(filename);
+  if(!ifile.is_open()) {
+    cout << "THcAnalyzer: cannot open request file " << filename
+	 << ", assuming all outputs are needed" << endl;
+    fRequestedPatterns.push_back("*");
+    return;
+  }
+  for(string line; getline(ifile, line);) {
+    string::size_type comment = line.find('#');
+    if(comment != string::npos) line.erase(comment);
+    string token;
+    for(string::size_type i=0;i<=line.length();i++) {
+      char c = (i<line.length()) ? line[i] : ' ';
+      if(isalnum(c) || c=='_' || c=='.' || c=='*' || c=='?' || c=='$') {
+	token += c;
+	continue;
+      }
+      if(!token.empty()) {
+	if(token.find_first_of("*?") != string::npos) {
+	  fRequestedPatterns.push_back(token.c_str());
+	} else {
+	  fRequestedNames.insert(token);
+	}
+	token.clear();
+      }
+    }
+  }
+}
+
+//_____________________________________________________________________________
+Bool_t THcAnalyzer::IsRequested( const char* varname ) const
+{
+  if(fRequestedNames.find(varname) != fRequestedNames.end()) return kTRUE;
+  TString name(varname);
+  for(UInt_t i=0;i<fRequestedPatterns.size();i++) {
+    TRegexp re(fRequestedPatterns[i], kTRUE);
+    Ssiz_t len;
+    if(name.Index(re, &len) == 0 && len == name.Length()) return kTRUE;
+  }
+  return kFALSE;
+}
+
+//_____________________________________________________________________________
+Bool_t THcAnalyzer::IsOutputRequested( const char* varname )
+{
+  /// Return kTRUE if the global variable "varname" (full name including
+  /// prefix, e.g. "H.hod.1x.posTdcTimeRaw") may be used by the output,
+  /// the cuts or a request file.  Always kTRUE unless the analyzer is a
+  /// THcAnalyzer with lazy output enabled.
+  THcAnalyzer* analyzer = dynamic_cast<THcAnalyzer*>(THaAnalyzer::GetInstance());
+  if(!analyzer || !analyzer->IsLazyOutput()) return kTRUE;
+  return analyzer->IsRequested(varname);
 }
 
 //_____________________________________________________________________________
@@ -72,6 +483,7 @@ void THcAnalyzer::PrintReport(const char* templatefile, const char* ofile)
   }
 
   LoadInfo();			// Load some run information into gHcParms
+  THcRunStats::MergeAll();	// Bring the published counters up to date
 
   // In principle, we should allow braces to be escaped.  But for
   // now we won't.  Existing template files don't seem to output
@@ -101,9 +513,18 @@ void THcAnalyzer::PrintReport(const char* templatefile, const char* ofile)
 	if(format.empty()) format = "%s";
 	replacement=Form(format.c_str(),textstring);
       } else {
-	THcFormula* formula = new THcFormula("temp",expression.c_str(),gHcParms,gHaVars,gHaCuts);
+	// Compiled formulas are kept for the next report of this run
+	THcFormula* formula = fReportFormulas[expression];
+	if(!formula) {
+	  formula = new THcFormula("temp",expression.c_str(),gHcParms,gHaVars,gHaCuts);
+	}
 	Double_t value=formula->Eval();
-	delete formula; formula = 0;
+	if(formula->IsError()) {
+	  delete formula; formula = 0;
+	  fReportFormulas.erase(expression);
+	} else {
+	  fReportFormulas[expression] = formula;
+	}
 	// If the value is close to integer and no format is defined
 	// use "%.0f" to print out integer
 	if(format.empty()) {
@@ -130,6 +551,30 @@ void THcAnalyzer::PrintReport(const char* templatefile, const char* ofile)
   return;
 }
 
+//_____________________________________________________________________________
+void THcAnalyzer::ClearReportFormulas()
+{
+  for(map<string, THcFormula*>::iterator it=fReportFormulas.begin();
+      it!=fReportFormulas.end(); ++it) {
+    delete it->second;
+  }
+  fReportFormulas.clear();
+}
+
+//_____________________________________________________________________________
+void THcAnalyzer::FlushOutput()
+{
+  /// Write the output tree and histograms filled so far, so that the
+  /// output file can be looked at while the replay goes on (THcLiveRun).
+  /// Earlier copies of the objects in the file are replaced.
+  if(fColumnWriter) fColumnWriter->End();
+  if(!fFile || !fFile->IsWritable()) return;
+  if(fHistBatch) fHistBatch->Flush();
+  TDirectory::TContext ctxt(fFile);
+  fFile->Write(0, TObject::kOverwrite);
+  fFile->Flush();
+}
+
 //_____________________________________________________________________________
 void THcAnalyzer::LoadInfo()
 {
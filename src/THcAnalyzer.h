@@ -8,6 +8,19 @@
 //////////////////////////////////////////////////////////////////////////
 
 #include "THaAnalyzer.h"
+#include "TString.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+class THcHistBatch;
+class THcColumnWriter;
+class THcFormula;
+class THcInitScheduler;
+class THcMemoryReport;
+class TStopwatch;
 
 class THcAnalyzer : public THaAnalyzer {
 
@@ -19,11 +32,73 @@ public:
   void SetPedestalEvtype( Int_t evtype ) { fPedestalEvtype = evtype; }
 
   void PrintReport( const char* templatefile, const char* ofile);
+  void FlushOutput();
+
+  using THaAnalyzer::Init;
+  virtual Int_t Init( THaRunBase* run );
+  virtual void  Close();
+
+  // Only fill optional detector outputs that are referenced in the output
+  // definition, cut definition, or additional request files (e.g. report
+  // templates). Off by default.
+  void   SetLazyOutput( Bool_t lazy = kTRUE ) { fLazyOutput = lazy; }
+  Bool_t IsLazyOutput() const { return fLazyOutput; }
+  void   AddRequestFile( const char* filename );
+
+  static Bool_t IsOutputRequested( const char* varname );
+
+  void   SetBatchHistograms( Int_t blocksize = 1000, Int_t nthreads = 1 );
+  Int_t  SetColumnOutput( const char* filename, const char* deffile,
+			  Int_t chunksize = 4096, Int_t nthreads = 1 );
+  void   SetCheckpoint( const char* filename, Int_t interval = 60 );
+  void   WriteCheckpoint();
+
+  // Read up to depth events ahead in a separate thread, for runs that
+  // are THcRun objects (THcRun::SetReadAhead).  0 (default): off.
+  void   SetReadAhead( Int_t depth ) { fReadAheadDepth = depth; }
+  Int_t  GetReadAhead() const { return fReadAheadDepth; }
+
+  void   SetInitThreads( Int_t nthreads );
+  THcInitScheduler* GetInitScheduler() const { return fInitScheduler; }
+
+  void   SetMemoryReport( Int_t interval = 0 );
+  THcMemoryReport* GetMemoryReport() const { return fMemoryReport; }
+
+  // Stopped and printed when the event loop of the next run starts
+  void   SetStartupTimer( TStopwatch* timer ) { fStartupTimer = timer; }
 
 protected:
 
+  virtual Int_t BeginAnalysis();
+  virtual Int_t MainAnalysis();
+  virtual Int_t PhysicsAnalysis( Int_t code );
+  virtual Int_t EndAnalysis();
+
   Int_t fPedestalEvtype;
 
+  Bool_t fLazyOutput;                       // Skip unreferenced detector outputs
+  std::vector<TString> fRequestFiles;       // Extra files scanned for variables
+  std::set<std::string> fRequestedNames;    // Variable names referenced
+  std::vector<TString> fRequestedPatterns;  // Wildcard patterns (block lines)
+
+  THcHistBatch* fHistBatch;                 // Block filling of odef histograms
+  THcColumnWriter* fColumnWriter;           // Columnar output of variables
+  Int_t fReadAheadDepth;                    // Events read ahead by the run
+  THcInitScheduler* fInitScheduler;         // Concurrent detector Init
+  THcMemoryReport* fMemoryReport;           // Memory of the analysis objects
+  std::map<std::string, THcFormula*> fReportFormulas; // PrintReport expressions
+  UInt_t fNevOffset;                        // Events counted before the checkpoint
+  Bool_t fResuming;                         // Restore the checkpoint at Begin
+  TStopwatch* fStartupTimer;                // Time to the first event
+
+  void ClearReportFormulas();
+
+  Int_t InitRun( THaRunBase* run );
+  void  PrepareResume( THaRunBase* run );
+
+  void ScanRequestFile( const char* filename );
+  Bool_t IsRequested( const char* varname ) const;
+
 private:
   //  THcAnalyzer( const THcAnalyzer& );
   //  THcAnalyzer& operator=( const THcAnalyzer& );
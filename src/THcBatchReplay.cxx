@@ -0,0 +1,309 @@
+/** \class THcBatchReplay
+    \ingroup Base
+
+    \brief Replays a list of runs with one set of apparatus, detectors and maps.
+
+    Replaying the runs of a scan one hcana session per run rebuilds the
+    spectrometers and detectors, loads the complete parameter tree and
+    the detector map, and defines all global variables again for every
+    run.  THcBatchReplay keeps all of these for the whole list.  Before
+    each run it reads the parameter files for the new run number into a
+    scratch list and copies only the parameters whose values changed
+    into gHcParms.  Values are copied in place when the type and length
+    are the same, so pointers to them stay valid.  Parameters that were
+    only defined for the previous run are removed.  The detector map is
+    reloaded only when g_decode_map_filename changes.
+
+    Each run gets its own output file and reports, and the THcRunStats
+    counters are zeroed before each run, so the results are the same as
+    for separate replays.
+
+    Usage, after setting up the apparatus and the analyzer as usual:
+
+        THcBatchReplay* batch = new THcBatchReplay(analyzer);
+        batch->SetDatabase("DBASE/standard.database");
+        batch->AddParmFileFromString("g_ctp_parm_filename");
+        batch->AddParmFile("PARAM/hcana.param");
+        batch->SetRunFilePattern("raw/hms_all_%05d.dat");
+        batch->SetOutFilePattern("ROOTfiles/hms_replay_%d.root");
+        batch->AddReport("TEMPLATES/hstackana.template", "REPORTS/hms_%d.report");
+        batch->AddRuns(1230, 1260);
+        batch->Process();
+*/
+
+#include "THcBatchReplay.h"
+#include "THcAnalyzer.h"
+#include "THcRun.h"
+#include "THcParmList.h"
+#include "THcDetectorMap.h"
+#include "THcGlobals.h"
+#include "THcRunStats.h"
+#include "THaVar.h"
+#include "VarType.h"
+#include "TError.h"
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+//_____________________________________________________________________________
+THcBatchReplay::THcBatchReplay(THcAnalyzer* analyzer)
+  : fAnalyzer(analyzer), fNEvents(-1), fFirstEvent(1), fRunNumber(0), fLoadedRun(0),
+    fLoaded(0)
+{
+  // Constructor.  The analyzer must be set up (event, odef file, ...)
+  // except for the output file, which is set for each run.
+}
+
+//_____________________________________________________________________________
+THcBatchReplay::~THcBatchReplay()
+{
+  DeleteValues(fLoaded);
+  delete fLoaded;
+}
+
+//_____________________________________________________________________________
+void THcBatchReplay::AddParmFile(const char* filename, Bool_t byrun)
+{
+  /**
+     Load filename for every run.  With byrun, only the run number
+     blocks matching the run are used, as for the database file.
+  */
+  ParmFile pf;
+  pf.name = filename;
+  pf.byrun = byrun;
+  pf.fromstring = kFALSE;
+  fParmFiles.push_back(pf);
+}
+
+//_____________________________________________________________________________
+void THcBatchReplay::AddParmFileFromString(const char* parmname, Bool_t byrun)
+{
+  /**
+     Load the file named by the string parameter parmname (e.g.
+     g_ctp_parm_filename), as defined for the run by the files before it.
+  */
+  ParmFile pf;
+  pf.name = parmname;
+  pf.byrun = byrun;
+  pf.fromstring = kTRUE;
+  fParmFiles.push_back(pf);
+}
+
+//_____________________________________________________________________________
+void THcBatchReplay::AddReport(const char* templatefile, const char* ofilepattern)
+{
+  // Print a report from templatefile after each run.  ofilepattern is
+  // formatted with the run number.
+  fReportTemplates.push_back(templatefile);
+  fReportPatterns.push_back(ofilepattern);
+}
+
+//_____________________________________________________________________________
+void THcBatchReplay::AddRuns(Int_t first, Int_t last)
+{
+  for(Int_t run=first;run<=last;run++) {
+    fRuns.push_back(run);
+  }
+}
+
+//_____________________________________________________________________________
+Int_t THcBatchReplay::LoadParameters(Int_t run)
+{
+  /**
+     Bring gHcParms and gHcDetectorMap up to date for run.  Can be called
+     before setting up the apparatus, e.g. to make the crate map for the
+     first run.  Returns the number of parameters that changed.
+  */
+  if(run == fLoadedRun) return 0;
+  fRunNumber = run;
+
+  THcParmList* parms = new THcParmList;
+  parms->Define("gen_run_number", "Run Number", fRunNumber);
+  if(!fDatabaseFile.IsNull()) {
+    parms->AddString("g_ctp_database_filename", fDatabaseFile.Data());
+    parms->Load(fDatabaseFile.Data(), run);
+  }
+  for(UInt_t i=0;i<fParmFiles.size();i++) {
+    const ParmFile& pf = fParmFiles[i];
+    TString filename = pf.name;
+    if(pf.fromstring) {
+      const char* value = parms->GetString(pf.name.Data());
+      if(!value) {
+	::Warning("THcBatchReplay::LoadParameters",
+		  "Run %d: %s is not defined", run, pf.name.Data());
+	continue;
+      }
+      filename = value;
+    }
+    parms->Load(filename.Data(), pf.byrun ? run : 0);
+  }
+  parms->RemoveName("gen_run_number");
+
+  Int_t nchanged = ApplyParameters(parms);
+  THaVar* runvar = gHcParms->Find("gen_run_number");
+  if(!runvar) {
+    gHcParms->Define("gen_run_number", "Run Number", fRunNumber);
+  } else if(runvar->GetType() == kInt) {
+    *(Int_t*) runvar->GetValuePointer() = fRunNumber;
+  }
+
+  DeleteValues(fLoaded);
+  delete fLoaded;
+  fLoaded = parms;
+  fLoadedRun = run;
+
+  const char* mapfile = gHcParms->GetString("g_decode_map_filename");
+  if(mapfile && (!gHcDetectorMap || fMapFile != mapfile)) {
+    delete gHcDetectorMap;
+    gHcDetectorMap = new THcDetectorMap();
+    gHcDetectorMap->Load(mapfile);
+    fMapFile = mapfile;
+    nchanged++;
+  }
+  return nchanged;
+}
+
+//_____________________________________________________________________________
+Int_t THcBatchReplay::ApplyParameters(THcParmList* parms)
+{
+  // Copy the parameters of parms that differ into gHcParms and remove
+  // those only defined for the previous run
+  Int_t nchanged = 0;
+  TIter next(parms);
+  while(THaVar* var = static_cast<THaVar*>(next())) {
+    const char* name = var->GetName();
+    Int_t type = var->GetType();
+    Int_t len = var->GetLen();
+    if(type != kInt && type != kDouble) continue; // Load makes no others
+    size_t nbytes = len*(type == kInt ? sizeof(Int_t) : sizeof(Double_t));
+    const void* src = var->GetValuePointer();
+
+    THaVar* existing = gHcParms->Find(name);
+    if(existing && existing->GetType() == type && existing->GetLen() == len) {
+      void* dst = const_cast<void*>(existing->GetValuePointer());
+      if(memcmp(dst, src, nbytes) != 0) {
+	memcpy(dst, src, nbytes);
+	nchanged++;
+      }
+      continue;
+    }
+    if(existing) {
+      if(fLoaded && fLoaded->Find(name)) { // Storage made by us
+	if(existing->GetType() == kInt) {
+	  delete [] (Int_t*) existing->GetValuePointer();
+	} else if(existing->GetType() == kDouble) {
+	  delete [] (Double_t*) existing->GetValuePointer();
+	}
+      }
+      gHcParms->RemoveName(name);
+    }
+    TString defname = (len > 1) ? Form("%s[%d]", name, len) : name;
+    if(type == kInt) {
+      Int_t* ip = new Int_t[len];
+      memcpy(ip, src, nbytes);
+      gHcParms->Define(defname.Data(), var->GetTitle(), *ip);
+    } else {
+      Double_t* fp = new Double_t[len];
+      memcpy(fp, src, nbytes);
+      gHcParms->Define(defname.Data(), var->GetTitle(), *fp);
+    }
+    nchanged++;
+  }
+
+  const set<string>& strings = parms->GetStringNames();
+  for(set<string>::const_iterator it=strings.begin(); it!=strings.end(); ++it) {
+    const char* value = parms->GetString(*it);
+    const char* current = gHcParms->GetString(*it);
+    if(value && (!current || strcmp(current, value) != 0)) {
+      gHcParms->RemoveString(*it);
+      gHcParms->AddString(*it, value);
+      nchanged++;
+    }
+  }
+
+  if(fLoaded) {
+    TIter nextold(fLoaded);
+    while(THaVar* var = static_cast<THaVar*>(nextold())) {
+      const char* name = var->GetName();
+      if(parms->Find(name)) continue;
+      THaVar* existing = gHcParms->Find(name);
+      if(!existing) continue;
+      if(existing->GetType() == kInt) {
+	delete [] (Int_t*) existing->GetValuePointer();
+      } else if(existing->GetType() == kDouble) {
+	delete [] (Double_t*) existing->GetValuePointer();
+      }
+      gHcParms->RemoveName(name);
+      nchanged++;
+    }
+    const set<string>& oldstrings = fLoaded->GetStringNames();
+    for(set<string>::const_iterator it=oldstrings.begin(); it!=oldstrings.end(); ++it) {
+      if(strings.find(*it) == strings.end()) {
+	gHcParms->RemoveString(*it);
+	nchanged++;
+      }
+    }
+  }
+  return nchanged;
+}
+
+//_____________________________________________________________________________
+void THcBatchReplay::DeleteValues(THcParmList* parms)
+{
+  // Free the values of a scratch list, allocated by THcParmList::Load
+  if(!parms) return;
+  TIter next(parms);
+  while(THaVar* var = static_cast<THaVar*>(next())) {
+    if(var->GetType() == kInt) {
+      delete [] (Int_t*) var->GetValuePointer();
+    } else if(var->GetType() == kDouble) {
+      delete [] (Double_t*) var->GetValuePointer();
+    }
+  }
+}
+
+//_____________________________________________________________________________
+Int_t THcBatchReplay::Process()
+{
+  /**
+     Replay all runs.  Returns the number of runs that failed.
+  */
+  if(!fAnalyzer) {
+    ::Error("THcBatchReplay::Process", "No analyzer");
+    return fRuns.size();
+  }
+  Int_t nfailed = 0;
+  for(UInt_t irun=0;irun<fRuns.size();irun++) {
+    Int_t runnum = fRuns[irun];
+    Int_t nchanged = LoadParameters(runnum);
+    cout << "THcBatchReplay: run " << runnum << " (" << irun+1 << " of "
+	 << fRuns.size() << "), " << nchanged << " parameters changed" << endl;
+    THcRunStats::ResetAll();
+
+    THcRun* run = new THcRun(Form(fRunFilePattern.Data(), runnum));
+    run->SetRunParamClass("THcRunParameters");
+    if(fNEvents > 0) {
+      run->SetEventRange(fFirstEvent, fFirstEvent+fNEvents-1);
+    } else if(fFirstEvent > 1) {
+      run->SetFirstEvent(fFirstEvent);
+    }
+    if(!fOutFilePattern.IsNull()) {
+      fAnalyzer->SetOutFile(Form(fOutFilePattern.Data(), runnum));
+    }
+    if(fAnalyzer->Process(run) < 0) {
+      ::Error("THcBatchReplay::Process", "Replay of run %d failed", runnum);
+      nfailed++;
+    } else {
+      for(UInt_t irep=0;irep<fReportTemplates.size();irep++) {
+	fAnalyzer->PrintReport(fReportTemplates[irep].Data(),
+			       Form(fReportPatterns[irep].Data(), runnum));
+      }
+    }
+    fAnalyzer->Close();		// Finish this run's output file
+    delete run;
+  }
+  return nfailed;
+}
+
+ClassImp(THcBatchReplay)
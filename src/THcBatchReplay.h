@@ -0,0 +1,76 @@
+#ifndef ROOT_THcBatchReplay
+#define ROOT_THcBatchReplay
+
+//////////////////////////////////////////////////////////////////////////
+//
+// THcBatchReplay
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "Rtypes.h"
+#include "TString.h"
+#include <vector>
+
+class THcAnalyzer;
+class THcParmList;
+
+class THcBatchReplay {
+
+public:
+
+  THcBatchReplay(THcAnalyzer* analyzer);
+  virtual ~THcBatchReplay();
+
+  // Parameter files, loaded in the order given for every run
+  void   SetDatabase(const char* filename) {fDatabaseFile = filename;}
+  void   AddParmFile(const char* filename, Bool_t byrun=kFALSE);
+  void   AddParmFileFromString(const char* parmname, Bool_t byrun=kFALSE);
+
+  void   SetRunFilePattern(const char* pattern) {fRunFilePattern = pattern;}
+  void   SetOutFilePattern(const char* pattern) {fOutFilePattern = pattern;}
+  void   AddReport(const char* templatefile, const char* ofilepattern);
+  void   SetNEvents(Int_t nevents) {fNEvents = nevents;}
+  void   SetFirstEvent(Int_t first) {fFirstEvent = first;}
+
+  void   AddRun(Int_t run) {fRuns.push_back(run);}
+  void   AddRuns(Int_t first, Int_t last);
+
+  Int_t  LoadParameters(Int_t run);
+  Int_t  Process();
+
+  // A parameter file to load, or a string parameter naming it
+  struct ParmFile {
+    TString name;
+    Bool_t  byrun;		// Load with the run number (run range blocks)
+    Bool_t  fromstring;		// name is a string parameter
+  };
+
+protected:
+
+  Int_t  ApplyParameters(THcParmList* parms);
+  static void DeleteValues(THcParmList* parms);
+
+  THcAnalyzer* fAnalyzer;
+  TString  fDatabaseFile;	// Run number database, loaded first
+  std::vector<ParmFile> fParmFiles;
+  TString  fRunFilePattern;
+  TString  fOutFilePattern;
+  std::vector<TString> fReportTemplates;
+  std::vector<TString> fReportPatterns;
+  Int_t    fNEvents;		// Events per run, all if <= 0
+  Int_t    fFirstEvent;		// First physics event analyzed
+  std::vector<Int_t> fRuns;
+
+  Int_t    fRunNumber;		// gen_run_number
+  Int_t    fLoadedRun;		// Run the parameters are loaded for, 0 if none
+  THcParmList* fLoaded;		// Parameters of fLoadedRun as read from the files
+  TString  fMapFile;		// Loaded gHcDetectorMap file
+
+private:
+  THcBatchReplay(const THcBatchReplay&);
+  THcBatchReplay& operator=(const THcBatchReplay&);
+
+  ClassDef(THcBatchReplay,0)	// Replay of many runs with one set of detectors
+};
+
+#endif
@@ -0,0 +1,446 @@
+/** \class THcCheckpoint
+    \ingroup Base
+
+    \brief Periodic snapshot of the run level analysis state, for resuming a replay.
+
+    Analysis objects define the storage of their run level state
+    (pedestal accumulators, helicity prediction state, scaler history,
+    ...) when they allocate it, much like global variables:
+
+        if(gHcCheckpoint) gHcCheckpoint->Define(prefix+"PedSum", fPedSum, fNelem);
+
+    and remove it with RemovePrefix when they are deleted.  The
+    THcRunStats counters (efficiencies) are always included.
+
+    THcAnalyzer::SetCheckpoint creates gHcCheckpoint.  During the replay
+    the analyzer calls Write every interval seconds, at an event
+    boundary: the output file is written first, then the state and the
+    number of CODA events read so far go to a temporary file which is
+    renamed to the checkpoint file, so a crash never leaves a partial
+    checkpoint.  Writing copies a few kB, which is negligible at
+    intervals of a minute.
+
+    With hcana --resume (or THcCheckpoint::SetResume()), the analyzer
+    reads the checkpoint after Begin, copies the state back into the
+    defined storage and skips the CODA events already analyzed, except
+    for control and configuration events.  The remaining events are
+    analyzed as in an uninterrupted replay; their output goes to the
+    output file of the resumed replay, to be combined with the first
+    one with hadd.  The checkpoint also records the entries of the
+    trees of the first output file, and TruncateOutput cuts them back
+    to those, so that the events written after the checkpoint (tree
+    autosaves) are not in both files.  The event count of the analyzer
+    at the checkpoint is recorded as well, so that the resumed replay
+    counts the skipped events against the event range of the run.  The
+    checkpoint file is deleted when the run ends normally.  The file
+    contains the values in the byte order of the machine, so it is only
+    meant for the same installation.
+*/
+
+#include "THcCheckpoint.h"
+#include "THcRunStats.h"
+#include "TError.h"
+#include "TFile.h"
+#include "TKey.h"
+#include "TTree.h"
+#include "TSystem.h"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <unistd.h>
+
+using namespace std;
+
+Bool_t THcCheckpoint::fgResume = kFALSE;
+
+static const char kCheckpointMagic[8] = {'H','C','C','K','P','T','0','2'};
+
+//_____________________________________________________________________________
+static void WriteString(const TString& s, FILE* f)
+{
+  UInt_t len = s.Length();
+  fwrite(&len, sizeof(len), 1, f);
+  fwrite(s.Data(), 1, len, f);
+}
+
+//_____________________________________________________________________________
+static Bool_t ReadString(TString& s, FILE* f)
+{
+  UInt_t len;
+  if(fread(&len, sizeof(len), 1, f) != 1 || len >= 1024) return kFALSE;
+  vector<char> buf(len+1, 0);
+  if(len > 0 && fread(&buf[0], 1, len, f) != len) return kFALSE;
+  s = &buf[0];
+  return kTRUE;
+}
+
+//_____________________________________________________________________________
+THcCheckpoint::THcCheckpoint(const char* filename)
+  : fFileName(filename), fInterval(60), fLastWrite(time(0)), fNCalls(0),
+    fRunNumber(0), fNEvents(0), fNCounted(0), fNControl(0)
+{
+}
+
+//_____________________________________________________________________________
+THcCheckpoint::~THcCheckpoint()
+{
+}
+
+//_____________________________________________________________________________
+size_t THcCheckpoint::ElementSize(Int_t type)
+{
+  switch(type) {
+  case kStInt: case kStIntV:       return sizeof(Int_t);
+  case kStUInt: case kStUIntV:     return sizeof(UInt_t);
+  case kStLong64:                  return sizeof(Long64_t);
+  case kStFloat:                   return sizeof(Float_t);
+  case kStDouble: case kStDoubleV: return sizeof(Double_t);
+  case kStBool:                    return sizeof(Bool_t);
+  }
+  return 0;
+}
+
+//_____________________________________________________________________________
+void THcCheckpoint::Add(const char* name, Int_t type, void* ptr, Int_t n)
+{
+  // Define (or redefine, e.g. after storage was reallocated in a new
+  // Init) the storage called name
+  for(UInt_t i=0;i<fEntries.size();i++) {
+    if(fEntries[i].name == name) {
+      fEntries[i].type = type;
+      fEntries[i].ptr = ptr;
+      fEntries[i].n = n;
+      return;
+    }
+  }
+  Entry e;
+  e.name = name;
+  e.type = type;
+  e.ptr = ptr;
+  e.n = n;
+  fEntries.push_back(e);
+}
+
+//_____________________________________________________________________________
+void THcCheckpoint::RemovePrefix(const char* prefix)
+{
+  // Forget all storage whose name starts with prefix
+  vector<Entry> kept;
+  for(UInt_t i=0;i<fEntries.size();i++) {
+    if(!fEntries[i].name.BeginsWith(prefix)) kept.push_back(fEntries[i]);
+  }
+  fEntries.swap(kept);
+}
+
+//_____________________________________________________________________________
+void THcCheckpoint::SetTreeEntries(const char* tree, Long64_t n)
+{
+  // Entries of the output tree called tree, for the next Write
+  for(UInt_t i=0;i<fTrees.size();i++) {
+    if(fTrees[i].first == tree) {
+      fTrees[i].second = n;
+      return;
+    }
+  }
+  fTrees.push_back(make_pair(TString(tree), n));
+}
+
+//_____________________________________________________________________________
+Long64_t THcCheckpoint::GetTreeEntries(const char* tree) const
+{
+  // Entries of tree at the checkpoint, -1 if it was not recorded
+  for(UInt_t i=0;i<fTrees.size();i++) {
+    if(fTrees[i].first == tree) return fTrees[i].second;
+  }
+  return -1;
+}
+
+//_____________________________________________________________________________
+Int_t THcCheckpoint::TruncateOutput(const char* target)
+{
+  /**
+     Copy the output file of the checkpoint read to target, which may be
+     the same file, with its trees cut back to the entries they had at
+     the checkpoint.  Trees not recorded did not exist then and are
+     left empty.  Of the other objects, the last cycle is copied.
+     Returns 0, or -1 if the file can not be copied.
+  */
+  if(fOutputFile.IsNull()) return 0;
+  TFile* in = TFile::Open(fOutputFile, "READ");
+  if(!in || in->IsZombie()) {
+    ::Error("THcCheckpoint::TruncateOutput", "Can not open %s", fOutputFile.Data());
+    delete in;
+    return -1;
+  }
+  TString tmpname = TString(target) + ".tmp";
+  TFile* out = TFile::Open(tmpname, "RECREATE");
+  if(!out || out->IsZombie()) {
+    ::Error("THcCheckpoint::TruncateOutput", "Can not create %s", tmpname.Data());
+    delete out;
+    delete in;
+    return -1;
+  }
+  TIter next(in->GetListOfKeys());
+  while(TKey* key = static_cast<TKey*>(next())) {
+    if(key->GetCycle() != in->GetKey(key->GetName())->GetCycle()) continue;
+    TObject* obj = key->ReadObj();
+    if(!obj) continue;
+    out->cd();
+    TTree* tree = dynamic_cast<TTree*>(obj);
+    if(tree) {
+      Long64_t n = GetTreeEntries(key->GetName());
+      TTree* cut = tree->CloneTree(n < 0 ? 0 : n);
+      cout << "THcCheckpoint: tree " << key->GetName() << " of "
+	   << fOutputFile << " cut from " << tree->GetEntries() << " to "
+	   << cut->GetEntries() << " entries" << endl;
+      cut->Write(key->GetName(), TObject::kOverwrite);
+      delete cut;
+    } else {
+      obj->Write(key->GetName(), TObject::kOverwrite);
+    }
+    delete obj;
+  }
+  out->Close();
+  delete out;
+  in->Close();
+  delete in;
+  if(gSystem->Rename(tmpname, target) != 0) {
+    ::Error("THcCheckpoint::TruncateOutput", "Can not write %s", target);
+    gSystem->Unlink(tmpname);
+    return -1;
+  }
+  return 0;
+}
+
+//_____________________________________________________________________________
+Bool_t THcCheckpoint::IsDue()
+{
+  // True once the interval has passed since the last checkpoint.  The
+  // clock is only read every 100 calls.
+  if(fInterval <= 0 || ++fNCalls < 100) return kFALSE;
+  fNCalls = 0;
+  return difftime(time(0), fLastWrite) >= fInterval;
+}
+
+//_____________________________________________________________________________
+Int_t THcCheckpoint::Write(Int_t run, Long64_t nevents, Long64_t ncounted,
+			   Long64_t ncontrol)
+{
+  /**
+     Write the current state, with the run number, the number of CODA
+     events read so far, the events counted by the analyzer, the control
+     events among those read, and the output file set with SetOutput.
+     Returns 0, or -1 if the file can not be written (the previous
+     checkpoint is then kept).
+  */
+  fLastWrite = time(0);
+  fNCalls = 0;
+  THcRunStats::SaveAll(fRunStats);
+
+  TString tmpname = fFileName + ".tmp";
+  FILE* f = fopen(tmpname.Data(), "wb");
+  if(!f) {
+    ::Error("THcCheckpoint::Write", "Can not create %s", tmpname.Data());
+    return -1;
+  }
+  UInt_t nentries = fEntries.size();
+  UInt_t nstats = fRunStats.size();
+  fwrite(kCheckpointMagic, 1, sizeof(kCheckpointMagic), f);
+  fwrite(&run, sizeof(run), 1, f);
+  fwrite(&nevents, sizeof(nevents), 1, f);
+  fwrite(&ncounted, sizeof(ncounted), 1, f);
+  fwrite(&ncontrol, sizeof(ncontrol), 1, f);
+  WriteString(fOutputFile, f);
+  UInt_t ntrees = fTrees.size();
+  fwrite(&ntrees, sizeof(ntrees), 1, f);
+  for(UInt_t i=0;i<ntrees;i++) {
+    WriteString(fTrees[i].first, f);
+    fwrite(&fTrees[i].second, sizeof(Long64_t), 1, f);
+  }
+  fwrite(&nstats, sizeof(nstats), 1, f);
+  if(nstats > 0) fwrite(&fRunStats[0], sizeof(Int_t), nstats, f);
+  fwrite(&nentries, sizeof(nentries), 1, f);
+  for(UInt_t i=0;i<fEntries.size();i++) {
+    const Entry& e = fEntries[i];
+    UInt_t len = e.name.Length();
+    const void* src = e.ptr;
+    UInt_t n = e.n;
+    switch(e.type) {		// Vectors: current size and contents
+    case kStIntV:
+      n = static_cast<vector<Int_t>*>(e.ptr)->size();
+      if(n > 0) src = &(*static_cast<vector<Int_t>*>(e.ptr))[0];
+      break;
+    case kStUIntV:
+      n = static_cast<vector<UInt_t>*>(e.ptr)->size();
+      if(n > 0) src = &(*static_cast<vector<UInt_t>*>(e.ptr))[0];
+      break;
+    case kStDoubleV:
+      n = static_cast<vector<Double_t>*>(e.ptr)->size();
+      if(n > 0) src = &(*static_cast<vector<Double_t>*>(e.ptr))[0];
+      break;
+    }
+    fwrite(&len, sizeof(len), 1, f);
+    fwrite(e.name.Data(), 1, len, f);
+    fwrite(&e.type, sizeof(e.type), 1, f);
+    fwrite(&n, sizeof(n), 1, f);
+    if(n > 0) fwrite(src, ElementSize(e.type), n, f);
+  }
+  Bool_t ok = (fflush(f) == 0 && fsync(fileno(f)) == 0);
+  ok = (fclose(f) == 0) && ok;
+  if(!ok || rename(tmpname.Data(), fFileName.Data()) != 0) {
+    ::Error("THcCheckpoint::Write", "Can not write %s", fFileName.Data());
+    unlink(tmpname.Data());
+    return -1;
+  }
+  cout << "THcCheckpoint: run " << run << ", " << nevents
+       << " events, state written to " << fFileName << endl;
+  return 0;
+}
+
+//_____________________________________________________________________________
+Int_t THcCheckpoint::Read()
+{
+  /**
+     Read the checkpoint file.  Returns 0, or -1 if there is no
+     complete checkpoint.
+  */
+  fSaved.clear();
+  fRunStats.clear();
+  fTrees.clear();
+  fOutputFile = "";
+  FILE* f = fopen(fFileName.Data(), "rb");
+  if(!f) return -1;
+  char magic[8];
+  UInt_t nstats = 0, nentries = 0, ntrees = 0;
+  Bool_t ok = (fread(magic, 1, 8, f) == 8 &&
+	       memcmp(magic, kCheckpointMagic, 8) == 0 &&
+	       fread(&fRunNumber, sizeof(fRunNumber), 1, f) == 1 &&
+	       fread(&fNEvents, sizeof(fNEvents), 1, f) == 1 &&
+	       fread(&fNCounted, sizeof(fNCounted), 1, f) == 1 &&
+	       fread(&fNControl, sizeof(fNControl), 1, f) == 1 &&
+	       ReadString(fOutputFile, f) &&
+	       fread(&ntrees, sizeof(ntrees), 1, f) == 1);
+  for(UInt_t i=0;i<ntrees && ok;i++) {
+    TString name;
+    Long64_t n;
+    ok = ReadString(name, f) && fread(&n, sizeof(n), 1, f) == 1;
+    if(ok) fTrees.push_back(make_pair(name, n));
+  }
+  ok = ok && fread(&nstats, sizeof(nstats), 1, f) == 1;
+  if(ok) {
+    fRunStats.resize(nstats);
+    ok = (nstats == 0 || fread(&fRunStats[0], sizeof(Int_t), nstats, f) == nstats) &&
+      fread(&nentries, sizeof(nentries), 1, f) == 1;
+  }
+  for(UInt_t i=0;i<nentries && ok;i++) {
+    Entry e;
+    UInt_t len, n;
+    ok = (fread(&len, sizeof(len), 1, f) == 1 && len < 1024);
+    if(!ok) break;
+    vector<char> name(len+1, 0);
+    ok = (fread(&name[0], 1, len, f) == len &&
+	  fread(&e.type, sizeof(e.type), 1, f) == 1 &&
+	  fread(&n, sizeof(n), 1, f) == 1 && ElementSize(e.type) > 0);
+    if(!ok) break;
+    e.name = &name[0];
+    e.ptr = 0;
+    e.n = n;
+    e.data.resize(n*ElementSize(e.type));
+    ok = (e.data.empty() || fread(&e.data[0], 1, e.data.size(), f) == e.data.size());
+    fSaved.push_back(e);
+  }
+  fclose(f);
+  if(!ok) {
+    ::Error("THcCheckpoint::Read", "%s is corrupt", fFileName.Data());
+    fSaved.clear();
+    fRunStats.clear();
+    fTrees.clear();
+    return -1;
+  }
+  return 0;
+}
+
+//_____________________________________________________________________________
+Int_t THcCheckpoint::Restore()
+{
+  /**
+     Copy the state read from the file into the defined storage.
+     Returns the number of problems: saved state without storage,
+     storage without saved state, and arrays whose size changed.
+  */
+  Int_t nproblems = 0;
+  if(!THcRunStats::RestoreAll(fRunStats)) {
+    ::Warning("THcCheckpoint::Restore", "THcRunStats counters differ, not restored");
+    nproblems++;
+  }
+  vector<Bool_t> used(fEntries.size(), kFALSE);
+  for(UInt_t is=0;is<fSaved.size();is++) {
+    const Entry& s = fSaved[is];
+    UInt_t i;
+    for(i=0;i<fEntries.size();i++) {
+      if(fEntries[i].name == s.name) break;
+    }
+    if(i == fEntries.size() || fEntries[i].type != s.type) {
+      ::Warning("THcCheckpoint::Restore", "No storage for %s", s.name.Data());
+      nproblems++;
+      continue;
+    }
+    Entry& e = fEntries[i];
+    used[i] = kTRUE;
+    void* dst = e.ptr;
+    switch(e.type) {
+    case kStIntV:
+      static_cast<vector<Int_t>*>(e.ptr)->resize(s.n);
+      dst = (s.n > 0) ? &(*static_cast<vector<Int_t>*>(e.ptr))[0] : 0;
+      break;
+    case kStUIntV:
+      static_cast<vector<UInt_t>*>(e.ptr)->resize(s.n);
+      dst = (s.n > 0) ? &(*static_cast<vector<UInt_t>*>(e.ptr))[0] : 0;
+      break;
+    case kStDoubleV:
+      static_cast<vector<Double_t>*>(e.ptr)->resize(s.n);
+      dst = (s.n > 0) ? &(*static_cast<vector<Double_t>*>(e.ptr))[0] : 0;
+      break;
+    default:
+      if(e.n != s.n) {
+	::Warning("THcCheckpoint::Restore", "%s has %d elements, %d saved",
+		  e.name.Data(), e.n, s.n);
+	nproblems++;
+	continue;
+      }
+    }
+    if(!s.data.empty()) memcpy(dst, &s.data[0], s.data.size());
+  }
+  for(UInt_t i=0;i<fEntries.size();i++) {
+    if(!used[i]) {
+      ::Warning("THcCheckpoint::Restore", "%s not in checkpoint",
+		fEntries[i].name.Data());
+      nproblems++;
+    }
+  }
+  cout << "THcCheckpoint: run " << fRunNumber << " restored from "
+       << fFileName << ", resuming after " << fNEvents << " events" << endl;
+  return nproblems;
+}
+
+//_____________________________________________________________________________
+void THcCheckpoint::Remove()
+{
+  // Delete the checkpoint file, e.g. when the run is complete
+  unlink(fFileName.Data());
+}
+
+//_____________________________________________________________________________
+void THcCheckpoint::Print() const
+{
+  cout << "Checkpoint " << fFileName << ", every " << fInterval << " s, "
+       << fEntries.size() << " state blocks" << endl;
+  for(UInt_t i=0;i<fEntries.size();i++) {
+    const Entry& e = fEntries[i];
+    cout << "  " << e.name;
+    if(e.n > 1) cout << "[" << e.n << "]";
+    cout << endl;
+  }
+}
+
+ClassImp(THcCheckpoint)
@@ -0,0 +1,103 @@
+#ifndef ROOT_THcCheckpoint
+#define ROOT_THcCheckpoint
+
+//////////////////////////////////////////////////////////////////////////
+//
+// THcCheckpoint
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "Rtypes.h"
+#include "TString.h"
+#include <vector>
+#include <utility>
+#include <ctime>
+
+class THcCheckpoint {
+
+public:
+
+  THcCheckpoint(const char* filename);
+  virtual ~THcCheckpoint();
+
+  // Run level state of analysis objects, defined where it is allocated
+  void   Define(const char* name, Int_t* p, Int_t n=1)    {Add(name, kStInt, p, n);}
+  void   Define(const char* name, UInt_t* p, Int_t n=1)   {Add(name, kStUInt, p, n);}
+  void   Define(const char* name, Long64_t* p, Int_t n=1) {Add(name, kStLong64, p, n);}
+  void   Define(const char* name, ULong64_t* p, Int_t n=1) {Add(name, kStLong64, p, n);}
+  void   Define(const char* name, Float_t* p, Int_t n=1)  {Add(name, kStFloat, p, n);}
+  void   Define(const char* name, Double_t* p, Int_t n=1) {Add(name, kStDouble, p, n);}
+  void   Define(const char* name, Bool_t* p, Int_t n=1)   {Add(name, kStBool, p, n);}
+  void   Define(const char* name, std::vector<Int_t>* p)    {Add(name, kStIntV, p, -1);}
+  void   Define(const char* name, std::vector<UInt_t>* p)   {Add(name, kStUIntV, p, -1);}
+  void   Define(const char* name, std::vector<Double_t>* p) {Add(name, kStDoubleV, p, -1);}
+  void   RemovePrefix(const char* prefix);
+
+  void   SetInterval(Int_t seconds) {fInterval = seconds;}
+  Int_t  GetInterval() const        {return fInterval;}
+  Bool_t IsDue();
+  // Output file of the replay and the entries of its trees, to be
+  // recorded by the next Write
+  void   SetOutput(const char* filename) {fOutputFile = filename; fTrees.clear();}
+  void   SetTreeEntries(const char* tree, Long64_t n);
+  Long64_t GetTreeEntries(const char* tree) const;
+  const char* GetOutputFile() const {return fOutputFile.Data();}
+  Int_t  TruncateOutput(const char* target);
+
+  Int_t  Write(Int_t run, Long64_t nevents, Long64_t ncounted=0,
+	       Long64_t ncontrol=0);
+  Int_t  Read();
+  Int_t  Restore();
+  void   Remove();
+  Long64_t GetNEvents() const {return fNEvents;}
+  Long64_t GetNCounted() const {return fNCounted;}
+  Long64_t GetNControl() const {return fNControl;}
+  Int_t  GetRunNumber() const {return fRunNumber;}
+  const char* GetFileName() const {return fFileName.Data();}
+  void   Print() const;
+
+  // Set by hcana --resume
+  static void   SetResume(Bool_t resume=kTRUE) {fgResume = resume;}
+  static Bool_t IsResume() {return fgResume;}
+
+  enum EStateType { kStInt, kStUInt, kStLong64, kStFloat, kStDouble, kStBool,
+		    kStIntV, kStUIntV, kStDoubleV };
+
+  // One block of registered storage, or its contents as read from file
+  struct Entry {
+    TString  name;
+    Int_t    type;		// EStateType
+    void*    ptr;		// Storage, 0 for entries read from file
+    Int_t    n;			// Elements, -1 for vectors
+    std::vector<char> data;	// Saved bytes
+  };
+
+protected:
+
+  void   Add(const char* name, Int_t type, void* ptr, Int_t n);
+  static size_t ElementSize(Int_t type);
+
+  TString  fFileName;
+  Int_t    fInterval;		// Seconds between checkpoints
+  time_t   fLastWrite;
+  Int_t    fNCalls;		// IsDue calls since the clock was read
+  Int_t    fRunNumber;		// Of the checkpoint read
+  Long64_t fNEvents;		// CODA events read at the checkpoint
+  Long64_t fNCounted;		// Events counted by the analyzer
+  Long64_t fNControl;		// Control events among those read
+  TString  fOutputFile;		// Output file of the replay
+  std::vector<std::pair<TString,Long64_t> > fTrees; // Its trees and entries
+  std::vector<Entry> fEntries;	// Registered storage
+  std::vector<Entry> fSaved;	// Read from the file
+  std::vector<Int_t> fRunStats;	// THcRunStats counters
+
+  static Bool_t fgResume;
+
+private:
+  THcCheckpoint(const THcCheckpoint&);
+  THcCheckpoint& operator=(const THcCheckpoint&);
+
+  ClassDef(THcCheckpoint,0)	// Periodic snapshot of run level analysis state
+};
+
+#endif
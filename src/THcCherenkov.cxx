@@ -16,6 +16,7 @@
 #include "THaCutList.h"
 #include "THcParmList.h"
 #include "THcHitList.h"
+#include "THcMemoryReport.h"
 #include "THaApparatus.h"
 #include "VarDef.h"
 #include "VarType.h"
@@ -695,5 +696,31 @@ Int_t THcCherenkov::End(THaRunBase* run)
   MissReport(Form("%s.%s", GetApparatus()->GetName(), GetName()));
   return 0;
 }
+
+//_____________________________________________________________________________
+void THcCherenkov::AccountMemory( THcMemoryReport& report ) const
+{
+  // Raw hits, the signal hit arrays, which grow with the largest
+  // event, and the per PMT arrays sized at Init
+  THcHitList::AccountMemory(report);
+  const TClonesArray* signals[] = {
+    frAdcPedRaw, frAdcPulseIntRaw, frAdcPulseAmpRaw, frAdcPulseTimeRaw,
+    frAdcPed, frAdcPulseInt, frAdcPulseAmp, frAdcPulseTime, fAdcErrorFlag
+  };
+  Long64_t bytes = 0;
+  for(UInt_t i=0;i<sizeof(signals)/sizeof(signals[0]);i++) {
+    bytes += THcMemoryReport::Bytes(signals[i]);
+  }
+  report.Add("signal hits", bytes, THcMemoryReport::kDynamic);
+  bytes = THcMemoryReport::Bytes(fNumAdcHits) + THcMemoryReport::Bytes(fNumGoodAdcHits)
+    + THcMemoryReport::Bytes(fNumTracksMatched) + THcMemoryReport::Bytes(fNumTracksFired)
+    + THcMemoryReport::Bytes(fGoodAdcPed) + THcMemoryReport::Bytes(fGoodAdcMult)
+    + THcMemoryReport::Bytes(fGoodAdcHitUsed) + THcMemoryReport::Bytes(fGoodAdcPulseInt)
+    + THcMemoryReport::Bytes(fGoodAdcPulseIntRaw) + THcMemoryReport::Bytes(fGoodAdcPulseAmp)
+    + THcMemoryReport::Bytes(fGoodAdcPulseTime) + THcMemoryReport::Bytes(fGoodAdcTdcDiffTime)
+    + THcMemoryReport::Bytes(fNpe);
+  report.Add("good hits", bytes, THcMemoryReport::kStatic);
+}
+
 ClassImp(THcCherenkov)
 ////////////////////////////////////////////////////////////////////////////////
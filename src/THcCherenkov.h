@@ -28,6 +28,7 @@ class THcCherenkov : public THaNonTrackingDetector, public THcHitList {
   virtual Int_t   DefineVariables(EMode mode = kDefine);
   virtual Int_t   CoarseProcess(TClonesArray& tracks);
   virtual Int_t   FineProcess(TClonesArray& tracks);
+  virtual void    AccountMemory(THcMemoryReport& report) const;
   virtual Int_t   ApplyCorrections( void );
   virtual EStatus Init(const TDatime& run_time);
   Int_t           End(THaRunBase* run);
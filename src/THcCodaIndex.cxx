@@ -0,0 +1,442 @@
+/** \class THcCodaIndex
+    \ingroup Base
+
+    \brief Index of the events of a CODA file: offset, length, type and
+    event number of every event.
+
+    The index is built by one walk over the block and event headers of
+    the memory mapped file; no event data is read.  It is kept in a
+    sidecar file next to the CODA file (run.dat -> run.dat.idx, 24 bytes
+    per event) and reused as long as the size and modification time of
+    the CODA file are unchanged.
+
+    With the index, THcIndexedRun reads any range of events directly,
+    and Split cuts a run into ranges of about equal size that
+    independent readers can replay in parallel:
+
+        THcCodaIndex index;
+        index.Load("raw/shms_all_01234.dat");   // Read or build the index
+        std::vector<Long64_t> bounds;
+        index.Split(4, bounds);                  // 5 boundaries for 4 ranges
+
+    See examples/indexedreplay.C.  evio version 1-3 (events may span
+    blocks) and version 4 files in either byte order are understood.
+*/
+
+#include "THcCodaIndex.h"
+#include "TMath.h"
+#include "TString.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+
+using namespace std;
+
+static const UInt_t kEvioMagic = 0xc0da0100;
+static const UInt_t kIndexMagic = 0x58494348; // "HCIX"
+static const UInt_t kIndexVersion = 1;
+
+static inline UInt_t SwapWord(UInt_t w)
+{
+  return ((w>>24)&0xff) | ((w>>8)&0xff00) | ((w<<8)&0xff0000) | (w<<24);
+}
+
+// Header of the sidecar file, followed by the entries
+struct IndexFileHeader {
+  UInt_t   magic;
+  UInt_t   version;
+  Long64_t filesize;
+  Long64_t filetime;
+  Int_t    evio;
+  Int_t    swapped;
+  Long64_t nevents;
+};
+
+//_____________________________________________________________________________
+THcCodaIndex::THcCodaIndex()
+  : fFileSize(0), fFileTime(0), fVersion(0), fSwapped(kFALSE)
+{
+}
+
+//_____________________________________________________________________________
+THcCodaIndex::~THcCodaIndex()
+{
+}
+
+//_____________________________________________________________________________
+void THcCodaIndex::Clear(Option_t*)
+{
+  fCodaFile = "";
+  fFileSize = fFileTime = 0;
+  fVersion = 0;
+  fSwapped = kFALSE;
+  fEntries.clear();
+}
+
+//_____________________________________________________________________________
+TString THcCodaIndex::IndexFileName(const char* codafile)
+{
+  return TString(codafile) + ".idx";
+}
+
+//_____________________________________________________________________________
+void THcCodaIndex::AddEvent(Long64_t word, Long64_t nwords, Long64_t nfirst,
+			    const UInt_t* head, Int_t nhead)
+{
+  // head holds the first nhead (up to 5) words of the event
+  Entry e;
+  e.offset = word*(Long64_t)sizeof(UInt_t);
+  e.nwords = nwords;
+  e.nfirst = nfirst;
+  e.evtype = (nhead > 1) ? (head[1]>>16) : 0;
+  e.evnum = (nhead > 4 && head[3] == 0xC0000100) ? head[4] : 0;
+  e.flags = (nfirst < nwords) ? kSpansBlocks : 0;
+  fEntries.push_back(e);
+}
+
+//_____________________________________________________________________________
+Int_t THcCodaIndex::Build(const char* codafile)
+{
+  /**
+     Index codafile by walking its block and event headers.  Returns 0
+     on success.  A truncated last block or event ends the index with a
+     warning, as the end of a file still being written would.
+  */
+  Clear();
+  fCodaFile = codafile;
+  Int_t fd = open(codafile, O_RDONLY);
+  if(fd < 0) {
+    Error("Build","Cannot open CODA file %s",codafile);
+    return -1;
+  }
+  struct stat st;
+  if(fstat(fd, &st) != 0 || st.st_size < (off_t)(8*sizeof(UInt_t))) {
+    Error("Build","CODA file %s is empty or unreadable",codafile);
+    close(fd);
+    return -2;
+  }
+  void* addr = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(addr == MAP_FAILED) {
+    Error("Build","Cannot map CODA file %s",codafile);
+    return -3;
+  }
+  madvise(addr, st.st_size, MADV_SEQUENTIAL);
+  fFileSize = st.st_size;
+  fFileTime = st.st_mtime;
+
+  const UInt_t* w = (const UInt_t*) addr;
+  Long64_t nwords = st.st_size/sizeof(UInt_t);
+  Int_t status = 0;
+  UInt_t head[5];
+#define WORD(i) (fSwapped ? SwapWord(w[(i)]) : w[(i)])
+
+  if(w[7] == kEvioMagic) {
+    fSwapped = kFALSE;
+  } else if(SwapWord(w[7]) == kEvioMagic) {
+    fSwapped = kTRUE;
+  } else {
+    Error("Build","%s is not a CODA (evio) file",codafile);
+    status = -4;
+  }
+  fVersion = WORD(5) & 0xff;
+
+  if(status != 0) {
+    // Not a CODA file
+  } else if(fVersion >= 4) {
+    // Events never span blocks
+    Long64_t b = 0;
+    while(b+8 <= nwords) {
+      Long64_t blen = WORD(b);
+      Long64_t hlen = WORD(b+2);
+      if(WORD(b+7) != kEvioMagic || blen < hlen || hlen < 8 || b+blen > nwords) {
+	Warning("Build","Bad or truncated block at word %lld",b);
+	break;
+      }
+      Long64_t e = b+hlen;
+      Long64_t bend = b+blen;
+      while(e < bend) {
+	Long64_t evwords = (Long64_t)WORD(e)+1;
+	if(e+evwords > bend) {
+	  Warning("Build","Event at word %lld overruns its block",e);
+	  break;
+	}
+	Int_t nhead = TMath::Min(evwords, (Long64_t)5);
+	for(Int_t k=0;k<nhead;k++) head[k] = WORD(e+k);
+	AddEvent(e, evwords, evwords, head, nhead);
+	e += evwords;
+      }
+      if(WORD(b+5) & 0x200) break; // Last block
+      b = bend;
+    }
+  } else {
+    // Fixed size blocks.  Word 3 of the first block points to the first
+    // event, word 4 is the number of words used in a block.
+    Long64_t b = 0;
+    Long64_t pos = WORD(3);
+    Long64_t end = WORD(4);
+    Bool_t more = (pos >= 8 && end <= nwords);
+    Long64_t npartial = 0;
+    while(more) {
+      // Move to the next block when this one is used up
+      while(pos >= end) {
+	Long64_t bsize = WORD(b);
+	b += bsize;
+	if(bsize == 0 || b+8 > nwords || WORD(b+7) != kEvioMagic) {
+	  more = kFALSE;
+	  break;
+	}
+	pos = b+WORD(b+2);
+	end = b+TMath::Min((Long64_t)WORD(b+4),(Long64_t)WORD(b));
+	if(end > nwords) end = nwords;
+      }
+      if(!more) break;
+      Long64_t evwords = (Long64_t)WORD(pos)+1;
+      if(evwords == 1) {	// Padding
+	pos++;
+	continue;
+      }
+      if(pos+evwords <= end) {
+	Int_t nhead = TMath::Min(evwords, (Long64_t)5);
+	for(Int_t k=0;k<nhead;k++) head[k] = WORD(pos+k);
+	AddEvent(pos, evwords, evwords, head, nhead);
+	pos += evwords;
+	continue;
+      }
+      // The event continues after the header of the next block.
+      // ReadEvent expects that header right after the first part.
+      if(end != b+(Long64_t)WORD(b)) npartial++;
+      Long64_t start = pos;
+      Long64_t nfirst = end-pos;
+      Int_t nhead = 0;
+      Long64_t k = 0;
+      while(k < evwords) {
+	if(pos >= end) {
+	  Long64_t bsize = WORD(b);
+	  b += bsize;
+	  if(bsize == 0 || b+8 > nwords || WORD(b+7) != kEvioMagic) break;
+	  pos = b+WORD(b+2);
+	  end = b+TMath::Min((Long64_t)WORD(b+4),(Long64_t)WORD(b));
+	  if(end > nwords) end = nwords;
+	  continue;
+	}
+	Long64_t n = TMath::Min(evwords-k, end-pos);
+	for(Long64_t j=0; j<n && nhead<5; j++) head[nhead++] = WORD(pos+j);
+	pos += n;
+	k += n;
+      }
+      if(k < evwords) {
+	Warning("Build","Last event is truncated");
+	break;
+      }
+      AddEvent(start, evwords, nfirst, head, nhead);
+    }
+    if(npartial > 0) {
+      Warning("Build","%lld events of %s start in a partly used block and "
+	      "cannot be read through the index",npartial,codafile);
+    }
+  }
+#undef WORD
+  munmap(addr, st.st_size);
+  if(status != 0) Clear();
+  return status;
+}
+
+//_____________________________________________________________________________
+Int_t THcCodaIndex::WriteIndex(const char* indexfile) const
+{
+  // Write the index to indexfile, by default the sidecar of the CODA file.
+  // The file is written under a temporary name and renamed, so readers
+  // running in parallel never see a partial index.
+  TString name = indexfile ? TString(indexfile) : IndexFileName(fCodaFile);
+  TString tmpname = name + Form(".%d", (Int_t)getpid());
+  FILE* f = fopen(tmpname.Data(), "wb");
+  if(!f) {
+    Warning("WriteIndex","Cannot write index file %s",name.Data());
+    return -1;
+  }
+  IndexFileHeader h;
+  memset(&h, 0, sizeof(h));
+  h.magic = kIndexMagic;
+  h.version = kIndexVersion;
+  h.filesize = fFileSize;
+  h.filetime = fFileTime;
+  h.evio = fVersion;
+  h.swapped = fSwapped;
+  h.nevents = fEntries.size();
+  Bool_t ok = (fwrite(&h, sizeof(h), 1, f) == 1);
+  if(ok && !fEntries.empty()) {
+    ok = (fwrite(&fEntries[0], sizeof(Entry), fEntries.size(), f) == fEntries.size());
+  }
+  if(fclose(f) != 0) ok = kFALSE;
+  if(!ok || rename(tmpname.Data(), name.Data()) != 0) {
+    Warning("WriteIndex","Error writing index file %s",name.Data());
+    remove(tmpname.Data());
+    return -2;
+  }
+  return 0;
+}
+
+//_____________________________________________________________________________
+Int_t THcCodaIndex::ReadIndex(const char* codafile, const char* indexfile)
+{
+  /**
+     Read the index of codafile from indexfile, by default its sidecar.
+     Returns 0 on success, and a nonzero value if there is no index file
+     or it does not match the current CODA file.
+  */
+  Clear();
+  struct stat st;
+  if(stat(codafile, &st) != 0) return -1;
+  TString name = indexfile ? TString(indexfile) : IndexFileName(codafile);
+  FILE* f = fopen(name.Data(), "rb");
+  if(!f) return -2;
+  IndexFileHeader h;
+  Int_t status = 0;
+  if(fread(&h, sizeof(h), 1, f) != 1 || h.magic != kIndexMagic ||
+     h.version != kIndexVersion) {
+    status = -3;
+  } else if(h.filesize != (Long64_t)st.st_size ||
+	    h.filetime != (Long64_t)st.st_mtime) {
+    status = -4;		// CODA file changed since indexed
+  } else {
+    fEntries.resize(h.nevents);
+    if(h.nevents > 0 &&
+       fread(&fEntries[0], sizeof(Entry), h.nevents, f) != (size_t)h.nevents)
+      status = -5;
+  }
+  fclose(f);
+  if(status != 0) {
+    Clear();
+    return status;
+  }
+  fCodaFile = codafile;
+  fFileSize = h.filesize;
+  fFileTime = h.filetime;
+  fVersion = h.evio;
+  fSwapped = h.swapped;
+  return 0;
+}
+
+//_____________________________________________________________________________
+Int_t THcCodaIndex::Load(const char* codafile)
+{
+  // Read the sidecar index of codafile, or build it and write the
+  // sidecar if there is none or it is stale.
+  if(ReadIndex(codafile) == 0) return 0;
+  Int_t status = Build(codafile);
+  if(status != 0) return status;
+  if(WriteIndex() == 0) {
+    cout << "THcCodaIndex: " << fEntries.size() << " events of " << codafile
+	 << " indexed in " << IndexFileName(codafile) << endl;
+  }
+  return 0;
+}
+
+//_____________________________________________________________________________
+Long64_t THcCodaIndex::FindEvNum(UInt_t evnum) const
+{
+  // Index of the first physics event with event number evnum or higher,
+  // -1 if there is none
+  for(Long64_t i=0; i<(Long64_t)fEntries.size(); i++) {
+    if(fEntries[i].evnum != 0 && fEntries[i].evnum >= evnum) return i;
+  }
+  return -1;
+}
+
+//_____________________________________________________________________________
+Int_t THcCodaIndex::Split(Int_t nparts, vector<Long64_t>& bounds) const
+{
+  /**
+     Cut the file into nparts ranges of events with about the same
+     number of bytes.  Range i is events bounds[i] to bounds[i+1]-1.
+     Ranges may be empty if there are fewer events than parts.
+     Returns the number of ranges.
+  */
+  if(nparts < 1) nparts = 1;
+  Long64_t nev = fEntries.size();
+  bounds.assign(nparts+1, nev);
+  bounds[0] = 0;
+  if(nev == 0) return nparts;
+  Long64_t start = fEntries[0].offset;
+  Long64_t size = fFileSize - start;
+  Long64_t i = 0;
+  for(Int_t p=1; p<nparts; p++) {
+    Long64_t target = start + (Long64_t)((Double_t)size*p/nparts);
+    // Offsets increase, so a binary search finds the first event at or
+    // after the target
+    Long64_t lo = i, hi = nev;
+    while(lo < hi) {
+      Long64_t mid = lo + (hi-lo)/2;
+      if(fEntries[mid].offset < target) lo = mid+1;
+      else hi = mid;
+    }
+    i = lo;
+    bounds[p] = i;
+  }
+  return nparts;
+}
+
+//_____________________________________________________________________________
+Int_t THcCodaIndex::ReadEvent(Int_t fd, Long64_t i, vector<UInt_t>& buffer) const
+{
+  /**
+     Read event i of the indexed file, open on descriptor fd, into
+     buffer, in native byte order.  Returns the event length in words,
+     or -1 on errors.  Only reads the bytes of the event (and the block
+     headers an evio 1-3 event straddles), so any number of readers can
+     share a file.
+  */
+  if(i < 0 || i >= (Long64_t)fEntries.size()) return -1;
+  const Entry& e = fEntries[i];
+  buffer.resize(e.nwords);
+  ssize_t nbytes = e.nfirst*sizeof(UInt_t);
+  if(pread(fd, &buffer[0], nbytes, e.offset) != nbytes) return -1;
+  Long64_t k = e.nfirst;
+  Long64_t b = e.offset + nbytes;	// Header of the next block
+  while(k < (Long64_t)e.nwords) {
+    UInt_t bh[8];
+    if(pread(fd, bh, sizeof(bh), b) != (ssize_t)sizeof(bh)) return -1;
+    if(fSwapped) {
+      for(Int_t j=0;j<8;j++) bh[j] = SwapWord(bh[j]);
+    }
+    if(bh[7] != kEvioMagic || bh[0] < 8 || bh[2] < 8) return -1;
+    Long64_t used = TMath::Min(bh[4], bh[0]);
+    Long64_t n = TMath::Min((Long64_t)e.nwords-k, used-(Long64_t)bh[2]);
+    if(n <= 0) return -1;
+    nbytes = n*sizeof(UInt_t);
+    if(pread(fd, &buffer[k], nbytes, b+bh[2]*sizeof(UInt_t)) != nbytes) return -1;
+    k += n;
+    b += bh[0]*(Long64_t)sizeof(UInt_t);
+  }
+  if(fSwapped) {
+    for(UInt_t j=0;j<e.nwords;j++) buffer[j] = SwapWord(buffer[j]);
+  }
+  return e.nwords;
+}
+
+//_____________________________________________________________________________
+void THcCodaIndex::Print(Option_t*) const
+{
+  map<UInt_t, Long64_t> ntype;
+  Long64_t nspan = 0;
+  for(UInt_t i=0;i<fEntries.size();i++) {
+    ntype[fEntries[i].evtype]++;
+    if(fEntries[i].flags & kSpansBlocks) nspan++;
+  }
+  cout << "THcCodaIndex of " << fCodaFile << ": " << fEntries.size()
+       << " events, evio version " << fVersion
+       << (fSwapped ? ", byte swapped" : "") << endl;
+  if(nspan > 0)
+    cout << "  " << nspan << " events span blocks" << endl;
+  for(map<UInt_t, Long64_t>::const_iterator it=ntype.begin(); it!=ntype.end(); ++it)
+    cout << "  type " << it->first << ": " << it->second << endl;
+}
+
+ClassImp(THcCodaIndex)
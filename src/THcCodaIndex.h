@@ -0,0 +1,73 @@
+#ifndef ROOT_THcCodaIndex
+#define ROOT_THcCodaIndex
+
+//////////////////////////////////////////////////////////////////////////
+//
+// THcCodaIndex
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "TObject.h"
+#include "TString.h"
+#include <vector>
+
+class THcCodaIndex : public TObject {
+
+public:
+
+  THcCodaIndex();
+  virtual ~THcCodaIndex();
+
+  Int_t  Build(const char* codafile);
+  Int_t  WriteIndex(const char* indexfile=0) const;
+  Int_t  ReadIndex(const char* codafile, const char* indexfile=0);
+  Int_t  Load(const char* codafile);
+  void   Clear(Option_t* opt="");
+  void   Print(Option_t* opt="") const;
+
+  // Location and identity of one event.  Events of evio 1-3 files may
+  // run on into the next block(s); then nfirst < nwords words are at
+  // offset and the rest follows the headers of the next blocks.
+  struct Entry {
+    Long64_t offset;		// Byte offset of the event in the file
+    UInt_t   nwords;		// Event length, header included
+    UInt_t   nfirst;		// Words in the block of the event header
+    UInt_t   evnum;		// Physics event number, 0 for other events
+    UShort_t evtype;
+    UShort_t flags;		// kSpansBlocks
+  };
+  enum { kSpansBlocks = 1 };
+
+  Long64_t GetNEvents() const { return fEntries.size(); }
+  const Entry& GetEntry(Long64_t i) const { return fEntries[i]; }
+  Long64_t GetOffset(Long64_t i) const { return fEntries[i].offset; }
+  UInt_t   GetEvLength(Long64_t i) const { return fEntries[i].nwords; }
+  UInt_t   GetEvType(Long64_t i) const { return fEntries[i].evtype; }
+  UInt_t   GetEvNum(Long64_t i) const { return fEntries[i].evnum; }
+  Long64_t GetFileSize() const { return fFileSize; }
+  Int_t    GetVersion() const { return fVersion; }
+  Bool_t   IsSwapped() const { return fSwapped; }
+  const char* GetCodaFile() const { return fCodaFile.Data(); }
+
+  Long64_t FindEvNum(UInt_t evnum) const;
+  Int_t    Split(Int_t nparts, std::vector<Long64_t>& bounds) const;
+  Int_t    ReadEvent(Int_t fd, Long64_t i, std::vector<UInt_t>& buffer) const;
+
+  static TString IndexFileName(const char* codafile);
+
+protected:
+
+  void   AddEvent(Long64_t word, Long64_t nwords, Long64_t nfirst,
+		  const UInt_t* head, Int_t nhead);
+
+  TString  fCodaFile;
+  Long64_t fFileSize;		// Size and modification time of the CODA
+  Long64_t fFileTime;		// file, to tell a stale index
+  Int_t    fVersion;		// evio version
+  Bool_t   fSwapped;		// File has the other byte order
+  std::vector<Entry> fEntries;
+
+  ClassDef(THcCodaIndex,0)	// Event offsets of a CODA file
+};
+
+#endif
@@ -0,0 +1,843 @@
+/** \class THcCodaSyncScanner
+    \ingroup Base
+
+    \brief Standalone TI/FADC/CAEN1190 synchronization checker and rewriter.
+
+    Performs the same checks as THcTimeSyncEvtHandler directly on a CODA
+    file, without an analyzer, run object or detectors.  The file is
+    memory mapped and split into events.  The bank headers of the events
+    are then scanned in parallel, a chunk of events at a time, into fixed
+    per-event records, by threads of a THcWorkerPool that are started
+    once and kept for all chunks.  The slippage detection, the statistics and the
+    optional rewrite need the events in order, so they are done serially
+    from those records.
+
+    Usage from a script or the hcana prompt:
+
+        THcCodaSyncScanner s("coin_all_03302.dat");
+        s.SetBadROC(3);                         // only needed to rewrite
+        s.SetRewriteFile("coin_all_03302_fixed.dat");
+        s.Scan();
+        s.PrintStats();
+
+    See examples/syncscan.C.  Event types 1-7 are checked unless set
+    with AddEvtType.  evio version 1-3 (events may span blocks) and
+    version 4 files in either byte order are understood.  The events of
+    a file in the other byte order are swapped a chunk at a time by the
+    scan threads, so only one chunk is held in memory in addition to the
+    mapping.
+*/
+
+#include "THcCodaSyncScanner.h"
+#include "THcWorkerPool.h"
+#include "THaCodaFile.h"
+#include "TStopwatch.h"
+#include "TMath.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+
+using namespace std;
+using namespace Decoder;
+
+static const UInt_t kEvioMagic = 0xc0da0100;
+
+static inline UInt_t SwapWord(UInt_t w)
+{
+  return ((w>>24)&0xff) | ((w>>8)&0xff00) | ((w<<8)&0xff0000) | (w<<24);
+}
+
+//_____________________________________________________________________________
+THcCodaSyncScanner::THcCodaSyncScanner(const char* filename)
+  : fFd(-1), fMap(0), fMapWords(0), fSwapped(kFALSE), fMaxEvLen(0),
+    fNThreads(0), fChunkSize(4096), fDebug(0), fPool(0),
+    fFirstTime(kTRUE), fMasterRoc(-1), fNEvents(0), fNNoMaster(0),
+    fNSyncEvents(0), fNSlipEvents(0), fSlippage(0), fWriteDelayed(kFALSE),
+    fBadROC(-1), fResync(kTRUE), fBadSyncSizeTrigger(450),
+    fLastEventWasSync(kFALSE), fFirstTdcCheck(kTRUE), fTdcMask(0),
+    fCodaOut(0)
+{
+  // IsInSync and PrintStats may be called before Scan
+  memset(fStats, 0, sizeof(fStats));
+  if(filename && strlen(filename)>0) {
+    Open(filename);
+  }
+}
+
+//_____________________________________________________________________________
+THcCodaSyncScanner::~THcCodaSyncScanner()
+{
+  delete fPool;
+  Close();
+  if(fCodaOut) {
+    fCodaOut->codaClose();
+    delete fCodaOut;
+  }
+}
+
+//_____________________________________________________________________________
+Int_t THcCodaSyncScanner::Open(const char* filename)
+{
+  // Map a CODA file and build the index of its events
+
+  Close();
+  fFileName = filename;
+  fFd = open(filename, O_RDONLY);
+  if(fFd < 0) {
+    Error("Open","Cannot open CODA file %s",filename);
+    return -1;
+  }
+  struct stat st;
+  if(fstat(fFd, &st) != 0 || st.st_size < (off_t)(8*sizeof(UInt_t))) {
+    Error("Open","CODA file %s is empty or unreadable",filename);
+    Close();
+    return -2;
+  }
+  void* addr = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fFd, 0);
+  if(addr == MAP_FAILED) {
+    Error("Open","Cannot map CODA file %s",filename);
+    Close();
+    return -3;
+  }
+  madvise(addr, st.st_size, MADV_SEQUENTIAL);
+  fMap = (const UInt_t*) addr;
+  fMapWords = st.st_size/sizeof(UInt_t);
+
+  if(IndexEvents() < 0) {
+    Close();
+    return -4;
+  }
+  cout << "THcCodaSyncScanner: " << fEventOffset.size() << " events in "
+       << filename << endl;
+  return 0;
+}
+
+//_____________________________________________________________________________
+void THcCodaSyncScanner::Close()
+{
+  if(fMap) {
+    munmap((void*)fMap, fMapWords*sizeof(UInt_t));
+    fMap = 0;
+  }
+  if(fFd >= 0) {
+    close(fFd);
+    fFd = -1;
+  }
+  fMapWords = 0;
+  fEventOffset.clear();
+  fArena.clear();
+  fMaxEvLen = 0;
+}
+
+//_____________________________________________________________________________
+void THcCodaSyncScanner::AddEvent(Long64_t offset, Long64_t nwords)
+{
+  fEventOffset.push_back(offset);
+  if(nwords > (Long64_t)fMaxEvLen) fMaxEvLen = nwords;
+}
+
+//_____________________________________________________________________________
+Int_t THcCodaSyncScanner::IndexEvents()
+{
+  /**
+     Find the start of every event in the mapped file.  Events that lie
+     inside one block are used in place.  Events that span blocks (evio
+     1-3) are copied to fArena, without their block headers.  Both stay
+     in the byte order of the file, see ScanRange.
+  */
+  const UInt_t* w = fMap;
+  Long64_t nwords = fMapWords;
+#define WORD(i) (fSwapped ? SwapWord(w[(i)]) : w[(i)])
+
+  if(w[7] == kEvioMagic) {
+    fSwapped = kFALSE;
+  } else if(SwapWord(w[7]) == kEvioMagic) {
+    fSwapped = kTRUE;
+  } else {
+    Error("IndexEvents","%s is not a CODA (evio) file",fFileName.Data());
+    return -1;
+  }
+  UInt_t version = WORD(5) & 0xff;
+
+  if(version >= 4) {
+    // Events never span blocks
+    Long64_t b = 0;
+    while(b+8 <= nwords) {
+      Long64_t blen = WORD(b);
+      Long64_t hlen = WORD(b+2);
+      if(WORD(b+7) != kEvioMagic || blen < hlen || hlen < 8 || b+blen > nwords) {
+	Warning("IndexEvents","Bad or truncated block at word %lld",b);
+	break;
+      }
+      Long64_t e = b+hlen;
+      Long64_t bend = b+blen;
+      while(e < bend) {
+	Long64_t evwords = (Long64_t)WORD(e)+1;
+	if(e+evwords > bend) {
+	  Warning("IndexEvents","Event at word %lld overruns its block",e);
+	  break;
+	}
+	AddEvent(e, evwords);
+	e += evwords;
+      }
+      if(WORD(b+5) & 0x200) break; // Last block
+      b = bend;
+    }
+  } else {
+    // Fixed size blocks.  Word 3 of the first block points to the first
+    // event, word 4 is the number of words used in a block.
+    Long64_t b = 0;
+    Long64_t pos = WORD(3);
+    Long64_t end = WORD(4);
+    Bool_t more = (pos >= 8 && end <= nwords);
+    while(more) {
+      // Move to the next block when this one is used up
+      while(pos >= end) {
+	Long64_t bsize = WORD(b);
+	b += bsize;
+	if(bsize == 0 || b+8 > nwords || WORD(b+7) != kEvioMagic) {
+	  more = kFALSE;
+	  break;
+	}
+	pos = b+WORD(b+2);
+	end = b+TMath::Min((Long64_t)WORD(b+4),(Long64_t)WORD(b));
+	if(end > nwords) end = nwords;
+      }
+      if(!more) break;
+      Long64_t evwords = (Long64_t)WORD(pos)+1;
+      if(evwords == 1) {	// Padding
+	pos++;
+	continue;
+      }
+      if(pos+evwords <= end) {
+	AddEvent(pos, evwords);
+	pos += evwords;
+      } else {
+	// Copy the event, skipping the block headers it straddles
+	Long64_t aofs = fArena.size();
+	Long64_t k = 0;
+	while(k < evwords) {
+	  if(pos >= end) {
+	    Long64_t bsize = WORD(b);
+	    b += bsize;
+	    if(bsize == 0 || b+8 > nwords || WORD(b+7) != kEvioMagic) break;
+	    pos = b+WORD(b+2);
+	    end = b+TMath::Min((Long64_t)WORD(b+4),(Long64_t)WORD(b));
+	    if(end > nwords) end = nwords;
+	    continue;
+	  }
+	  fArena.push_back(w[pos]);
+	  pos++; k++;
+	}
+	if(k < evwords) {
+	  Warning("IndexEvents","Last event is truncated");
+	  fArena.resize(aofs);
+	  break;
+	}
+	AddEvent(-aofs-1, evwords);
+      }
+    }
+  }
+#undef WORD
+  return 0;
+}
+
+//_____________________________________________________________________________
+Bool_t THcCodaSyncScanner::IsMyEvent(UInt_t evtype) const
+{
+  for(UInt_t i=0;i<fEventTypes.size();i++) {
+    if((Int_t)evtype == fEventTypes[i]) return kTRUE;
+  }
+  return kFALSE;
+}
+
+//_____________________________________________________________________________
+void THcCodaSyncScanner::ScanRange(Long64_t first, Long64_t lo, Long64_t hi)
+{
+  // Scan events first+lo to first+hi-1 into the pools.  Each thread
+  // writes only its own slice of the pools and, for a byte swapped file,
+  // swaps its events into their place in fChunkBuf first.
+  for(Long64_t j=lo;j<hi;j++) {
+    if(fSwapped) {
+      const UInt_t* raw = EventBuffer(first+j);
+      UInt_t* buf = &fChunkBuf[fChunkOfs[j]];
+      Long64_t len = fChunkOfs[j+1]-fChunkOfs[j];
+      for(Long64_t k=0;k<len;k++) buf[k] = SwapWord(raw[k]);
+    }
+    ScanEvent(ChunkEvent(first,j), fRecords[j], &fRocPool[j*kMaxRoc]);
+  }
+}
+
+namespace {
+  // The chunk being scanned, for ScanSlice
+  struct ScanChunk {
+    THcCodaSyncScanner* scanner;
+    Long64_t first;		// First event of the chunk
+    Long64_t n;			// Events in the chunk
+  };
+}
+
+//_____________________________________________________________________________
+void THcCodaSyncScanner::ScanSlice(void* arg, Int_t islice, Int_t nslices)
+{
+  // Task of the worker pool: slice islice of nslices of the chunk
+  const ScanChunk& c = *static_cast<ScanChunk*>(arg);
+  Long64_t per = (c.n+nslices-1)/nslices;
+  Long64_t lo = islice*per;
+  if(lo < c.n) c.scanner->ScanRange(c.first, lo, TMath::Min(c.n, lo+per));
+}
+
+//_____________________________________________________________________________
+void THcCodaSyncScanner::ScanEvent(const UInt_t* rdata, EventRecord& ev,
+				   RocTimes* rocs) const
+{
+  /**
+     Walk the banks of one event looking for TI, FADC (tag 250) and
+     CAEN 1190 headers.  Same bank logic as THcTimeSyncEvtHandler::Analyze,
+     but results go into the pooled records and nothing is allocated.
+  */
+  ev.evtype = rdata[1]>>16;
+  ev.evnum = (rdata[3] == 0xC0000100) ? rdata[4] : 0;
+  ev.mine = IsMyEvent(ev.evtype);
+  ev.issync = kFALSE;
+  ev.rocmask = 0;
+  ev.nbadbanks = 0;
+  if(!ev.mine) return;
+
+  Int_t evlen = rdata[0]+1;
+  const UInt_t *p = rdata;
+  const UInt_t *plast = p+*p;	// Index to last word in the bank
+  Int_t roc = -1;
+  RocTimes* rt = 0;
+
+  while(p<plast) {
+    Int_t banklen = *p;
+    p++;
+    if((*p & 0xff00) == 0x1000) {	// Bank Containing banks
+      if(evlen-*(p-1) > 1) { // Don't use overall event header
+        roc = (*p>>16) & 0xf;
+	rt = &rocs[roc];
+	rt->has_ti_ttime = kFALSE;
+	rt->ti_ttime = 0;
+	rt->ti_evcount = 0;
+	rt->fadcmask = 0;
+	rt->tdcmask = 0;
+	ev.rocmask |= (1U<<roc);
+      }
+      p++;				// Now pointing to a bank in the bank
+    } else if (((*p & 0xff00) == 0x100) && (*p != 0xC0000100)) {
+      // Bank containing integers.  Look for TI, FADC and 1190 banks.
+      UInt_t tag = (*p>>16) & 0xffff;
+      UInt_t num = *p & 0xff;
+      const UInt_t *pnext = p+banklen;	// Next bank
+      p++;			// First data word
+      if(tag==4) { // This is a TI blob banks
+        Int_t ifill = ((((*p)>>27)&0x1F) == 0x1F) ? 1 : 0;
+        if(ifill) {
+          p++; banklen--;  // Skip filler word
+        }
+	if(rt) {
+	  rt->ti_evcount = p[3];
+	  if(banklen>=5) {
+	    rt->has_ti_ttime = kTRUE;
+	    rt->ti_ttime = p[4];
+	  }
+	}
+      } else if (tag==3801) {
+	if(fResync && num==1) {
+	  ev.issync = kTRUE;
+	}
+      } else if (tag==250 && rt) { // This is an FADC bank
+        Int_t slot=-1;
+        while(p<pnext) {
+          UInt_t code = (*p >> 27) & 0x1F;
+          switch(code) {
+	  case 0x10: // block header
+	    slot = (*p >> 22) & 0x1F;
+	    p++;
+	    break;
+	  case 0x13:  // trigger time word
+	    if(slot >= 0) {
+	      rt->fadctime[slot] = ((*p)&0xFFFFFF) + (((*(p+1))&0xFF)<<24);
+	      rt->fadcmask |= (1U<<slot);
+	    }
+	    p += 2;
+	    break;
+	  default: // event headers, trailers, fillers, data nwords
+	    p++;
+	    break;
+	  }
+	}
+      } else if (tag==1190 && rt) {	// Bank with CAEN 1190 TDCs
+	const UInt_t* bank = p-2;
+	if(roc==fBadROC && ev.nbadbanks < kMaxBadBanks) {
+	  Int_t ib = ev.nbadbanks++;
+	  ev.badbank[ib] = bank-rdata;
+	  ev.badbanklen[ib] = banklen;
+	  UInt_t headermask=0, trailermask=0;
+	  const UInt_t* q = bank+1;
+	  while(q++ < bank+bank[0]) {
+	    if((*q & 0xf8000000) == 0x40000000) {
+	      headermask |= (1U<<(*q&0x1f));
+	    } else if ((*q & 0xf8000000) == 0x80000000) {
+	      trailermask |= (1U<<(*q&0x1f));
+	    }
+	  }
+	  ev.headermask[ib] = headermask;
+	  ev.trailermask[ib] = trailermask;
+	}
+	// Walk through this bank looking for TDC headers
+	while(p<pnext) {
+	  if((*p & 0xf8000000) == 0x40000000) {
+	    Int_t slot= *p & 0x1f;
+	    rt->tdcevcount[slot] = (*p >> 5) & 0x3fffff;
+	    rt->tdcmask |= (1U<<slot);
+	  }
+	  p++;
+	}
+      }
+      p=pnext;    // Skip to next bank
+    } else {
+      if(*(p-1) == 0) break;	// Corrupt bank, give up on this event
+      p = p+*(p-1);
+    }
+  }
+}
+
+//_____________________________________________________________________________
+Int_t THcCodaSyncScanner::Scan()
+{
+  /**
+     Check the whole file.  Bank headers are scanned by fNThreads threads
+     (one per core by default) a chunk of fChunkSize events at a time.
+     The chunk is then processed in event order.  The threads are
+     started at the first chunk and kept until the scanner is deleted.
+  */
+  if(!fMap) {
+    Error("Scan","No CODA file open");
+    return -1;
+  }
+  if(fEventTypes.size()==0) {
+    for(Int_t i=1;i<=7;i++) fEventTypes.push_back(i);
+  }
+  if(fCodaOut && fBadROC < 0) {
+    Warning("Scan", "Sync filtering requested, but bad ROC not specified");
+  }
+
+  fFirstTime = kTRUE;
+  fFirstTdcCheck = kTRUE;
+  fMasterRoc = -1;
+  fNEvents = fNNoMaster = fNSyncEvents = fNSlipEvents = 0;
+  fSlippage = 0;
+  fWriteDelayed = kFALSE;
+  fLastEventWasSync = kFALSE;
+  memset(fStats, 0, sizeof(fStats));
+  fLastEvent.assign(2*fMaxEvLen+2, 0);
+
+  fRecords.resize(fChunkSize);
+  fRocPool.resize((size_t)fChunkSize*kMaxRoc);
+
+  if(!fPool) fPool = new THcWorkerPool;
+  fPool->SetNThreads(fNThreads);
+  Int_t nthreads = fPool->GetNThreads();
+
+  TStopwatch timer;
+  Long64_t nev = fEventOffset.size();
+  for(Long64_t first=0; first<nev; first+=fChunkSize) {
+    Long64_t n = TMath::Min((Long64_t)fChunkSize, nev-first);
+    if(fSwapped) {
+      // Lay out the chunk's events for the swapping in ScanRange
+      fChunkOfs.resize(n+1);
+      fChunkOfs[0] = 0;
+      for(Long64_t j=0;j<n;j++)
+	fChunkOfs[j+1] = fChunkOfs[j]+SwapWord(EventBuffer(first+j)[0])+1;
+      fChunkBuf.resize(fChunkOfs[n]);
+    }
+    if(nthreads > 1 && n >= 2*nthreads) {
+      ScanChunk chunk = {this, first, n};
+      fPool->Run(&THcCodaSyncScanner::ScanSlice, &chunk, nthreads);
+    } else
+      ScanRange(first, 0, n);
+
+    for(Long64_t j=0;j<n;j++) {
+      ProcessEvent(ChunkEvent(first,j), fRecords[j], &fRocPool[j*kMaxRoc]);
+    }
+  }
+  timer.Stop();
+
+  if(fCodaOut) {
+    fCodaOut->codaClose();
+    delete fCodaOut;
+    fCodaOut = 0;
+  }
+  cout << "THcCodaSyncScanner: " << nev << " events scanned with " << nthreads
+       << " threads in " << timer.RealTime() << " s" << endl;
+  return 0;
+}
+
+//_____________________________________________________________________________
+void THcCodaSyncScanner::ProcessEvent(const UInt_t* rdata, const EventRecord& ev,
+				      const RocTimes* rocs)
+{
+  // Serial part of THcTimeSyncEvtHandler::Analyze
+
+  // If filtering data file, pass through all events we are not dealing with
+  if(!ev.mine) {
+    if(fCodaOut) {
+      fCodaOut->codaWrite(rdata);
+    }
+    return;
+  }
+
+  const UInt_t* pslippedbank = 0;
+  for(Int_t ib=0;ib<ev.nbadbanks;ib++) {
+    const UInt_t* bank = rdata+ev.badbank[ib];
+    Int_t banklen = ev.badbanklen[ib];
+    Int_t missing = AllTdcsPresent(bank, banklen, ev.headermask[ib], ev.trailermask[ib]);
+    if(fSlippage) {
+      pslippedbank = bank;
+      if(missing && (banklen > fBadSyncSizeTrigger)) {
+	cout << "Slippage detected at event " << ev.evnum << " with size " << banklen << " but not corrected" << endl;
+      }
+    } else {
+      if(missing && (banklen > fBadSyncSizeTrigger)) {
+	cout << "Slippage enabled at event " << ev.evnum << " with size " << banklen << endl;
+	fSlippage = 1;
+      }
+    }
+  }
+
+  if(fFirstTime) {
+    if(ev.rocmask == 0) return;	// Need ROC banks to set up
+    InitStats(ev, rocs);
+    fLastEvent[0] = 0;
+    fFirstTime = kFALSE;
+  }
+  if(ev.issync) {
+    if(fDebug) cout << "SYNC event " << ev.evnum << endl;
+    fNSyncEvents++;
+  }
+  AccumulateStats(ev, rocs, fLastEventWasSync);
+  fLastEventWasSync = ev.issync;
+
+  if(!fCodaOut) return;
+
+  if(fSlippage > 0) {
+    if(fLastEvent[0]>0) { // Now slipping.  Output corrected event
+      fWriteDelayed=kTRUE;
+    } else {
+      cout << "Skipping event " << ev.evnum << endl;
+    }
+  } else {			// Not slipping yet, just copy event
+    fCodaOut->codaWrite(rdata);
+  }
+
+  if(fWriteDelayed) {
+    WriteCorrectedEvent(pslippedbank);
+    if(ev.issync) {		// If this was a sync event, write it out and stop rewriting
+      cout << "Run back in sync at event " << ev.evnum << endl;
+      fCodaOut->codaWrite(rdata);
+      fSlippage = 0;
+      fLastEvent[0] = 0;
+      fWriteDelayed = kFALSE;
+    }
+  }
+  if(fSlippage>0) {		// Just handle slippage of 1 now
+    memcpy(&fLastEvent[0], rdata, (rdata[0]+1)*sizeof(UInt_t));
+  }
+}
+
+//_____________________________________________________________________________
+void THcCodaSyncScanner::WriteCorrectedEvent(const UInt_t* pslippedbank)
+{
+  /**
+     Write the cached previous event with its bad ROC 1190 bank replaced
+     by the one from the current event.  Everything beyond that bank is
+     shifted to make room.
+  */
+  UInt_t* lastevent = &fLastEvent[0];
+  UInt_t* p = lastevent;
+  UInt_t* plast = p+*p;
+  Int_t roc = -1;
+  UInt_t *poverwrite=0;
+  Int_t replacementlen=0;
+  Int_t banklen=0;
+  UInt_t *rocbanklenp=0;
+  UInt_t *roc3banklenp=0;
+
+  while(p<plast && pslippedbank) {
+    banklen = *p;
+    p++;
+    if((*p & 0xff00) == 0x1000) {	// Bank Containing banks
+      if((lastevent[0]+1)-*(p-1) > 1) { // Don't use overall event header
+	roc = (*p>>16) & 0xf;
+	rocbanklenp = p-1;	// Pointer to rocbank length
+      }
+      p++;				// Now pointing to a bank in the bank
+    } else if (((*p & 0xff00) == 0x100) && (*p != 0xC0000100)) {
+      UInt_t tag = (*p>>16) & 0xffff;
+      UInt_t *pnext = p+banklen;	// Next bank
+      p++;			// First data word
+      if(tag==1190 && roc==fBadROC) { // The TDC bank we want to replace
+	replacementlen=pslippedbank[0];
+	roc3banklenp=rocbanklenp; // Save pointer to ROC bank header
+	poverwrite=p-2;	// Where to write the slipped bank
+	break;
+      }
+      p=pnext;
+    } else {
+      if(*(p-1) == 0) break;
+      p=p+*(p-1);
+    }
+  }
+  if(poverwrite) {
+    if(replacementlen < banklen) { // Shift data after bank down
+      p = poverwrite+banklen+1;    // Data to be shifted
+      while(p<=plast) {
+	*(p + replacementlen - banklen) = *p;
+	p++;
+      }
+    } else if (replacementlen > banklen) { // Shift data up
+      p = plast;
+      UInt_t *pfirst = poverwrite + banklen + 1;
+      while(p>=pfirst) {
+	*(p+replacementlen-banklen) = *p;
+	p--;
+      }
+    }
+    lastevent[0] += replacementlen-banklen; // Correct overall event length
+    *roc3banklenp += replacementlen-banklen; // Also ROC bank length
+    for(Int_t i=0;i<=replacementlen;i++) { // Copy slipped bank into last event
+      poverwrite[i] = pslippedbank[i];
+    }
+    fNSlipEvents++;
+  }
+  fCodaOut->codaWrite(lastevent);
+}
+
+//_____________________________________________________________________________
+void THcCodaSyncScanner::InitStats(const EventRecord& ev, const RocTimes* rocs)
+{
+  /** Record the offset of each TI and FADC time relative to the
+      trigger time of the master TI, using the first checked event.
+  */
+  // Assume the smallest ROC # is the TI master
+  if(fMasterRoc < 0) {
+    for(Int_t roc=0;roc<kMaxRoc;roc++) {
+      if(ev.rocmask & (1U<<roc)) {
+	fMasterRoc = roc;
+	break;
+      }
+    }
+  }
+  if(fDebug) cout << "fMasterRoc " << fMasterRoc << endl;
+  UInt_t master_ttime = (ev.rocmask & (1U<<fMasterRoc)) ? rocs[fMasterRoc].ti_ttime : 0;
+
+  for(Int_t roc=0;roc<kMaxRoc;roc++) {
+    if(!(ev.rocmask & (1U<<roc))) continue;
+    const RocTimes& rt = rocs[roc];
+    RocStats& rs = fStats[roc];
+    rs.active = kTRUE;
+    rs.ti_ttime_offset = rt.ti_ttime - master_ttime;
+    Bool_t use_expected_offset = kFALSE;
+    Int_t expected_offset = 0;
+    if(fExpectedOffsetMap.find(roc) != fExpectedOffsetMap.end()) {
+      expected_offset = fExpectedOffsetMap[roc];
+      use_expected_offset = kTRUE;
+    }
+    rs.fadcmask = rt.fadcmask;
+    rs.tdcmask = rt.tdcmask;
+    for(Int_t slot=0;slot<kMaxSlot;slot++) {
+      if(rt.fadcmask & (1U<<slot)) {
+	rs.fadcoffset[slot] = use_expected_offset ? expected_offset
+	  : (Int_t)(rt.fadctime[slot] - master_ttime);
+      }
+    }
+  }
+}
+
+//_____________________________________________________________________________
+void THcCodaSyncScanner::AccumulateStats(const EventRecord& ev, const RocTimes* rocs,
+					 Bool_t sync)
+{
+  fNEvents++;
+  if(fMasterRoc < 0 || !(ev.rocmask & (1U<<fMasterRoc))) {
+    fNNoMaster++;
+    return;
+  }
+  // Get trigger time from master ROC
+  UInt_t master_ttime = rocs[fMasterRoc].ti_ttime;
+  for(Int_t roc=0;roc<kMaxRoc;roc++) {
+    RocStats& rs = fStats[roc];
+    if(!rs.active) continue;
+    if(!(ev.rocmask & (1U<<roc))) {
+      rs.nmissing++;
+      continue;
+    }
+    const RocTimes& rt = rocs[roc];
+    if(rt.ti_ttime < master_ttime + rs.ti_ttime_offset) {
+      rs.ti_earlyslipcount++;
+    } else if(rt.ti_ttime > master_ttime + rs.ti_ttime_offset) {
+      rs.ti_lateslipcount++;
+    }
+    for(Int_t slot=0;slot<kMaxSlot;slot++) {
+      UInt_t bit = (1U<<slot);
+      if(rs.fadcmask & bit) {
+	UInt_t fadctime = (rt.fadcmask & bit) ? rt.fadctime[slot] : 0;
+        if(fadctime < master_ttime+rs.fadcoffset[slot]) {
+          rs.fadcearlyslips[slot]++;
+	} else if(fadctime > master_ttime+rs.fadcoffset[slot]) {
+	  rs.fadclateslips[slot]++;
+        }
+      }
+      if(rs.tdcmask & bit) {
+	if(!(rs.tdcoffsetmask & bit)) {
+	  rs.tdcevcountoffset[slot] = 1;
+	  rs.tdcoffsetmask |= bit;
+	}
+	UInt_t evcount = (rt.tdcmask & bit) ? rt.tdcevcount[slot] : 0;
+	Int_t cdiff = (rt.ti_evcount & 0x3fffff) -
+	  ((evcount+rs.tdcevcountoffset[slot])&0x3fffff);
+	if(sync) { // Need to do this check on the event after the sync event too
+	  if(cdiff>2) {
+	    cout << "ROC/Slot " << roc << "/" << slot << " count diff correction " << cdiff << endl;
+	    rs.tdcevcountoffset[slot] += cdiff;
+	    cdiff = 0;
+	  }
+	}
+	if(cdiff != 0) {
+	  rs.tdcevcountwrong[slot]++;
+	}
+      }
+    }
+  }
+}
+
+//_____________________________________________________________________________
+Int_t THcCodaSyncScanner::AllTdcsPresent(const UInt_t* bank, Int_t banklen,
+					 UInt_t headermask, UInt_t trailermask)
+{
+  /**
+     Check that all the 1190 TDCs that should be present are there.
+     The masks were filled by ScanEvent.  Returns 0 if all TDCs are
+     present, 1 otherwise.
+  */
+  if(fFirstTdcCheck) {
+    fFirstTdcCheck=kFALSE;
+    fTdcMask = headermask | trailermask;
+    return(0);			// All TDC present by definition
+  }
+  if((fTdcMask == headermask) && (fTdcMask == trailermask)) {
+    return(0);
+  }
+  if(fDebug) {
+    cout << hex << "Header mask " << headermask << "  Trailer mask " << trailermask << dec << endl;
+    cout << "TDC1190 Bank" << endl;
+    for(Int_t i=0;i<=banklen;i++) {
+      if(i%5 == 0) cout<<endl<<dec<<i<<": ";
+      cout << hex << setw(10) << bank[i];
+    }
+    cout << dec << endl;
+  }
+  return(1);
+}
+
+//_____________________________________________________________________________
+Bool_t THcCodaSyncScanner::IsInSync() const
+{
+  // True if no slips or TDC event count mismatches were found
+  for(Int_t roc=0;roc<kMaxRoc;roc++) {
+    const RocStats& rs = fStats[roc];
+    if(!rs.active) continue;
+    if(rs.ti_earlyslipcount || rs.ti_lateslipcount) return kFALSE;
+    for(Int_t slot=0;slot<kMaxSlot;slot++) {
+      if(rs.fadcearlyslips[slot] || rs.fadclateslips[slot]
+	 || rs.tdcevcountwrong[slot]) return kFALSE;
+    }
+  }
+  return kTRUE;
+}
+
+//_____________________________________________________________________________
+void THcCodaSyncScanner::PrintStats() const
+{
+  // Same layout as THcTimeSyncEvtHandler::PrintStats, plus a verdict
+  cout << "-------------------------------------------------------------------" << endl;
+  cout << "------ TI and FADC250 trigger time synchronization statitics ------" << endl;
+  cout << "-------------------------------------------------------------------" << endl;
+  cout << "      " << fFileName << endl;
+  cout << "      " << fNEvents << " events analyzed" << endl;
+  if(fNNoMaster > 0) {
+    cout << "      " << fNNoMaster << " events without master ROC " << fMasterRoc << endl;
+  }
+  if(fNSyncEvents > 0) {
+    cout << "      " << fNSyncEvents << " sync events" << endl;
+  }
+  for(Int_t roc=0;roc<kMaxRoc;roc++) {
+    const RocStats& rs = fStats[roc];
+    if(!rs.active) continue;
+    cout << "ROC " << roc << "  TI Offset " << rs.ti_ttime_offset << "  Slips " << rs.ti_earlyslipcount << "   " << rs.ti_lateslipcount;
+    if(rs.nmissing > 0) cout << "  Missing " << rs.nmissing;
+    cout << endl;
+    for(Int_t slot=0;slot<kMaxSlot;slot++) {
+      if(!(rs.fadcmask & (1U<<slot))) continue;
+      if(rs.fadcearlyslips[slot]+rs.fadclateslips[slot] > 0) { // Only print slots with slippage
+	cout << "    " << slot << " " << rs.fadcoffset[slot] << "    " << rs.fadcearlyslips[slot] << "    " << rs.fadclateslips[slot] << endl;
+      }
+    }
+    for(Int_t slot=0;slot<kMaxSlot;slot++) {
+      if(!(rs.tdcmask & (1U<<slot))) continue;
+      if(rs.tdcevcountwrong[slot] > 0) {
+	cout << "    " << slot << " " << rs.tdcevcountwrong[slot] << endl;
+      }
+    }
+  }
+  if(fNSlipEvents > 0) {
+    cout << "      " << fNSlipEvents << " events rewritten with ROC " << fBadROC << " TDC bank of the next event" << endl;
+  }
+  cout << "      Verdict: " << (IsInSync() ? "IN SYNC" : "OUT OF SYNC") << endl;
+  cout << "-------------------------------------------------------------------" << endl;
+}
+
+//_____________________________________________________________________________
+void THcCodaSyncScanner::SetExpectedOffset(Int_t roc, Int_t offset) {
+  fExpectedOffsetMap.clear();
+  AddExpectedOffset(roc, offset);
+}
+
+//_____________________________________________________________________________
+void THcCodaSyncScanner::AddExpectedOffset(Int_t roc, Int_t offset) {
+  fExpectedOffsetMap[roc] = offset;
+}
+
+//_____________________________________________________________________________
+Int_t THcCodaSyncScanner::SetRewriteFile(const char *filename) {
+  if(fCodaOut) {
+    fCodaOut->codaClose();
+    delete fCodaOut;
+    fCodaOut = 0;
+  }
+  if(filename==0 || strlen(filename)==0) {
+    cout << "THcCodaSyncScanner sync filtering disabled" << endl;
+  } else {
+    TString ts=filename;
+    fCodaOut = new THaCodaFile;
+    if ( fCodaOut->codaOpen(ts, "w", 1) ) {
+      Error("SetRewriteFile","Cannot open CODA file %s for writing.",ts.Data());
+      delete fCodaOut;
+      fCodaOut = 0;
+      return -3;
+    }
+    cout << "THcCodaSyncScanner writing sync filtered coda file to " << ts <<endl;
+  }
+  return(0);
+}
+
+ClassImp(THcCodaSyncScanner)
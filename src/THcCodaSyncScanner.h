@@ -0,0 +1,164 @@
+#ifndef THcCodaSyncScanner_
+#define THcCodaSyncScanner_
+
+/////////////////////////////////////////////////////////////////////
+//
+//   THcCodaSyncScanner
+//
+/////////////////////////////////////////////////////////////////////
+
+#include "TObject.h"
+#include "TString.h"
+#include <vector>
+#include <map>
+
+namespace Decoder {
+  class THaCodaFile;
+}
+class THcWorkerPool;
+
+class THcCodaSyncScanner : public TObject {
+
+public:
+
+  THcCodaSyncScanner(const char* filename=0);
+  virtual ~THcCodaSyncScanner();
+
+  Int_t  Open(const char* filename);
+  void   Close();
+  Int_t  Scan();
+  void   PrintStats() const;
+  Bool_t IsInSync() const;
+
+  void   AddEvtType(Int_t evtype) {fEventTypes.push_back(evtype);}
+  void   SetExpectedOffset(Int_t roc, Int_t offset);
+  void   AddExpectedOffset(Int_t roc, Int_t offset);
+  Int_t  SetRewriteFile(const char *filename);
+  void   SetBadROC(Int_t roc) {fBadROC = roc;}
+  void   SetResync(Bool_t b) {fResync = b;}
+  void   SetBadSyncSizeTrigger(Int_t sizetrigger) {fBadSyncSizeTrigger = sizetrigger;}
+  void   SetNThreads(Int_t n) {fNThreads = n;}
+  void   SetChunkSize(Int_t nevents) {fChunkSize = (nevents>0) ? nevents : 1;}
+  void   SetDebug(Int_t level) {fDebug = level;}
+
+  Long64_t GetNEventsInFile() const {return fEventOffset.size();}
+  Long64_t GetNEvents() const {return fNEvents;}
+
+  enum { kMaxRoc = 16, kMaxSlot = 32, kMaxBadBanks = 4 };
+
+  // Times and counters found in the bank headers of one ROC for one event.
+  // A fixed block of these is kept per event in a pool reused for each chunk.
+  struct RocTimes {
+    Bool_t has_ti_ttime;
+    UInt_t ti_ttime;
+    UInt_t ti_evcount;
+    UInt_t fadcmask;		// Slots with an FADC trigger time
+    UInt_t tdcmask;		// Slots with a 1190 global header
+    UInt_t fadctime[kMaxSlot];
+    UInt_t tdcevcount[kMaxSlot];
+  };
+
+  // Summary of one event filled by the parallel scan
+  struct EventRecord {
+    UInt_t evtype;
+    UInt_t evnum;
+    Bool_t mine;		// Event type is checked
+    Bool_t issync;		// Contains a sync flag bank (tag 3801)
+    UInt_t rocmask;		// ROCs present in the event
+    Int_t  nbadbanks;		// 1190 banks in the bad ROC
+    UInt_t badbank[kMaxBadBanks];     // Word offset of the bank in the event
+    Int_t  badbanklen[kMaxBadBanks];
+    UInt_t headermask[kMaxBadBanks];  // TDC global headers seen
+    UInt_t trailermask[kMaxBadBanks]; // TDC global trailers seen
+  };
+
+  // Accumulated statistics for one ROC
+  struct RocStats {
+    Bool_t   active;
+    Int_t    ti_ttime_offset;
+    Long64_t ti_earlyslipcount;
+    Long64_t ti_lateslipcount;
+    Long64_t nmissing;		// Events in which the ROC bank was absent
+    UInt_t   fadcmask;
+    Int_t    fadcoffset[kMaxSlot];
+    Long64_t fadcearlyslips[kMaxSlot];
+    Long64_t fadclateslips[kMaxSlot];
+    UInt_t   tdcmask;
+    UInt_t   tdcoffsetmask;
+    Int_t    tdcevcountoffset[kMaxSlot];
+    Long64_t tdcevcountwrong[kMaxSlot];
+  };
+
+private:
+
+  Int_t  IndexEvents();
+  void   AddEvent(Long64_t offset, Long64_t nwords);
+  const UInt_t* EventBuffer(Long64_t i) const {
+    Long64_t offset = fEventOffset[i];
+    return (offset >= 0) ? fMap + offset : &fArena[-offset-1];
+  }
+  const UInt_t* ChunkEvent(Long64_t first, Long64_t j) const {
+    return fSwapped ? &fChunkBuf[fChunkOfs[j]] : EventBuffer(first+j);
+  }
+  Bool_t IsMyEvent(UInt_t evtype) const;
+  void   ScanRange(Long64_t first, Long64_t lo, Long64_t hi);
+  static void ScanSlice(void* arg, Int_t islice, Int_t nslices);
+  void   ScanEvent(const UInt_t* rdata, EventRecord& ev, RocTimes* rocs) const;
+  void   ProcessEvent(const UInt_t* rdata, const EventRecord& ev, const RocTimes* rocs);
+  void   InitStats(const EventRecord& ev, const RocTimes* rocs);
+  void   AccumulateStats(const EventRecord& ev, const RocTimes* rocs, Bool_t sync);
+  Int_t  AllTdcsPresent(const UInt_t* bank, Int_t banklen,
+			UInt_t headermask, UInt_t trailermask);
+  void   WriteCorrectedEvent(const UInt_t* pslippedbank);
+
+  TString         fFileName;
+  Int_t           fFd;		// File descriptor of the mapped file
+  const UInt_t*   fMap;		//! Mapped CODA file
+  Long64_t        fMapWords;	// Size of the mapping in 32 bit words
+  Bool_t          fSwapped;	// File has the other byte order
+  std::vector<Long64_t> fEventOffset; // >=0: word in fMap, <0: -(word in fArena)-1
+  std::vector<UInt_t>   fArena;	// Events spanning blocks, in file byte order
+  UInt_t          fMaxEvLen;	// Largest event in the file, in words
+
+  std::vector<Int_t>    fEventTypes;
+  std::map<Int_t, Int_t> fExpectedOffsetMap;
+  Int_t           fNThreads;	// 0: one per core
+  Int_t           fChunkSize;	// Events scanned in parallel at a time
+  Int_t           fDebug;
+  THcWorkerPool*  fPool;	//! Scan threads, kept for all chunks
+
+  // Event pools, sized once from fChunkSize
+  std::vector<EventRecord> fRecords;
+  std::vector<RocTimes>    fRocPool;
+  // Events of the chunk in host byte order, if the file is swapped
+  std::vector<UInt_t>      fChunkBuf;
+  std::vector<Long64_t>    fChunkOfs;	// [n+1] offsets into fChunkBuf
+
+  // Same state as THcTimeSyncEvtHandler
+  Bool_t   fFirstTime;
+  Int_t    fMasterRoc;
+  Long64_t fNEvents;
+  Long64_t fNNoMaster;		// Events without the master ROC
+  Long64_t fNSyncEvents;
+  Long64_t fNSlipEvents;	// Events written with a corrected TDC bank
+  Int_t    fSlippage;
+  std::vector<UInt_t> fLastEvent;
+  Bool_t   fWriteDelayed;
+  Int_t    fBadROC;
+  Bool_t   fResync;
+  Int_t    fBadSyncSizeTrigger;
+  Bool_t   fLastEventWasSync;
+  Bool_t   fFirstTdcCheck;
+  UInt_t   fTdcMask;
+  RocStats fStats[kMaxRoc];
+
+  Decoder::THaCodaFile* fCodaOut; //! The CODA output file
+
+  THcCodaSyncScanner(const THcCodaSyncScanner& fh);
+  THcCodaSyncScanner& operator=(const THcCodaSyncScanner& fh);
+
+  ClassDef(THcCodaSyncScanner,0)  // Standalone TI/FADC/1190 sync checker
+
+};
+
+#endif
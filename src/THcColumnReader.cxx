@@ -0,0 +1,182 @@
+/** \class THcColumnReader
+    \ingroup Base
+
+    \brief Reads the columnar files written by THcColumnWriter.
+
+    The footer gives the columns and the offsets of the chunks.  A
+    column is read by seeking to its part of each chunk, so the other
+    columns are neither read nor decoded.  Values come back as Double_t
+    in one flat vector, with the offset of the first value of each
+    event (the values of event i are values[offsets[i]] to
+    values[offsets[i+1]-1]).  They are the values of the global
+    variables at the time of writing, except for quantized variables,
+    which are rounded to multiples of their step.
+
+        THcColumnReader reader("ROOTfiles/hms_1234.col");
+        vector<Double_t> values;
+        vector<Long64_t> offsets;
+        reader.ReadColumn("H.gtr.dp", values, offsets);
+*/
+
+#include "THcColumnReader.h"
+#include "THcColumnWriter.h"
+#include "TError.h"
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+
+using namespace std;
+
+//_____________________________________________________________________________
+THcColumnReader::THcColumnReader(const char* filename)
+  : fFile(0), fNEvents(0)
+{
+  fFile = fopen(filename, "rb");
+  if(!fFile) {
+    ::Error("THcColumnReader", "Can not open %s", filename);
+    return;
+  }
+  if(ReadFooter() != 0) {
+    ::Error("THcColumnReader", "%s is not a complete column file", filename);
+    fclose(fFile);
+    fFile = 0;
+  }
+}
+
+//_____________________________________________________________________________
+THcColumnReader::~THcColumnReader()
+{
+  if(fFile) fclose(fFile);
+}
+
+//_____________________________________________________________________________
+Int_t THcColumnReader::ReadFooter()
+{
+  char magic[8];
+  if(fread(magic, 1, 8, fFile) != 8 ||
+     memcmp(magic, THcColumnWriter::kMagic, 8) != 0) return -1;
+  Long64_t offset;
+  if(fseeko(fFile, -16, SEEK_END) != 0 ||
+     fread(&offset, sizeof(offset), 1, fFile) != 1 ||
+     fread(magic, 1, 8, fFile) != 8 ||
+     memcmp(magic, THcColumnWriter::kEndMagic, 8) != 0) return -1;
+  if(fseeko(fFile, offset, SEEK_SET) != 0 ||
+     fread(magic, 1, 4, fFile) != 4 || memcmp(magic, "FOOT", 4) != 0) return -1;
+
+  UInt_t ncols;
+  if(fread(&ncols, sizeof(ncols), 1, fFile) != 1) return -1;
+  for(UInt_t i=0;i<ncols;i++) {
+    UInt_t len;
+    if(fread(&len, sizeof(len), 1, fFile) != 1 || len > 4096) return -1;
+    vector<char> name(len+1, 0);
+    Int_t type;
+    Double_t step;
+    UChar_t isarray;
+    if(fread(&name[0], 1, len, fFile) != len ||
+       fread(&type, sizeof(type), 1, fFile) != 1 ||
+       fread(&step, sizeof(step), 1, fFile) != 1 ||
+       fread(&isarray, 1, 1, fFile) != 1) return -1;
+    fNames.push_back(&name[0]);
+    fTypes.push_back(type);
+    fSteps.push_back(step);
+    fIsArray.push_back(isarray);
+  }
+  UInt_t nchunks;
+  if(fread(&nchunks, sizeof(nchunks), 1, fFile) != 1) return -1;
+  for(UInt_t i=0;i<nchunks;i++) {
+    Long64_t choffset;
+    UInt_t nev;
+    if(fread(&choffset, sizeof(choffset), 1, fFile) != 1 ||
+       fread(&nev, sizeof(nev), 1, fFile) != 1) return -1;
+    fChunkOffsets.push_back(choffset);
+    fChunkEvents.push_back(nev);
+    fNEvents += nev;
+  }
+  return 0;
+}
+
+//_____________________________________________________________________________
+Int_t THcColumnReader::FindColumn(const char* name) const
+{
+  for(UInt_t i=0;i<fNames.size();i++) {
+    if(fNames[i] == name) return i;
+  }
+  return -1;
+}
+
+//_____________________________________________________________________________
+Int_t THcColumnReader::ReadColumn(const char* name, vector<Double_t>& values,
+				  vector<Long64_t>& offsets)
+{
+  Int_t icol = FindColumn(name);
+  if(icol < 0) {
+    ::Error("THcColumnReader::ReadColumn", "No column %s", name);
+    return -1;
+  }
+  return ReadColumn(icol, values, offsets);
+}
+
+//_____________________________________________________________________________
+Int_t THcColumnReader::ReadColumn(Int_t icol, vector<Double_t>& values,
+				  vector<Long64_t>& offsets)
+{
+  /**
+     Read all events of column icol.  offsets gets one entry per event
+     plus one.  Returns 0, or -1 on error.
+  */
+  values.clear();
+  offsets.assign(1, 0);
+  if(!fFile || icol < 0 || icol >= (Int_t)fNames.size()) return -1;
+  offsets.reserve(fNEvents+1);
+
+  vector<ULong64_t> sizes;
+  vector<UChar_t> blob;
+  vector<Double_t> chunkvalues;
+  vector<UInt_t> lengths;
+  for(UInt_t ich=0;ich<fChunkOffsets.size();ich++) {
+    char magic[4];
+    UInt_t nev, ncols;
+    if(fseeko(fFile, fChunkOffsets[ich], SEEK_SET) != 0 ||
+       fread(magic, 1, 4, fFile) != 4 || memcmp(magic, "CHNK", 4) != 0 ||
+       fread(&nev, sizeof(nev), 1, fFile) != 1 ||
+       fread(&ncols, sizeof(ncols), 1, fFile) != 1 ||
+       ncols != fNames.size() || nev != fChunkEvents[ich]) {
+      ::Error("THcColumnReader::ReadColumn", "Bad chunk %u", ich);
+      return -1;
+    }
+    sizes.resize(ncols);
+    if(fread(&sizes[0], sizeof(ULong64_t), ncols, fFile) != ncols) return -1;
+    Long64_t skip = 0;
+    for(Int_t i=0;i<icol;i++) skip += sizes[i];
+    blob.resize(sizes[icol]);
+    if(fseeko(fFile, skip, SEEK_CUR) != 0 ||
+       (!blob.empty() && fread(&blob[0], 1, blob.size(), fFile) != blob.size()) ||
+       THcColumnWriter::Decode(blob.empty() ? 0 : &blob[0], blob.size(),
+			       fSteps[icol], fIsArray[icol], nev,
+			       chunkvalues, lengths) < 0) {
+      ::Error("THcColumnReader::ReadColumn", "Can not decode %s in chunk %u",
+	      fNames[icol].Data(), ich);
+      return -1;
+    }
+    values.insert(values.end(), chunkvalues.begin(), chunkvalues.end());
+    for(UInt_t i=0;i<nev;i++) offsets.push_back(offsets.back() + lengths[i]);
+  }
+  return 0;
+}
+
+//_____________________________________________________________________________
+void THcColumnReader::Print() const
+{
+  static const char* const types[] = { "Double_t", "Float_t", "Int_t" };
+  cout << fNEvents << " events in " << fChunkOffsets.size() << " chunks, "
+       << fNames.size() << " columns" << endl;
+  for(UInt_t i=0;i<fNames.size();i++) {
+    cout << "  " << setw(30) << left << fNames[i] << right << " "
+	 << ((fTypes[i] >= 0 && fTypes[i] <= 2) ? types[fTypes[i]] : "?")
+	 << (fIsArray[i] ? "[]" : "");
+    if(fSteps[i] > 0) cout << "  step " << fSteps[i];
+    cout << endl;
+  }
+}
+
+ClassImp(THcColumnReader)
@@ -0,0 +1,54 @@
+#ifndef ROOT_THcColumnReader
+#define ROOT_THcColumnReader
+
+//////////////////////////////////////////////////////////////////////////
+//
+// THcColumnReader
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "Rtypes.h"
+#include "TString.h"
+#include <vector>
+#include <cstdio>
+
+class THcColumnReader {
+
+public:
+
+  THcColumnReader(const char* filename);
+  virtual ~THcColumnReader();
+
+  Bool_t      IsOpen() const      {return fFile != 0;}
+  Int_t       GetNColumns() const {return fNames.size();}
+  const char* GetColumnName(Int_t i) const {return fNames[i].Data();}
+  Int_t       FindColumn(const char* name) const;
+  Long64_t    GetNEvents() const  {return fNEvents;}
+
+  Int_t  ReadColumn(Int_t icol, std::vector<Double_t>& values,
+		    std::vector<Long64_t>& offsets);
+  Int_t  ReadColumn(const char* name, std::vector<Double_t>& values,
+		    std::vector<Long64_t>& offsets);
+  void   Print() const;
+
+protected:
+
+  Int_t  ReadFooter();
+
+  FILE*    fFile;
+  Long64_t fNEvents;
+  std::vector<TString>  fNames;
+  std::vector<Int_t>    fTypes;
+  std::vector<Double_t> fSteps;
+  std::vector<Bool_t>   fIsArray;
+  std::vector<Long64_t> fChunkOffsets;
+  std::vector<UInt_t>   fChunkEvents;
+
+private:
+  THcColumnReader(const THcColumnReader&);
+  THcColumnReader& operator=(const THcColumnReader&);
+
+  ClassDef(THcColumnReader,0)	// Reader of THcColumnWriter files
+};
+
+#endif
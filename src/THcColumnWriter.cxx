@@ -0,0 +1,614 @@
+/** \class THcColumnWriter
+    \ingroup Base
+
+    \brief Writes global variables to a compact columnar file.
+
+    An alternative to the output tree for replays whose output is read
+    back variable by variable (calibrations, skims).  The variables are
+    selected with wildcard patterns, as in the block lines of an output
+    definition file.  The values of each variable are kept in a column
+    and written in chunks of a fixed number of events.  Each chunk of a
+    column is encoded on its own:
+
+    - Arrays store the length per event, delta encoded and bit packed.
+    - When more than a quarter of the values equal the most common value
+      of the chunk (0, or kBig for planes without hits), only a bitmap
+      and the other values are stored.
+    - Integer variables, and floating point variables whose values are
+      all integers (raw ADC and TDC values), are delta encoded, zigzag
+      mapped and bit packed with the smallest width that fits the chunk.
+    - Floating point variables matching a quantization pattern are
+      rounded to multiples of the step and stored as integers.
+    - Other values are stored as they are, 4 bytes for Float_t and 8
+      bytes for Double_t variables.
+
+    The columns of a chunk are encoded in parallel when several threads
+    are requested, by a THcWorkerPool kept for all chunks.  The chunks are followed by a footer with the column
+    names, types and quantization steps and the offset of every chunk,
+    so THcColumnReader can read a single column without touching the
+    others.  The footer is written at the end of every run, so the file
+    is complete after each one.  Values are stored in the byte order of
+    the machine that wrote the file.
+
+    A definition file has one entry per line:
+
+        # comment
+        block H.hod.*
+        block H.dc.*.tdchits
+        variable H.gtr.dp
+        quantize H.dc.*.time 0.01
+
+    Usage in a replay script, before Init:
+
+        analyzer->SetColumnOutput("ROOTfiles/hms_1234.col", "DEF-files/hms_col.def");
+*/
+
+#include "THcColumnWriter.h"
+#include "THcWorkerPool.h"
+#include "THaGlobals.h"
+#include "THaVarList.h"
+#include "THaVar.h"
+#include "VarType.h"
+#include "TRegexp.h"
+#include "TError.h"
+#include "TMath.h"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cstring>
+#include <cmath>
+#include <map>
+#include <unistd.h>
+
+using namespace std;
+
+const char THcColumnWriter::kMagic[8] = {'H','C','C','O','L','0','0','1'};
+const char THcColumnWriter::kEndMagic[8] = {'H','C','C','O','L','E','N','D'};
+
+namespace {
+  const Double_t kMaxExact = 9007199254740992.0; // 2^53
+
+  // Variable length unsigned integer, 7 bits per byte
+  void PutVarint(vector<UChar_t>& out, ULong64_t v)
+  {
+    while(v >= 0x80) {
+      out.push_back((v & 0x7f) | 0x80);
+      v >>= 7;
+    }
+    out.push_back(v);
+  }
+
+  Bool_t GetVarint(const UChar_t*& p, const UChar_t* end, ULong64_t& v)
+  {
+    v = 0;
+    for(Int_t shift=0; p<end && shift<64; shift+=7) {
+      UChar_t b = *p++;
+      v |= (ULong64_t)(b & 0x7f) << shift;
+      if(!(b & 0x80)) return kTRUE;
+    }
+    return kFALSE;
+  }
+
+  void PutBytes(vector<UChar_t>& out, const void* src, size_t n)
+  {
+    const UChar_t* s = static_cast<const UChar_t*>(src);
+    out.insert(out.end(), s, s+n);
+  }
+
+  // Differences of successive values, zigzag mapped so that small
+  // negative differences give small numbers, then packed with the
+  // width of the largest one.  The width is 0 for constant values.
+  void PackDelta(vector<UChar_t>& out, const Long64_t* v, size_t n)
+  {
+    vector<ULong64_t> z(n);
+    ULong64_t prev = 0, all = 0;
+    for(size_t i=0;i<n;i++) {
+      ULong64_t d = (ULong64_t)v[i] - prev;
+      prev = (ULong64_t)v[i];
+      z[i] = (d << 1) ^ (ULong64_t)((Long64_t)d >> 63);
+      all |= z[i];
+    }
+    Int_t width = 0;
+    while(width < 64 && (all >> width)) width++;
+    PutVarint(out, n);
+    out.push_back(width);
+    if(width == 0) return;
+    ULong64_t acc = 0;
+    Int_t nbits = 0;
+    for(size_t i=0;i<n;i++) {
+      ULong64_t x = z[i];
+      Int_t left = width;
+      while(left > 0) {		// acc holds fewer than 8 bits here
+	Int_t take = TMath::Min(left, 56);
+	acc |= (x & ((1ULL << take) - 1)) << nbits;
+	nbits += take;
+	x >>= take;
+	left -= take;
+	while(nbits >= 8) {
+	  out.push_back(acc & 0xff);
+	  acc >>= 8;
+	  nbits -= 8;
+	}
+      }
+    }
+    if(nbits > 0) out.push_back(acc & 0xff);
+  }
+
+  Bool_t UnpackDelta(const UChar_t*& p, const UChar_t* end, vector<Long64_t>& v)
+  {
+    ULong64_t n;
+    if(!GetVarint(p, end, n) || p >= end) return kFALSE;
+    Int_t width = *p++;
+    if(width > 64) return kFALSE;
+    size_t nbytes = (n*width + 7)/8;
+    if((size_t)(end - p) < nbytes) return kFALSE;
+    v.resize(n);
+    ULong64_t prev = 0;
+    size_t bitpos = 0;
+    for(size_t i=0;i<n;i++) {
+      ULong64_t z = 0;
+      for(Int_t got=0; got<width; ) {
+	size_t byte = bitpos >> 3;
+	Int_t shift = bitpos & 7;
+	Int_t take = TMath::Min(8 - shift, width - got);
+	ULong64_t bits = (p[byte] >> shift) & ((1U << take) - 1);
+	z |= bits << got;
+	got += take;
+	bitpos += take;
+      }
+      ULong64_t d = (z >> 1) ^ (0 - (z & 1));
+      prev += d;
+      v[i] = (Long64_t)prev;
+    }
+    p += nbytes;
+    return kTRUE;
+  }
+}
+
+//_____________________________________________________________________________
+THcColumnWriter::THcColumnWriter(const char* filename, Int_t chunksize, Int_t nthreads)
+  : fFileName(filename), fFile(0), fChunkSize(chunksize > 0 ? chunksize : 1),
+    fNThreads(nthreads), fNEvents(0), fNTotal(0), fFooterOffset(-1),
+    fPool(0)
+{
+  // Constructor.  The file is created by the first Init.
+}
+
+//_____________________________________________________________________________
+THcColumnWriter::~THcColumnWriter()
+{
+  if(fFile) {
+    if(fNEvents > 0 || fFooterOffset < 0) End();
+    fclose(fFile);
+  }
+  for(UInt_t i=0;i<fColumns.size();i++) delete fColumns[i];
+  delete fPool;
+}
+
+//_____________________________________________________________________________
+Int_t THcColumnWriter::LoadDefinitions(const char* deffile)
+{
+  /**
+     Read the block, variable and quantize lines of deffile.  Returns
+     the number of entries, or -1 if the file can not be opened.
+  */
+  ifstream ifile(deffile);
+  if(!ifile) {
+    ::Error("THcColumnWriter::LoadDefinitions", "Can not open %s", deffile);
+    return -1;
+  }
+  Int_t nentries = 0;
+  string line;
+  while(getline(ifile, line)) {
+    size_t comment = line.find('#');
+    if(comment != string::npos) line.erase(comment);
+    istringstream is(line);
+    string key, pattern;
+    if(!(is >> key >> pattern)) continue;
+    TString lkey(key.c_str());
+    lkey.ToLower();
+    if(lkey == "block" || lkey == "variable") {
+      AddBlock(pattern.c_str());
+    } else if(lkey == "quantize") {
+      Double_t step = 0;
+      if(!(is >> step) || step <= 0) {
+	::Warning("THcColumnWriter::LoadDefinitions",
+		  "Bad quantization step for %s", pattern.c_str());
+	continue;
+      }
+      AddQuantization(pattern.c_str(), step);
+    } else {
+      ::Warning("THcColumnWriter::LoadDefinitions", "Unknown entry %s",
+		key.c_str());
+      continue;
+    }
+    nentries++;
+  }
+  return nentries;
+}
+
+//_____________________________________________________________________________
+void THcColumnWriter::AddQuantization(const char* pattern, Double_t step)
+{
+  // Store floating point variables matching pattern as multiples of
+  // step.  The first matching pattern is used.
+  fQuantPatterns.push_back(pattern);
+  fQuantSteps.push_back(step);
+}
+
+//_____________________________________________________________________________
+Int_t THcColumnWriter::Init()
+{
+  /**
+     Find the variables.  The columns are made at the first Init and
+     kept for later runs, where the variables are looked up again by
+     name.  A variable that is missing in a later run is written with
+     no values.
+  */
+  if(!gHaVars) return -1;
+  if(fColumns.empty()) {
+    TIter next(gHaVars);
+    while(THaVar* var = static_cast<THaVar*>(next())) {
+      TString name = var->GetName();
+      Bool_t found = kFALSE;
+      for(UInt_t i=0;i<fBlocks.size() && !found;i++) {
+	TRegexp re(fBlocks[i], kTRUE);
+	Ssiz_t len;
+	found = (name.Index(re, &len) == 0 && len == name.Length());
+      }
+      if(!found) continue;
+      Column* col = new Column;
+      col->name = name;
+      switch(var->GetType()) {
+      case kFloat:
+	col->type = kColFloat;
+	break;
+      case kInt: case kUInt: case kShort: case kUShort:
+      case kChar: case kUChar: case kLong: case kULong:
+	col->type = kColInt;
+	break;
+      default:
+	col->type = kColDouble;
+      }
+      col->step = 0;
+      if(col->type != kColInt) {
+	for(UInt_t i=0;i<fQuantPatterns.size();i++) {
+	  TRegexp re(fQuantPatterns[i], kTRUE);
+	  Ssiz_t len;
+	  if(name.Index(re, &len) == 0 && len == name.Length()) {
+	    col->step = fQuantSteps[i];
+	    break;
+	  }
+	}
+      }
+      col->isarray = var->IsArray();
+      col->var = var;
+      fColumns.push_back(col);
+    }
+    if(fColumns.empty()) {
+      ::Warning("THcColumnWriter::Init", "No variables match the definitions");
+    }
+  } else {
+    for(UInt_t i=0;i<fColumns.size();i++) {
+      fColumns[i]->var = gHaVars->Find(fColumns[i]->name.Data());
+    }
+  }
+
+  if(!fFile) {
+    fFile = fopen(fFileName.Data(), "wb");
+    if(!fFile) {
+      ::Error("THcColumnWriter::Init", "Can not create %s", fFileName.Data());
+      return -1;
+    }
+    fwrite(kMagic, 1, sizeof(kMagic), fFile);
+  }
+  cout << "THcColumnWriter: " << fColumns.size() << " variables to "
+       << fFileName << endl;
+  return 0;
+}
+
+//_____________________________________________________________________________
+void THcColumnWriter::Process()
+{
+  // Add the values of the current event to the columns
+  if(!fFile) return;
+  for(UInt_t i=0;i<fColumns.size();i++) {
+    Column* col = fColumns[i];
+    THaVar* var = col->var;
+    Int_t len = var ? var->GetLen() : 0;
+    if(len < 0) len = 0;
+    if(col->isarray) {
+      col->lengths.push_back(len);
+    } else if(len != 1) {	// Scalars always have one value
+      col->values.push_back(0);
+      continue;
+    }
+    for(Int_t j=0;j<len;j++) {
+      col->values.push_back(var->GetValue(j));
+    }
+  }
+  if(++fNEvents >= fChunkSize) WriteChunk();
+}
+
+//_____________________________________________________________________________
+void THcColumnWriter::End()
+{
+  // Write the events collected so far and the footer.  Chunks written
+  // later replace the footer.
+  if(!fFile) return;
+  if(fNEvents > 0) WriteChunk();
+  WriteFooter();
+}
+
+//_____________________________________________________________________________
+void THcColumnWriter::EncodeColumns(Int_t first, Int_t step)
+{
+  for(UInt_t i=first;i<fColumns.size();i+=step) {
+    Encode(*fColumns[i]);
+  }
+}
+
+//_____________________________________________________________________________
+void THcColumnWriter::EncodeSlice(void* arg, Int_t islice, Int_t nslices)
+{
+  // Task of the worker pool
+  static_cast<THcColumnWriter*>(arg)->EncodeColumns(islice, nslices);
+}
+
+//_____________________________________________________________________________
+void THcColumnWriter::WriteChunk()
+{
+  // Encode the columns of the current chunk and append them to the file
+  if(fNThreads != 1 && fColumns.size() > 1) {
+    if(!fPool) fPool = new THcWorkerPool;
+    fPool->SetNThreads(fNThreads);
+    Int_t nthreads = fPool->GetNThreads();
+    if(nthreads > (Int_t)fColumns.size()) nthreads = fColumns.size();
+    fPool->Run(&THcColumnWriter::EncodeSlice, this, nthreads);
+  } else {
+    EncodeColumns(0, 1);
+  }
+
+  if(fFooterOffset >= 0) {	// Overwrite the footer of the last run
+    fseeko(fFile, fFooterOffset, SEEK_SET);
+    fFooterOffset = -1;
+  }
+  fChunkOffsets.push_back(ftello(fFile));
+  fChunkEvents.push_back(fNEvents);
+  UInt_t nev = fNEvents, ncols = fColumns.size();
+  fwrite("CHNK", 1, 4, fFile);
+  fwrite(&nev, sizeof(nev), 1, fFile);
+  fwrite(&ncols, sizeof(ncols), 1, fFile);
+  for(UInt_t i=0;i<fColumns.size();i++) {
+    ULong64_t size = fColumns[i]->blob.size();
+    fwrite(&size, sizeof(size), 1, fFile);
+  }
+  for(UInt_t i=0;i<fColumns.size();i++) {
+    Column* col = fColumns[i];
+    if(!col->blob.empty()) fwrite(&col->blob[0], 1, col->blob.size(), fFile);
+    col->blob.clear();
+    col->values.clear();
+    col->lengths.clear();
+  }
+  fNTotal += fNEvents;
+  fNEvents = 0;
+}
+
+//_____________________________________________________________________________
+void THcColumnWriter::WriteFooter()
+{
+  // Schema and chunk index, followed by the offset of the footer
+  Long64_t offset = ftello(fFile);
+  fwrite("FOOT", 1, 4, fFile);
+  UInt_t ncols = fColumns.size();
+  fwrite(&ncols, sizeof(ncols), 1, fFile);
+  for(UInt_t i=0;i<fColumns.size();i++) {
+    const Column* col = fColumns[i];
+    UInt_t len = col->name.Length();
+    fwrite(&len, sizeof(len), 1, fFile);
+    fwrite(col->name.Data(), 1, len, fFile);
+    Int_t type = col->type;
+    UChar_t isarray = col->isarray;
+    fwrite(&type, sizeof(type), 1, fFile);
+    fwrite(&col->step, sizeof(col->step), 1, fFile);
+    fwrite(&isarray, 1, 1, fFile);
+  }
+  UInt_t nchunks = fChunkOffsets.size();
+  fwrite(&nchunks, sizeof(nchunks), 1, fFile);
+  for(UInt_t i=0;i<nchunks;i++) {
+    fwrite(&fChunkOffsets[i], sizeof(Long64_t), 1, fFile);
+    fwrite(&fChunkEvents[i], sizeof(UInt_t), 1, fFile);
+  }
+  fwrite(&offset, sizeof(offset), 1, fFile);
+  fwrite(kEndMagic, 1, sizeof(kEndMagic), fFile);
+  fflush(fFile);
+  if(ftruncate(fileno(fFile), ftello(fFile)) != 0) { // Remove an older, longer footer
+    ::Warning("THcColumnWriter::WriteFooter", "Can not truncate %s",
+	      fFileName.Data());
+  }
+  fFooterOffset = offset;
+  cout << "THcColumnWriter: " << fNTotal << " events in "
+       << nchunks << " chunks written to " << fFileName << endl;
+}
+
+//_____________________________________________________________________________
+void THcColumnWriter::Encode(Column& col)
+{
+  /**
+     Encode the values of one chunk into col.blob:
+
+         flags, mode                    1 byte each
+         default value                  Double_t, if kSuppressed
+         lengths                        packed deltas, if kIsArray
+         bitmap of non-default values   if kSuppressed
+         values                         packed deltas or raw, by mode
+  */
+  vector<UChar_t>& out = col.blob;
+  out.clear();
+  const vector<Double_t>& values = col.values;
+  size_t n = values.size();
+
+  UChar_t flags = col.isarray ? kIsArray : 0;
+  Double_t defval = 0;
+  size_t ndef = 0;
+  if(n > 0) {			// Most common value of the first values
+    map<Double_t, Int_t> counts;
+    size_t nsample = TMath::Min(n, (size_t)1024);
+    for(size_t i=0;i<nsample;i++) {
+      if(values[i] == values[i]) counts[values[i]]++; // Not NaN
+    }
+    Int_t best = 0;
+    for(map<Double_t, Int_t>::iterator it=counts.begin(); it!=counts.end(); ++it) {
+      if(it->second > best) {
+	best = it->second;
+	defval = it->first;
+      }
+    }
+    for(size_t i=0;i<n;i++) if(values[i] == defval) ndef++;
+  }
+  if(ndef*4 > n) flags |= kSuppressed;
+
+  vector<Double_t> present;
+  const vector<Double_t>* stored = &values;
+  if(flags & kSuppressed) {
+    present.reserve(n - ndef);
+    for(size_t i=0;i<n;i++) if(values[i] != defval) present.push_back(values[i]);
+    stored = &present;
+  }
+  size_t m = stored->size();
+
+  // Integers when exact, otherwise the values as they are
+  UChar_t mode = (col.type == kColFloat) ? kModeFloat : kModeDouble;
+  vector<Long64_t> ints(m);
+  {
+    Bool_t exact = kTRUE;
+    for(size_t i=0;i<m && exact;i++) {
+      Double_t x = (*stored)[i];
+      if(col.step > 0) x = floor(x/col.step + 0.5);
+      if(!(fabs(x) < kMaxExact) || x != floor(x)) {
+	exact = kFALSE;
+      } else {
+	ints[i] = (Long64_t)x;
+      }
+    }
+    if(exact) {
+      mode = (col.step > 0) ? kModeQuant : kModeInt;
+    }
+  }
+
+  out.push_back(flags);
+  out.push_back(mode);
+  if(flags & kSuppressed) PutBytes(out, &defval, sizeof(defval));
+  if(flags & kIsArray) {
+    vector<Long64_t> lengths(col.lengths.begin(), col.lengths.end());
+    PackDelta(out, lengths.empty() ? 0 : &lengths[0], lengths.size());
+  }
+  if(flags & kSuppressed) {
+    size_t start = out.size();
+    out.resize(start + (n+7)/8, 0);
+    for(size_t i=0;i<n;i++) {
+      if(values[i] != defval) out[start + (i>>3)] |= 1 << (i&7);
+    }
+  }
+  switch(mode) {
+  case kModeInt: case kModeQuant:
+    PackDelta(out, ints.empty() ? 0 : &ints[0], m);
+    break;
+  case kModeFloat:
+    for(size_t i=0;i<m;i++) {
+      Float_t f = (*stored)[i];
+      PutBytes(out, &f, sizeof(f));
+    }
+    break;
+  default:
+    if(m > 0) PutBytes(out, &(*stored)[0], m*sizeof(Double_t));
+  }
+}
+
+//_____________________________________________________________________________
+Int_t THcColumnWriter::Decode(const UChar_t* blob, size_t size, Double_t step,
+			      Bool_t isarray, Int_t nevents,
+			      vector<Double_t>& values, vector<UInt_t>& lengths)
+{
+  /**
+     Decode one chunk of a column written by Encode.  Returns the number
+     of values, or -1 if the data are corrupt.
+  */
+  const UChar_t* p = blob;
+  const UChar_t* end = blob + size;
+  lengths.clear();
+  values.clear();
+  if(size < 2) return -1;
+  UChar_t flags = *p++;
+  UChar_t mode = *p++;
+  if(((flags & kIsArray) != 0) != isarray) return -1;
+  Double_t defval = 0;
+  if(flags & kSuppressed) {
+    if((size_t)(end - p) < sizeof(defval)) return -1;
+    memcpy(&defval, p, sizeof(defval));
+    p += sizeof(defval);
+  }
+  size_t n = 0;
+  if(flags & kIsArray) {
+    vector<Long64_t> lens;
+    if(!UnpackDelta(p, end, lens) || (Int_t)lens.size() != nevents) return -1;
+    lengths.resize(nevents);
+    for(Int_t i=0;i<nevents;i++) {
+      lengths[i] = lens[i];
+      n += lens[i];
+    }
+  } else {
+    lengths.assign(nevents, 1);
+    n = nevents;
+  }
+  const UChar_t* bitmap = 0;
+  size_t m = n;
+  if(flags & kSuppressed) {
+    if((size_t)(end - p) < (n+7)/8) return -1;
+    bitmap = p;
+    p += (n+7)/8;
+    m = 0;
+    for(size_t i=0;i<n;i++) if(bitmap[i>>3] & (1 << (i&7))) m++;
+  }
+
+  vector<Double_t> stored(m);
+  switch(mode) {
+  case kModeInt: case kModeQuant: {
+    vector<Long64_t> ints;
+    if(!UnpackDelta(p, end, ints) || ints.size() != m) return -1;
+    for(size_t i=0;i<m;i++) {
+      stored[i] = (mode == kModeQuant) ? ints[i]*step : (Double_t)ints[i];
+    }
+    break;
+  }
+  case kModeFloat:
+    if((size_t)(end - p) < m*sizeof(Float_t)) return -1;
+    for(size_t i=0;i<m;i++) {
+      Float_t f;
+      memcpy(&f, p, sizeof(f));
+      p += sizeof(f);
+      stored[i] = f;
+    }
+    break;
+  case kModeDouble:
+    if((size_t)(end - p) < m*sizeof(Double_t)) return -1;
+    if(m > 0) memcpy(&stored[0], p, m*sizeof(Double_t));
+    p += m*sizeof(Double_t);
+    break;
+  default:
+    return -1;
+  }
+
+  if(!bitmap) {
+    values.swap(stored);
+  } else {
+    values.resize(n);
+    size_t j = 0;
+    for(size_t i=0;i<n;i++) {
+      values[i] = (bitmap[i>>3] & (1 << (i&7))) ? stored[j++] : defval;
+    }
+  }
+  return n;
+}
+
+ClassImp(THcColumnWriter)
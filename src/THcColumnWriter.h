@@ -0,0 +1,88 @@
+#ifndef ROOT_THcColumnWriter
+#define ROOT_THcColumnWriter
+
+//////////////////////////////////////////////////////////////////////////
+//
+// THcColumnWriter
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "Rtypes.h"
+#include "TString.h"
+#include <vector>
+#include <cstdio>
+
+class THaVar;
+class THcWorkerPool;
+
+class THcColumnWriter {
+
+public:
+
+  THcColumnWriter(const char* filename, Int_t chunksize=4096, Int_t nthreads=1);
+  virtual ~THcColumnWriter();
+
+  Int_t  LoadDefinitions(const char* deffile);
+  void   AddBlock(const char* pattern) {fBlocks.push_back(pattern);}
+  void   AddQuantization(const char* pattern, Double_t step);
+  void   SetNThreads(Int_t n) {fNThreads = n;}
+
+  Int_t  Init();
+  void   Process();
+  void   End();
+
+  enum EColType { kColDouble, kColFloat, kColInt };
+  enum EFlags { kIsArray = 1, kSuppressed = 2 };
+  enum EMode { kModeDouble, kModeFloat, kModeInt, kModeQuant };
+
+  // One global variable (scalar or array)
+  struct Column {
+    TString  name;
+    Int_t    type;		// EColType
+    Double_t step;		// Quantization step, 0 if none
+    Bool_t   isarray;
+    THaVar*  var;
+    std::vector<UInt_t>   lengths; // Per event, arrays only
+    std::vector<Double_t> values;
+    std::vector<UChar_t>  blob;	// Encoded chunk
+  };
+
+  // Shared with THcColumnReader
+  static void  Encode(Column& col);
+  static Int_t Decode(const UChar_t* blob, size_t size, Double_t step,
+		      Bool_t isarray, Int_t nevents,
+		      std::vector<Double_t>& values, std::vector<UInt_t>& lengths);
+
+  static const char kMagic[8];
+  static const char kEndMagic[8];
+
+protected:
+
+  void   WriteChunk();
+  void   WriteFooter();
+  void   EncodeColumns(Int_t first, Int_t step);
+  static void EncodeSlice(void* arg, Int_t islice, Int_t nslices);
+
+  TString  fFileName;
+  FILE*    fFile;
+  Int_t    fChunkSize;		// Events per chunk
+  Int_t    fNThreads;		// 0: one per core
+  Int_t    fNEvents;		// Events in the current chunk
+  Long64_t fNTotal;		// Events written
+  Long64_t fFooterOffset;	// Footer written at End, -1 if none
+  std::vector<TString>  fBlocks;	// Variable name patterns
+  std::vector<TString>  fQuantPatterns;
+  std::vector<Double_t> fQuantSteps;
+  std::vector<Column*>  fColumns;
+  std::vector<Long64_t> fChunkOffsets;
+  std::vector<UInt_t>   fChunkEvents;
+  THcWorkerPool*        fPool;	//! Encoding threads, kept for all chunks
+
+private:
+  THcColumnWriter(const THcColumnWriter&);
+  THcColumnWriter& operator=(const THcColumnWriter&);
+
+  ClassDef(THcColumnWriter,0)	// Columnar output of global variables
+};
+
+#endif
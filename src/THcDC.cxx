@@ -27,12 +27,16 @@ the number of parameters per plane.
 #include "TMath.h"
 #include "TVectorD.h"
 #include "THaApparatus.h"
+#include "THcMemoryReport.h"
 #include "THcHallCSpectrometer.h"
+#include "THcAnalyzer.h"
+#include "THcDCLookupTTDConv.h"
 
 #include <cstring>
 #include <cstdio>
 #include <cstdlib>
 #include <iostream>
+#include <fstream>
 
 using namespace std;
 
@@ -74,6 +78,12 @@ THcDC::THcDC(
   fPlaneTimeZero = NULL;
   fSigma = NULL;
 
+  fPlaneCoeffs = NULL;
+  fResiduals = NULL;
+  fResidualsExclPlane = NULL;
+  fWire_hit_did = NULL;
+  fWire_hit_should = NULL;
+
   // These should be set to zero (in a parameter file) in order to
   // replicate historical ENGINE behavior
   fFixLR = 1;
@@ -82,11 +92,13 @@ THcDC::THcDC(
 
   fDCTracks = new TClonesArray( "THcDCTrack", 20 );
 
-  fNChamHits = 0;
-  fPlaneEvents = 0;
+  fTotEventsId = fNChamHitsId = fPlaneEventsId = -1;
+  fDoWireEff = kTRUE;
 
   //The version defaults to 0 (old HMS style). 1 is new HMS style and 2 is SHMS style.
   fVersion = 0;
+  fTimeSpacePoints = kFALSE;
+  fNSpacePointCalls = 0;
 }
 
 //_____________________________________________________________________________
@@ -187,7 +199,9 @@ void THcDC::Setup(const char* name, const char* description)
 
 //_____________________________________________________________________________
 THcDC::THcDC( ) :
-  THaTrackingDetector()
+  THaTrackingDetector(), fResiduals(NULL), fResidualsExclPlane(NULL),
+  fWire_hit_did(NULL), fWire_hit_should(NULL), fTimeSpacePoints(kFALSE),
+  fNSpacePointCalls(0), fPlaneCoeffs(NULL)
 {
   // Constructor
 }
@@ -197,8 +211,14 @@ THaAnalysisObject::EStatus THcDC::Init( const TDatime& date )
 {
   // Register the plane objects with the appropriate chambers.
   // Trigger ReadDatabase to load the remaining parameters
-  Setup(GetName(), GetTitle());	// Create the subdetectors here
+  // The subdetectors are only created the first time, so that a new Init
+  // (e.g. for the next run of a THcBatchReplay) keeps them and their
+  // global variables.
+  Bool_t newplanes = fPlanes.empty();
+  if(newplanes) Setup(GetName(), GetTitle());	// Create the subdetectors here
   EffInit();
+  fSpacePointTimer.Reset();	// A TStopwatch starts when it is made
+  fNSpacePointCalls = 0;
 
   char EngineDID[] = "xDC";
   EngineDID[0] = toupper(GetApparatus()->GetName()[0]);
@@ -225,7 +245,7 @@ THaAnalysisObject::EStatus THcDC::Init( const TDatime& date )
   for(Int_t ip=0;ip<fNPlanes;ip++) {
     if((status = fPlanes[ip]->Init( date ))) {
       return fStatus=status;
-    } else {
+    } else if(newplanes) {
       Int_t chamber=fNChamber[ip];
       fChambers[chamber-1]->AddPlane(fPlanes[ip]);
     }
@@ -237,15 +257,16 @@ THaAnalysisObject::EStatus THcDC::Init( const TDatime& date )
     }
   }
   // Retrieve the fiting coefficients
-  fPlaneCoeffs = new Double_t* [fNPlanes];
+  // Init is called again for each run of a THcBatchReplay
+  delete [] fPlaneCoeffs;  fPlaneCoeffs = new Double_t* [fNPlanes];
   for(Int_t ip=0; ip<fNPlanes;ip++) {
     fPlaneCoeffs[ip] = fPlanes[ip]->GetPlaneCoef();
   }
 
-  fResiduals = new Double_t [fNPlanes];
-  fResidualsExclPlane = new Double_t [fNPlanes];
-  fWire_hit_did = new Double_t [fNPlanes];
-  fWire_hit_should = new Double_t [fNPlanes];
+  delete [] fResiduals;  fResiduals = new Double_t [fNPlanes];
+  delete [] fResidualsExclPlane;  fResidualsExclPlane = new Double_t [fNPlanes];
+  delete [] fWire_hit_did;  fWire_hit_did = new Double_t [fNPlanes];
+  delete [] fWire_hit_should;  fWire_hit_should = new Double_t [fNPlanes];
 
 
   // Replace with what we need for Hall C
@@ -260,6 +281,11 @@ THaAnalysisObject::EStatus THcDC::Init( const TDatime& date )
   if(vpresent) {
     fPresentP = (Bool_t *) vpresent->GetValuePointer();
   }
+
+  // Per wire efficiency is only used by the wireHitDid/wireHitShould
+  // variables
+  fDoWireEff = THcAnalyzer::IsOutputRequested(Form("%swireHitDid",GetPrefix()))
+    || THcAnalyzer::IsOutputRequested(Form("%swireHitShould",GetPrefix()));
   return fStatus = kOK;
 }
 
@@ -368,8 +394,12 @@ Int_t THcDC::ReadDatabase( const TDatime& date )
    DBRequest listOpt[]={
      {"dc_xpos", fXPos, kDouble, (UInt_t)fNPlanes, optional},
      {"dc_ypos", fYPos, kDouble, (UInt_t)fNPlanes, optional},
+     {"dc_calc_driftmap", &fCalcDriftMap, kInt, 0, optional},
+     {"dc_driftmap_file", &fDriftMapFile, kString, 0, optional},
      {0}
    };
+   fCalcDriftMap = 0;
+   fDriftMapFile = Form("%sdriftmap_new.param", fPrefix);
    gHcParms->LoadParmValues((DBRequest*)&listOpt,fPrefix);
   if(fNTracksMaxFP <= 0) fNTracksMaxFP = 10;
   // if(fNTracksMaxFP > HNRACKS_MAX) fNTracksMaxFP = NHTRACKS_MAX;
@@ -479,10 +509,6 @@ void THcDC::DeleteArrays()
   delete [] fPlaneTimeZero;   fPlaneTimeZero = NULL;
   delete [] fSigma;   fSigma = NULL;
 
-  // Efficiency arrays
-  delete [] fNChamHits; fNChamHits = NULL;
-  delete [] fPlaneEvents; fPlaneEvents = NULL;
-
   for( Int_t i = 0; i<fNPlanes; ++i )
     delete [] fPlaneNames[i];
   delete [] fPlaneNames;
@@ -601,7 +627,14 @@ Int_t THcDC::CoarseTrack( TClonesArray& tracks )
     }
     //
   for(UInt_t i=0;i<fNChambers;i++) {
-    fChambers[i]->FindSpacePoints();
+    if(fTimeSpacePoints) {
+      fSpacePointTimer.Start(kFALSE);
+      fChambers[i]->FindSpacePoints();
+      fSpacePointTimer.Stop();
+      fNSpacePointCalls++;
+    } else {
+      fChambers[i]->FindSpacePoints();
+    }
     fChambers[i]->CorrectHitTimes();
     fChambers[i]->LeftRight();
   }
@@ -662,8 +695,9 @@ void THcDC::SetFocalPlaneBestTrack(Int_t golden_track_index)
 	Int_t plane = hit->GetPlaneNum() - 1;
         fResiduals[plane] = tr1->GetResidual(plane);
         fResidualsExclPlane[plane] = tr1->GetResidualExclPlane(plane);
+	if(fCalcDriftMap) hit->GetWirePlane()->AccumulateDriftTime(hit->GetTime());
 	 } 
-	 EfficiencyPerWire(golden_track_index);
+	 if(fDoWireEff) EfficiencyPerWire(golden_track_index);
 }
 //
 void THcDC::EfficiencyPerWire(Int_t golden_track_index)
@@ -1286,9 +1320,47 @@ Int_t THcDC::End(THaRunBase* run)
 {
   //  EffCalc();
   MissReport(Form("%s.%s", GetApparatus()->GetName(), GetName()));
+  if(fCalcDriftMap) WriteDriftMaps();
+  if(fTimeSpacePoints && fNSpacePointCalls > 0) {
+    Long64_t ncalls = fNSpacePointCalls;
+    Double_t real = fSpacePointTimer.RealTime(), cpu = fSpacePointTimer.CpuTime();
+    cout << GetApparatus()->GetName() << "." << GetName()
+	 << " FindSpacePoints: " << ncalls << " calls, "
+	 << real << " s real, " << cpu << " s cpu, "
+	 << Form("%.2f", 1e6*real/ncalls) << " us real per call" << endl;
+  }
   return 0;
 }
 
+//_____________________________________________________________________________
+void THcDC::WriteDriftMaps()
+{
+  /**
+     Write the drift maps accumulated by the planes during the replay to
+     dc_driftmap_file, in the format of the driftmap parameter files, so
+     that the next replay can load them.
+  */
+  THcDCLookupTTDConv* conv = dynamic_cast<THcDCLookupTTDConv*>(fPlanes[0]->GetTTDConv());
+  if(!conv) return;
+  ofstream ofile(fDriftMapFile.c_str());
+  if(!ofile.is_open()) {
+    Error(Here("WriteDriftMaps"), "Can not open %s", fDriftMapFile.c_str());
+    return;
+  }
+  cout << "Writing " << GetApparatus()->GetName() << " drift maps to "
+       << fDriftMapFile << endl;
+  ofile << "; Lookup table made from golden track hits" << endl;
+  ofile << ";number of bins in time to distance lookup table" << endl;
+  ofile << fPrefix << "driftbins=" << conv->GetNumBins() << endl;
+  ofile << ";time of 1st bin in ns" << endl;
+  ofile << fPrefix << "drift1stbin=" << conv->GetT0() << endl;
+  ofile << ";bin size in ns" << endl;
+  ofile << fPrefix << "driftbinsz=" << conv->GetBinSize() << endl;
+  for(Int_t ip=0;ip<fNPlanes;ip++) {
+    fPlanes[ip]->WriteDriftMap(ofile, fPrefix);
+  }
+}
+
 //_____________________________________________________________________________
 void THcDC::EffInit()
 {
@@ -1298,19 +1370,10 @@ void THcDC::EffInit()
      variables can be used in end of run reports.
   */
 
-  delete [] fNChamHits; fNChamHits = new Int_t [fNChambers];
-  delete [] fPlaneEvents; fPlaneEvents = new Int_t [fNPlanes];
-
-  fTotEvents = 0;
-  for(UInt_t i=0;i<fNChambers;i++) {
-    fNChamHits[i] = 0;
-  }
-  for(Int_t i=0;i<fNPlanes;i++) {
-    fPlaneEvents[i] = 0;
-  }
-  gHcParms->Define(Form("%sdc_tot_events",fPrefix),"Total DC Events",fTotEvents);
-  gHcParms->Define(Form("%sdc_cham_hits[%d]",fPrefix,fNChambers),"N events with hits per chamber",*fNChamHits);
-  gHcParms->Define(Form("%sdc_events[%d]",fPrefix,fNPlanes),"N events with hits per plane",*fPlaneEvents);
+  fEffStats.Clear();
+  fTotEventsId = fEffStats.DefineCounter(Form("%sdc_tot_events",fPrefix),"Total DC Events");
+  fNChamHitsId = fEffStats.DefineCounter(Form("%sdc_cham_hits",fPrefix),"N events with hits per chamber",fNChambers);
+  fPlaneEventsId = fEffStats.DefineCounter(Form("%sdc_events",fPrefix),"N events with hits per plane",fNPlanes);
 }
 
 //_____________________________________________________________________________
@@ -1320,15 +1383,27 @@ void THcDC::Eff()
      Accumulate statistics for efficiency calculations
   */
 
-  fTotEvents++;
+  fEffStats.Increment(fTotEventsId);
   for(UInt_t i=0;i<fNChambers;i++) {
-    if(fChambers[i]->GetNHits()>0) fNChamHits[i]++;
+    if(fChambers[i]->GetNHits()>0) fEffStats.Increment(fNChamHitsId, i);
   }
   for(Int_t i=0;i<fNPlanes;i++) {
-    if(fPlanes[i]->GetNHits() > 0) fPlaneEvents[i]++;
+    if(fPlanes[i]->GetNHits() > 0) fEffStats.Increment(fPlaneEventsId, i);
   }
   return;
 }
 
+//_____________________________________________________________________________
+void THcDC::AccountMemory( THcMemoryReport& report ) const
+{
+  // Raw hits, the chambers, the planes and the tracks found from the
+  // stubs
+  THcHitList::AccountMemory(report);
+  for(UInt_t ic=0;ic<fChambers.size();ic++) fChambers[ic]->AccountMemory(report);
+  for(UInt_t ip=0;ip<fPlanes.size();ip++) fPlanes[ip]->AccountMemory(report);
+  report.Add("tracks", THcMemoryReport::Bytes(fDCTracks)
+	     + THcMemoryReport::Bytes(fTrackProj), THcMemoryReport::kDynamic);
+}
+
 ClassImp(THcDC)
 ////////////////////////////////////////////////////////////////////////////////
@@ -14,6 +14,8 @@
 #include "THcDriftChamberPlane.h"
 #include "THcDriftChamber.h"
 #include "TMath.h"
+#include "TStopwatch.h"
+#include <string>
 
 #define NUM_FPRAY 4
 
@@ -30,6 +32,7 @@ public:
   virtual Int_t      Decode( const THaEvData& );
   virtual EStatus    Init( const TDatime& run_time );
   virtual Int_t      End(THaRunBase* run=0);
+  virtual void       AccountMemory( THcMemoryReport& report ) const;
   virtual Int_t      CoarseTrack( TClonesArray& tracks );
   virtual Int_t      FineTrack( TClonesArray& tracks );
 
@@ -65,6 +68,9 @@ public:
   Int_t GetReadoutLR(Int_t plane) const { return fReadoutLR[plane-1];}
   Int_t GetReadoutTB(Int_t plane) const { return fReadoutTB[plane-1];}
   Int_t GetVersion() const {return fVersion;}
+  Int_t GetCalcDriftMap() const {return fCalcDriftMap;}
+  // Time every FindSpacePoints call and print the totals at End
+  void  SetTimeSpacePoints(Bool_t enable=kTRUE) {fTimeSpacePoints = enable;}
 
 
   Double_t GetPlaneTimeZero(Int_t plane) const { return fPlaneTimeZero[plane-1];}
@@ -124,6 +130,12 @@ protected:
   Double_t* fResidualsExclPlane;         //[fNPlanes] Array of residuals with plane excluded
   Double_t* fWire_hit_did;      //[fNPlanes]
   Double_t* fWire_hit_should;   //[fNPlanes]
+  Bool_t fDoWireEff;            // Compute per wire efficiency (only if used)
+  Int_t fCalcDriftMap;          // Make drift maps from golden track hits
+  std::string fDriftMapFile;    // Parameter file the drift maps are written to
+  Bool_t fTimeSpacePoints;      // Time the FindSpacePoints calls
+  TStopwatch fSpacePointTimer;  //! Summed over the calls of a run
+  Long64_t fNSpacePointCalls;
 
   Double_t fNSperChan;		/* TDC bin size */
   Double_t fWireVelocity;
@@ -178,9 +190,10 @@ protected:
   Int_t fSp2_ID_best;
   Bool_t fInSideDipoleExit_best;
  // For accumulating statitics for efficiencies
-  Int_t fTotEvents;
-  Int_t* fNChamHits;
-  Int_t* fPlaneEvents;
+  THcRunStats fEffStats;
+  Int_t fTotEventsId;
+  Int_t fNChamHitsId;
+  Int_t fPlaneEventsId;
 
   // Pointer to global var indicating whether this spectrometer is triggered
   // for this event.
@@ -205,6 +218,7 @@ protected:
   void           TrackFit();
   Double_t       DpsiFun(Double_t ray[4], Int_t plane);
   void           EffInit();
+  void           WriteDriftMaps();
   void           Eff();
 
   void Setup(const char* name, const char* description);
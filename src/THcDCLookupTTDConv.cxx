@@ -38,6 +38,16 @@ Double_t THcDCLookupTTDConv::ConvertTimeToDist(Double_t time)
   /**
      Convert drift time to a distance from the wire by looking up in a table.
   */
+  return fMaxDriftDistance * GetFraction(time);
+}
+
+//______________________________________________________________________________
+Double_t THcDCLookupTTDConv::GetFraction(Double_t time) const
+{
+  /**
+     Fraction of the maximum drift distance for a drift time, interpolated
+     between the table entries.
+  */
   Int_t ib = (time-fT0)/fBinSize;
   Double_t frac = 0;
   if(ib >= 0 && ib+1 < fNumBins) {
@@ -47,10 +57,7 @@ Double_t THcDCLookupTTDConv::ConvertTimeToDist(Double_t time)
     frac = 1.0;
   }
 
-  Double_t drift_distance = fMaxDriftDistance * frac;
-
-
-  return(drift_distance);
+  return(frac);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
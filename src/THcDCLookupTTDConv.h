@@ -20,6 +20,12 @@ public:
 
   virtual Double_t ConvertTimeToDist(Double_t time);
 
+  Double_t GetFraction(Double_t time) const;
+  Double_t GetT0() const { return fT0; }
+  Double_t GetBinSize() const { return fBinSize; }
+  Int_t    GetNumBins() const { return fNumBins; }
+  const Double_t* GetTable() const { return fTable; }
+
 
 protected:
 
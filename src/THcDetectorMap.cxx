@@ -9,6 +9,7 @@ FillMap method builds a map for a specific detector
 
 */
 #include "THcDetectorMap.h"
+#include "THcInitScheduler.h"
 
 #include "TObjArray.h"
 #include "TObjString.h"
@@ -55,9 +56,13 @@ Int_t THcDetectorMap::FillMap(THaDetMap *detmap, const char *detectorname)
   \param name of the detector
 
   Called be each detector object to build a DAQ hardware to detector
-  element map for the detector.
+  element map for the detector.  Only reads the map, so detectors
+  initialized by a THcInitScheduler may call it concurrently.
 */
 
+  THcInitScheduler::ParallelSection parallel;
+
+  list<ModChanList> mlist;
   list<ModChanList>::iterator imod;
   list<ChaninMod>::iterator ichan;
   ChaninMod Achan;
@@ -79,7 +84,6 @@ Int_t THcDetectorMap::FillMap(THaDetMap *detmap, const char *detectorname)
     did = 0;
   }
 
-  mlist.clear();
   //  cout << "fNchans=" << fNchans << endl;
   for(Int_t ich=0;ich<fNchans;ich++) {
     if(fTable[ich].did == did) {
@@ -51,7 +51,6 @@ class THcDetectorMap : public TObject {
     std::list<ChaninMod> clist;
 
   };
-  std::list<ModChanList> mlist;
 
   struct IDMap {
     char* name;
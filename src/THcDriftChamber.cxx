@@ -23,6 +23,8 @@
 #include "TVectorD.h"
 #include "THcSpacePoint.h"
 #include "THaApparatus.h"
+#include "THcMemoryReport.h"
+#include "TClass.h"
 
 #include "THaTrackProj.h"
 
@@ -34,6 +36,32 @@
 
 using namespace std;
 
+//_____________________________________________________________________________
+static inline Int_t PopCount( UInt_t w )
+{
+  // Number of set bits of w
+#ifdef __GNUC__
+  return __builtin_popcount(w);
+#else
+  Int_t n = 0;
+  for( ; w; w &= w-1 ) ++n;
+  return n;
+#endif
+}
+
+//_____________________________________________________________________________
+static inline Int_t LowestBit( UInt_t w )
+{
+  // Index of the lowest set bit of w != 0
+#ifdef __GNUC__
+  return __builtin_ctz(w);
+#else
+  Int_t i = 0;
+  while( !(w & 1) ) { w >>= 1; ++i; }
+  return i;
+#endif
+}
+
 //_____________________________________________________________________________
 THcDriftChamber::THcDriftChamber(
  const char* name, const char* description,
@@ -45,6 +73,7 @@ THcDriftChamber::THcDriftChamber(
   //  fTrackProj = new TClonesArray( "THaTrackProj", 5 );
   fTrackProj = NULL;
   fNPlanes = 0;			// No planes until we make them
+  YPlaneInd = YPlanePInd = -1;	// Set by AddPlane for HMS style chambers
 
   fChamberNum = chambernum;
 
@@ -61,6 +90,7 @@ THcDriftChamber::THcDriftChamber() :
   fTrackProj = NULL;
   fSpacePoints = NULL;
   fIsInit = 0;
+  YPlaneInd = YPlanePInd = -1;
 
 }
 //_____________________________________________________________________________
@@ -165,6 +195,12 @@ Int_t THcDriftChamber::ReadDatabase( const TDatime& date )
   fSpacePointCriterion = static_cast<THcDC*>(fParent)->GetSpacePointCriterion(fChamberNum);
   fMaxDist = TMath::Sqrt(fSpacePointCriterion/2.0); // For easy space points
 
+  if(fNPlanes > MAX_PLANES_PER_CHAMBER) { // Plane patterns are one word
+    Error(Here("ReadDatabase"), "%d planes, at most %d supported",
+	  fNPlanes, MAX_PLANES_PER_CHAMBER);
+    return kInitError;
+  }
+
   if (fhdebugflagpr) cout << " cham = " << fChamberNum << " Set yplane num " << YPlaneNum << " "<< YPlanePNum << endl;
   // Generate the HAA3INV matrix for all the acceptable combinations
   // of hit planes.  Try to make it as generic as possible
@@ -638,35 +674,22 @@ Int_t THcDriftChamber::FindHardSpacePoints()
 // HMS Specific?
 Int_t THcDriftChamber::DestroyPoorSpacePoints()
 {
-  Int_t nhitsperplane[fNPlanes];
-
   Int_t spacepointsgood[fNSpacePoints];
   Int_t ngood=0;
 
   for(Int_t i=0;i<fNSpacePoints;i++) {
     spacepointsgood[i] = 0;
   }
+  // Both Y planes, none if not HMS style
+  const UInt_t ymask = (YPlaneInd >= 0 && YPlanePInd >= 0)
+    ? (1U<<YPlaneInd) | (1U<<YPlanePInd) : 0;
   for(Int_t isp=0;isp<fNSpacePoints;isp++) {
-    Int_t nplanes_hit = 0;
-    for(Int_t ip=0;ip<fNPlanes;ip++) {
-      nhitsperplane[ip] = 0;
-    }
-    // Count # hits in each plane for this space point
+    // Planes that have hits for this space point
     THcSpacePoint* sp = (THcSpacePoint*)(*fSpacePoints)[isp];
-    for(Int_t ihit=0;ihit<sp->GetNHits();ihit++) {
-      THcDCHit* hit=sp->GetHit(ihit);
-      // hit_order(hit) = ihit;
-      Int_t ip = hit->GetPlaneIndex();
-      nhitsperplane[ip]++;
-    }
-    // Count # planes that have hits
-    for(Int_t ip=0;ip<fNPlanes;ip++) {
-      if(nhitsperplane[ip] > 0) {
-	nplanes_hit++;
-      }
-    }
-    if(nplanes_hit >= fMinHits && nhitsperplane[YPlaneInd]>0
-       && nhitsperplane[YPlanePInd] > 0) {
+    PlanePattern pat;
+    GetPlanePattern(sp, pat);
+    Int_t nplanes_hit = PopCount(pat.planes);
+    if(nplanes_hit >= fMinHits && (pat.planes & ymask) == ymask) {
       spacepointsgood[ngood++] = isp; // Build list of good points
     } else {
       //      if (fhdebugflagpr) cout << "Missing Y-hit!!";
@@ -731,6 +754,13 @@ Int_t THcDriftChamber::SpacePointMultiWire()
     Int_t newsp_num=0;
     //if (fhdebugflagpr) cout << "Looping thru space pts at # = " << isp << " total = " << fNSpacePoints << endl;
 
+    // Skip the space points that fail the plane conditions for cloning
+    // below without sorting their hits
+    PlanePattern pat;
+    GetPlanePattern((THcSpacePoint*)(*fSpacePoints)[isp], pat);
+    Int_t nmult = PopCount(pat.multi);
+    if(PopCount(pat.planes) < 4 || nmult >= 4 || nmult == 0) continue;
+
     for(Int_t ip=0;ip<fNPlanes;ip++) {
       nhitsperplane[ip] = 0;
       for(Int_t ih=0;ih<MAX_HITS_PER_POINT;ih++) {
@@ -859,32 +889,28 @@ void THcDriftChamber::ChooseSingleHit()
   for(Int_t isp=0;isp<fNSpacePoints;isp++) {
     THcSpacePoint* sp = (THcSpacePoint*)(*fSpacePoints)[isp];
     Int_t startnum = sp->GetNHits();
-    Int_t goodhit[startnum];
-    for(Int_t ihit=0;ihit<startnum;ihit++) {
-      goodhit[ihit] = 1;
+    PlanePattern pat;
+    GetPlanePattern(sp, pat);
+    if(!pat.multi) continue;	// Already one hit per plane
+    // For each plane with several hits, keep the first hit with the
+    // shortest drift time
+    Int_t besthit[MAX_PLANES_PER_CHAMBER];
+    for(UInt_t w=pat.multi; w; w &= w-1) {
+      besthit[LowestBit(w)] = -1;
     }
-    // For each plane, mark all hits longer than the shortest drift time
-    for(Int_t ihit1=0;ihit1<startnum-1;ihit1++) {
-      THcDCHit* hit1 = sp->GetHit(ihit1);
-      Int_t plane1=hit1->GetPlaneIndex();
-      Double_t tdrift1 = hit1->GetTime();
-      for(Int_t ihit2=ihit1+1;ihit2<startnum;ihit2++) {
-	THcDCHit* hit2 = sp->GetHit(ihit2);
-	Int_t plane2=hit2->GetPlaneIndex();
-	Double_t tdrift2 = hit2->GetTime();
-	if(plane1 == plane2) {
-	  if(tdrift1 > tdrift2) {
-	    goodhit[ihit1] = 0;
-	  } else {
-	    goodhit[ihit2] = 0;
-	  }
-	}
+    for(Int_t ihit=0;ihit<startnum;ihit++) {
+      Int_t ip = sp->GetHit(ihit)->GetPlaneIndex();
+      if(!(pat.multi & (1U<<ip))) continue;
+      if(besthit[ip] < 0
+	 || sp->GetHit(besthit[ip])->GetTime() > sp->GetHit(ihit)->GetTime()) {
+	besthit[ip] = ihit;
       }
     }
     // Gather the remaining hits
     Int_t finalnum = 0;
     for(Int_t ihit=0;ihit<startnum;ihit++) {
-      if(goodhit[ihit] > 0) {	// Keep this hit
+      Int_t ip = sp->GetHit(ihit)->GetPlaneIndex();
+      if(!(pat.multi & (1U<<ip)) || besthit[ip] == ihit) { // Keep this hit
 	if (ihit > finalnum) {	// Move hit
 	  sp->ReplaceHit(finalnum++, sp->GetHit(ihit));
 	} else {
@@ -1072,12 +1098,25 @@ void THcDriftChamber::CorrectHitTimes()
     }
   }
 }
+//_____________________________________________________________________________
 UInt_t THcDriftChamber::Count1Bits(UInt_t x)
-// From http://graphics.stanford.edu/~seander/bithacks.html
 {
-  x = x - ((x >> 1) & 0x55555555);
-  x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
-  return (((x + (x >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+  return PopCount(x);
+}
+
+//_____________________________________________________________________________
+void THcDriftChamber::GetPlanePattern(THcSpacePoint* sp, PlanePattern& pat)
+{
+  // Planes with hits and with several hits in space point sp, and the
+  // last hit of each plane with hits.
+  pat.planes = 0;
+  pat.multi = 0;
+  for(Int_t ihit=0;ihit<sp->GetNHits();ihit++) {
+    UInt_t bit = 1U<<sp->GetHit(ihit)->GetPlaneIndex();
+    pat.multi |= pat.planes & bit;
+    pat.planes |= bit;
+    pat.lasthit[sp->GetHit(ihit)->GetPlaneIndex()] = ihit;
+  }
 }
 
 //_____________________________________________________________________________
@@ -1093,17 +1132,25 @@ void THcDriftChamber::LeftRight()
     // Build a bit pattern of which planes are hit
     THcSpacePoint* sp = (THcSpacePoint*)(*fSpacePoints)[isp];
     Int_t nhits = sp->GetNHits();
-    UInt_t bitpat  = 0;		// Bit pattern of which planes are hit
+    PlanePattern pat;
+    GetPlanePattern(sp, pat);
+    UInt_t bitpat  = pat.planes;	// Bit pattern of which planes are hit
     Double_t maxchi2= 1.0e10;
     Double_t minchi2 = maxchi2;
     Double_t tmp_minchi2=maxchi2;
     Double_t minxp = 0.25;
     Int_t hasy1 = -1;
     Int_t hasy2 = -1;
-    Int_t plusminusknown[nhits];
-    Int_t plusminusbest[nhits];
+    if(fHMSStyleChambers) {
+      if(YPlaneInd >= 0 && (pat.planes & (1U<<YPlaneInd))) hasy1 = pat.lasthit[YPlaneInd];
+      if(YPlanePInd >= 0 && (pat.planes & (1U<<YPlanePInd))) hasy2 = pat.lasthit[YPlanePInd];
+    }
+    // Left/right of the hits as bit ihit, set for +1
+    UInt_t lrknown = 0;		// Hits with left/right known
+    UInt_t lrknownplus = 0;
+    UInt_t lrbest = 0;
+    UInt_t tmp_lr = 0;
     Int_t plusminus[nhits];	// ENGINE makes this array float.  Why?
-    Int_t tmp_plusminus[nhits];
     Int_t plane_list[nhits];
     Double_t stub[4];
     Double_t tmp_stub[4];
@@ -1115,29 +1162,19 @@ void THcDriftChamber::LeftRight()
       if (fhdebugflagpr) cout << "THcDriftChamber::LeftRight() nhits = 0" << endl;
     }
     for(Int_t ihit=0;ihit < nhits;ihit++) {
-      THcDCHit* hit = sp->GetHit(ihit);
-      Int_t pindex = hit->GetPlaneIndex();
-      plane_list[ihit] = pindex;
-
-      bitpat |= 1<<pindex;
-
-      plusminusknown[ihit] = 0;
-
-      if(pindex == YPlaneInd) hasy1 = ihit;
-      if(pindex == YPlanePInd) hasy2 = ihit;
+      plane_list[ihit] = sp->GetHit(ihit)->GetPlaneIndex();
     }
     nplusminus = 1<<nhits;
     if(fHMSStyleChambers) {
       Int_t smallAngOK = (hasy1>=0) && (hasy2>=0);
       if(fSmallAngleApprox !=0 && smallAngOK) { // to small Angle L/R for Y,Y' planes
 
+	lrknown |= (1U<<hasy1) | (1U<<hasy2);
 	if(sp->GetHit(hasy2)->GetPos() <=
 	   sp->GetHit(hasy1)->GetPos()) {
-	  plusminusknown[hasy1] = -1;
-	  plusminusknown[hasy2] = 1;
+	  lrknownplus |= 1U<<hasy2;
 	} else {
-	  plusminusknown[hasy1] = 1;
-	  plusminusknown[hasy2] = -1;
+	  lrknownplus |= 1U<<hasy1;
 	}
 	nplusminus = 1<<(nhits-2);
 	//	if (fhdebugflagpr) cout << " Small angle approx = " << smallAngOK << " " << plusminusknown[hasy1] << endl;
@@ -1151,16 +1188,17 @@ void THcDriftChamber::LeftRight()
 	for(Int_t ihit1=0;ihit1 < nhits;ihit1++) {
 	  THcDCHit* hit1 = sp->GetHit(ihit1);
 	  Int_t pindex1=hit1->GetPlaneIndex();
-	  if((pindex1%2)==0) { // Odd plane (or even index)
+	  // Odd plane (or even index), with a hit in the adjacent plane
+	  if((pindex1%2)==0 && (pat.planes & (1U<<(pindex1+1)))) {
 	    for(Int_t ihit2=0;ihit2<nhits;ihit2++) {
 	      THcDCHit* hit2 = sp->GetHit(ihit2);
 	      if(hit2->GetPlaneIndex()-pindex1 == 1 && TMath::Abs(hit2->GetPos()-hit1->GetPos())<0.51) { // Adjacent plane
+		UInt_t bit1 = 1U<<ihit1, bit2 = 1U<<ihit2;
+		lrknown |= bit1 | bit2;
 		if(hit2->GetPos() <= hit1->GetPos() ) {
-		  plusminusknown[ihit1] = -1;
-		  plusminusknown[ihit2] = 1;
+		  lrknownplus = (lrknownplus & ~bit1) | bit2;
 		} else {
-		  plusminusknown[ihit1] = 1;
-		  plusminusknown[ihit2] = -1;
+		  lrknownplus = (lrknownplus & ~bit2) | bit1;
 		}
 		npaired+=2;
 	      }
@@ -1175,24 +1213,21 @@ void THcDriftChamber::LeftRight()
     } else if (nhits == 2) {
       if (fdebugstubchisq) cout << "THcDriftChamber::LeftRight: numhits-2 = 0" << endl;
     }
-    Int_t nplaneshit = Count1Bits(bitpat);
+    Int_t nplaneshit = PopCount(bitpat);
     //if (fhdebugflagpr) cout << " num of pm = " << nplusminus << " num of hits =" << nhits << endl;
     // Use bit value of integer word to set + or -
     // Loop over all combinations of left right.
     for(Int_t pmloop=0;pmloop<nplusminus;pmloop++) {
-      Int_t iswhit = 1;
+      // Spread the bits of pmloop over the hits with left/right unknown.
+      // Max hits per point has to be less than 32.
+      UInt_t lr = lrknownplus;
+      UInt_t iswhit = 1;
+      for(UInt_t w=~lrknown & ((nhits<32) ? (1U<<nhits)-1 : ~0U); w; w &= w-1) {
+	if(pmloop & iswhit) lr |= 1U<<LowestBit(w);
+	iswhit <<= 1;
+      }
       for(Int_t ihit=0;ihit<nhits;ihit++) {
-	if(plusminusknown[ihit]!=0) {
-	  plusminus[ihit] = plusminusknown[ihit];
-	} else {
-	  // Max hits per point has to be less than 32.
-	  if(pmloop & iswhit) {
-	    plusminus[ihit] = 1;
-	  } else {
-	    plusminus[ihit] = -1;
-	  }
-	  iswhit <<= 1;
-	}
+	plusminus[ihit] = (lr & (1U<<ihit)) ? 1 : -1;
       }
       if ( (nplaneshit >= fNPlanes-1) || (nplaneshit >= fNPlanes-2 && !fHMSStyleChambers)) {
 	Double_t chi2;
@@ -1213,16 +1248,12 @@ void THcDriftChamber::LeftRight()
 	    Double_t xp_expect = sp->GetX()*fRatio_xpfp_to_xfp;
 	    if(TMath::Abs(xp_fit-xp_expect)<fStubMaxXPDiff) {
 	      minchi2 = chi2;
-	      for(Int_t ihit=0;ihit<nhits;ihit++) {
-		plusminusbest[ihit] = plusminus[ihit];
-	      }
+	      lrbest = lr;
               sp->SetStub(stub);
 	    } else {		// Record best stub failing angle cut
               if (chi2 < tmp_minchi2) {
 		tmp_minchi2 = chi2;
-		for(Int_t ihit=0;ihit<nhits;ihit++) {
-		  tmp_plusminus[ihit] = plusminus[ihit];
-		}
+		tmp_lr = lr;
 		for(Int_t i=0;i<4;i++) {
 		  tmp_stub[i] = stub[i];
 		}
@@ -1230,9 +1261,7 @@ void THcDriftChamber::LeftRight()
 	    }
 	  } else { // Not HMS specific
 	    minchi2 = chi2;
-	    for(Int_t ihit=0;ihit<nhits;ihit++) {
-	      plusminusbest[ihit] = plusminus[ihit];
-	    }
+	    lrbest = lr;
             sp->SetStub(stub);
 	  }
 	}
@@ -1250,9 +1279,7 @@ void THcDriftChamber::LeftRight()
 	if(TMath::Abs(xp_fit) <= minxp) {
 	  minxp = TMath::Abs(xp_fit);
 	  minchi2 = chi2;
-	  for(Int_t ihit=0;ihit<nhits;ihit++) {
-	    plusminusbest[ihit] = plusminus[ihit];
-	  }
+	  lrbest = lr;
           sp->SetStub(stub);
 	}
       } else {
@@ -1265,20 +1292,19 @@ void THcDriftChamber::LeftRight()
     } else {
       if(minchi2 == maxchi2 ) {	// No track passed angle cut
 	minchi2 = tmp_minchi2;
-	for(Int_t ihit=0;ihit<nhits;ihit++) {
-	  plusminusbest[ihit] = tmp_plusminus[ihit];
-	}
+	lrbest = tmp_lr;
 	sp->SetStub(tmp_stub);
       }
       Double_t *spstub = sp->GetStubP();
 
-      // Calculate final coordinate based on plusminusbest
+      // Calculate final coordinate based on lrbest
       // Update the hit positions in the space points
       for(Int_t ihit=0; ihit<nhits; ihit++) {
 	// Save left/right status with the hit and in the spaleftce point
 	// In THcDC will decide which to used based on fix_lr flag
-	sp->GetHit(ihit)->SetLeftRight(plusminusbest[ihit]);
-	sp->SetHitLR(ihit, plusminusbest[ihit]);
+	Int_t plusminusbest = (lrbest & (1U<<ihit)) ? 1 : -1;
+	sp->GetHit(ihit)->SetLeftRight(plusminusbest);
+	sp->SetHitLR(ihit, plusminusbest);
       }
 
       // Stubs are calculated in rotated coordinate system
@@ -1401,5 +1427,16 @@ Int_t THcDriftChamber::ApplyCorrections( void )
   return(0);
 }
 
+//_____________________________________________________________________________
+void THcDriftChamber::AccountMemory( THcMemoryReport& report ) const
+{
+  // Called by THcDC::AccountMemory.  The hits themselves belong to the
+  // planes; the chamber keeps pointers to them and its space points.
+  report.Add("chamber space points", THcMemoryReport::Bytes(fSpacePoints)
+	     + THcMemoryReport::Bytes(fHits) + THcMemoryReport::Bytes(fTrackProj),
+	     THcMemoryReport::kDynamic);
+  report.Add("chamber", IsA()->Size(), THcMemoryReport::kStatic);
+}
+
 ClassImp(THcDriftChamber)
 ////////////////////////////////////////////////////////////////////////////////
@@ -17,12 +17,14 @@
 
 #define MAX_SPACE_POINTS 100
 #define MAX_HITS_PER_POINT 20
+#define MAX_PLANES_PER_CHAMBER 32
 
 //#include "TMath.h"
 
 //class THaScCalib;
 class TClonesArray;
 class THcSpacePoint;
+class THcMemoryReport;
 
 class THcDriftChamber : public THaSubDetector {
 
@@ -37,6 +39,7 @@ public:
   virtual void       AddPlane(THcDriftChamberPlane *plane);
   virtual Int_t      ApplyCorrections( void );
   virtual void       ProcessHits( void );
+  void               AccountMemory( THcMemoryReport& report ) const;
   virtual Int_t      FindSpacePoints( void ) ;
   virtual void       PrintDecode( void ) ;
   virtual void       CorrectHitTimes( void ) ;
@@ -125,6 +128,15 @@ protected:
   void       ChooseSingleHit(void);
   void       SelectSpacePoints(void);
   UInt_t     Count1Bits(UInt_t x);
+
+  // Planes of the hits of one space point, bit ip for plane index ip.
+  // The chambers have at most MAX_PLANES_PER_CHAMBER planes.
+  struct PlanePattern {
+    UInt_t planes;		// Planes with hits
+    UInt_t multi;		// Planes with more than one hit
+    Int_t  lasthit[MAX_PLANES_PER_CHAMBER]; // Last hit of each plane in planes
+  };
+  void       GetPlanePattern(THcSpacePoint* sp, PlanePattern& pat);
   Double_t   FindStub(Int_t nhits, THcSpacePoint *sp,
 		      Int_t* plane_list, UInt_t bitpat,
 		      Int_t* plusminus, Double_t* stub);
@@ -17,6 +17,7 @@
 #include "THaApparatus.h"
 #include "THcHodoscope.h"
 #include "TClass.h"
+#include "THcMemoryReport.h"
 
 
 #include <cstring>
@@ -33,7 +34,7 @@ THcDriftChamberPlane::THcDriftChamberPlane( const char* name,
 					    const char* description,
 					    const Int_t planenum,
 					    THaDetectorBase* parent )
-: THaSubDetector(name,description,parent), fTTDConv(0)
+: THaSubDetector(name,description,parent), fTTDConv(0), fDriftMapId(-1)
 {
   // Normal constructor with name and description
   fHits = new TClonesArray("THcDCHit",100);
@@ -52,6 +53,7 @@ THcDriftChamberPlane::THcDriftChamberPlane() :
   fRawHits = NULL;
   fWires = NULL;
   fTTDConv = NULL;
+  fDriftMapId = -1;
 }
 //______________________________________________________________________________
 THcDriftChamberPlane::~THcDriftChamberPlane()
@@ -253,6 +255,15 @@ Int_t THcDriftChamberPlane::ReadDatabase( const TDatime& date )
 				    NumDriftMapBins,DriftMap);
   delete [] DriftMap;
 
+  // Same binning as the lookup table, so the new table can replace it
+  fDriftMapStats.Clear();
+  fDriftMapId = -1;
+  if(fParent->GetCalcDriftMap()) {
+    fDriftMapId = fDriftMapStats.DefineHistogram("", "Drift times on golden tracks",
+						 NumDriftMapBins, DriftMapFirstBin,
+						 DriftMapFirstBin+NumDriftMapBins*DriftMapBinSize);
+  }
+
   Int_t nWires = fParent->GetNWires(fPlaneNum);
   // For HMS, wire numbers start with one, but arrays start with zero.
   // So wire number is index+1
@@ -403,6 +414,76 @@ Int_t THcDriftChamberPlane::SubtractStartTime()
   }
   return 0;
 }
+//_____________________________________________________________________________
+static Double_t HalfDriftTime(const Double_t* table, Int_t nbins,
+			      Double_t t0, Double_t binsize)
+{
+  // Drift time where a drift map reaches half the maximum drift distance
+  for(Int_t ib=0;ib+1<nbins;ib++) {
+    if(table[ib+1] >= 0.5) {
+      Double_t step = table[ib+1]-table[ib];
+      Double_t tfrac = (step > 0) ? (0.5-table[ib])/step : 0;
+      if(tfrac < 0) tfrac = 0;
+      return t0 + (ib+tfrac)*binsize;
+    }
+  }
+  return t0 + nbins*binsize;
+}
+
+//_____________________________________________________________________________
+Long64_t THcDriftChamberPlane::WriteDriftMap(std::ostream& out, const char* prefix)
+{
+  /**
+     Write the drift map made from the drift times of the hits on golden
+     tracks, in the format of the driftmap parameter files.  Entry ib
+     of the table is the fraction of hits with a drift time below
+     drift1stbin + ib*driftbinsz.  Prints the shift of the time at half
+     the maximum drift distance relative to the loaded map.  If there
+     were no hits the loaded map is written.  Returns the number of hits.
+  */
+  THcDCLookupTTDConv* conv = dynamic_cast<THcDCLookupTTDConv*>(fTTDConv);
+  if(fDriftMapId < 0 || !conv) return 0;
+
+  fDriftMapStats.Merge();
+  const Int_t* counts = fDriftMapStats.GetValues(fDriftMapId); // [0] is underflow
+  Int_t nbins = conv->GetNumBins();
+  const Double_t* oldtable = conv->GetTable();
+  Long64_t total = 0;
+  for(Int_t ib=0;ib<nbins;ib++) {
+    total += counts[ib+1];
+  }
+  if(total == 0) {
+    Warning(Here("WriteDriftMap"), "No hits on golden tracks, "
+	    "writing the loaded drift map");
+  }
+
+  Double_t* table = new Double_t[nbins];
+  Long64_t sum = 0;
+  Double_t maxdiff = 0;
+  for(Int_t ib=0;ib<nbins;ib++) {
+    table[ib] = (total > 0) ? Double_t(sum)/total : oldtable[ib];
+    sum += counts[ib+1];
+    maxdiff = TMath::Max(maxdiff, TMath::Abs(table[ib]-oldtable[ib]));
+  }
+
+  out << prefix << "wc" << GetName() << "fract=";
+  for(Int_t ib=0;ib<nbins;ib++) {
+    out << Form("%.4f", table[ib]);
+    if(ib+1 < nbins) out << (((ib+1)%10 == 0) ? "\n" : ",");
+  }
+  out << endl;
+
+  Double_t oldhalf = HalfDriftTime(oldtable, nbins, conv->GetT0(), conv->GetBinSize());
+  Double_t newhalf = HalfDriftTime(table, nbins, conv->GetT0(), conv->GetBinSize());
+  cout << "Drift map " << GetName() << ": " << total << " hits, "
+       << Form("half drift distance at %.2f ns, loaded map %.2f ns (%+.2f ns), "
+	       "largest change %.4f", newhalf, oldhalf, newhalf-oldhalf, maxdiff)
+       << endl;
+  delete [] table;
+  return total;
+}
+
+//_____________________________________________________________________________
 Int_t THcDriftChamberPlane::GetReadoutSide(Int_t wirenum)
 {
   Int_t readoutside;
@@ -483,3 +564,15 @@ Int_t THcDriftChamberPlane::GetReadoutSide(Int_t wirenum)
   }
   return(readoutside);
 }
+
+//_____________________________________________________________________________
+void THcDriftChamberPlane::AccountMemory( THcMemoryReport& report ) const
+{
+  // Called by THcDC::AccountMemory.  The hit arrays grow with the
+  // largest event, the wires and their constants are set up at Init.
+  report.Add("plane hits", THcMemoryReport::Bytes(fHits)
+	     + THcMemoryReport::Bytes(fRawHits), THcMemoryReport::kDynamic);
+  report.Add("plane wires", THcMemoryReport::Bytes(fWires)
+	     + (Long64_t)2*fNWires*sizeof(Double_t), THcMemoryReport::kStatic);
+  report.Add("plane", IsA()->Size(), THcMemoryReport::kStatic);
+}
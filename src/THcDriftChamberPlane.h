@@ -14,13 +14,16 @@
 
 #include "THaSubDetector.h"
 #include "TClonesArray.h"
+#include "THcRunStats.h"
 #include <cassert>
+#include <iostream>
 
 class THaEvData;
 class THcDCWire;
 class THcDCHit;
 class THcDCTimeToDistConv;
 class THcHodoscope;
+class THcMemoryReport;
 
 /*class THaSignalHit;*/
 
@@ -41,6 +44,7 @@ public:
   virtual Bool_t   IsPid()      { return kFALSE; }
 
   virtual Int_t ProcessHits(TClonesArray* rawhits, Int_t nexthit);
+  void          AccountMemory(THcMemoryReport& report) const;
 
   virtual Int_t SubtractStartTime();
 
@@ -76,6 +80,12 @@ public:
   Int_t        GetReadoutLR() const { return fReadoutLR;}
   Int_t        GetReadoutTB() const { return fReadoutTB;}
   Int_t        GetVersion() const {return fVersion;}
+  THcDCTimeToDistConv* GetTTDConv() const { return fTTDConv; }
+
+  // Drift map generation, enabled with dc_calc_driftmap
+  void         AccumulateDriftTime(Double_t time)
+  { if(fDriftMapId >= 0) fDriftMapStats.Fill(fDriftMapId, time); }
+  Long64_t     WriteDriftMap(std::ostream& out, const char* prefix);
 
 protected:
 
@@ -128,6 +138,9 @@ protected:
 
   THcDCTimeToDistConv* fTTDConv;  // Time-to-distance converter for this plane's wires
 
+  THcRunStats fDriftMapStats;	// Drift times of hits on golden tracks
+  Int_t fDriftMapId;		// -1 unless making a drift map
+
   THcHodoscope* fglHod;		// Hodoscope to get start time
 
   ClassDef(THcDriftChamberPlane,0); // A single plane within a THcDriftChamber
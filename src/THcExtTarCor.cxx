@@ -115,13 +115,21 @@ Int_t THcExtTarCor::Process( const THaEvData& )
     if( theTrack == spectro->GetGoldenTrack() ) {
       // Calculate corrections & recalculate ,,,track parameters
       Double_t x_tg = -vertex[1]-pointing_off[0]; // units of cm, beam position in spectrometer coordinate system
-      spectro->CalculateTargetQuantities(theTrack,x_tg,xptar,ytar,yptar,delta);
+      // Only the xtar dependent part of the reconstruction is redone,
+      // using the partial sums kept by the spectrometer for this track
+      THcHallCSpectrometer::TargetSums trksums;
+      const THcHallCSpectrometer::TargetSums* sums = spectro->GetTargetSums(theTrack);
+      if( !sums ) {
+	spectro->CalculateTargetSums(theTrack,trksums);
+	sums = &trksums;
+      }
+      spectro->FinishTargetQuantities(*sums,x_tg,xptar,ytar,yptar,delta);
       p  = spectro->GetPcentral() * ( 1.0+delta );
       spectro->TransportToLab( p, xptar, yptar, pvect );
       Double_t theta=spectro->GetThetaSph();
       xtar_new = x_tg - xptar*ztarg*cos(theta); //units of cm
       // Get a second-iteration value for x_tg based on the 
-      spectro->CalculateTargetQuantities(theTrack,xtar_new,xptar,ytar,yptar,delta);
+      spectro->FinishTargetQuantities(*sums,xtar_new,xptar,ytar,yptar,delta);
       fDeltaDp = delta*100 -theTrack->GetDp();
       fDeltaP = p - theTrack->GetP();
       fDeltaTh = xptar -  theTrack->GetTTheta();
@@ -10,6 +10,16 @@ The number of times a cut has been try, as well as the number of times
 that the cut has been tested can be accessed with cutname.`scaler` (or
 .`npassed`) and cutname.`ncalled`.
 
+Expressions are also compiled into a short list of instructions when
+the formula is created.  The addresses of basic type global variables
+and parameters are bound directly, constant subexpressions are folded
+and && and || skip their right hand side when the left decides the
+result.  Eval then runs these instructions instead of the interpreted
+TFormula evaluation.  Expressions with whole arrays, array indices
+that are not constants or functions the compiler does not know are
+evaluated by THaFormula as before.  The results are the same either
+way, including TFormula's conventions (x/0 = 0, log(x<=0) = 0).
+
 \author S. A. Wood
 
 */
@@ -20,11 +30,15 @@ that the cut has been tested can be accessed with cutname.`scaler` (or
 #include "THaVarList.h"
 #include "THaCutList.h"
 #include "THaCut.h"
+#include "THaVar.h"
 #include "TMath.h"
 
 #include <iostream>
 #include <cassert>
 #include <numeric>
+#include <cstdlib>
+#include <cctype>
+#include <cstring>
 
 using namespace std;
 
@@ -55,6 +69,8 @@ THcFormula::THcFormula(const char* name, const char* expression,
   SetBit(kNotGlobal,!do_register);
 
   Compile();   // This calls our own Compile()
+  if( !IsError() )
+    CompileCode();
 
   if( do_register )
     RegisterFormula();
@@ -66,13 +82,16 @@ THcFormula& THcFormula::operator=( const THcFormula& rhs )
   if( this != &rhs ) {
     THaFormula::operator=(rhs);
     fParmList = rhs.fParmList;
+    fCode = rhs.fCode;
+    fStack = rhs.fStack;
   }
   return *this;
 }
 
 //_____________________________________________________________________________
 THcFormula::THcFormula( const THcFormula& rhs ) :
-  THaFormula(rhs), fParmList(rhs.fParmList)
+  THaFormula(rhs), fParmList(rhs.fParmList), fCode(rhs.fCode),
+  fStack(rhs.fStack)
 {
   // Copy ctor
 }
@@ -117,6 +136,456 @@ Int_t THcFormula::DefinedGlobalVariable( TString& name )
 }
 
 
+//_____________________________________________________________________________
+// Compiled expressions
+
+enum ECodeOp { kOpConst, kOpLoadD, kOpLoadF, kOpLoadI, kOpLoadUI, kOpLoadS,
+	       kOpLoadUS, kOpLoadC, kOpLoadUC, kOpLoadVar, kOpCutResult,
+	       kOpCutPassed, kOpCutCalled, kOpNeg, kOpNot, kOpBool, kOpFunc1,
+	       kOpFunc2, kOpAdd, kOpSub, kOpMul, kOpDiv, kOpMod, kOpPow, kOpEq,
+	       kOpNe, kOpLt, kOpLe, kOpGt, kOpGe, kOpBitAnd, kOpBitOr, kOpAnd,
+	       kOpOr, kOpJumpZero, kOpJumpNonZero };
+
+static Double_t FSin(Double_t x)   { return TMath::Sin(x); }
+static Double_t FCos(Double_t x)   { return TMath::Cos(x); }
+static Double_t FTan(Double_t x)   { return TMath::Tan(x); }
+static Double_t FASin(Double_t x)  { return TMath::ASin(x); }
+static Double_t FACos(Double_t x)  { return TMath::ACos(x); }
+static Double_t FATan(Double_t x)  { return TMath::ATan(x); }
+static Double_t FSinH(Double_t x)  { return TMath::SinH(x); }
+static Double_t FCosH(Double_t x)  { return TMath::CosH(x); }
+static Double_t FTanH(Double_t x)  { return TMath::TanH(x); }
+static Double_t FExp(Double_t x)   { return TMath::Exp(x); }
+static Double_t FLog(Double_t x)   { return (x > 0) ? TMath::Log(x) : 0; }
+static Double_t FLog10(Double_t x) { return (x > 0) ? TMath::Log10(x) : 0; }
+static Double_t FSqrt(Double_t x)  { return TMath::Sqrt(x); }
+static Double_t FAbs(Double_t x)   { return TMath::Abs(x); }
+static Double_t FSq(Double_t x)    { return x*x; }
+static Double_t FInt(Double_t x)   { return (Double_t)(Int_t)x; }
+static Double_t FATan2(Double_t y, Double_t x) { return TMath::ATan2(y,x); }
+static Double_t FPow(Double_t x, Double_t y)   { return TMath::Power(x,y); }
+static Double_t FMin(Double_t x, Double_t y)   { return TMath::Min(x,y); }
+static Double_t FMax(Double_t x, Double_t y)   { return TMath::Max(x,y); }
+static Double_t FMod(Double_t x, Double_t y)   { return TMath::Abs(y) > 0 ? fmod(x,y) : 0; }
+static Double_t FSign(Double_t x, Double_t y)  { return TMath::Sign(x,y); }
+
+struct CodeFunc_t {
+  const char* name;
+  Double_t  (*func1)(Double_t);
+  Double_t  (*func2)(Double_t, Double_t);
+};
+
+static const CodeFunc_t kCodeFuncs[] = {
+  { "sin", FSin, 0 }, { "cos", FCos, 0 }, { "tan", FTan, 0 },
+  { "asin", FASin, 0 }, { "acos", FACos, 0 }, { "atan", FATan, 0 },
+  { "sinh", FSinH, 0 }, { "cosh", FCosH, 0 }, { "tanh", FTanH, 0 },
+  { "exp", FExp, 0 }, { "log", FLog, 0 }, { "log10", FLog10, 0 },
+  { "sqrt", FSqrt, 0 }, { "abs", FAbs, 0 }, { "fabs", FAbs, 0 },
+  { "sq", FSq, 0 }, { "int", FInt, 0 },
+  { "atan2", 0, FATan2 }, { "pow", 0, FPow }, { "min", 0, FMin },
+  { "max", 0, FMax }, { "fmod", 0, FMod }, { "sign", 0, FSign },
+  { "TMath::Sin", FSin, 0 }, { "TMath::Cos", FCos, 0 },
+  { "TMath::Tan", FTan, 0 }, { "TMath::ASin", FASin, 0 },
+  { "TMath::ACos", FACos, 0 }, { "TMath::ATan", FATan, 0 },
+  { "TMath::Exp", FExp, 0 }, { "TMath::Sqrt", FSqrt, 0 },
+  { "TMath::Abs", FAbs, 0 }, { "TMath::ATan2", 0, FATan2 },
+  { "TMath::Power", 0, FPow }, { "TMath::Min", 0, FMin },
+  { "TMath::Max", 0, FMax }, { "TMath::Sign", 0, FSign },
+  { 0, 0, 0 }
+};
+
+static inline Double_t CodeUnary( const THcFormula::Instr& in, Double_t a )
+{
+  switch( in.op ) {
+  case kOpNeg:   return -a;
+  case kOpNot:   return (a == 0) ? 1 : 0;
+  case kOpBool:  return (a != 0) ? 1 : 0;
+  default:       return in.func1(a);
+  }
+}
+
+static inline Double_t CodeBinary( const THcFormula::Instr& in, Double_t a,
+				   Double_t b )
+{
+  switch( in.op ) {
+  case kOpAdd:    return a+b;
+  case kOpSub:    return a-b;
+  case kOpMul:    return a*b;
+  case kOpDiv:    return (b == 0) ? 0 : a/b;
+  case kOpMod:    return ((Int_t)b == 0) ? 0 : (Double_t)((Int_t)a % (Int_t)b);
+  case kOpPow:    return TMath::Power(a,b);
+  case kOpEq:     return (a == b) ? 1 : 0;
+  case kOpNe:     return (a != b) ? 1 : 0;
+  case kOpLt:     return (a < b) ? 1 : 0;
+  case kOpLe:     return (a <= b) ? 1 : 0;
+  case kOpGt:     return (a > b) ? 1 : 0;
+  case kOpGe:     return (a >= b) ? 1 : 0;
+  case kOpBitAnd: return (Double_t)((Int_t)a & (Int_t)b);
+  case kOpBitOr:  return (Double_t)((Int_t)a | (Int_t)b);
+  case kOpAnd:    return (a != 0 && b != 0) ? 1 : 0;
+  case kOpOr:     return (a != 0 || b != 0) ? 1 : 0;
+  default:        return in.func2(a,b);
+  }
+}
+
+// Expression tree built by the parser, with constants folded
+struct CodeNode {
+  THcFormula::Instr in;
+  CodeNode* a;
+  CodeNode* b;
+  CodeNode( Int_t op, CodeNode* na=0, CodeNode* nb=0 ) : a(na), b(nb) {
+    memset(&in, 0, sizeof(in));
+    in.op = op;
+  }
+  ~CodeNode() { delete a; delete b; }
+  Bool_t IsConst() const { return in.op == kOpConst; }
+};
+
+// Recursive descent parser for the TFormula expression syntax
+class CodeParser {
+public:
+  CodeParser( const char* expr, const THaVarList* vars,
+	      const THcParmList* parms, const THaCutList* cuts )
+    : fPos(expr), fVars(vars), fParms(parms), fCuts(cuts) {}
+
+  CodeNode* Parse() {
+    CodeNode* n = ParseOr();
+    SkipSpace();
+    if( n && *fPos != 0 ) { delete n; n = 0; }
+    return n;
+  }
+
+private:
+  const char*        fPos;
+  const THaVarList*  fVars;
+  const THcParmList* fParms;
+  const THaCutList*  fCuts;
+
+  void SkipSpace() { while( isspace(*fPos) ) fPos++; }
+
+  // Accept token tok, unless it is followed by one of the characters in
+  // notnext (so that "<" does not match "<=")
+  Bool_t Accept( const char* tok, const char* notnext="" ) {
+    SkipSpace();
+    size_t len = strlen(tok);
+    if( strncmp(fPos, tok, len) != 0 ) return kFALSE;
+    if( fPos[len] != 0 && strchr(notnext, fPos[len]) ) return kFALSE;
+    fPos += len;
+    return kTRUE;
+  }
+
+  CodeNode* Make( Int_t op, CodeNode* a, CodeNode* b=0 ) {
+    if( !a || (b == 0 && op >= kOpAdd) ) { delete a; delete b; return 0; }
+    if( op == kOpAnd && a->IsConst() ) {	// Decided by the left side?
+      Bool_t left = (a->in.value != 0);
+      delete a;
+      if( !left ) { delete b; return Const(0); }
+      return Make(kOpBool, b);
+    }
+    if( op == kOpOr && a->IsConst() ) {
+      Bool_t left = (a->in.value != 0);
+      delete a;
+      if( left ) { delete b; return Const(1); }
+      return Make(kOpBool, b);
+    }
+    CodeNode* n = new CodeNode(op, a, b);
+    return Fold(n);
+  }
+
+  CodeNode* Fold( CodeNode* n ) {
+    if( !n->a->IsConst() || (n->b && !n->b->IsConst()) ) return n;
+    Double_t v = n->b ? CodeBinary(n->in, n->a->in.value, n->b->in.value)
+      : CodeUnary(n->in, n->a->in.value);
+    delete n;
+    return Const(v);
+  }
+
+  CodeNode* Const( Double_t v ) {
+    CodeNode* n = new CodeNode(kOpConst);
+    n->in.value = v;
+    return n;
+  }
+
+  CodeNode* ParseOr() {
+    CodeNode* n = ParseAnd();
+    while( n && Accept("||") ) n = Make(kOpOr, n, ParseAnd());
+    return n;
+  }
+  CodeNode* ParseAnd() {
+    CodeNode* n = ParseBitOr();
+    while( n && Accept("&&") ) n = Make(kOpAnd, n, ParseBitOr());
+    return n;
+  }
+  CodeNode* ParseBitOr() {
+    CodeNode* n = ParseBitAnd();
+    while( n && Accept("|", "|") ) n = Make(kOpBitOr, n, ParseBitAnd());
+    return n;
+  }
+  CodeNode* ParseBitAnd() {
+    CodeNode* n = ParseCompare();
+    while( n && Accept("&", "&") ) n = Make(kOpBitAnd, n, ParseCompare());
+    return n;
+  }
+  CodeNode* ParseCompare() {
+    CodeNode* n = ParseAdd();
+    while( n ) {
+      Int_t op;
+      if( Accept("==") )          op = kOpEq;
+      else if( Accept("!=") )     op = kOpNe;
+      else if( Accept("<=") )     op = kOpLe;
+      else if( Accept(">=") )     op = kOpGe;
+      else if( Accept("<", "<") ) op = kOpLt;
+      else if( Accept(">", ">") ) op = kOpGt;
+      else break;
+      n = Make(op, n, ParseAdd());
+    }
+    return n;
+  }
+  CodeNode* ParseAdd() {
+    CodeNode* n = ParseMul();
+    while( n ) {
+      Int_t op;
+      if( Accept("+") )      op = kOpAdd;
+      else if( Accept("-") ) op = kOpSub;
+      else break;
+      n = Make(op, n, ParseMul());
+    }
+    return n;
+  }
+  CodeNode* ParseMul() {
+    CodeNode* n = ParseUnary();
+    while( n ) {
+      Int_t op;
+      if( Accept("*", "*") ) op = kOpMul;
+      else if( Accept("/") ) op = kOpDiv;
+      else if( Accept("%") ) op = kOpMod;
+      else break;
+      n = Make(op, n, ParseUnary());
+    }
+    return n;
+  }
+  CodeNode* ParseUnary() {
+    if( Accept("-") )      return Make(kOpNeg, ParseUnary());
+    if( Accept("+") )      return ParseUnary();
+    if( Accept("!", "=") ) return Make(kOpNot, ParseUnary());
+    return ParsePow();
+  }
+  CodeNode* ParsePow() {
+    CodeNode* n = ParsePrimary();
+    if( n && (Accept("^") || Accept("**")) ) n = Make(kOpPow, n, ParseUnary());
+    return n;
+  }
+
+  CodeNode* ParsePrimary() {
+    SkipSpace();
+    if( Accept("(") ) {
+      CodeNode* n = ParseOr();
+      if( n && !Accept(")") ) { delete n; n = 0; }
+      return n;
+    }
+    if( isdigit(*fPos) || (*fPos == '.' && isdigit(fPos[1])) ) {
+      char* end;
+      Double_t v = strtod(fPos, &end);
+      fPos = end;
+      return Const(v);
+    }
+    if( !(isalpha(*fPos) || *fPos == '_') ) return 0;
+    const char* start = fPos;
+    while( isalnum(*fPos) || *fPos == '_' || *fPos == '.' ||
+	   (fPos[0] == ':' && fPos[1] == ':') ) {
+      fPos += (*fPos == ':') ? 2 : 1;
+    }
+    TString name(start, fPos-start);
+    if( Accept("(") ) return ParseCall(name);
+    if( name == "pi" ) return Const(TMath::Pi());
+    Int_t index = -1;
+    if( *fPos == '[' ) {
+      fPos++;
+      char* end;
+      long i = strtol(fPos, &end, 10);
+      if( end == fPos || *end != ']' || i < 0 ) return 0;
+      index = i;
+      fPos = end+1;
+    }
+    return Resolve(name, index);
+  }
+
+  CodeNode* ParseCall( const TString& name ) {
+    if( name == "TMath::Pi" ) return Accept(")") ? Const(TMath::Pi()) : 0;
+    const CodeFunc_t* f = kCodeFuncs;
+    while( f->name && name != f->name ) f++;
+    if( !f->name ) return 0;
+    CodeNode* a = ParseOr();
+    CodeNode* b = 0;
+    if( a && f->func2 && Accept(",") ) b = ParseOr();
+    if( !a || (f->func2 && !b) || !Accept(")") ) { delete a; delete b; return 0; }
+    CodeNode* n = new CodeNode(f->func2 ? kOpFunc2 : kOpFunc1, a, b);
+    n->in.func1 = f->func1;
+    n->in.func2 = f->func2;
+    return Fold(n);
+  }
+
+  CodeNode* Resolve( const TString& name, Int_t index ) {
+    // Global variable or parameter, as DefinedGlobalVariable
+    THaVar* var = fVars ? fVars->Find(name) : 0;
+    if( !var && fParms ) var = fParms->Find(name);
+    if( var ) {
+      if( index < 0 ) {
+	if( var->IsArray() ) return 0; // Array formula
+	index = 0;
+      }
+      if( !var->IsVarArray() && !var->IsPointerArray() ) {
+	if( index >= var->GetLen() ) return 0;
+	Int_t op = -1;
+	size_t size = 0;
+	switch( var->GetType() ) {
+	case kDouble: op = kOpLoadD;  size = sizeof(Double_t); break;
+	case kFloat:  op = kOpLoadF;  size = sizeof(Float_t);  break;
+	case kInt:    op = kOpLoadI;  size = sizeof(Int_t);    break;
+	case kUInt:   op = kOpLoadUI; size = sizeof(UInt_t);   break;
+	case kShort:  op = kOpLoadS;  size = sizeof(Short_t);  break;
+	case kUShort: op = kOpLoadUS; size = sizeof(UShort_t); break;
+	case kChar:   op = kOpLoadC;  size = sizeof(Char_t);   break;
+	case kUChar:  op = kOpLoadUC; size = sizeof(UChar_t);  break;
+	default: break;
+	}
+	if( op >= 0 ) {
+	  CodeNode* n = new CodeNode(op);
+	  n->in.ptr = (const char*)var->GetValuePointer() + index*size;
+	  return n;
+	}
+      }
+      CodeNode* n = new CodeNode(kOpLoadVar); // Through THaVar::GetValue
+      n->in.ptr = var;
+      n->in.n = index;
+      return n;
+    }
+    // Cut, or cut.scaler/npassed/ncalled as DefinedCut
+    if( !fCuts || index >= 0 ) return 0;
+    Int_t op = kOpCutResult;
+    TString cutname = name;
+    Ssiz_t period = name.Index('.');
+    if( period >= 0 ) {
+      cutname = name(0,period);
+      TString attribute(name(period+1,name.Length()-period-1));
+      if( attribute == "scaler" || attribute == "npassed" ) op = kOpCutPassed;
+      else if( attribute == "ncalled" ) op = kOpCutCalled;
+      else cutname = name;
+    }
+    THaCut* cut = fCuts->FindCut(cutname);
+    if( !cut ) return 0;
+    CodeNode* n = new CodeNode(op);
+    n->in.ptr = cut;
+    return n;
+  }
+};
+
+// Append the code of node n to code
+static void EmitCode( const CodeNode* n, vector<THcFormula::Instr>& code,
+		      Int_t& depth, Int_t& maxdepth )
+{
+  if( n->in.op == kOpAnd || n->in.op == kOpOr ) {
+    EmitCode(n->a, code, depth, maxdepth);
+    UInt_t jump = code.size();
+    THcFormula::Instr in = n->in;
+    in.op = (n->in.op == kOpAnd) ? kOpJumpZero : kOpJumpNonZero;
+    code.push_back(in);
+    depth--;
+    EmitCode(n->b, code, depth, maxdepth);
+    in.op = kOpBool;
+    code.push_back(in);
+    code[jump].n = code.size();
+  } else {
+    if( n->a ) EmitCode(n->a, code, depth, maxdepth);
+    if( n->b ) EmitCode(n->b, code, depth, maxdepth);
+    code.push_back(n->in);
+    if( !n->a ) depth++;
+    if( n->b ) depth--;
+  }
+  if( depth > maxdepth ) maxdepth = depth;
+}
+
+//_____________________________________________________________________________
+Bool_t THcFormula::CompileCode()
+{
+  /// Compile the expression into fCode.  Returns kFALSE (and leaves the
+  /// evaluation to THaFormula) if the expression uses anything the
+  /// compiler does not handle.
+  fCode.clear();
+  CodeParser parser(GetTitle(), fVarList, fParmList, fCutList);
+  CodeNode* tree = parser.Parse();
+  if( !tree ) return kFALSE;
+  Int_t depth = 0, maxdepth = 0;
+  EmitCode(tree, fCode, depth, maxdepth);
+  delete tree;
+  fStack.resize(maxdepth+1);
+  return kTRUE;
+}
+
+//_____________________________________________________________________________
+Double_t THcFormula::EvalCode()
+{
+  Double_t* stack = &fStack[0];
+  Int_t sp = -1;
+  const Instr* code = &fCode[0];
+  Int_t ncode = fCode.size();
+  for( Int_t pc=0; pc<ncode; pc++ ) {
+    const Instr& in = code[pc];
+    switch( in.op ) {
+    case kOpConst:  stack[++sp] = in.value; break;
+    case kOpLoadD:  stack[++sp] = *(const Double_t*)in.ptr; break;
+    case kOpLoadF:  stack[++sp] = *(const Float_t*)in.ptr; break;
+    case kOpLoadI:  stack[++sp] = *(const Int_t*)in.ptr; break;
+    case kOpLoadUI: stack[++sp] = *(const UInt_t*)in.ptr; break;
+    case kOpLoadS:  stack[++sp] = *(const Short_t*)in.ptr; break;
+    case kOpLoadUS: stack[++sp] = *(const UShort_t*)in.ptr; break;
+    case kOpLoadC:  stack[++sp] = *(const Char_t*)in.ptr; break;
+    case kOpLoadUC: stack[++sp] = *(const UChar_t*)in.ptr; break;
+    case kOpLoadVar: {
+      const THaVar* var = (const THaVar*)in.ptr;
+      if( in.n >= var->GetLen() ) return kBig;
+      stack[++sp] = var->GetValue(in.n);
+      break;
+    }
+    case kOpCutResult: stack[++sp] = ((const THaCut*)in.ptr)->GetResult(); break;
+    case kOpCutPassed: stack[++sp] = ((const THaCut*)in.ptr)->GetNPassed(); break;
+    case kOpCutCalled: stack[++sp] = ((const THaCut*)in.ptr)->GetNCalled(); break;
+    case kOpNeg: case kOpNot: case kOpBool: case kOpFunc1:
+      stack[sp] = CodeUnary(in, stack[sp]);
+      break;
+    case kOpJumpZero:
+      if( stack[sp] == 0 ) { stack[sp] = 0; pc = in.n-1; }
+      else sp--;
+      break;
+    case kOpJumpNonZero:
+      if( stack[sp] != 0 ) { stack[sp] = 1; pc = in.n-1; }
+      else sp--;
+      break;
+    case kOpAdd: sp--; stack[sp] += stack[sp+1]; break;
+    case kOpSub: sp--; stack[sp] -= stack[sp+1]; break;
+    case kOpMul: sp--; stack[sp] *= stack[sp+1]; break;
+    case kOpLt:  sp--; stack[sp] = (stack[sp] <  stack[sp+1]) ? 1 : 0; break;
+    case kOpLe:  sp--; stack[sp] = (stack[sp] <= stack[sp+1]) ? 1 : 0; break;
+    case kOpGt:  sp--; stack[sp] = (stack[sp] >  stack[sp+1]) ? 1 : 0; break;
+    case kOpGe:  sp--; stack[sp] = (stack[sp] >= stack[sp+1]) ? 1 : 0; break;
+    case kOpEq:  sp--; stack[sp] = (stack[sp] == stack[sp+1]) ? 1 : 0; break;
+    default:
+      sp--;
+      stack[sp] = CodeBinary(in, stack[sp], stack[sp+1]);
+      break;
+    }
+  }
+  return stack[0];
+}
+
+//_____________________________________________________________________________
+Double_t THcFormula::Eval()
+{
+  // Evaluate the compiled expression if there is one
+  if( fCode.empty() ) return THaFormula::Eval();
+  return EvalCode();
+}
+
 //_____________________________________________________________________________
 
 ClassImp(THcFormula)
@@ -9,6 +9,7 @@
 
 #include "THcGlobals.h"
 #include "THaFormula.h"
+#include <vector>
 
 class THaParmList;
 
@@ -25,10 +26,28 @@ public:
 
   virtual Int_t    DefinedCut( TString& variable);
   virtual Int_t    DefinedGlobalVariable( TString& variable);
+  virtual Double_t Eval();
+
+  Bool_t   IsCompiled() const { return !fCode.empty(); }
+
+  // One instruction of the compiled expression
+  struct Instr {
+    Int_t       op;
+    Int_t       n;		// Jump target or array element
+    const void* ptr;		// Bound variable or cut
+    Double_t    value;		// Constant
+    Double_t  (*func1)(Double_t);
+    Double_t  (*func2)(Double_t, Double_t);
+  };
 
 protected:
 
+  Bool_t   CompileCode();
+  Double_t EvalCode();
+
   const THcParmList* fParmList; // Pointer to list of parameters
+  std::vector<Instr>    fCode;	//! Compiled expression, empty if not compiled
+  std::vector<Double_t> fStack;	//! Evaluation stack
   ClassDef(THcFormula,0) // Formula with cut scalers
 };
 
@@ -10,5 +10,7 @@
 
 R__EXTERN class THcParmList*  gHcParms;      //List of global symbolic variables
 R__EXTERN class THcDetectorMap*  gHcDetectorMap;   //Cached map file
+R__EXTERN class THcHitCache*  gHcHitCache;   //Decoded hit cache, if used
+R__EXTERN class THcCheckpoint* gHcCheckpoint; //Run state snapshots, if used
 
 #endif
@@ -31,6 +31,12 @@
    \fn THcHallCSpectrometer::CalculateTargetQuantities(THaTrack* track,Double_t& xtar,Double_t&  xptar,Double_t& ytar,Double_t& yptar,Double_t& delta)
    \brief Transport focal plane track to target.
 
+   \fn THcHallCSpectrometer::CalculateTargetSums(THaTrack* track, TargetSums& sums) const
+   \brief Evaluate the xtar independent part of the reconstruction of a track.
+
+   \fn THcHallCSpectrometer::FinishTargetQuantities(const TargetSums& sums, Double_t xtar, Double_t& xptar, Double_t& ytar, Double_t& yptar, Double_t& delta) const
+   \brief Finish the reconstruction of a track for a given xtar.
+
    \fn THcHallCSpectrometer::BestTrackSimple()
    \brief Choose best track based on Chisq.
 
@@ -95,6 +101,7 @@
 #include "THcShower.h"
 #include "THcHitList.h"
 #include "THcHodoscope.h"
+#include "THcInitScheduler.h"
 
 #include <vector>
 #include <cstring>
@@ -108,7 +115,8 @@ using namespace std;
 
 //_____________________________________________________________________________
 THcHallCSpectrometer::THcHallCSpectrometer( const char* name, const char* description ) :
-  THaSpectrometer( name, description ), fPresent(kTRUE)
+  THaSpectrometer( name, description ), fNReconTerms(0), fMaxReconExp(0),
+  fMaxReconXtarExp(0), fNTargetSums(0), fPresent(kTRUE)
 {
   // Constructor. Defines the standard detectors for the HRS.
   //  AddDetector( new THaTriggerTime("trg","Trigger-based time offset"));
@@ -127,6 +135,16 @@ THcHallCSpectrometer::~THcHallCSpectrometer()
   DefineVariables( kDelete );
 }
 
+//_____________________________________________________________________________
+THaAnalysisObject::EStatus THcHallCSpectrometer::Init( const TDatime& run_time )
+{
+  // Nothing to do if this spectrometer and its detectors were just
+  // initialized by a THcInitScheduler (THcAnalyzer::SetInitThreads)
+  if( THcInitScheduler::TakeInitialized(this) )
+    return fStatus;
+  return THaSpectrometer::Init(run_time);
+}
+
 //_____________________________________________________________________________
 Int_t THcHallCSpectrometer::DefineVariables( EMode mode )
 {
@@ -172,6 +190,9 @@ void THcHallCSpectrometer::InitializeReconstruction()
 {
   fNReconTerms = 0;
   fReconTerms.clear();
+  fMaxReconExp = 0;
+  fMaxReconXtarExp = 0;
+  fNTargetSums = 0;
   fAngSlope_x = 0.0;
   fAngSlope_y = 0.0;
   fAngOffset_x = 0.0;
@@ -438,6 +459,10 @@ Int_t THcHallCSpectrometer::ReadDatabase( const TDatime& date )
 	   ,&fReconTerms[fNReconTerms].Exp[2]
 	   ,&fReconTerms[fNReconTerms].Exp[3]
 	   ,&fReconTerms[fNReconTerms].Exp[4]);
+    for(Int_t j=0;j<5;j++) {
+      fMaxReconExp = TMath::Max(fMaxReconExp,fReconTerms[fNReconTerms].Exp[j]);
+    }
+    fMaxReconXtarExp = TMath::Max(fMaxReconXtarExp,fReconTerms[fNReconTerms].Exp[4]);
     fNReconTerms++;
     good = getline(ifile,line).good();
   }
@@ -481,11 +506,18 @@ Int_t THcHallCSpectrometer::FindVertices( TClonesArray& tracks )
 
   fNtracks = tracks.GetLast()+1;
 
+  // Keep the partial sums of each track for the physics modules that
+  // redo the reconstruction with the actual xtar (see GetTargetSums)
+  if( (Int_t)fTargetSums.size() < fNtracks )
+    fTargetSums.resize(fNtracks);
+  fNTargetSums = fNtracks;
+
   for (Int_t it=0;it<tracks.GetLast()+1;it++) {
     THaTrack* track = static_cast<THaTrack*>( tracks[it] );
     Double_t xptar=kBig,yptar=kBig,ytar=kBig,delta=kBig;
     Double_t xtar=0;
-    CalculateTargetQuantities(track,xtar,xptar,ytar,yptar,delta); 
+    CalculateTargetSums(track,fTargetSums[it]);
+    FinishTargetQuantities(fTargetSums[it],xtar,xptar,ytar,yptar,delta);
     // Transfer results to track
     // No beam raster yet
     //; In transport coordinates phi = hyptar = dy/dz and theta = hxptar = dx/dz
@@ -523,39 +555,87 @@ void THcHallCSpectrometer::CalculateTargetQuantities(THaTrack* track,Double_t& x
      saturation effects.
   */
 
-  Double_t hut[5];
-  Double_t hut_rot[5];
+  TargetSums sums;
+  CalculateTargetSums(track,sums);
+  FinishTargetQuantities(sums,xtar,xptar,ytar,yptar,delta);
+}
+//
+//_____________________________________________________________________________
+void THcHallCSpectrometer::CalculateTargetSums(THaTrack* track, TargetSums& sums) const
+{
+  /**
+     First half of CalculateTargetQuantities(): evaluate the part of each
+     reconstruction term that depends on the focal plane coordinates of
+     the track, and sum the terms by their power of xtar.
+     FinishTargetQuantities() completes the sums for a given xtar.
+  */
+
+  Double_t hut_rot[4];
 
-  hut[0] = track->GetX()/100.0 + fZTrueFocus*track->GetTheta() + fDetOffset_x;//m
-  hut[1] = track->GetTheta() + fAngOffset_x;//radians
-  hut[2] = track->GetY()/100.0 + fZTrueFocus*track->GetPhi() + fDetOffset_y;//m
-  hut[3] = track->GetPhi() + fAngOffset_y;//radians
+  sums.Track = track;
+  sums.Fp[0] = track->GetX();
+  sums.Fp[1] = track->GetTheta();
+  sums.Fp[2] = track->GetY();
+  sums.Fp[3] = track->GetPhi();
 
-  hut[4] = xtar/100.0;
+  Double_t hut0 = sums.Fp[0]/100.0 + fZTrueFocus*sums.Fp[1] + fDetOffset_x;//m
+  Double_t hut1 = sums.Fp[1] + fAngOffset_x;//radians
+  Double_t hut2 = sums.Fp[2]/100.0 + fZTrueFocus*sums.Fp[3] + fDetOffset_y;//m
+  Double_t hut3 = sums.Fp[3] + fAngOffset_y;//radians
 
-  // Retrieve the focal plane coordnates
   // Do the transformation
-  // Stuff results into track
-  hut_rot[0] = hut[0];
-  hut_rot[1] = hut[1] + hut[0]*fAngSlope_x;
-  hut_rot[2] = hut[2];
-  hut_rot[3] = hut[3] + hut[2]*fAngSlope_y;
-  hut_rot[4] = hut[4];
+  hut_rot[0] = hut0;
+  hut_rot[1] = hut1 + hut0*fAngSlope_x;
+  hut_rot[2] = hut2;
+  hut_rot[3] = hut3 + hut2*fAngSlope_y;
+
+  // Powers of the focal plane coordinates
+  Double_t pw[4][kMaxReconExp+1];
+  for(Int_t j=0;j<4;j++) {
+    pw[j][0] = 1.0;
+    for(Int_t n=1;n<=fMaxReconExp;n++) {
+      pw[j][n] = pw[j][n-1]*hut_rot[j];
+    }
+  }
 
   // Compute COSY sums
-  Double_t sum[4];
-  for(Int_t k=0;k<4;k++) {
-    sum[k] = 0.0;
+  sums.NXtarExp = fMaxReconXtarExp;
+  for(Int_t n=0;n<=fMaxReconXtarExp;n++) {
+    for(Int_t k=0;k<4;k++) {
+      sums.Sum[n][k] = 0.0;
+    }
   }
   for(Int_t iterm=0;iterm<fNReconTerms;iterm++) {
-    Double_t term=1.0;
-    for(Int_t j=0;j<5;j++) {
-      if(fReconTerms[iterm].Exp[j]!=0) {
-	term *= pow(hut_rot[j],fReconTerms[iterm].Exp[j]);
-      }
+    const reconTerm& rt = fReconTerms[iterm];
+    Double_t term = pw[0][rt.Exp[0]]*pw[1][rt.Exp[1]]
+      *pw[2][rt.Exp[2]]*pw[3][rt.Exp[3]];
+    Double_t* sum = sums.Sum[rt.Exp[4]];
+    for(Int_t k=0;k<4;k++) {
+      sum[k] += term*rt.Coeff[k];
     }
+  }
+}
+//
+//_____________________________________________________________________________
+void THcHallCSpectrometer::FinishTargetQuantities(const TargetSums& sums, Double_t xtar, Double_t& xptar, Double_t& ytar, Double_t& yptar, Double_t& delta) const
+{
+  /**
+     Second half of CalculateTargetQuantities(): complete the partial sums
+     from CalculateTargetSums() for the beam position xtar (cm) and apply
+     the offsets.
+  */
+
+  Double_t hut4 = xtar/100.0;
+
+  Double_t sum[4];
+  for(Int_t k=0;k<4;k++) {
+    sum[k] = sums.Sum[0][k];
+  }
+  Double_t xpow = 1.0;
+  for(Int_t n=1;n<=sums.NXtarExp;n++) {
+    xpow *= hut4;
     for(Int_t k=0;k<4;k++) {
-      sum[k] += term*fReconTerms[iterm].Coeff[k];
+      sum[k] += sums.Sum[n][k]*xpow;
     }
   }
   xptar=sum[0] + fPhiOffset;
@@ -569,6 +649,25 @@ void THcHallCSpectrometer::CalculateTargetQuantities(THaTrack* track,Double_t& x
 }
 //
 //_____________________________________________________________________________
+const THcHallCSpectrometer::TargetSums* THcHallCSpectrometer::GetTargetSums(const THaTrack* track) const
+{
+  /**
+     Return the partial sums computed for track in FindVertices() this
+     event, or 0 if there are none (or the focal plane coordinates of the
+     track changed since).
+  */
+
+  for(Int_t it=0;it<fNTargetSums;it++) {
+    const TargetSums& sums = fTargetSums[it];
+    if( sums.Track == track &&
+	sums.Fp[0] == track->GetX() && sums.Fp[1] == track->GetTheta() &&
+	sums.Fp[2] == track->GetY() && sums.Fp[3] == track->GetPhi() )
+      return &sums;
+  }
+  return 0;
+}
+//
+//_____________________________________________________________________________
 Int_t THcHallCSpectrometer::TrackCalc()
 {
   if( fNtracks > 0 ) {
@@ -630,31 +729,11 @@ Int_t THcHallCSpectrometer::BestTrackUsingScin()
     Int_t y2Dmin = 100;
     Int_t x2Dmin = 100;
 
-    Bool_t* x2Hits        = new Bool_t [fHodo->GetNPaddles(2)];
-    Bool_t* y2Hits        = new Bool_t [fHodo->GetNPaddles(3)];
-    for (UInt_t j = 0; j < fHodo->GetNPaddles(2); j++ ){
-      x2Hits[j] = kFALSE;
-    }
-    for (UInt_t j = 0; j < fHodo->GetNPaddles(3); j++ ){
-      y2Hits[j] = kFALSE;
-    }
-
-    for (Int_t rawindex=0; rawindex<fHodo->GetTotHits(); rawindex++) {
-      Int_t ip = fHodo->GetGoodRawPlane(rawindex);
-      if(ip==2) {	// X2
-	Int_t goodRawPad = fHodo->GetGoodRawPad(rawindex);
-	x2Hits[goodRawPad] = kTRUE;
-      } else if (ip==3) { // Y2
-	Int_t goodRawPad = fHodo->GetGoodRawPad(rawindex);
-	y2Hits[goodRawPad] = kTRUE;
-      }
-    }
-
     for (Int_t itrack = 0; itrack < fNtracks; itrack++ ){
       Double_t chi2PerDeg;
 
       THaTrack* aTrack = static_cast<THaTrack*>( fTracks->At(itrack) );
-      if (!aTrack) {delete[] x2Hits; delete[] y2Hits; return -1;}
+      if (!aTrack) return -1;
 
       if ( aTrack->GetNDoF() > fSelNDegreesMin ){
 	chi2PerDeg =  aTrack->GetChi2() / aTrack->GetNDoF();
@@ -676,33 +755,12 @@ Int_t THcHallCSpectrometer::BestTrackUsingScin()
 	    Int_t icounter4  = TMath::Nint( ( fHodo->GetPlaneCenter(3) - hitpos4 ) / fHodo->GetPlaneSpacing(3) ) + 1;
 	    Int_t hitCnt4  = TMath::Max( TMath::Min(icounter4, (Int_t) fHodo->GetNPaddles(3) ) , 1); // scin_2y_nr = 10
 	    //	      fHitDist4 = fHitPos4 - ( fHodo->GetPlaneCenter(3) - fHodo->GetPlaneSpacing(3) * ( hitCnt4 - 1 ) );
-	    // Plane 3
-	    Int_t mindiff=1000;
-	    for (UInt_t i = 0; i <  fHodo->GetNPaddles(2); i++ ){
-	      if ( x2Hits[i] ) {
-		Int_t diff = TMath::Abs((Int_t)hitCnt3-(Int_t)i-1);
-		if (diff < mindiff) mindiff = diff;
-	      }
-	    }
-	    if(mindiff < 1000) {
-	      x2D = mindiff;
-	    } else {
-	      x2D = 0;	// Is this what we really want if there were no hits on this plane?
-	    }
-
-	    // Plane 4
-	    mindiff = 1000;
-	    for (UInt_t i = 0; i < fHodo->GetNPaddles(3); i++ ){
-	      if ( y2Hits[i] ) {
-		Int_t diff = TMath::Abs((Int_t)hitCnt4-(Int_t)i-1);
-		if (diff < mindiff) mindiff = diff;
-	      }
-	    }
-	    if(mindiff < 1000) {
-	      y2D = mindiff;
-	    } else {
-	      y2D = 0;	// Is this what we really want if there were no hits on this plane?
-	    }
+	    // Distance to the nearest hit paddle on the X2 and Y2 planes,
+	    // from the hodoscope's occupancy bitmaps
+	    x2D = fHodo->GetPaddleDistance(2, hitCnt3-1);
+	    if(x2D < 0) x2D = 0;	// Is this what we really want if there were no hits on this plane?
+	    y2D = fHodo->GetPaddleDistance(3, hitCnt4-1);
+	    if(y2D < 0) y2D = 0;
 	  } else { // Only a single track
 	    x2D = 0.;
 	    y2D = 0.;
@@ -39,9 +39,25 @@ public:
   THcHallCSpectrometer( const char* name, const char* description );
   virtual ~THcHallCSpectrometer();
 
+  virtual EStatus Init( const TDatime& run_time );
   virtual Int_t   ReadDatabase( const TDatime& date );
   virtual void    EnforcePruneLimits();
   virtual void    CalculateTargetQuantities(THaTrack* track,Double_t& gbeam_y,Double_t&  xptar,Double_t& ytar,Double_t& yptar,Double_t& delta);
+
+  // Maximum exponent of a variable in the reconstruction matrix elements
+  enum { kMaxReconExp = 9 };
+  // Partial COSY sums of one track, by power of xtar.  All dependence on
+  // the focal plane coordinates is in Sum, so the target quantities can be
+  // finished cheaply for any number of xtar values.
+  struct TargetSums {
+    const THaTrack* Track;	// Track the sums were computed for
+    Double_t Fp[4];		// Its focal plane x, theta, y, phi
+    Int_t    NXtarExp;		// Highest power of xtar in use
+    Double_t Sum[kMaxReconExp+1][4];
+  };
+  void            CalculateTargetSums(THaTrack* track, TargetSums& sums) const;
+  void            FinishTargetQuantities(const TargetSums& sums, Double_t xtar, Double_t& xptar, Double_t& ytar, Double_t& yptar, Double_t& delta) const;
+  const TargetSums* GetTargetSums(const THaTrack* track) const;
   virtual Int_t   FindVertices( TClonesArray& tracks );
   virtual Int_t   TrackCalc();
   virtual Int_t   BestTrackSimple();
@@ -134,6 +150,10 @@ protected:
     }
   };
   std::vector<reconTerm> fReconTerms;
+  Int_t fMaxReconExp;		// Highest exponent of any variable
+  Int_t fMaxReconXtarExp;	// Highest exponent of xtar
+  std::vector<TargetSums> fTargetSums; // Sums of the tracks of this event
+  Int_t fNTargetSums;
   //  Double_t fReconCoeff[fMaxReconElements][4];
   //  Int_t fReconExponents[fMaxReconElements][5];
   Double_t fAngSlope_x;
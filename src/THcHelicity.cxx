@@ -14,6 +14,7 @@
 #include "THaApparatus.h"
 #include "THaEvData.h"
 #include "THcGlobals.h"
+#include "THcCheckpoint.h"
 #include "THcParmList.h"
 #include "THcHelicityScaler.h"
 #include "TH1F.h"
@@ -50,6 +51,7 @@ THcHelicity::THcHelicity()
 THcHelicity::~THcHelicity() 
 {
   DefineVariables( kDelete );
+  if(gHcCheckpoint) gHcCheckpoint->RemovePrefix(GetPrefix());
 
   // for( Int_t i = 0; i < NHIST; ++i ) {
   //   delete fHisto[i];
@@ -95,6 +97,56 @@ THaAnalysisObject::EStatus THcHelicity::Init(const TDatime& date) {
   fCycle = 0.0;
   fRecommendedFreq = -1.0;
 
+  if(gHcCheckpoint) {		// Prediction state to save for resuming
+    TString prefix = GetPrefix();
+    gHcCheckpoint->Define(prefix+"FirstEvProcessed", &fFirstEvProcessed);
+    gHcCheckpoint->Define(prefix+"FoundMPS", &fFoundMPS);
+    gHcCheckpoint->Define(prefix+"FoundQuartet", &fFoundQuartet);
+    gHcCheckpoint->Define(prefix+"IsNewCycle", &fIsNewCycle);
+    gHcCheckpoint->Define(prefix+"FixFirstCycle", &fFixFirstCycle);
+    gHcCheckpoint->Define(prefix+"HaveQRT", &fHaveQRT);
+    gHcCheckpoint->Define(prefix+"Disabled", &fDisabled);
+    gHcCheckpoint->Define(prefix+"FirstEvTime", &fFirstEvTime);
+    gHcCheckpoint->Define(prefix+"LastEvTime", &fLastEvTime);
+    gHcCheckpoint->Define(prefix+"LastMPSTime", &fLastMPSTime);
+    gHcCheckpoint->Define(prefix+"TITime_last", &fTITime_last);
+    gHcCheckpoint->Define(prefix+"TITime_rollovers", &fTITime_rollovers);
+    gHcCheckpoint->Define(prefix+"Freq", &fFreq);
+    gHcCheckpoint->Define(prefix+"RecommendedFreq", &fRecommendedFreq);
+    gHcCheckpoint->Define(prefix+"TIPeriod", &fTIPeriod);
+    gHcCheckpoint->Define(prefix+"PeriodCheck", &fPeriodCheck);
+    gHcCheckpoint->Define(prefix+"PeriodCheckOffset", &fPeriodCheckOffset);
+    gHcCheckpoint->Define(prefix+"Cycle", &fCycle);
+    gHcCheckpoint->Define(prefix+"FirstCycle", &fFirstCycle);
+    gHcCheckpoint->Define(prefix+"LastReportedHelicity", &fLastReportedHelicity);
+    gHcCheckpoint->Define(prefix+"PredictedHelicity", &fPredictedHelicity);
+    gHcCheckpoint->Define(prefix+"ActualHelicity", &fActualHelicity);
+    gHcCheckpoint->Define(prefix+"LastActualHelicity", &fLastActualHelicity);
+    gHcCheckpoint->Define(prefix+"QuartetStartHelicity", &fQuartetStartHelicity);
+    gHcCheckpoint->Define(prefix+"QuartetStartPredictedHelicity",
+			  &fQuartetStartPredictedHelicity);
+    gHcCheckpoint->Define(prefix+"NCycle", &fNCycle);
+    gHcCheckpoint->Define(prefix+"NQuartet", &fNQuartet);
+    gHcCheckpoint->Define(prefix+"NLastQuartet", &fNLastQuartet);
+    gHcCheckpoint->Define(prefix+"Quartet", fQuartet, 4);
+    gHcCheckpoint->Define(prefix+"NBits", &fNBits);
+    gHcCheckpoint->Define(prefix+"nQrt", &fnQrt);
+    gHcCheckpoint->Define(prefix+"NQRTProblems", &fNQRTProblems);
+    gHcCheckpoint->Define(prefix+"RingSeed_reported_initial", &fRingSeed_reported_initial);
+    gHcCheckpoint->Define(prefix+"RingSeed_reported", &fRingSeed_reported);
+    gHcCheckpoint->Define(prefix+"RingSeed_actual", &fRingSeed_actual);
+    gHcCheckpoint->Define(prefix+"EvNumCheck", &fEvNumCheck);
+    gHcCheckpoint->Define(prefix+"LastHelpCycle", &fLastHelpCycle);
+    gHcCheckpoint->Define(prefix+"QuadPattern", fQuadPattern, 8);
+    gHcCheckpoint->Define(prefix+"HelperHistory", &fHelperHistory);
+    gHcCheckpoint->Define(prefix+"HelperQuartetHistory", &fHelperQuartetHistory);
+    gHcCheckpoint->Define(prefix+"ScalerSeed", &fScalerSeed);
+    gHcCheckpoint->Define(prefix+"lastispos", &lastispos);
+    gHcCheckpoint->Define(prefix+"ThisScaleHel", &fThisScaleHel);
+    gHcCheckpoint->Define(prefix+"LastScaleHel", &fLastScaleHel);
+    gHcCheckpoint->Define(prefix+"LastLastScaleHel", &fLastLastScaleHel);
+  }
+
   fStatus = kOK;
   return fStatus;
 }
@@ -26,6 +26,7 @@
 #include "THaGlobals.h"
 #include "THcParmList.h"
 #include "THcHelicity.h"
+#include "THcMemoryReport.h"
 #include "TNamed.h"
 #include "TMath.h"
 #include "TString.h"
@@ -1421,4 +1422,15 @@ size_t THcHelicityScaler::FindNoCase(const string& sdata, const string& skey)
 //---------------------------------------------------------------------------------
 
 
+//_____________________________________________________________________________
+void THcHelicityScaler::AccountMemory( THcMemoryReport& report ) const
+{
+  // Events of the delayed type are kept until End
+  Long64_t bytes = THcMemoryReport::Bytes(fDelayedEvents);
+  for( vector<UInt_t*>::const_iterator it = fDelayedEvents.begin();
+       it != fDelayedEvents.end(); ++it )
+    bytes += ((*it)[0]+1)*sizeof(UInt_t);
+  report.Add("delayed events", bytes, THcMemoryReport::kDynamic);
+}
+
 ClassImp(THcHelicityScaler)
@@ -10,6 +10,7 @@
 
 #include "THaEvtTypeHandler.h"
 #include "THcScalerEvtHandler.h"
+#include "THcMemoryAccount.h"
 #include "Decoder.h"
 #include <string>
 #include <vector>
@@ -23,7 +24,7 @@
 class THcHelicity;
 class HCScalerLoc;
 
-class THcHelicityScaler : public THaEvtTypeHandler {
+class THcHelicityScaler : public THaEvtTypeHandler, public THcMemoryAccount {
 
 public:
 
@@ -37,6 +38,7 @@ public:
   virtual EStatus Init( const TDatime& run_time);
   virtual Int_t   ReadDatabase(const TDatime& date );
   virtual Int_t End( THaRunBase* r=0 );
+  virtual void AccountMemory( THcMemoryReport& report ) const;
 
   virtual void SetUseFirstEvent(Bool_t b = kFALSE) {fUseFirstEvent = b;}
   virtual void SetDelayedType(int evtype);
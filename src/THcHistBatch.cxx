@@ -0,0 +1,417 @@
+/** \class THcHistBatch
+    \ingroup Base
+
+    \brief Fills the histograms of the output definition a block of events at a time.
+
+    THaOutput fills each TH1F/TH1D/TH2F/TH2D of the output definition file
+    right after each event.  With THcAnalyzer::SetBatchHistograms these
+    histograms are taken out of the output definition before THaOutput
+    reads it, and are handled here instead.  After each event the values
+    that pass the histogram cut are appended to a buffer per histogram.
+    Every fBlockSize events the buffers are emptied into the histograms
+    with FillN, optionally by several threads of a THcWorkerPool, which
+    are started at the first block and kept for the following ones.
+    Each histogram is always filled by the same thread, in event order,
+    so the contents and the statistics are bit for bit the same as
+    filling one value at a time.  No per-thread copies or merging are
+    needed.
+
+    Axis variables and cuts that are plain global variables (or one
+    element, "H.cal.1pr.goodPosAdcPulseInt[3]") are read directly.
+    Anything else is evaluated with THcFormula.  Histograms that use a
+    formula or cut defined in the output definition itself are left to
+    THaOutput.  As in THaOutput, array variables fill one entry per
+    element.  An array cut selects elements, a scalar cut the whole
+    event.
+*/
+
+#include "THcHistBatch.h"
+#include "THcWorkerPool.h"
+#include "THcFormula.h"
+#include "THcGlobals.h"
+#include "THaGlobals.h"
+#include "THaVarList.h"
+#include "THaVar.h"
+#include "THaCutList.h"
+#include "TH1F.h"
+#include "TH1D.h"
+#include "TH2F.h"
+#include "TH2D.h"
+#include "TDirectory.h"
+#include "TError.h"
+#include "TMath.h"
+#include <fstream>
+#include <sstream>
+#include <cctype>
+#include <iostream>
+
+using namespace std;
+
+static Bool_t IsIdentifier(const TString& s)
+{
+  if(s.Length() == 0 || !(isalpha(s[0]) || s[0] == '_')) return kFALSE;
+  for(Int_t i=1;i<s.Length();i++) {
+    if(!(isalnum(s[i]) || s[i] == '_' || s[i] == '.')) return kFALSE;
+  }
+  return kTRUE;
+}
+
+static Int_t SourceSize(const THcHistBatch::Source& s)
+{
+  if(s.var) {
+    if(s.index >= 0) return (s.index < s.var->GetLen()) ? 1 : 0;
+    return s.var->GetLen();
+  }
+  return s.form->IsArray() ? s.form->GetNdata() : 1;
+}
+
+static Double_t SourceValue(THcHistBatch::Source& s, Int_t i)
+{
+  if(s.var) return s.var->GetValue(s.index >= 0 ? s.index : i);
+  return s.form->IsArray() ? s.form->EvalInstance(i) : s.form->Eval();
+}
+
+//_____________________________________________________________________________
+THcHistBatch::THcHistBatch(Int_t blocksize, Int_t nthreads)
+  : fBlockSize(blocksize > 0 ? blocksize : 1), fNThreads(nthreads), fNEvents(0),
+    fPool(0), fDir(0)
+{
+}
+
+//_____________________________________________________________________________
+THcHistBatch::~THcHistBatch()
+{
+  // The histograms belong to the output file
+  delete fPool;
+  for(UInt_t i=0;i<fHists.size();i++) {
+    delete fHists[i]->x.form;
+    delete fHists[i]->y.form;
+    delete fHists[i]->cut.form;
+    delete fHists[i];
+  }
+}
+
+//_____________________________________________________________________________
+Bool_t THcHistBatch::ParseHist(const TString& line, Hist& h) const
+{
+  // Parse "TH1F name 'title' x nbins lo hi [cut]" or
+  // "TH2F name 'title' x y nx xlo xhi ny ylo yhi [cut]"
+  Ssiz_t q1 = line.Index("'");
+  Ssiz_t q2 = (q1 >= 0) ? line.Index("'", q1+1) : -1;
+  if(q2 < 0) return kFALSE;
+  istringstream head(line(0, q1).Data());
+  string type, name;
+  head >> type >> name;
+  h.type = type;
+  h.type.ToUpper();
+  h.name = name;
+  h.title = line(q1+1, q2-q1-1);
+  Bool_t is2d = h.type.BeginsWith("TH2");
+
+  istringstream args(line(q2+1, line.Length()-q2-1).Data());
+  vector<string> tok;
+  string s;
+  while(args >> s) tok.push_back(s);
+  UInt_t nargs = is2d ? 8 : 4;
+  if(h.name.IsNull() || (tok.size() != nargs && tok.size() != nargs+1)) {
+    return kFALSE;
+  }
+  h.x.expr = tok[0].c_str();
+  if(is2d) {
+    h.y.expr = tok[1].c_str();
+    h.nx = atoi(tok[2].c_str());
+    h.xlo = atof(tok[3].c_str());
+    h.xhi = atof(tok[4].c_str());
+    h.ny = atoi(tok[5].c_str());
+    h.ylo = atof(tok[6].c_str());
+    h.yhi = atof(tok[7].c_str());
+  } else {
+    h.nx = atoi(tok[1].c_str());
+    h.xlo = atof(tok[2].c_str());
+    h.xhi = atof(tok[3].c_str());
+    h.ny = 0;
+    h.ylo = h.yhi = 0;
+  }
+  if(tok.size() > nargs) h.cut.expr = tok[nargs].c_str();
+  return h.nx > 0 && (!is2d || h.ny > 0);
+}
+
+//_____________________________________________________________________________
+Bool_t THcHistBatch::UsesName(const TString& expr) const
+{
+  // Does expr use a formula or cut defined in the output definition?
+  Int_t i = 0;
+  while(i < expr.Length()) {
+    if(!(isalpha(expr[i]) || expr[i] == '_')) {
+      i++;
+      continue;
+    }
+    Int_t j = i+1;
+    while(j < expr.Length() &&
+	  (isalnum(expr[j]) || expr[j] == '_' || expr[j] == '.')) j++;
+    TString word = expr(i, j-i);
+    for(UInt_t k=0;k<fOdefNames.size();k++) {
+      if(word == fOdefNames[k]) return kTRUE;
+    }
+    i = j;
+  }
+  return kFALSE;
+}
+
+//_____________________________________________________________________________
+Int_t THcHistBatch::SplitOutputDef(const char* odeffile, const char* restfile)
+{
+  /**
+     Read the output definition odeffile, keep the histograms that can be
+     filled here and write everything else to restfile for THaOutput.
+     Returns the number of histograms kept, or -1 on errors.
+  */
+  ifstream in(odeffile);
+  if(!in) {
+    ::Error("THcHistBatch::SplitOutputDef", "Cannot open %s", odeffile);
+    return -1;
+  }
+  vector<string> lines;
+  string line;
+  fOdefNames.clear();
+  while(getline(in, line)) {
+    lines.push_back(line);
+    istringstream ls(line);
+    string key, name;
+    ls >> key >> name;
+    TString k(key.c_str());
+    k.ToLower();
+    if((k == "formula" || k == "cut") && !name.empty()) {
+      fOdefNames.push_back(name.c_str());
+    }
+  }
+  in.close();
+
+  ofstream out(restfile);
+  if(!out) {
+    ::Error("THcHistBatch::SplitOutputDef", "Cannot write %s", restfile);
+    return -1;
+  }
+  Bool_t inblock = kFALSE;	// begin epics ... end epics
+  for(UInt_t il=0;il<lines.size();il++) {
+    TString tl(lines[il].c_str());
+    Ssiz_t comment = tl.Index("#");
+    if(comment >= 0) tl.Remove(comment);
+    tl = tl.Strip(TString::kBoth);
+    TString key = tl;
+    Ssiz_t space = key.First(" \t");
+    if(space > 0) key.Remove(space);
+    key.ToLower();
+    if(key == "begin") inblock = kTRUE;
+    if(key == "end") inblock = kFALSE;
+    if(!inblock && key.BeginsWith("th") && key.Length() == 4) {
+      Hist* h = new Hist;
+      h->x.var = h->y.var = h->cut.var = 0;
+      h->x.form = h->y.form = h->cut.form = 0;
+      h->x.index = h->y.index = h->cut.index = -1;
+      h->hist = 0;
+      if((key == "th1f" || key == "th1d" || key == "th2f" || key == "th2d")
+	 && ParseHist(tl, *h) && !UsesName(h->x.expr) && !UsesName(h->y.expr)
+	 && !UsesName(h->cut.expr)) {
+	Bool_t known = kFALSE;
+	for(UInt_t i=0;i<fHists.size();i++) {
+	  if(fHists[i]->name == h->name) known = kTRUE;
+	}
+	if(known) {		// Already set up by an earlier Init
+	  delete h;
+	} else {
+	  fHists.push_back(h);
+	}
+	continue;
+      }
+      delete h;
+    }
+    out << lines[il] << endl;
+  }
+  out.close();
+  return fHists.size();
+}
+
+//_____________________________________________________________________________
+Bool_t THcHistBatch::Compile(Source& s, const char* name)
+{
+  delete s.form;
+  s.form = 0;
+  s.var = 0;
+  s.index = -1;
+  if(s.expr.IsNull()) return kTRUE;
+
+  TString vname = s.expr;
+  Int_t index = -1;
+  Ssiz_t lb = s.expr.Index("[");
+  if(lb > 0 && s.expr.EndsWith("]")) {
+    TString idx = s.expr(lb+1, s.expr.Length()-lb-2);
+    if(idx.IsDigit()) {
+      vname = s.expr(0, lb);
+      index = idx.Atoi();
+    }
+  }
+  if(IsIdentifier(vname)) {
+    THaVar* var = gHaVars->Find(vname);
+    if(var) {
+      s.var = var;
+      s.index = index;
+      return kTRUE;
+    }
+  }
+  s.form = new THcFormula(name, s.expr, gHcParms, gHaVars, gHaCuts);
+  if(s.form->IsError()) {
+    delete s.form;
+    s.form = 0;
+    return kFALSE;
+  }
+  return kTRUE;
+}
+
+//_____________________________________________________________________________
+Int_t THcHistBatch::Init(TDirectory* dir)
+{
+  /**
+     Look up the variables and compile the expressions, which may have
+     changed since the last run, and book the histograms in dir unless
+     they are already there (a following run written to the same file).
+     Returns the number of histograms that can not be filled.
+  */
+  if(dir != fDir) Detach();	// The histograms went with the old file
+  fDir = dir;
+  Int_t nbad = 0;
+  for(UInt_t i=0;i<fHists.size();i++) {
+    Hist& h = *fHists[i];
+    h.xbuf.clear();
+    h.ybuf.clear();
+    if(!Compile(h.x, h.name+"_x") || !Compile(h.y, h.name+"_y")
+       || !Compile(h.cut, h.name+"_cut")) {
+      ::Warning("THcHistBatch::Init", "Histogram %s: can not evaluate %s %s %s",
+		h.name.Data(), h.x.expr.Data(), h.y.expr.Data(), h.cut.expr.Data());
+      nbad++;
+      continue;
+    }
+    if(!h.hist) {
+      TDirectory::TContext ctxt(dir);
+      if(h.type == "TH1F") {
+	h.hist = new TH1F(h.name, h.title, h.nx, h.xlo, h.xhi);
+      } else if(h.type == "TH1D") {
+	h.hist = new TH1D(h.name, h.title, h.nx, h.xlo, h.xhi);
+      } else if(h.type == "TH2F") {
+	h.hist = new TH2F(h.name, h.title, h.nx, h.xlo, h.xhi, h.ny, h.ylo, h.yhi);
+      } else {
+	h.hist = new TH2D(h.name, h.title, h.nx, h.xlo, h.xhi, h.ny, h.ylo, h.yhi);
+      }
+    }
+  }
+  fNEvents = 0;
+  cout << "THcHistBatch: " << fHists.size()-nbad << " histograms filled in blocks of "
+       << fBlockSize << " events" << endl;
+  return nbad;
+}
+
+//_____________________________________________________________________________
+void THcHistBatch::Collect(Hist& h)
+{
+  // Append the values of the current event that pass the cut
+  if(h.cut.var || h.cut.form) {
+    Int_t ncut = SourceSize(h.cut);
+    if(ncut == 0 || (ncut == 1 && SourceValue(h.cut, 0) == 0)) return;
+  }
+  Bool_t is2d = (h.ny > 0);
+  Int_t nx = SourceSize(h.x);
+  Int_t ny = is2d ? SourceSize(h.y) : 1;
+  Int_t n = (nx == 1) ? ny : ((ny == 1) ? nx : TMath::Min(nx, ny));
+  if(n == 0) return;
+  Int_t ncut = (h.cut.var || h.cut.form) ? SourceSize(h.cut) : 1;
+  Double_t x0 = (nx == 1) ? SourceValue(h.x, 0) : 0;
+  Double_t y0 = (is2d && ny == 1) ? SourceValue(h.y, 0) : 0;
+  for(Int_t i=0;i<n;i++) {
+    if(ncut > 1 && (i >= ncut || SourceValue(h.cut, i) == 0)) continue;
+    h.xbuf.push_back((nx == 1) ? x0 : SourceValue(h.x, i));
+    if(is2d) h.ybuf.push_back((ny == 1) ? y0 : SourceValue(h.y, i));
+  }
+}
+
+//_____________________________________________________________________________
+void THcHistBatch::Process()
+{
+  // Once per accepted physics event, after the cuts have been evaluated
+  for(UInt_t i=0;i<fHists.size();i++) {
+    if(fHists[i]->hist && (fHists[i]->x.var || fHists[i]->x.form)) {
+      Collect(*fHists[i]);
+    }
+  }
+  if(++fNEvents >= fBlockSize) Flush();
+}
+
+//_____________________________________________________________________________
+void THcHistBatch::FillHists(Int_t first, Int_t step)
+{
+  // Empty the buffers of histograms first, first+step, ...
+  for(UInt_t i=first;i<fHists.size();i+=step) {
+    Hist& h = *fHists[i];
+    Int_t n = h.xbuf.size();
+    if(n == 0) continue;
+    if(h.ny > 0) {
+      static_cast<TH2*>(h.hist)->FillN(n, &h.xbuf[0], &h.ybuf[0], 0);
+    } else {
+      h.hist->FillN(n, &h.xbuf[0], 0);
+    }
+    h.xbuf.clear();
+    h.ybuf.clear();
+  }
+}
+
+//_____________________________________________________________________________
+void THcHistBatch::FillSlice(void* arg, Int_t islice, Int_t nslices)
+{
+  // Task of the worker pool
+  static_cast<THcHistBatch*>(arg)->FillHists(islice, nslices);
+}
+
+//_____________________________________________________________________________
+void THcHistBatch::Flush()
+{
+  // Fill the histograms with the values collected so far
+  if(fNThreads != 1 && fHists.size() > 1) {
+    if(!fPool) fPool = new THcWorkerPool;
+    fPool->SetNThreads(fNThreads);
+    Int_t nthreads = fPool->GetNThreads();
+    if(nthreads > (Int_t)fHists.size()) nthreads = fHists.size();
+    fPool->Run(&THcHistBatch::FillSlice, this, nthreads);
+  } else {
+    FillHists(0, 1);
+  }
+  fNEvents = 0;
+}
+
+//_____________________________________________________________________________
+void THcHistBatch::Detach()
+{
+  // Forget the histograms and the directory they were booked in, which
+  // is about to be closed.  The file deletes the histograms, so the next
+  // Init books them again in the new output file.
+  for(UInt_t i=0;i<fHists.size();i++) {
+    fHists[i]->hist = 0;
+    fHists[i]->xbuf.clear();
+    fHists[i]->ybuf.clear();
+  }
+  fDir = 0;
+  fNEvents = 0;
+}
+
+//_____________________________________________________________________________
+void THcHistBatch::End()
+{
+  // Fill the last block and write the histograms to their file
+  Flush();
+  for(UInt_t i=0;i<fHists.size();i++) {
+    TH1* hist = fHists[i]->hist;
+    if(!hist || !hist->GetDirectory()) continue;
+    TDirectory::TContext ctxt(hist->GetDirectory());
+    hist->Write(0, TObject::kOverwrite);
+  }
+}
+
+ClassImp(THcHistBatch)
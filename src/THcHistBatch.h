@@ -0,0 +1,84 @@
+#ifndef ROOT_THcHistBatch
+#define ROOT_THcHistBatch
+
+//////////////////////////////////////////////////////////////////////////
+//
+// THcHistBatch
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "Rtypes.h"
+#include "TString.h"
+#include <vector>
+
+class TH1;
+class TDirectory;
+class THaVar;
+class THcFormula;
+class THcWorkerPool;
+
+class THcHistBatch {
+
+public:
+
+  THcHistBatch(Int_t blocksize=1000, Int_t nthreads=1);
+  virtual ~THcHistBatch();
+
+  Int_t  SplitOutputDef(const char* odeffile, const char* restfile);
+  Int_t  Init(TDirectory* dir);
+  void   Process();
+  void   Flush();
+  void   End();
+  void   Detach();
+
+  void   SetBlockSize(Int_t n) {fBlockSize = (n>0) ? n : 1;}
+  void   SetNThreads(Int_t n)  {fNThreads = n;}
+  Int_t  GetNHists() const     {return fHists.size();}
+
+  // Values of one axis or the cut, from a global variable (read
+  // directly) or an expression
+  struct Source {
+    TString     expr;
+    THaVar*     var;
+    Int_t       index;		// Element of var, -1 for all
+    THcFormula* form;
+  };
+
+  // One histogram taken from the output definition
+  struct Hist {
+    TString  type;		// TH1F, TH1D, TH2F or TH2D
+    TString  name;
+    TString  title;
+    Int_t    nx, ny;
+    Double_t xlo, xhi, ylo, yhi;
+    Source   x, y, cut;
+    TH1*     hist;
+    std::vector<Double_t> xbuf;	// Values of the current block
+    std::vector<Double_t> ybuf;
+  };
+
+protected:
+
+  Bool_t ParseHist(const TString& line, Hist& h) const;
+  Bool_t UsesName(const TString& expr) const;
+  Bool_t Compile(Source& s, const char* name);
+  void   Collect(Hist& h);
+  void   FillHists(Int_t first, Int_t step);
+  static void FillSlice(void* arg, Int_t islice, Int_t nslices);
+
+  Int_t  fBlockSize;		// Events per block
+  Int_t  fNThreads;		// 0: one per core
+  Int_t  fNEvents;		// Events in the current block
+  THcWorkerPool* fPool;		//! Fill threads, kept for all blocks
+  TDirectory* fDir;		//! Where the histograms are booked
+  std::vector<Hist*> fHists;
+  std::vector<TString> fOdefNames; // Formulas and cuts of the output definition
+
+private:
+  THcHistBatch(const THcHistBatch&);
+  THcHistBatch& operator=(const THcHistBatch&);
+
+  ClassDef(THcHistBatch,0)	// Block filling of output definition histograms
+};
+
+#endif
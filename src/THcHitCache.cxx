@@ -0,0 +1,204 @@
+/** \class THcHitCache
+    \ingroup Base
+
+    \brief File of decoded raw hits, written once and replayed in later passes.
+
+    Calibration passes (hodoscope timing, calorimeter gains, drift
+    chamber t0's) decode the same raw data again every time.  When
+    gHcHitCache is open for writing, every THcHitList records the raw
+    hit setter calls it makes while decoding an event (plane, counter,
+    TDC hits, FADC samples and pulse integral/time/pedestal/peak,
+    resolved reference times) and stores them here.  When it is open
+    for reading, DecodeToHitList replays those calls instead of looking
+    at the event data.  The channel loops, the reference time search
+    and the FADC trigger time corrections are skipped.
+
+    Each detector has its own tree, named after its prefix, with one
+    entry per decoded event and the event number as a key.  A detector
+    without a tree, or an event missing from the tree, is decoded from
+    the raw data as usual.  The cache must be written with the same
+    detector map (and reference time cuts) as the replay that uses it.
+
+    Typical use in a replay script:
+
+        gHcHitCache = new THcHitCache("cache/hits_1234.root");  // first pass
+        gHcHitCache = new THcHitCache("cache/hits_1234.root",
+                                      THcHitCache::kRead);      // later passes
+        ...
+        analyzer->Process(run);
+        gHcHitCache->Close();
+
+    The CODA file is still read by the event loop, since event headers,
+    scalers, EPICS and detectors without hit lists need it.
+*/
+
+#include "THcHitCache.h"
+#include "TFile.h"
+#include "TTree.h"
+#include "TBranch.h"
+#include "TDirectory.h"
+#include "TError.h"
+#include <iostream>
+#include <iomanip>
+
+using namespace std;
+
+//_____________________________________________________________________________
+THcHitCache::THcHitCache(const char* filename, EMode mode, Int_t compress)
+  : fFile(0), fMode(mode)
+{
+  // Open the cache file.  Writing replaces an existing file.
+  TDirectory::TContext ctxt(0);
+  if(mode == kWrite) {
+    fFile = new TFile(filename, "RECREATE", "hcana decoded raw hits", compress);
+  } else {
+    fFile = new TFile(filename, "READ");
+  }
+  if(!fFile || fFile->IsZombie()) {
+    ::Error("THcHitCache", "Can not open hit cache %s", filename);
+    delete fFile;
+    fFile = 0;
+  }
+}
+
+//_____________________________________________________________________________
+THcHitCache::~THcHitCache()
+{
+  Close();
+}
+
+//_____________________________________________________________________________
+Int_t THcHitCache::Register(const char* name)
+{
+  /**
+     Get the stream for the detector with prefix name.  Returns -1 if the
+     cache is not open, or, when reading, has nothing for the detector.
+  */
+  if(!fFile) return -1;
+  TString treename(name);
+  if(treename.EndsWith(".")) treename.Chop();
+  treename.ReplaceAll(".","_");
+
+  for(UInt_t id=0;id<fStreams.size();id++) {
+    if(fStreams[id]->name == treename) {
+      ::Error("THcHitCache::Register", "Stream %s registered twice",
+	      treename.Data());
+      return -1;
+    }
+  }
+
+  Stream* s = new Stream;
+  s->name = treename;
+  s->evnum = 0;
+  s->ops = new vector<Int_t>;
+  s->entry = 0;
+  s->nfound = 0;
+  s->nmissed = 0;
+  if(fMode == kWrite) {
+    TDirectory::TContext ctxt(fFile);
+    s->tree = new TTree(treename, Form("Decoded raw hits of %s", name));
+    s->evbranch = s->tree->Branch("evnum", &s->evnum, "evnum/I");
+    s->opsbranch = s->tree->Branch("ops", &s->ops);
+    s->nentries = 0;
+  } else {
+    s->tree = dynamic_cast<TTree*>(fFile->Get(treename));
+    if(!s->tree) {
+      cout << "THcHitCache: no hits for " << name
+	   << ", decoding from raw data" << endl;
+      delete s->ops;
+      delete s;
+      return -1;
+    }
+    s->tree->SetBranchAddress("evnum", &s->evnum);
+    s->tree->SetBranchAddress("ops", &s->ops);
+    s->evbranch = s->tree->GetBranch("evnum");
+    s->opsbranch = s->tree->GetBranch("ops");
+    s->nentries = s->tree->GetEntries();
+  }
+  fStreams.push_back(s);
+  return fStreams.size()-1;
+}
+
+//_____________________________________________________________________________
+void THcHitCache::Store(Int_t id, Int_t evnum, const vector<Int_t>& ops)
+{
+  // Save the ops of one event
+  Stream* s = fStreams[id];
+  s->evnum = evnum;
+  *s->ops = ops;
+  s->tree->Fill();
+  s->nentries++;
+}
+
+//_____________________________________________________________________________
+const vector<Int_t>* THcHitCache::Fetch(Int_t id, Int_t evnum)
+{
+  /**
+     Return the ops saved for event evnum, or 0 if there are none.
+     Events are expected in increasing order, as they come from the
+     CODA file.  Entries of skipped events are passed over without
+     reading their hits.
+  */
+  Stream* s = fStreams[id];
+  while(s->entry < s->nentries) {
+    s->evbranch->GetEntry(s->entry);
+    if(s->evnum < evnum) {
+      s->entry++;
+      continue;
+    }
+    if(s->evnum > evnum) break;
+    s->opsbranch->GetEntry(s->entry);
+    s->entry++;
+    s->nfound++;
+    return s->ops;
+  }
+  s->nmissed++;
+  return 0;
+}
+
+//_____________________________________________________________________________
+void THcHitCache::Rewind()
+{
+  // Start reading from the first event again, e.g. for a new pass
+  for(UInt_t id=0;id<fStreams.size();id++) {
+    fStreams[id]->entry = 0;
+  }
+}
+
+//_____________________________________________________________________________
+void THcHitCache::Print() const
+{
+  cout << "Hit cache " << (fFile ? fFile->GetName() : "(closed)")
+       << (fMode == kWrite ? " (writing)" : " (reading)") << endl;
+  for(UInt_t id=0;id<fStreams.size();id++) {
+    const Stream* s = fStreams[id];
+    cout << "  " << setw(12) << s->name << "  " << s->nentries << " events";
+    if(fMode == kRead) {
+      cout << ", " << s->nfound << " replayed, " << s->nmissed
+	   << " decoded from raw data";
+    }
+    cout << endl;
+  }
+}
+
+//_____________________________________________________________________________
+void THcHitCache::Close()
+{
+  // Write the trees (when writing) and close the file
+  if(!fFile) return;
+  Print();
+  if(fMode == kWrite) {
+    TDirectory::TContext ctxt(fFile);
+    fFile->Write();
+  }
+  fFile->Close();
+  delete fFile;			// Also deletes the trees
+  fFile = 0;
+  for(UInt_t id=0;id<fStreams.size();id++) {
+    delete fStreams[id]->ops;
+    delete fStreams[id];
+  }
+  fStreams.clear();
+}
+
+ClassImp(THcHitCache)
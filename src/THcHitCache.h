@@ -0,0 +1,73 @@
+#ifndef ROOT_THcHitCache
+#define ROOT_THcHitCache
+
+//////////////////////////////////////////////////////////////////////////
+//
+// THcHitCache
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "Rtypes.h"
+#include "TString.h"
+#include <vector>
+
+class TFile;
+class TTree;
+class TBranch;
+
+class THcHitCache {
+
+public:
+
+  enum EMode { kWrite, kRead };
+
+  // Raw hit setter calls recorded by THcHitList.  Each op is stored as
+  // a header word (op | nargs<<4 | signal<<8), plane, counter and the
+  // nargs arguments of the setter.
+  enum EOp { kHit, kData, kSample, kPulse, kReference, kF250 };
+
+  THcHitCache(const char* filename, EMode mode=kWrite, Int_t compress=101);
+  virtual ~THcHitCache();
+
+  Bool_t IsOpen() const    {return fFile != 0;}
+  Bool_t IsReading() const {return fFile && fMode == kRead;}
+  Bool_t IsWriting() const {return fFile && fMode == kWrite;}
+
+  Int_t  Register(const char* name);
+  void   Store(Int_t id, Int_t evnum, const std::vector<Int_t>& ops);
+  const std::vector<Int_t>* Fetch(Int_t id, Int_t evnum);
+  void   Rewind();
+  void   Close();
+  void   Print() const;
+
+  static Int_t OpWord(Int_t op, Int_t nargs, Int_t signal)
+  {return op | (nargs<<4) | (signal<<8);}
+
+  // Hits of one detector, one tree entry per decoded event
+  struct Stream {
+    TString  name;
+    TTree*   tree;
+    TBranch* evbranch;
+    TBranch* opsbranch;
+    Int_t    evnum;
+    std::vector<Int_t>* ops;
+    Long64_t entry;		// Read cursor
+    Long64_t nentries;
+    Long64_t nfound;
+    Long64_t nmissed;
+  };
+
+protected:
+
+  TFile*  fFile;
+  EMode   fMode;
+  std::vector<Stream*> fStreams;	//!
+
+private:
+  THcHitCache(const THcHitCache&);
+  THcHitCache& operator=(const THcHitCache&);
+
+  ClassDef(THcHitCache,0)	// Decoded raw hits saved for reprocessing
+};
+
+#endif
@@ -9,6 +9,12 @@
 
 */
 #include "THcHitList.h"
+#include "THcRawHodoHit.h"
+#include "THcRawShowerHit.h"
+#include "THcRawDCHit.h"
+#include "THcTrigRawHit.h"
+#include "THcCherenkovHit.h"
+#include "THcAerogelHit.h"
 #include "TError.h"
 #include "TClass.h"
 
@@ -16,17 +22,24 @@
 #include "THaGlobals.h"
 #include "THcGlobals.h"
 #include "THcParmList.h"
+#include "THcHitCache.h"
+#include "THcMemoryReport.h"
+#include "TMath.h"
+#include "THaAnalysisObject.h"
 #include "TList.h"
 
 using namespace std;
 
 #define SUPPRESSMISSINGADCREFTIMEMESSAGES 1
-THcHitList::THcHitList() : fMap(0), fTISlot(0), fDisableSlipCorrection(kFALSE)
+THcHitList::THcHitList() : fHitLayout(kGenericHit), fGenericDecode(kFALSE),
+			   fHitCache(0), fHitCacheId(-1), fRecordHits(kFALSE),
+			   fMap(0), fTISlot(0), fDisableSlipCorrection(kFALSE)
 {
   /// Normal constructor.
 
   fRawHitList = NULL;
   fPSE125 = NULL;
+  fTDCRefMissId = fADCRefMissId = -1;
   fFADCSlotMap.clear();
 
 }
@@ -94,6 +107,22 @@ void THcHitList::InitHitList(THaDetMap* detmap,
 
   fdMap = detmap;
 
+  // Pick the decoding specialized for the hit class.  Classes derived
+  // from these by users may override the setters, so match exactly.
+  if(fRawHitClass == THcRawHodoHit::Class()
+     || fRawHitClass == THcCherenkovHit::Class()
+     || fRawHitClass == THcAerogelHit::Class()) {
+    fHitLayout = kHodoHit;
+  } else if(fRawHitClass == THcRawShowerHit::Class()) {
+    fHitLayout = kShowerHit;
+  } else if(fRawHitClass == THcRawDCHit::Class()) {
+    fHitLayout = kDCHit;
+  } else if(fRawHitClass == THcTrigRawHit::Class()) {
+    fHitLayout = kTrigHit;
+  } else {
+    fHitLayout = kGenericHit;
+  }
+
   /* Pull out all the reference channels */
   fNRefIndex = 0;
   fRefIndexMaps.clear();
@@ -135,10 +164,13 @@ void THcHitList::InitHitList(THaDetMap* detmap,
     THaDetMap::Module* d = fdMap->GetModule(i);
     Int_t refindex = d->refindex;
     if(d->plane < 1000) {
-      if(d->signal >= fNSignals) {
+      if(d->signal < 0 || d->signal >= (Int_t) fNSignals) {
 	cout << "Invalid signal " << d->signal << " for " <<
 	  " (" << d->crate << ", " << d->slot <<
 	  ", " << d->lo << ")" << endl;
+	// The specialized setters do not range check the signal.
+	// Keep the checked virtual ones so this still throws.
+	fHitLayout = kGenericHit;
       }
       if(refindex >= 0) {
 	if(!fRefIndexMaps[refindex].defined) {
@@ -166,146 +198,28 @@ void THcHitList::InitHitList(THaDetMap* detmap,
   }
   fHaveFADCInfo = kFALSE;
 
-  fNTDCRef_miss = 0;
-  fNADCRef_miss = 0;
+  fRefMissStats.Clear();
+  fTDCRefMissId = fRefMissStats.DefineCounter("", "Missing TDC reference times");
+  fADCRefMissId = fRefMissStats.DefineCounter("", "Missing ADC reference times");
 
   //  DisableSlipCorrection();
 }
 
 /**
 
-\brief Populate the hitlist from the raw event data.
+\brief Fill the hit list from the channels of all modules in the detector map.
 
-Clears the hit list then, finds all populated channels belonging to the detector and add
-sort it into the hitlist.  A given counter in the detector can have
-at most one entry in the hit list.  However, the raw "hit" can contain
-multiple signal types (e.g. ADC+, ADC-, TDC+, TDC-), or multiplehits for multihit tdcs.
-The hit list is sorted (by plane, counter) after filling.
+Called by DecodeToHitList once the reference times of the event are known.
+HitT is the concrete raw hit class for the standard detectors, so that the
+data setters are bound and inlined at compile time.  For any other hit
+class HitT is THcRawHit and the virtual setters are used.
 
 */
-Int_t THcHitList::DecodeToHitList( const THaEvData& evdata, Bool_t suppresswarnings ) {
+template<class HitT>
+void THcHitList::DecodeChannels( const THaEvData& evdata, Int_t titime,
+				 Bool_t suppresswarnings,
+				 Bool_t& tdcref_miss, Bool_t& adcref_miss ) {
 
-  if(!fMap) {			// Find the TI slot for ADCs
-    // Assumes that all FADCs are in the same crate
-    cout << "Got the Crate map" << endl;
-    fMap = evdata.GetCrateMap();
-    for (Int_t i=0; i < fdMap->GetSize(); i++) { // Look for a FADC250
-      THaDetMap::Module* d = fdMap->GetModule(i);
-      Decoder::Fadc250Module* isfadc = dynamic_cast<Decoder::Fadc250Module*>(evdata.GetModule(d->crate, d->slot));
-      if(isfadc) {
-	// Scan this crate to find the TI.
-	for(Int_t slot=0;slot<Decoder::MAXSLOT;slot++) {
-	  if(fMap->getModel(d->crate, slot) == 4) {
-	    fTISlot = slot;
-	    fTICrate = d->crate;
-	    cout << "TI Slot = " << fTISlot << endl;
-	    break;
-	  }
-	}
-	// Now make a map of all the FADCs in this crate
-	if(fTISlot>0) {
-	  for(Int_t slot=0;slot<Decoder::MAXSLOT;slot++) {
-	    Decoder::Fadc250Module* fadc = dynamic_cast<Decoder::Fadc250Module*>
-	      (evdata.GetModule(d->crate, slot));
-	    if(fadc) {
-	      fFADCSlotMap[slot] = fadc;
-	    }
-	  }	    
-	}
-	break;
-      }
-    }
-  }
-  if(fDisableSlipCorrection) fTISlot = -1;
-    
-  Int_t titime = 0;
-  if(fTISlot>0) {
-#define FUDGE 7
-    titime = evdata.GetData(fTICrate, fTISlot, 2, 0)-FUDGE;
-    // Need to get the FADC time for all modules in this crate
-    // that have hits.  Make a map with these times.
-    fTrigTimeShiftMap.clear();
-    //cout << "TI Crate: " << fTICrate << " " << (UInt_t) titime << endl;
-  }
-
-  // cout << " Clearing TClonesArray " << endl;
-  fRawHitList->Clear( );
-  fNRawHits = 0;
-  Bool_t tdcref_miss = kFALSE;
-  Bool_t adcref_miss = kFALSE;
-
-  // Get the indexed reference times for this event
-  for(Int_t i=0;i<fNRefIndex;i++) {
-    if(fRefIndexMaps[i].defined) {
-      
-      if(evdata.IsMultifunction(fRefIndexMaps[i].crate,
-				fRefIndexMaps[i].slot)) { // Multifunction module (e.g. FADC)
-	// Make sure at least one pulse
-	Int_t nrefhits = evdata.GetNumEvents(Decoder::kPulseTime,
-					     fRefIndexMaps[i].crate,
-					     fRefIndexMaps[i].slot,
-					     fRefIndexMaps[i].channel);
-	Int_t timeshift=0;
-	if(fTISlot>0) {		// Get the trigger time for this module
-	  if(fTrigTimeShiftMap.find(fRefIndexMaps[i].slot)
-	     == fTrigTimeShiftMap.end()) { // 
-	    if(fFADCSlotMap.find(fRefIndexMaps[i].slot) != fFADCSlotMap.end()) {
-	      fTrigTimeShiftMap[fRefIndexMaps[i].slot]
-		= fFADCSlotMap[fRefIndexMaps[i].slot]->GetTriggerTime() - titime;
-	    }
-	    timeshift = fTrigTimeShiftMap[fRefIndexMaps[i].slot];
-	  }
-	}
-	fRefIndexMaps[i].hashit = kFALSE;
-	Bool_t goodreftime=kFALSE;
-	Int_t reftime = 0;
-	Int_t prevtime = 0;
-	Int_t difftime = 0;
-	for(Int_t ihit=0; ihit<nrefhits; ihit++) {
-	  reftime = evdata.GetData(Decoder::kPulseTime,fRefIndexMaps[i].crate,
-				   fRefIndexMaps[i].slot, fRefIndexMaps[i].channel,ihit);
-	  reftime += 64*timeshift;
-	  if (ihit != 0) difftime=reftime-prevtime;
-	  prevtime = reftime;
-	  if(reftime >= fADC_RefTimeCut) {
-	    goodreftime = kTRUE;
-	    break;
-	  }
-	}
-	if(goodreftime || (nrefhits>0 && fADC_RefTimeBest)) {
-	  fRefIndexMaps[i].reftime = reftime;
-	  fRefIndexMaps[i].refdifftime = difftime;
-	  fRefIndexMaps[i].hashit = kTRUE;
-	}
-      } else {			// Assume this is a TDC
-	Int_t nrefhits = evdata.GetNumHits(fRefIndexMaps[i].crate,
-					   fRefIndexMaps[i].slot,
-					   fRefIndexMaps[i].channel);
-	fRefIndexMaps[i].hashit = kFALSE;
-	// Only take first hit in this reference channel that is bigger
-	// then fTDC_RefTimeCut
-	Bool_t goodreftime=kFALSE;
-	Int_t reftime = 0;
-	Int_t prevtime = 0;
-	Int_t difftime = 0;
-	for(Int_t ihit=0; ihit<nrefhits; ihit++) {
-	  reftime = evdata.GetData(fRefIndexMaps[i].crate,fRefIndexMaps[i].slot,
-				   fRefIndexMaps[i].channel,ihit);
-	  if( ihit != 0) difftime=reftime-prevtime;
-	    prevtime=reftime;
-	  if(reftime >= fTDC_RefTimeCut) {
-	    goodreftime = kTRUE;
-	    break;
-	  }
-	}
-	if(goodreftime || (nrefhits>0 && fTDC_RefTimeBest)) {
-	    fRefIndexMaps[i].reftime = reftime;
-	    fRefIndexMaps[i].refdifftime = difftime;
-	    fRefIndexMaps[i].hashit = kTRUE;
-	}
-      }
-    }
-  }
   for ( Int_t i=0; i < fdMap->GetSize(); i++ ) {
     THaDetMap::Module* d = fdMap->GetModule(i);
     
@@ -319,8 +233,10 @@ Int_t THcHitList::DecodeToHitList( const THaEvData& evdata, Bool_t suppresswarni
     // Should probably get the Decoder::Module object and use it's
     // methods.  Saving a THaEvData::GetModule call every time
 
-    for ( Int_t j=0; j < evdata.GetNumChan( d->crate, d->slot); j++) {
-      THcRawHit* rawhit=0;
+    Int_t nchan = evdata.GetNumChan( d->crate, d->slot);
+
+    for ( Int_t j=0; j < nchan; j++) {
+      HitT* rawhit=0;
 
       Int_t chan = evdata.GetNextChan( d->crate, d->slot, j );
       if( chan < d->lo || chan > d->hi ) continue;     // Not one of my channels
@@ -334,7 +250,7 @@ Int_t THcHitList::DecodeToHitList( const THaEvData& evdata, Bool_t suppresswarni
       // We could do sorting
       UInt_t thishit = 0;
       while(thishit < fNRawHits) {
-	rawhit = (THcRawHit*) (*fRawHitList)[thishit];
+	rawhit = static_cast<HitT*>((*fRawHitList)[thishit]);
 	if (plane == rawhit->fPlane
 	    && counter == rawhit->fCounter) {
 	  // cout << "Found as " << thishit << "/" << fNRawHits << endl;
@@ -344,10 +260,11 @@ Int_t THcHitList::DecodeToHitList( const THaEvData& evdata, Bool_t suppresswarni
       }
 
       if(thishit == fNRawHits) {
-	rawhit = (THcRawHit*) fRawHitList->ConstructedAt(thishit,"");
+	rawhit = static_cast<HitT*>(fRawHitList->ConstructedAt(thishit,""));
 	fNRawHits++;
 	rawhit->fPlane = plane;
 	rawhit->fCounter = counter;
+	if(fRecordHits) CacheOp(THcHitCache::kHit, 0, plane, counter);
       }
 
       // Get the data from this channel
@@ -357,7 +274,8 @@ Int_t THcHitList::DecodeToHitList( const THaEvData& evdata, Bool_t suppresswarni
 	for (Int_t mhit = 0; mhit < nMHits; mhit++) {
 	  Int_t data = evdata.GetData( d->crate, d->slot, chan, mhit);
 	  // cout << "Signal " << signal << "=" << data << endl;
-	  rawhit->SetData(signal,data);
+	  rawhit->FillData(signal,data);
+	  if(fRecordHits) CacheOp(THcHitCache::kData, signal, plane, counter, 1, data);
 	}
 	// Get the reference time.
 	if(d->refchan >= 0) {
@@ -378,8 +296,9 @@ Int_t THcHitList::DecodeToHitList( const THaEvData& evdata, Bool_t suppresswarni
 	  // If RefTimeBest flag set, take the last hit if none of the
 	  // hits make the RefTimeCut
 	  if(goodreftime || (nrefhits>0 && fTDC_RefTimeBest)) {
-	    rawhit->SetReference(signal, reftime);
-	    rawhit->SetReferenceDiff(signal, difftime);
+	    rawhit->FillReference(signal, reftime, difftime);
+	    if(fRecordHits) CacheOp(THcHitCache::kReference, signal, plane, counter,
+				    2, reftime, difftime);
 	  } else if (!suppresswarnings) {
 	    cout << "HitList(event=" << evdata.GetEvNum() << "): refchan " << d->refchan <<
 	      " missing for (" << d->crate << ", " << d->slot <<
@@ -389,8 +308,11 @@ Int_t THcHitList::DecodeToHitList( const THaEvData& evdata, Bool_t suppresswarni
 	} else {
 	  if(d->refindex >=0 && d->refindex < fNRefIndex) {
 	    if(fRefIndexMaps[d->refindex].hashit) {
-	      rawhit->SetReference(signal, fRefIndexMaps[d->refindex].reftime);
-	      rawhit->SetReferenceDiff(signal, fRefIndexMaps[d->refindex].refdifftime);
+	      rawhit->FillReference(signal, fRefIndexMaps[d->refindex].reftime,
+				    fRefIndexMaps[d->refindex].refdifftime);
+	      if(fRecordHits) CacheOp(THcHitCache::kReference, signal, plane, counter,
+				      2, fRefIndexMaps[d->refindex].reftime,
+				      fRefIndexMaps[d->refindex].refdifftime);
 	    } else {
 	      if(!suppresswarnings) {
 		cout << "HitList(event=" << evdata.GetEvNum() << "): refindex " << d->refindex <<
@@ -414,7 +336,9 @@ Int_t THcHitList::DecodeToHitList( const THaEvData& evdata, Bool_t suppresswarni
 	    fHaveFADCInfo = kTRUE;
 	  }
 	  // Set F250 parameters.
-          rawhit->SetF250Params(fNSA, fNSB, fNPED);
+          rawhit->FillF250Params(fNSA, fNSB, fNPED);
+	  if(fRecordHits) CacheOp(THcHitCache::kF250, 0, plane, counter,
+				  3, fNSA, fNSB, fNPED);
         }
 	
 	// Copy the samples
@@ -423,7 +347,9 @@ Int_t THcHitList::DecodeToHitList( const THaEvData& evdata, Bool_t suppresswarni
 	// If nsamples comes back zero, may want to suppress further attempts to
 	// get sample data for this or all modules
 	for (Int_t isamp=0;isamp<nsamples;isamp++) {
-	  rawhit->SetSample(signal,evdata.GetData(Decoder::kSampleADC, d->crate, d->slot, chan, isamp));
+	  Int_t sample = evdata.GetData(Decoder::kSampleADC, d->crate, d->slot, chan, isamp);
+	  rawhit->FillSample(signal,sample);
+	  if(fRecordHits) CacheOp(THcHitCache::kSample, signal, plane, counter, 1, sample);
 	}
 	// Now get the pulse mode data
 	// Pulse area will go into regular SetData, others will use special hit methods
@@ -441,11 +367,13 @@ Int_t THcHitList::DecodeToHitList( const THaEvData& evdata, Bool_t suppresswarni
 	  timeshift = fTrigTimeShiftMap[d->slot];
 	}
 	for (Int_t ipulse=0;ipulse<npulses;ipulse++) {
-	  rawhit->SetDataTimePedestalPeak(signal,
-					  evdata.GetData(Decoder::kPulseIntegral, d->crate, d->slot, chan, ipulse),
-					  evdata.GetData(Decoder::kPulseTime, d->crate, d->slot, chan, ipulse)+64*timeshift,
-					  evdata.GetData(Decoder::kPulsePedestal, d->crate, d->slot, chan, ipulse),
-					  evdata.GetData(Decoder::kPulsePeak, d->crate, d->slot, chan, ipulse));
+	  Int_t pulseint = evdata.GetData(Decoder::kPulseIntegral, d->crate, d->slot, chan, ipulse);
+	  Int_t pulsetime = evdata.GetData(Decoder::kPulseTime, d->crate, d->slot, chan, ipulse)+64*timeshift;
+	  Int_t pulseped = evdata.GetData(Decoder::kPulsePedestal, d->crate, d->slot, chan, ipulse);
+	  Int_t pulsepeak = evdata.GetData(Decoder::kPulsePeak, d->crate, d->slot, chan, ipulse);
+	  rawhit->FillDataTimePedestalPeak(signal, pulseint, pulsetime, pulseped, pulsepeak);
+	  if(fRecordHits) CacheOp(THcHitCache::kPulse, signal, plane, counter,
+				  4, pulseint, pulsetime, pulseped, pulsepeak);
 	}
 	// Get the reference time for the FADC pulse time
 	if(d->refchan >= 0) {	// Reference time for the slot
@@ -479,8 +407,9 @@ Int_t THcHitList::DecodeToHitList( const THaEvData& evdata, Bool_t suppresswarni
 	  // If RefTimeBest flag set, take the last hit if none of the
 	  // hits make the RefTimeCut
 	  if(goodreftime || (nrefhits>0 && fADC_RefTimeBest)) {
-	    rawhit->SetReference(signal, reftime);
-	    rawhit->SetReferenceDiff(signal, difftime);
+	    rawhit->FillReference(signal, reftime, difftime);
+	    if(fRecordHits) CacheOp(THcHitCache::kReference, signal, plane, counter,
+				    2, reftime, difftime);
 	  } else if (!suppresswarnings) {
 #ifndef SUPPRESSMISSINGADCREFTIMEMESSAGES
 	    cout << "HitList(event=" << evdata.GetEvNum() << "): refchan " << d->refchan <<
@@ -492,8 +421,11 @@ Int_t THcHitList::DecodeToHitList( const THaEvData& evdata, Bool_t suppresswarni
 	} else {
 	  if(d->refindex >=0 && d->refindex < fNRefIndex) {
 	    if(fRefIndexMaps[d->refindex].hashit) {
-	      rawhit->SetReference(signal, fRefIndexMaps[d->refindex].reftime);
-	      rawhit->SetReferenceDiff(signal, fRefIndexMaps[d->refindex].refdifftime);
+	      rawhit->FillReference(signal, fRefIndexMaps[d->refindex].reftime,
+				    fRefIndexMaps[d->refindex].refdifftime);
+	      if(fRecordHits) CacheOp(THcHitCache::kReference, signal, plane, counter,
+				      2, fRefIndexMaps[d->refindex].reftime,
+				      fRefIndexMaps[d->refindex].refdifftime);
 	    } else {
 	      if(!suppresswarnings) {
 #ifndef SUPPRESSMISSINGADCREFTIMEMESSAGES
@@ -512,6 +444,191 @@ Int_t THcHitList::DecodeToHitList( const THaEvData& evdata, Bool_t suppresswarni
       }
     }
   }
+}
+
+//_____________________________________________________________________________
+void THcHitList::AccountMemory(THcMemoryReport& report) const
+{
+  // The raw hits constructed by InitHitList, with their sample buffers,
+  // are static; slots added beyond fNMaxRawHits are dynamic.
+  if(!fRawHitList) return;	// InitHitList not called
+  Long64_t bytes = THcMemoryReport::Bytes(fRawHitList);
+  Long64_t nslots = fRawHitList->GetSize();
+  Long64_t fixed = (nslots > 0) ? bytes*TMath::Min(nslots,(Long64_t)fNMaxRawHits)/nslots : 0;
+  report.Add("raw hits", fixed, THcMemoryReport::kStatic);
+  report.Add("raw hits", bytes-fixed, THcMemoryReport::kDynamic);
+  report.Add("reference channels", THcMemoryReport::Bytes(fRefIndexMaps)
+	     + fNSignals*sizeof(THcRawHit::ESignalType), THcMemoryReport::kStatic);
+  report.Add("hit cache", THcMemoryReport::Bytes(fHitCacheOps), THcMemoryReport::kDynamic);
+}
+
+/**
+
+\brief Populate the hitlist from the raw event data.
+
+Clears the hit list then, finds all populated channels belonging to the detector and add
+sort it into the hitlist.  A given counter in the detector can have
+at most one entry in the hit list.  However, the raw "hit" can contain
+multiple signal types (e.g. ADC+, ADC-, TDC+, TDC-), or multiplehits for multihit tdcs.
+The hit list is sorted (by plane, counter) after filling.
+
+*/
+Int_t THcHitList::DecodeToHitList( const THaEvData& evdata, Bool_t suppresswarnings ) {
+
+  if(fHitCache != gHcHitCache) AttachHitCache();
+  if(fHitCacheId >= 0 && fHitCache->IsReading()) {
+    const vector<Int_t>* ops = fHitCache->Fetch(fHitCacheId, evdata.GetEvNum());
+    if(ops) return ReplayHitList(*ops);
+  }
+
+  if(!fMap) {			// Find the TI slot for ADCs
+    // Assumes that all FADCs are in the same crate
+    cout << "Got the Crate map" << endl;
+    fMap = evdata.GetCrateMap();
+    for (Int_t i=0; i < fdMap->GetSize(); i++) { // Look for a FADC250
+      THaDetMap::Module* d = fdMap->GetModule(i);
+      Decoder::Fadc250Module* isfadc = dynamic_cast<Decoder::Fadc250Module*>(evdata.GetModule(d->crate, d->slot));
+      if(isfadc) {
+	// Scan this crate to find the TI.
+	for(Int_t slot=0;slot<Decoder::MAXSLOT;slot++) {
+	  if(fMap->getModel(d->crate, slot) == 4) {
+	    fTISlot = slot;
+	    fTICrate = d->crate;
+	    cout << "TI Slot = " << fTISlot << endl;
+	    break;
+	  }
+	}
+	// Now make a map of all the FADCs in this crate
+	if(fTISlot>0) {
+	  for(Int_t slot=0;slot<Decoder::MAXSLOT;slot++) {
+	    Decoder::Fadc250Module* fadc = dynamic_cast<Decoder::Fadc250Module*>
+	      (evdata.GetModule(d->crate, slot));
+	    if(fadc) {
+	      fFADCSlotMap[slot] = fadc;
+	    }
+	  }	    
+	}
+	break;
+      }
+    }
+  }
+  if(fDisableSlipCorrection) fTISlot = -1;
+    
+  Int_t titime = 0;
+  if(fTISlot>0) {
+#define FUDGE 7
+    titime = evdata.GetData(fTICrate, fTISlot, 2, 0)-FUDGE;
+    // Need to get the FADC time for all modules in this crate
+    // that have hits.  Make a map with these times.
+    fTrigTimeShiftMap.clear();
+    //cout << "TI Crate: " << fTICrate << " " << (UInt_t) titime << endl;
+  }
+
+  // cout << " Clearing TClonesArray " << endl;
+  fRawHitList->Clear( );
+  fNRawHits = 0;
+  Bool_t tdcref_miss = kFALSE;
+  Bool_t adcref_miss = kFALSE;
+
+  // Get the indexed reference times for this event
+  for(Int_t i=0;i<fNRefIndex;i++) {
+    if(fRefIndexMaps[i].defined) {
+      
+      if(evdata.IsMultifunction(fRefIndexMaps[i].crate,
+				fRefIndexMaps[i].slot)) { // Multifunction module (e.g. FADC)
+	// Make sure at least one pulse
+	Int_t nrefhits = evdata.GetNumEvents(Decoder::kPulseTime,
+					     fRefIndexMaps[i].crate,
+					     fRefIndexMaps[i].slot,
+					     fRefIndexMaps[i].channel);
+	Int_t timeshift=0;
+	if(fTISlot>0) {		// Get the trigger time for this module
+	  if(fTrigTimeShiftMap.find(fRefIndexMaps[i].slot)
+	     == fTrigTimeShiftMap.end()) { // 
+	    if(fFADCSlotMap.find(fRefIndexMaps[i].slot) != fFADCSlotMap.end()) {
+	      fTrigTimeShiftMap[fRefIndexMaps[i].slot]
+		= fFADCSlotMap[fRefIndexMaps[i].slot]->GetTriggerTime() - titime;
+	    }
+	    timeshift = fTrigTimeShiftMap[fRefIndexMaps[i].slot];
+	  }
+	}
+	fRefIndexMaps[i].hashit = kFALSE;
+	Bool_t goodreftime=kFALSE;
+	Int_t reftime = 0;
+	Int_t prevtime = 0;
+	Int_t difftime = 0;
+	for(Int_t ihit=0; ihit<nrefhits; ihit++) {
+	  reftime = evdata.GetData(Decoder::kPulseTime,fRefIndexMaps[i].crate,
+				   fRefIndexMaps[i].slot, fRefIndexMaps[i].channel,ihit);
+	  reftime += 64*timeshift;
+	  if (ihit != 0) difftime=reftime-prevtime;
+	  prevtime = reftime;
+	  if(reftime >= fADC_RefTimeCut) {
+	    goodreftime = kTRUE;
+	    break;
+	  }
+	}
+	if(goodreftime || (nrefhits>0 && fADC_RefTimeBest)) {
+	  fRefIndexMaps[i].reftime = reftime;
+	  fRefIndexMaps[i].refdifftime = difftime;
+	  fRefIndexMaps[i].hashit = kTRUE;
+	}
+      } else {			// Assume this is a TDC
+	Int_t nrefhits = evdata.GetNumHits(fRefIndexMaps[i].crate,
+					   fRefIndexMaps[i].slot,
+					   fRefIndexMaps[i].channel);
+	fRefIndexMaps[i].hashit = kFALSE;
+	// Only take first hit in this reference channel that is bigger
+	// then fTDC_RefTimeCut
+	Bool_t goodreftime=kFALSE;
+	Int_t reftime = 0;
+	Int_t prevtime = 0;
+	Int_t difftime = 0;
+	for(Int_t ihit=0; ihit<nrefhits; ihit++) {
+	  reftime = evdata.GetData(fRefIndexMaps[i].crate,fRefIndexMaps[i].slot,
+				   fRefIndexMaps[i].channel,ihit);
+	  if( ihit != 0) difftime=reftime-prevtime;
+	    prevtime=reftime;
+	  if(reftime >= fTDC_RefTimeCut) {
+	    goodreftime = kTRUE;
+	    break;
+	  }
+	}
+	if(goodreftime || (nrefhits>0 && fTDC_RefTimeBest)) {
+	    fRefIndexMaps[i].reftime = reftime;
+	    fRefIndexMaps[i].refdifftime = difftime;
+	    fRefIndexMaps[i].hashit = kTRUE;
+	}
+      }
+    }
+  }
+  fRecordHits = (fHitCacheId >= 0 && fHitCache->IsWriting());
+  if(fRecordHits) {
+    fHitCacheOps.clear();
+    fHitCacheOps.push_back(0);	// Reference time miss flags, set below
+  }
+  switch(fGenericDecode ? kGenericHit : fHitLayout) {
+  case kHodoHit:
+    DecodeChannels<THcRawHodoHit>(evdata, titime, suppresswarnings,
+				  tdcref_miss, adcref_miss);
+    break;
+  case kShowerHit:
+    DecodeChannels<THcRawShowerHit>(evdata, titime, suppresswarnings,
+				    tdcref_miss, adcref_miss);
+    break;
+  case kDCHit:
+    DecodeChannels<THcRawDCHit>(evdata, titime, suppresswarnings,
+				tdcref_miss, adcref_miss);
+    break;
+  case kTrigHit:
+    DecodeChannels<THcTrigRawHit>(evdata, titime, suppresswarnings,
+				  tdcref_miss, adcref_miss);
+    break;
+  default:
+    DecodeChannels<THcRawHit>(evdata, titime, suppresswarnings,
+			      tdcref_miss, adcref_miss);
+    break;
+  }
 #if 1
   if(fTISlot>0) {
     //    cout << "TI ROC: " << fTICrate << "   TI Time: " << titime << endl;
@@ -526,10 +643,100 @@ Int_t THcHitList::DecodeToHitList( const THaEvData& evdata, Bool_t suppresswarni
 #endif    
   fRawHitList->Sort(fNRawHits);
 
-  fNTDCRef_miss += (tdcref_miss ? 1 : 0);
-  fNADCRef_miss += (adcref_miss ? 1 : 0);
+  if(tdcref_miss) fRefMissStats.Increment(fTDCRefMissId);
+  if(adcref_miss) fRefMissStats.Increment(fADCRefMissId);
+  if(fRecordHits) {
+    fHitCacheOps[0] = (tdcref_miss ? 1 : 0) | (adcref_miss ? 2 : 0);
+    fHitCache->Store(fHitCacheId, evdata.GetEvNum(), fHitCacheOps);
+  }
   return fNRawHits;		// Does anything care what is returned
 }
+
+//_____________________________________________________________________________
+void THcHitList::AttachHitCache()
+{
+  // Look up this detector's stream when gHcHitCache is set or replaced
+  fHitCache = gHcHitCache;
+  fHitCacheId = -1;
+  if(!fHitCache || !fHitCache->IsOpen()) return;
+  THaAnalysisObject* obj = dynamic_cast<THaAnalysisObject*>(this);
+  if(!obj) return;
+  fHitCacheId = fHitCache->Register(obj->GetPrefix());
+}
+
+/**
+
+\brief Fill the hit list from ops saved in the decoded hit cache.
+
+Repeats the raw hit setter calls recorded by DecodeToHitList when the
+cache was written, through the virtual setters so that any hit class
+works.  The result is the same hit list, without looking at the raw data.
+
+*/
+Int_t THcHitList::ReplayHitList(const vector<Int_t>& ops) {
+
+  fRawHitList->Clear( );
+  fNRawHits = 0;
+  if(ops.empty()) return 0;
+
+  UInt_t iop = 1;
+  while(iop+3 <= ops.size()) {
+    Int_t op = ops[iop] & 0xf;
+    UInt_t nargs = (ops[iop]>>4) & 0xf;
+    Int_t signal = ops[iop]>>8;
+    Int_t plane = ops[iop+1];
+    Int_t counter = ops[iop+2];
+    const Int_t* args = &ops[iop+3];
+    if(iop+3+nargs > ops.size()) {
+      Error("THcHitList::ReplayHitList", "Truncated hit cache entry");
+      break;
+    }
+    iop += 3+nargs;
+
+    THcRawHit* rawhit=0;
+    UInt_t thishit = 0;
+    while(thishit < fNRawHits) {
+      rawhit = static_cast<THcRawHit*>((*fRawHitList)[thishit]);
+      if (plane == rawhit->fPlane
+	  && counter == rawhit->fCounter) {
+	break;
+      }
+      thishit++;
+    }
+    if(thishit == fNRawHits) {
+      rawhit = static_cast<THcRawHit*>(fRawHitList->ConstructedAt(thishit,""));
+      fNRawHits++;
+      rawhit->fPlane = plane;
+      rawhit->fCounter = counter;
+    }
+
+    switch(op) {
+    case THcHitCache::kData:
+      rawhit->SetData(signal, args[0]);
+      break;
+    case THcHitCache::kSample:
+      rawhit->SetSample(signal, args[0]);
+      break;
+    case THcHitCache::kPulse:
+      rawhit->SetDataTimePedestalPeak(signal, args[0], args[1], args[2], args[3]);
+      break;
+    case THcHitCache::kReference:
+      rawhit->SetReference(signal, args[0]);
+      rawhit->SetReferenceDiff(signal, args[1]);
+      break;
+    case THcHitCache::kF250:
+      rawhit->SetF250Params(args[0], args[1], args[2]);
+      break;
+    default:			// kHit, only creates the hit
+      break;
+    }
+  }
+  fRawHitList->Sort(fNRawHits);
+
+  if(ops[0] & 1) fRefMissStats.Increment(fTDCRefMissId);
+  if(ops[0] & 2) fRefMissStats.Increment(fADCRefMissId);
+  return fNRawHits;
+}
 void THcHitList::CreateMissReportParms(const char *prefix)
 {
   /**
@@ -540,12 +747,13 @@ Parameters created are ${prefix}_tdcref_miss and ${prefix}_adcref_miss
 
   */
   cout << "Defining " << Form("%s_tdcref_miss", prefix) << " and " << Form("%s_adcref_miss", prefix) << endl;
-  gHcParms->Define(Form("%s_tdcref_miss", prefix), "Missing TDC reference times", fNTDCRef_miss);
-  gHcParms->Define(Form("%s_adcref_miss", prefix), "Missing ADC reference times", fNADCRef_miss);
+  fRefMissStats.Publish(fTDCRefMissId, Form("%s_tdcref_miss", prefix), "Missing TDC reference times");
+  fRefMissStats.Publish(fADCRefMissId, Form("%s_adcref_miss", prefix), "Missing ADC reference times");
 }
 void THcHitList::MissReport(const char *name)
 {
-  cout << "Missing Ref times:" << setw(20) << name << setw(10) << fNTDCRef_miss << setw(10) << fNADCRef_miss << endl;
+  fRefMissStats.Merge();
+  cout << "Missing Ref times:" << setw(20) << name << setw(10) << fRefMissStats.GetValue(fTDCRefMissId) << setw(10) << fRefMissStats.GetValue(fADCRefMissId) << endl;
 }
 
 ClassImp(THcHitList)
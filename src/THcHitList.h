@@ -2,6 +2,9 @@
 #define ROOT_THcHitList
 
 #include "THcRawHit.h"
+#include "THcRunStats.h"
+#include "THcHitCache.h"
+#include "THcMemoryAccount.h"
 #include "THaDetMap.h"
 #include "THaEvData.h"
 #include "TClonesArray.h"
@@ -24,7 +27,7 @@ using namespace std;
 //class THaDetMap;
 class THcConfigEvtHandler;
 
-class THcHitList {
+class THcHitList : public THcMemoryAccount {
 
 public:
 
@@ -41,6 +44,8 @@ public:
   void          CreateMissReportParms(const char *prefix);
   void          MissReport(const char *name);
   void          DisableSlipCorrection() {fDisableSlipCorrection = kTRUE;}
+  void          SetGenericDecode(Bool_t generic=kTRUE) {fGenericDecode = generic;}
+  virtual void  AccountMemory(THcMemoryReport& report) const;
 
   UInt_t         fNRawHits;
   Int_t         fNMaxRawHits;
@@ -55,6 +60,32 @@ public:
 
 protected:
 
+  // Raw hit classes with a decoding specialized in DecodeChannels
+  enum EHitLayout { kGenericHit, kHodoHit, kShowerHit, kDCHit, kTrigHit };
+  EHitLayout fHitLayout;
+  Bool_t fGenericDecode;	// Always use the virtual raw hit setters
+
+  template<class HitT>
+  void DecodeChannels(const THaEvData& evdata, Int_t titime,
+		      Bool_t suppresswarnings,
+		      Bool_t& tdcref_miss, Bool_t& adcref_miss);
+
+  // Decoded hit cache (gHcHitCache)
+  void  AttachHitCache();
+  Int_t ReplayHitList(const std::vector<Int_t>& ops);
+  void  CacheOp(Int_t op, Int_t signal, Int_t plane, Int_t counter,
+		Int_t nargs=0, Int_t a0=0, Int_t a1=0, Int_t a2=0, Int_t a3=0) {
+    Int_t args[4] = {a0, a1, a2, a3};
+    fHitCacheOps.push_back(THcHitCache::OpWord(op, nargs, signal));
+    fHitCacheOps.push_back(plane);
+    fHitCacheOps.push_back(counter);
+    fHitCacheOps.insert(fHitCacheOps.end(), args, args+nargs);
+  }
+  THcHitCache* fHitCache;	// gHcHitCache when last attached
+  Int_t  fHitCacheId;		// Stream of this detector, -1 if none
+  Bool_t fRecordHits;		// Record the setter calls of this event
+  std::vector<Int_t> fHitCacheOps;
+
   struct RefIndexMap { // Mapping for one reference channel
     Bool_t defined;
     Bool_t hashit;
@@ -78,8 +109,9 @@ protected:
   Int_t fNSB;
   Int_t fNPED;
 
-  Int_t fNTDCRef_miss;
-  Int_t fNADCRef_miss;
+  THcRunStats fRefMissStats;	// Events with missing reference times
+  Int_t fTDCRefMissId;
+  Int_t fADCRefMissId;
 
   Decoder::THaCrateMap* fMap;	/* The Crate map */
   Int_t fTISlot;
@@ -26,7 +26,9 @@ using namespace std;
 //_____________________________________________________________________________
 THcHodoEff::THcHodoEff (const char *name, const char* description,
 			const char* hodname) :
-  THaPhysicsModule(name, description), fName(hodname), fHod(NULL), fNevt(0)
+  THaPhysicsModule(name, description), fName(hodname), fHod(NULL), fNevt(0),
+  fPlanes(0), fPosZ(0), fSpacing(0), fCenterFirst(0), fNCounters(0),
+  fStatTrkSum(0), fStatAndSum(0), fStatAndEff(0), fHodoSlop(0), fHitPlane(0)
 {
 
 }
@@ -46,12 +48,6 @@ THcHodoEff::~THcHodoEff()
   delete [] fStatAndSum; fStatAndSum = 0;
   delete [] fStatAndEff; fStatAndEff = 0;
 
-  delete [] fHodoPosEffi; fHodoPosEffi = 0;
-  delete [] fHodoNegEffi; fHodoNegEffi = 0;
-  delete [] fHodoOrEffi; fHodoOrEffi = 0;
-  delete [] fHodoAndEffi; fHodoAndEffi = 0;
-  delete [] fStatTrk; fStatTrk = 0;
-
   delete [] fHitPlane; fHitPlane = 0;
 
   RemoveVariables();
@@ -76,16 +72,16 @@ Int_t THcHodoEff::Begin( THaRunBase* )
   fNevt = 0;
 
   // Clear all the accumulators here
+  fStats.Reset(fStatPosHitId);
+  fStats.Reset(fStatNegHitId);
+  fStats.Reset(fStatAndHitId);
+  fStats.Reset(fStatOrHitId);
+  fStats.Reset(fBothGoodId);
+  fStats.Reset(fPosGoodId);
+  fStats.Reset(fNegGoodId);
   for(Int_t ip=0;ip<fNPlanes;ip++) {
     fHitPlane[ip] = 0;
     for(Int_t ic=0;ic<fNCounters[ip];ic++) {
-      fStatPosHit[ip][ic] = 0;
-      fStatNegHit[ip][ic] = 0;
-      fStatAndHit[ip][ic] = 0;
-      fStatOrHit[ip][ic] = 0;
-      fBothGood[ip][ic] = 0;
-      fPosGood[ip][ic] = 0;
-      fNegGood[ip][ic] = 0;
       for(Int_t idel=0;idel<20;idel++) {
 	fStatTrkDel[ip][ic][idel] = 0;
 	fStatAndHitDel[ip][ic][idel] = 0;
@@ -100,11 +96,12 @@ Int_t THcHodoEff::Begin( THaRunBase* )
 Int_t THcHodoEff::End( THaRunBase* )
 {
   // End of analysis
+  fStats.Merge();
   for(Int_t ip=0;ip<fNPlanes;ip++) {
     fStatAndEff[ip]=0;
     for(Int_t ic=0;ic<fNCounters[ip];ic++) {
-      fStatTrkSum[ip]+=fStatTrk[fHod->GetScinIndex(ip,ic)];
-      fStatAndSum[ip]+=fHodoAndEffi[fHod->GetScinIndex(ip,ic)];
+      fStatTrkSum[ip]+=fStats.GetValue(fStatTrkId,fHod->GetScinIndex(ip,ic));
+      fStatAndSum[ip]+=fStats.GetValue(fHodoAndEffiId,fHod->GetScinIndex(ip,ic));
     }
     if (fStatTrkSum[ip] !=0) fStatAndEff[ip]=float(fStatAndSum[ip])/float(fStatTrkSum[ip]);
   }
@@ -161,15 +158,16 @@ Int_t THcHodoEff::ReadDatabase( const TDatime& date )
   // Get # of planes and their z positions here.
 
   fNPlanes = fHod->GetNPlanes();
-  fPlanes = new THcScintillatorPlane* [fNPlanes];
-  fPosZ = new Double_t[fNPlanes];
-  fSpacing = new Double_t[fNPlanes];
-  fCenterFirst = new Double_t[fNPlanes];
-  fNCounters = new Int_t[fNPlanes];
-  fHodoSlop = new Double_t[fNPlanes];
-  fStatTrkSum = new Int_t[fNPlanes];
-  fStatAndSum = new Int_t[fNPlanes];
-  fStatAndEff = new Double_t[fNPlanes];
+  // Called again for each run of a THcBatchReplay
+  delete [] fPlanes;  fPlanes = new THcScintillatorPlane* [fNPlanes];
+  delete [] fPosZ;  fPosZ = new Double_t[fNPlanes];
+  delete [] fSpacing;  fSpacing = new Double_t[fNPlanes];
+  delete [] fCenterFirst;  fCenterFirst = new Double_t[fNPlanes];
+  delete [] fNCounters;  fNCounters = new Int_t[fNPlanes];
+  delete [] fHodoSlop;  fHodoSlop = new Double_t[fNPlanes];
+  delete [] fStatTrkSum;  fStatTrkSum = new Int_t[fNPlanes];
+  delete [] fStatAndSum;  fStatAndSum = new Int_t[fNPlanes];
+  delete [] fStatAndEff;  fStatAndEff = new Double_t[fNPlanes];
 
   Int_t maxcountersperplane=0;
   for(Int_t ip=0;ip<fNPlanes;ip++) {
@@ -184,11 +182,6 @@ Int_t THcHodoEff::ReadDatabase( const TDatime& date )
     maxcountersperplane = TMath::Max(maxcountersperplane,fNCounters[ip]);
   }
   Int_t totalpaddles = fNPlanes*maxcountersperplane;
-  fHodoPosEffi = new Int_t[totalpaddles];
-  fHodoNegEffi = new Int_t[totalpaddles];
-  fHodoOrEffi = new Int_t[totalpaddles];
-  fHodoAndEffi = new Int_t[totalpaddles];
-  fStatTrk = new Int_t[totalpaddles];
 
   char prefix[2];
   prefix[0] = tolower((fHod->GetApparatus())->GetName()[0]);
@@ -207,16 +200,9 @@ Int_t THcHodoEff::ReadDatabase( const TDatime& date )
   // Setup statistics arrays
   // Better method to put this in?
   // These all need to be cleared in Begin
-  fHitPlane = new Int_t[fNPlanes];
+  delete [] fHitPlane;  fHitPlane = new Int_t[fNPlanes];
   fStatTrkDel.resize(fNPlanes);
   fStatAndHitDel.resize(fNPlanes);
-  fStatPosHit.resize(fNPlanes);
-  fStatNegHit.resize(fNPlanes);
-  fStatAndHit.resize(fNPlanes);
-  fStatOrHit.resize(fNPlanes);
-  fBothGood.resize(fNPlanes);
-  fPosGood.resize(fNPlanes);
-  fNegGood.resize(fNPlanes);
 
   for(Int_t ip=0;ip<fNPlanes;ip++) {
 
@@ -224,22 +210,9 @@ Int_t THcHodoEff::ReadDatabase( const TDatime& date )
 
     fStatTrkDel[ip].resize(fNCounters[ip]);
     fStatAndHitDel[ip].resize(fNCounters[ip]);
-    fStatPosHit[ip].resize(fNCounters[ip]);
-    fStatNegHit[ip].resize(fNCounters[ip]);
-    fStatAndHit[ip].resize(fNCounters[ip]);
-    fStatOrHit[ip].resize(fNCounters[ip]);
-    fBothGood[ip].resize(fNCounters[ip]);
-    fPosGood[ip].resize(fNCounters[ip]);
-    fNegGood[ip].resize(fNCounters[ip]);
     for(Int_t ic=0;ic<fNCounters[ip];ic++) {
       fStatTrkDel[ip][ic].resize(20); // Max this settable
       fStatAndHitDel[ip][ic].resize(20); // Max this settable
-      
-      fHodoPosEffi[fHod->GetScinIndex(ip,ic)] = 0;
-      fHodoNegEffi[fHod->GetScinIndex(ip,ic)] = 0;
-      fHodoOrEffi[fHod->GetScinIndex(ip,ic)] = 0;
-      fHodoAndEffi[fHod->GetScinIndex(ip,ic)] = 0;
-      fStatTrk[fHod->GetScinIndex(ip,ic)] = 0;
     }
   }
 
@@ -247,12 +220,26 @@ Int_t THcHodoEff::ReadDatabase( const TDatime& date )
   // gHcParms->Define(Form("%shodo_pos_hits[%d][%d]",fPrefix,fNPlanes,fHodPaddles),
   // 		        "Golden track's pos pmt hit",*&fStatPosHit);
 
-  gHcParms->Define(Form("%shodo_pos_eff[%d]",  prefix,totalpaddles), "Hodo positive effi",*fHodoPosEffi);
-  gHcParms->Define(Form("%shodo_neg_eff[%d]",  prefix,totalpaddles), "Hodo negative effi",*fHodoNegEffi);
-  gHcParms->Define(Form("%shodo_or_eff[%d]",   prefix,totalpaddles), "Hodo or effi",      *fHodoOrEffi);
-  gHcParms->Define(Form("%shodo_and_eff[%d]",  prefix,totalpaddles), "Hodo and effi",     *fHodoAndEffi);
+  fStats.Clear();
+  fHodoPosEffiId = fStats.DefineCounter(Form("%shodo_pos_eff",  prefix), "Hodo positive effi",totalpaddles);
+  fHodoNegEffiId = fStats.DefineCounter(Form("%shodo_neg_eff",  prefix), "Hodo negative effi",totalpaddles);
+  fHodoOrEffiId = fStats.DefineCounter(Form("%shodo_or_eff",   prefix), "Hodo or effi",      totalpaddles);
+  fHodoAndEffiId = fStats.DefineCounter(Form("%shodo_and_eff",  prefix), "Hodo and effi",     totalpaddles);
+  // The plane array is new, so a parameter of an earlier Init would
+  // point to the freed one
+  gHcParms->RemoveName(Form("%shodo_plane_AND_eff",prefix));
   gHcParms->Define(Form("%shodo_plane_AND_eff[%d]",prefix,fNPlanes), "Hodo plane AND eff",  *fStatAndEff);
-  gHcParms->Define(Form("%shodo_gold_hits[%d]",prefix,totalpaddles), "Hodo golden hits",  *fStatTrk);
+  fStatTrkId = fStats.DefineCounter(Form("%shodo_gold_hits",prefix), "Hodo golden hits",  totalpaddles);
+  fStatPosHitId = fStats.DefineCounter("", "Golden track's pos pmt hit", totalpaddles);
+  fStatNegHitId = fStats.DefineCounter("", "Golden track's neg pmt hit", totalpaddles);
+  fStatAndHitId = fStats.DefineCounter("", "Golden track's both pmts hit", totalpaddles);
+  fStatOrHitId = fStats.DefineCounter("", "Golden track's either pmt hit", totalpaddles);
+  fBothGoodId = fStats.DefineCounter("", "Both pmts good", totalpaddles);
+  fNegGoodId = fStats.DefineCounter("", "Only neg pmt good", totalpaddles);
+  fPosGoodId = fStats.DefineCounter("", "Only pos pmt good", totalpaddles);
+  const char* const effnames[] = { "s1XY", "s2XY", "stof", "3_of_4", "4_of_4", 0 };
+  for(const char* const* n = effnames; *n; n++)
+    gHcParms->RemoveName(Form("%shodo_%s_eff",prefix,*n));
   gHcParms->Define(Form("%shodo_s1XY_eff",prefix), "Efficiency for S1XY",fHodoEff_s1);
   gHcParms->Define(Form("%shodo_s2XY_eff",prefix), "Efficiency for S2XY",fHodoEff_s2);
   gHcParms->Define(Form("%shodo_stof_eff",prefix), "Efficiency for STOF",fHodoEff_tof);
@@ -344,20 +331,9 @@ Int_t THcHodoEff::Process( const THaEvData& evdata )
     Int_t hitcounter=hitCounter[ip];
     // goodTdcBothSides[ip] = kFALSE;
     // goodTdcOneSide[ip] = kFALSE;
-    checkHit[ip] = 2;
-    Int_t nphits=fPlanes[ip]->GetNScinHits();
-    TClonesArray* hodoHits = fPlanes[ip]->GetHits();
-    for(Int_t ihit=0;ihit<nphits;ihit++) {
-      THcHodoHit* hit=(THcHodoHit*) hodoHits->At(ihit);
-      Int_t counter = hit->GetPaddleNumber();
-      if(counter == hitcounter) {
-	checkHit[ip] = 0;
-      } else {
-	if(TMath::Abs(counter-hitcounter) == 1 && checkHit[ip] != 0) {
-	  checkHit[ip] = 1;
-	}
-      }
-    }
+    // 0 if the paddle on the track fired, 1 if only a neighbour did
+    Int_t d = fHod->GetPaddleDistance(ip, hitcounter-1);
+    checkHit[ip] = (d == 0 || d == 1) ? d : 2;
   }
 
   // Record position differences between track and center of scin
@@ -369,7 +345,7 @@ Int_t THcHodoEff::Process( const THaEvData& evdata )
        theTrack->GetChi2()/theTrack->GetNDoF() <= fMaxChisq &&
        theTrack->GetEnergy() >= fHodoEff_CalEnergy_Cut )
       {
-	fStatTrk[fHod->GetScinIndex(ip,hitCounter[ip]-1)]++;
+	fStats.Increment(fStatTrkId, fHod->GetScinIndex(ip,hitCounter[ip]-1));
 	// Double_t delta = theTrack->GetDp();
 	// Int_t idel = TMath::Floor(delta+10.0);
 	// Should
@@ -395,33 +371,32 @@ Int_t THcHodoEff::Process( const THaEvData& evdata )
     if (hitcounter<0) hitcounter=0;    
     Double_t dist = hitDistance[ip];
     Int_t nphits=fPlanes[ip]->GetNScinHits();
-    TClonesArray* hodoHits = fPlanes[ip]->GetHits();
-    for(Int_t ihit=0;ihit<nphits;ihit++) {
-      THcHodoHit* hit=(THcHodoHit*) hodoHits->At(ihit);
-      Int_t counter = hit->GetPaddleNumber();
-      // Finds first best hit
-      Bool_t onTrack, goodScinTime, goodTdcNeg, goodTdcPos;
-      fHod->GetFlags(trackIndex,ip,ihit,
-		     onTrack, goodScinTime, goodTdcNeg, goodTdcPos);
-      if(TMath::Abs(dist) <= fStatSlop &&
-	 TMath::Abs(hitcounter-counter) <= checkHit[ip] &&
-	 fHitPlane[ip] == 0 &&
-	 theTrack->GetChi2()/theTrack->GetNDoF() <= fMaxChisq &&
-	 theTrack->GetEnergy() >= fHodoEff_CalEnergy_Cut) {
+    // Finds first best hit: the lowest fired paddle within checkHit of
+    // the track, and its hit from the hodoscope's paddle table
+    if(TMath::Abs(dist) <= fStatSlop &&
+       theTrack->GetChi2()/theTrack->GetNDoF() <= fMaxChisq &&
+       theTrack->GetEnergy() >= fHodoEff_CalEnergy_Cut) {
+      Int_t ipad = fHod->GetFirstHitPaddle(ip, hitcounter-1-checkHit[ip],
+					   hitcounter-1+checkHit[ip]);
+      if(ipad >= 0) {
+	Int_t ihit = fHod->GetPaddleHitIndex(ip, ipad);
+	Bool_t onTrack, goodScinTime, goodTdcNeg, goodTdcPos;
+	fHod->GetFlags(trackIndex,ip,ihit,
+		       onTrack, goodScinTime, goodTdcNeg, goodTdcPos);
 	fHitPlane[ip]++;
 
 	// Need to find out hgood_tdc_pos(igoldentrack,ihit) and neg
 	if(goodTdcPos) {
 	  if(goodTdcNeg) {	// Both fired
-	    fStatPosHit[ip][hitcounter]++;
-	    fStatNegHit[ip][hitcounter]++;
-	    fStatAndHit[ip][hitcounter]++;
-	    fStatOrHit[ip][hitcounter]++;
+	    fStats.Increment(fStatPosHitId, fHod->GetScinIndex(ip,hitcounter));
+	    fStats.Increment(fStatNegHitId, fHod->GetScinIndex(ip,hitcounter));
+	    fStats.Increment(fStatAndHitId, fHod->GetScinIndex(ip,hitcounter));
+	    fStats.Increment(fStatOrHitId, fHod->GetScinIndex(ip,hitcounter));
 
-	    fHodoPosEffi[fHod->GetScinIndex(ip,hitCounter[ip]-1)]++;
-	    fHodoNegEffi[fHod->GetScinIndex(ip,hitCounter[ip]-1)]++;
-	    fHodoAndEffi[fHod->GetScinIndex(ip,hitCounter[ip]-1)]++;
-	    fHodoOrEffi[fHod->GetScinIndex(ip,hitCounter[ip]-1)]++;
+	    fStats.Increment(fHodoPosEffiId, fHod->GetScinIndex(ip,hitCounter[ip]-1));
+	    fStats.Increment(fHodoNegEffiId, fHod->GetScinIndex(ip,hitCounter[ip]-1));
+	    fStats.Increment(fHodoAndEffiId, fHod->GetScinIndex(ip,hitCounter[ip]-1));
+	    fStats.Increment(fHodoOrEffiId, fHod->GetScinIndex(ip,hitCounter[ip]-1));
 
 	    // Double_t delta = theTrack->GetDp();
 	    // Int_t idel = TMath::Floor(delta+10.0);
@@ -429,16 +404,16 @@ Int_t THcHodoEff::Process( const THaEvData& evdata )
 	    //   fStatAndHitDel[ip][hitcounter][idel]++;
 	    // }
 	  } else {
-	    fStatPosHit[ip][hitcounter]++;
-	    fStatOrHit[ip][hitcounter]++;
-	    fHodoPosEffi[fHod->GetScinIndex(ip,hitCounter[ip]-1)]++;
-	    fHodoOrEffi[fHod->GetScinIndex(ip,hitCounter[ip]-1)]++;
+	    fStats.Increment(fStatPosHitId, fHod->GetScinIndex(ip,hitcounter));
+	    fStats.Increment(fStatOrHitId, fHod->GetScinIndex(ip,hitcounter));
+	    fStats.Increment(fHodoPosEffiId, fHod->GetScinIndex(ip,hitCounter[ip]-1));
+	    fStats.Increment(fHodoOrEffiId, fHod->GetScinIndex(ip,hitCounter[ip]-1));
 	  }
 	} else if (goodTdcNeg) {
-	  fStatNegHit[ip][hitcounter]++;
-	  fStatOrHit[ip][hitcounter]++;
-	  fHodoNegEffi[fHod->GetScinIndex(ip,hitCounter[ip]-1)]++;
-	  fHodoOrEffi[fHod->GetScinIndex(ip,hitCounter[ip]-1)]++;
+	  fStats.Increment(fStatNegHitId, fHod->GetScinIndex(ip,hitcounter));
+	  fStats.Increment(fStatOrHitId, fHod->GetScinIndex(ip,hitcounter));
+	  fStats.Increment(fHodoNegEffiId, fHod->GetScinIndex(ip,hitCounter[ip]-1));
+	  fStats.Increment(fHodoOrEffiId, fHod->GetScinIndex(ip,hitCounter[ip]-1));
 	}
 
 	// Increment pos/neg/both fired.  Track independent, so
@@ -446,12 +421,12 @@ Int_t THcHodoEff::Process( const THaEvData& evdata )
 	// track are examined.
 	if(goodTdcPos) {
 	  if(goodTdcNeg) {
-	    fBothGood[ip][hitcounter]++;
+	    fStats.Increment(fBothGoodId, fHod->GetScinIndex(ip,hitcounter));
 	  } else {
-	    fPosGood[ip][hitcounter]++;
+	    fStats.Increment(fPosGoodId, fHod->GetScinIndex(ip,hitcounter));
 	  }
 	} else if (goodTdcNeg) {
-	  fNegGood[ip][hitcounter]++;
+	  fStats.Increment(fNegGoodId, fHod->GetScinIndex(ip,hitcounter));
 	}
 	// Determine if one or both PMTs had a good tdc
 
@@ -462,8 +437,9 @@ Int_t THcHodoEff::Process( const THaEvData& evdata )
 	//  goodTdcOneSide[ip] = kTRUE;
 	// }
       }
+    }
 
-      /*
+    /*
 	For each plane, see of other 3 fired.  This means that they were enough
 	to form a 3/4 trigger, and so the fraction of times this plane fired is
 	the plane trigger efficiency.  NOTE: we only require a TDC hit, not a
@@ -474,15 +450,14 @@ Int_t THcHodoEff::Process( const THaEvData& evdata )
 	NOTE ALSO: to make this check simpler, we are assuming that all planes
 	have identical active areas.  y_scin = y_cent + y_offset, so shift track
 	position by offset for comparing to edges.
-      */
+    */
 
-      // Need to add calculation and cuts on
-      // xatback and yatback in order to set the
-      // htrig_hododidflag, htrig_hodoshouldflag and otherthreehit flags
-      //
+    // Need to add calculation and cuts on
+    // xatback and yatback in order to set the
+    // htrig_hododidflag, htrig_hodoshouldflag and otherthreehit flags
+    //
 
-      ++fNevt;
-    }
+    fNevt += nphits;
   }
   return 0;
 }
@@ -20,6 +20,7 @@
 
 #include "THaPhysicsModule.h"
 #include "THcHodoscope.h"
+#include "THcRunStats.h"
 #include "THaSpectrometer.h"
 #include "THaTrack.h"
 
@@ -62,11 +63,13 @@ protected:
   Double_t* fCenterFirst;
   Int_t* fNCounters;
   //  Int_t* fHodoPlnContHit;
-  Int_t* fHodoPosEffi;
-  Int_t* fHodoNegEffi;
-  Int_t* fHodoOrEffi;
-  Int_t* fHodoAndEffi;
-  Int_t* fStatTrk;
+  // Run counters, indexed with THcHodoscope::GetScinIndex(plane,paddle)
+  THcRunStats fStats;
+  Int_t fHodoPosEffiId;
+  Int_t fHodoNegEffiId;
+  Int_t fHodoOrEffiId;
+  Int_t fHodoAndEffiId;
+  Int_t fStatTrkId;
   Int_t* fStatTrkSum;
   Int_t* fStatAndSum;
   Double_t* fStatAndEff;
@@ -80,13 +83,14 @@ protected:
   vector<vector<vector<Int_t> > > fHitShould;
   vector<vector<vector<Int_t> > > fStatAndHitDel;
   vector<vector<vector<Int_t> > > fStatTrkDel;
-  vector<vector<Int_t> > fStatPosHit;
-  vector<vector<Int_t> > fStatNegHit;
-  vector<vector<Int_t> > fStatAndHit;
-  vector<vector<Int_t> > fStatOrHit;
-  vector<vector<Int_t> > fBothGood;
-  vector<vector<Int_t> > fNegGood;
-  vector<vector<Int_t> > fPosGood;
+  // Cleared in Begin, same indexing as above
+  Int_t fStatPosHitId;
+  Int_t fStatNegHitId;
+  Int_t fStatAndHitId;
+  Int_t fStatOrHitId;
+  Int_t fBothGoodId;
+  Int_t fNegGoodId;
+  Int_t fPosGoodId;
 
   Int_t* fHitPlane;
 
@@ -21,7 +21,7 @@ public:
 	     Int_t ipad, THcScintillatorPlane* sp) :
   fPosTDC(postdc), fNegTDC(negtdc), fPosADC_Ped(posadc), fNegADC_Ped(negadc),
     fPaddleNumber(ipad), fHasCorrectedTimes(kFALSE),
-    fTwoGoodTimes(kFALSE), fPlane(sp) {};
+    fTwoGoodTimes(kFALSE), fGoodEnds(0), fPlane(sp) {};
 
   virtual ~THcHodoHit() {}
 
@@ -46,6 +46,10 @@ public:
   Double_t GetScinCorrectedTime() const { return fScinCorrectedTime;}
   Bool_t GetTwoGoodTimes() const { return fTwoGoodTimes;}
   Bool_t GetHasCorrectedTimes() const { return fHasCorrectedTimes;}
+  Bool_t GetGoodPosTdc() const { return fGoodEnds & kGoodPosTdc; }
+  Bool_t GetGoodNegTdc() const { return fGoodEnds & kGoodNegTdc; }
+  Bool_t GetGoodPosAdc() const { return fGoodEnds & kGoodPosAdc; }
+  Bool_t GetGoodNegAdc() const { return fGoodEnds & kGoodNegAdc; }
   Int_t GetPaddleNumber() const { return fPaddleNumber; }
   Double_t GetPaddleCenter() const { return fPaddleCenter; }
 
@@ -61,6 +65,10 @@ public:
     fScinCorrectedTime = timeave;
     fHasCorrectedTimes = kTRUE;
   }
+  void SetGoodEnds(Bool_t postdc, Bool_t negtdc, Bool_t posadc, Bool_t negadc) {
+    fGoodEnds = (postdc ? kGoodPosTdc : 0) | (negtdc ? kGoodNegTdc : 0)
+      | (posadc ? kGoodPosAdc : 0) | (negadc ? kGoodNegAdc : 0);
+  }
   void SetTwoGoodTimes(Bool_t flag) {
     fTwoGoodTimes = flag;
   }
@@ -113,6 +121,8 @@ protected:
 
   Bool_t fHasCorrectedTimes;
   Bool_t fTwoGoodTimes;
+  enum { kGoodPosTdc = 1, kGoodNegTdc = 2, kGoodPosAdc = 4, kGoodNegAdc = 8 };
+  Int_t fGoodEnds;		// Ends with a good TDC or ADC hit
   Double_t fPaddleCenter;
 
   THcScintillatorPlane* fPlane;	// Pointer to parent scintillator plane
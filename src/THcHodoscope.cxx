@@ -15,6 +15,7 @@ hodoscope array, not just one plane.
 #include "THcCherenkov.h"
 #include "THcHallCSpectrometer.h"
 #include "THcHitList.h"
+#include "THcMemoryReport.h"
 #include "THcRawShowerHit.h"
 #include "TClass.h"
 #include "math.h"
@@ -48,6 +49,61 @@ hodoscope array, not just one plane.
 using namespace std;
 using std::vector;
 
+//_____________________________________________________________________________
+static inline Int_t LowestBit( ULong64_t w )
+{
+  // Index of the lowest set bit of w != 0
+#ifdef __GNUC__
+  return __builtin_ctzll(w);
+#else
+  Int_t i = 0;
+  while( !(w & 1) ) { w >>= 1; ++i; }
+  return i;
+#endif
+}
+
+//_____________________________________________________________________________
+static inline Int_t HighestBit( ULong64_t w )
+{
+  // Index of the highest set bit of w != 0
+#ifdef __GNUC__
+  return 63-__builtin_clzll(w);
+#else
+  Int_t i = 63;
+  while( !(w >> 63) ) { w <<= 1; --i; }
+  return i;
+#endif
+}
+
+//_____________________________________________________________________________
+static Int_t NextPaddle( const ULong64_t* w, Int_t nwords, Int_t ipad )
+{
+  // First occupied paddle >= ipad in the bitmap w, -1 if none
+  if( ipad < 0 ) ipad = 0;
+  Int_t iw = ipad >> 6;
+  if( iw >= nwords ) return -1;
+  ULong64_t word = w[iw] & (~0ULL << (ipad & 63));
+  while( !word ) {
+    if( ++iw == nwords ) return -1;
+    word = w[iw];
+  }
+  return (iw << 6) + LowestBit(word);
+}
+
+//_____________________________________________________________________________
+static Int_t PrevPaddle( const ULong64_t* w, Int_t ipad )
+{
+  // Last occupied paddle <= ipad in the bitmap w, -1 if none
+  if( ipad < 0 ) return -1;
+  Int_t iw = ipad >> 6;
+  ULong64_t word = w[iw] & (~0ULL >> (63 - (ipad & 63)));
+  while( !word ) {
+    if( --iw < 0 ) return -1;
+    word = w[iw];
+  }
+  return (iw << 6) + HighestBit(word);
+}
+
 //_____________________________________________________________________________
 THcHodoscope::THcHodoscope( const char* name, const char* description,
 				  THaApparatus* apparatus ) :
@@ -60,6 +116,9 @@ THcHodoscope::THcHodoscope( const char* name, const char* description,
   fNPlanes = 0;			// No planes until we make them
   fStartTime=-1e5;
   fGoodStartTime=kFALSE;
+  fNCluster = 0; fClusterSize = 0; fClusterXPos = 0; fClusterYPos = 0;
+  fOccWords = 0;
+  fArenaTracks = fArenaHitsPerPlane = fArenaHitsPerTrack = fNTOFHits = 0;
 }
 
 //_____________________________________________________________________________
@@ -67,6 +126,9 @@ THcHodoscope::THcHodoscope( ) :
   THaNonTrackingDetector()
 {
   // Constructor
+  fNCluster = 0; fClusterSize = 0; fClusterXPos = 0; fClusterYPos = 0;
+  fOccWords = 0;
+  fArenaTracks = fArenaHitsPerPlane = fArenaHitsPerTrack = fNTOFHits = 0;
 }
 
 //_____________________________________________________________________________
@@ -154,7 +216,8 @@ void THcHodoscope::Setup(const char* name, const char* description)
 THaAnalysisObject::EStatus THcHodoscope::Init( const TDatime& date )
 {
   // cout << "In THcHodoscope::Init()" << endl;
-  Setup(GetName(), GetTitle());
+  // Planes are kept when re-initialized, e.g. by THcBatchReplay
+  if(fNPlanes == 0) Setup(GetName(), GetTitle());
 
   char EngineDID[] = "xSCIN";
   EngineDID[0] = toupper(GetApparatus()->GetName()[0]);
@@ -189,6 +252,28 @@ THaAnalysisObject::EStatus THcHodoscope::Init( const TDatime& date )
   fNPlaneTime    = new Int_t [fNPlanes];
   fSumPlaneTime  = new Double_t [fNPlanes];
 
+  fNCluster      = new Int_t [fNPlanes];
+  fClusterSize   = new Int_t [fNPlanes*kMaxNCluster];
+  fClusterXPos   = new Double_t [fNPlanes*kMaxNCluster];
+  fClusterYPos   = new Double_t [fNPlanes*kMaxNCluster];
+
+  // Per-event arenas for CoarseProcess, sized for one track with every
+  // paddle hit.  ResizeArenas grows them if an event needs more.
+  fArenaTracks = 0;
+  fArenaHitsPerPlane = 0;
+  fArenaHitsPerTrack = 0;
+  ResizeArenas(1, fMaxScinPerPlane);
+  fNArenaAllocs = 0;
+  fNArenaEvents = 0;
+
+  // Occupancy bitmaps and cluster table, see FillOccupancy
+  fOccWords = (fMaxScinPerPlane+63)/64;
+  fOccupancy.assign(fNPlanes*kNOccupancy*fOccWords, 0);
+  fPaddleHit.assign(fNPlanes*fMaxScinPerPlane, -1);
+  fClusters.clear();
+  fClusters.reserve(fNPlanes*kMaxNCluster);
+  fFirstCluster.assign(fNPlanes+1, 0);
+
   //  Double_t  fHitCnt4 = 0., fHitCnt3 = 0.;
 
   // Int_t m = 0;
@@ -197,10 +282,6 @@ THaAnalysisObject::EStatus THcHodoscope::Init( const TDatime& date )
   //   fScinHit[m] = new Double_t[fNPaddle[0]];
   // }
 
-  for (int ip=0; ip<fNPlanes; ++ip) {
-    fScinHitPaddle.push_back(std::vector<Int_t>(fNPaddle[ip], 0));
-  }
-
   fPresentP = 0;
   THaVar* vpresent = gHaVars->Find(Form("%s.present",GetApparatus()->GetName()));
   if(vpresent) {
@@ -637,6 +718,10 @@ void THcHodoscope::DeleteArrays()
   delete [] fGoodPlaneTime;       fGoodPlaneTime = NULL;
   delete [] fNPlaneTime;          fNPlaneTime = NULL;
   delete [] fSumPlaneTime;        fSumPlaneTime = NULL;
+  delete [] fNCluster;            fNCluster = NULL;
+  delete [] fClusterSize;         fClusterSize = NULL;
+  delete [] fClusterXPos;         fClusterXPos = NULL;
+  delete [] fClusterYPos;         fClusterYPos = NULL;
   delete [] fNScinHits;           fNScinHits = NULL;
   delete [] fTdcOffset;           fTdcOffset = NULL;
   delete [] fAdcTdcOffset;        fAdcTdcOffset = NULL;
@@ -689,23 +774,15 @@ void THcHodoscope::Clear( Option_t* opt )
       fFPTime[ip]=0.;
       fPlaneCenter[ip]=0.;
       fPlaneSpacing[ip]=0.;
-      for(UInt_t iPaddle=0;iPaddle<fNPaddle[ip]; ++iPaddle) {
-	fScinHitPaddle[ip][iPaddle]=0;
-      }
     }
+    ClearOccupancy();
   }
-  fdEdX.clear();
+  // fdEdX, fGoodFlags, fTOFPInfo/fTOFCalc and the cluster arrays are
+  // arenas that CoarseProcess overwrites, so they are not cleared here.
   fNScinHit.clear();
   fNClust.clear();
-  fClustSize.clear();
-  fClustPos.clear();
-  fNCluster.clear();
-  fClusterSize.clear();
-  fClusterXPos.clear();
-  fClusterYPos.clear();
   fThreeScin.clear();
   fGoodScinHitsX.clear();
-  fGoodFlags.clear();
 }
 
 //_____________________________________________________________________________
@@ -776,6 +853,7 @@ Int_t THcHodoscope::Decode( const THaEvData& evdata )
   //
   fStartTime=-1000;
   if (thits>0 ) EstimateFocalPlaneTime();
+  FillOccupancy();
 
   if (fdebugprintscinraw == 1) {
     for(UInt_t ihit = 0; ihit < fNRawHits ; ihit++) {
@@ -790,6 +868,97 @@ Int_t THcHodoscope::Decode( const THaEvData& evdata )
 
   return fNHits;
 }
+//_____________________________________________________________________________
+void THcHodoscope::ClearOccupancy()
+{
+  // Empty the occupancy bitmaps and the cluster table
+  fOccupancy.assign(fOccupancy.size(), 0);
+  fClusters.clear();
+  fFirstCluster.assign(fFirstCluster.size(), 0);
+}
+
+//_____________________________________________________________________________
+void THcHodoscope::FillOccupancy()
+{
+  /**
+     Set the occupancy bits and the paddle to hit table of each plane from
+     its hits, then collect the runs of adjacent paddles with two good
+     times into the cluster table.  Called at the end of Decode, after
+     EstimateFocalPlaneTime has flagged the hits, so that TrackEffTest,
+     CalcCluster, the spectrometer's best track selection and THcHodoEff
+     need not loop over the hit lists again.
+  */
+  if( fOccupancy.empty() ) return;
+  ClearOccupancy();
+  for(Int_t ip=0;ip<fNPlanes;ip++) {
+    ULong64_t* any  = &fOccupancy[(ip*kNOccupancy+kOccAny)*fOccWords];
+    ULong64_t* both = &fOccupancy[(ip*kNOccupancy+kOccBothEnds)*fOccWords];
+    ULong64_t* good = &fOccupancy[(ip*kNOccupancy+kOccTwoGoodTimes)*fOccWords];
+    ULong64_t* postdc = &fOccupancy[(ip*kNOccupancy+kOccPosTdc)*fOccWords];
+    ULong64_t* negtdc = &fOccupancy[(ip*kNOccupancy+kOccNegTdc)*fOccWords];
+    ULong64_t* posadc = &fOccupancy[(ip*kNOccupancy+kOccPosAdc)*fOccWords];
+    ULong64_t* negadc = &fOccupancy[(ip*kNOccupancy+kOccNegAdc)*fOccWords];
+    Int_t* paddlehit = &fPaddleHit[ip*fMaxScinPerPlane];
+    Int_t nphits=fPlanes[ip]->GetNScinHits();
+    TClonesArray* hodoHits = fPlanes[ip]->GetHits();
+    for(Int_t iphit=0;iphit<nphits;iphit++) {
+      THcHodoHit *hit = (THcHodoHit*)hodoHits->At(iphit);
+      Int_t ipad = hit->GetPaddleNumber()-1;
+      ULong64_t bit = 1ULL << (ipad & 63);
+      any[ipad>>6] |= bit;
+      if(hit->GetHasCorrectedTimes()) both[ipad>>6] |= bit;
+      if(hit->GetTwoGoodTimes()) good[ipad>>6] |= bit;
+      // A hit needs a good TDC and ADC on one end only
+      if(hit->GetGoodPosTdc()) postdc[ipad>>6] |= bit;
+      if(hit->GetGoodNegTdc()) negtdc[ipad>>6] |= bit;
+      if(hit->GetGoodPosAdc()) posadc[ipad>>6] |= bit;
+      if(hit->GetGoodNegAdc()) negadc[ipad>>6] |= bit;
+      paddlehit[ipad] = iphit;
+    }
+    Double_t offset = fPlanes[ip]->GetPosOffset();
+    Int_t ipad = NextPaddle(good, fOccWords, 0);
+    while(ipad >= 0) {
+      HodoCluster clus;
+      clus.first = ipad;
+      clus.size = 0;
+      clus.pos = 0.0;
+      do {
+	clus.pos += fPlanes[ip]->GetPosCenter(ipad) + offset;
+	clus.size++;
+	ipad++;
+      } while( ipad < fOccWords*64 && ((good[ipad>>6] >> (ipad&63)) & 1) );
+      clus.pos /= clus.size;
+      fClusters.push_back(clus);
+      ipad = NextPaddle(good, fOccWords, ipad);
+    }
+    fFirstCluster[ip+1] = fClusters.size();
+  }
+}
+
+//_____________________________________________________________________________
+Int_t THcHodoscope::GetPaddleDistance( Int_t ip, Int_t ipad, Int_t kind ) const
+{
+  // Distance in paddles from ipad to the nearest occupied paddle of
+  // plane ip, -1 if the plane has none
+  const ULong64_t* w = OccupancyWords(ip,kind);
+  Int_t above = NextPaddle(w, fOccWords, ipad);
+  Int_t below = PrevPaddle(w, TMath::Min(ipad, fOccWords*64-1));
+  if( above < 0 )
+    return (below < 0) ? -1 : ipad-below;
+  if( below < 0 )
+    return above-ipad;
+  return TMath::Min(above-ipad, ipad-below);
+}
+
+//_____________________________________________________________________________
+Int_t THcHodoscope::GetFirstHitPaddle( Int_t ip, Int_t lo, Int_t hi,
+				       Int_t kind ) const
+{
+  // Lowest occupied paddle of plane ip in [lo,hi], -1 if none
+  Int_t ipad = NextPaddle(OccupancyWords(ip,kind), fOccWords, lo);
+  return (ipad >= 0 && ipad <= hi) ? ipad : -1;
+}
+
 //_____________________________________________________________________________
 Double_t  THcHodoscope::DetermineTimePeak(Int_t FillFlag)
 {
@@ -1206,407 +1375,171 @@ Int_t THcHodoscope::CoarseProcess( TClonesArray& tracks )
 
   if (ntracks > 0 ) {
 
+    // Make sure the per-event arenas can hold this event.  They only
+    // grow, so after the first few events this is a no-op.
+    Int_t maxPlaneHits = 0;
+    for(Int_t ip = 0; ip < fNumPlanesBetaCalc; ip++ ) {
+      maxPlaneHits = TMath::Max(maxPlaneHits, fPlanes[ip]->GetNScinHits());
+    }
+    ResizeArenas(ntracks, maxPlaneHits);
+
+    // Tabulate the hits and the tracks once, then project every track
+    // onto every hit in one pass.  What is left per track is the time
+    // peak, the choice of good times and the beta fit, whose sums are
+    // accumulated while the good times are chosen.
+    Int_t nhits = FillTOFHitTable();
+    if (nhits < 0) return -1;
+    for ( Int_t itrack = 0; itrack < ntracks; itrack++ ) {
+      THaTrack* theTrack = dynamic_cast<THaTrack*>( tracks.At(itrack) );
+      if (!theTrack) return -1;
+      Double_t theta = theTrack->GetTheta();
+      Double_t phi = theTrack->GetPhi();
+      Double_t betatrack = theTrack->GetP()/TMath::Sqrt(theTrack->GetP()*theTrack->GetP()+fPartMass*fPartMass);
+      fTOFTracks.track[itrack] = theTrack;
+      fTOFTracks.x[itrack] = theTrack->GetX();
+      fTOFTracks.y[itrack] = theTrack->GetY();
+      fTOFTracks.theta[itrack] = theta;
+      fTOFTracks.phi[itrack] = phi;
+      fTOFTracks.pathNorm[itrack] = TMath::Sqrt(1. + theta*theta + phi*phi);
+      fTOFTracks.zcorDenom[itrack] = 29.979*betatrack;
+    }
+    ProjectTracks(ntracks, nhits);
+
     // **MAIN LOOP: Loop over all tracks and get corrected time, tof, beta...
-    vector<Double_t> nPmtHit(ntracks);
-    vector<Double_t> timeAtFP(ntracks);
-    fdEdX.reserve(ntracks);
-    fGoodFlags.reserve(ntracks);
     for ( Int_t itrack = 0; itrack < ntracks; itrack++ ) { // Line 133
-      nPmtHit[itrack]=0;
-      timeAtFP[itrack]=0;
+      Double_t nPmtHit=0;
 
-      THaTrack* theTrack = dynamic_cast<THaTrack*>( tracks.At(itrack) );
-      if (!theTrack) return -1;
+      THaTrack* theTrack = fTOFTracks.track[itrack];
+      // fTOFPInfo/fTOFCalc are left holding the last track for FineProcess
+      Bool_t lastTrack = ( itrack == ntracks-1 );
 
       for (Int_t ip = 0; ip < fNumPlanesBetaCalc; ip++ ){
 	fGoodPlaneTime[ip] = kFALSE;
-	fNScinHits[ip] = 0;
+	fNScinHits[ip] = fPlanes[ip]->GetNScinHits();
 	fNPlaneTime[ip] = 0;
 	fSumPlaneTime[ip] = 0.;
       }
-      std::vector<Double_t> dedx_temp;
-      std::vector<std::vector<GoodFlags> > goodflagstmp1;
-      goodflagstmp1.reserve(fNumPlanesBetaCalc);
-#if __cplusplus >= 201103L
-      fdEdX.push_back(std::move(dedx_temp)); // Create array of dedx per hit
-      fGoodFlags.push_back(std::move(goodflagstmp1));
-#else
-      fdEdX.push_back(dedx_temp); // Create array of dedx per hit
-      fGoodFlags.push_back(goodflagstmp1);
-#endif
-      Int_t nFPTime = 0;
+      Double_t* dedx_track = &fdEdX[itrack*fArenaHitsPerTrack]; // dedx per hit
+      const UChar_t* tofflags = &fTOFFlags[itrack*fArenaHitsPerTrack];
+      const Double_t* time_pos = &fTOFTimePos[itrack*fArenaHitsPerTrack];
+      const Double_t* time_neg = &fTOFTimeNeg[itrack*fArenaHitsPerTrack];
+      const Double_t* scin_pos_time = &fTOFScinPosTime[itrack*fArenaHitsPerTrack];
+      const Double_t* scin_neg_time = &fTOFScinNegTime[itrack*fArenaHitsPerTrack];
       Double_t betaChiSq = -3;
       Double_t beta = 0;
-      //      timeAtFP[itrack] = 0.;
-      Double_t sumFPTime = 0.; // Line 138
       fNScinHit.push_back(0);
+      if (lastTrack) FillTOFPInfo(itrack, nhits);
 
-
-
-       hTime->Reset();
-      fTOFCalc.clear();   // SAW - Can we
-      fTOFPInfo.clear();  // SAW - combine these two?
-      Int_t ihhit = 0;		// Hit # overall
-
-      for(Int_t ip = 0; ip < fNumPlanesBetaCalc; ip++ ) {
-
-	std::vector<GoodFlags> goodflagstmp2;
-	goodflagstmp2.reserve(fNScinHits[ip]);
-#if __cplusplus >= 201103L
-	fGoodFlags[itrack].push_back(std::move(goodflagstmp2));
-#else
-	fGoodFlags[itrack].push_back(goodflagstmp2);
-#endif
-	fNScinHits[ip] = fPlanes[ip]->GetNScinHits();
-	TClonesArray* hodoHits = fPlanes[ip]->GetHits();
-
-	Double_t zPos = fPlanes[ip]->GetZpos();
-	Double_t dzPos = fPlanes[ip]->GetDzpos();
-
-	// first loop over hits with in a single plane
-	for (Int_t iphit = 0; iphit < fNScinHits[ip]; iphit++ ){
-	  // iphit is hit # within a plane
-	  THcHodoHit *hit = (THcHodoHit*)hodoHits->At(iphit);
-
-	  fTOFPInfo.push_back(TOFPInfo());
-	  // Can remove these as we will initialize in the constructor
-	  //	  fTOFPInfo[ihhit].time_pos = -99.0;
-	  //	  fTOFPInfo[ihhit].time_neg = -99.0;
-	  //	  fTOFPInfo[ihhit].keep_pos = kFALSE;
-	  //	  fTOFPInfo[ihhit].keep_neg = kFALSE;
-	  fTOFPInfo[ihhit].scin_pos_time = 0.0;
-	  fTOFPInfo[ihhit].scin_neg_time = 0.0;
-	  fTOFPInfo[ihhit].hit = hit;
-	  fTOFPInfo[ihhit].planeIndex = ip;
-	  fTOFPInfo[ihhit].hitNumInPlane = iphit;
-	  fTOFPInfo[ihhit].onTrack = kFALSE;
-
-	  Int_t paddle = hit->GetPaddleNumber()-1;
-	  Double_t zposition = zPos + (paddle%2)*dzPos;
-
-	  Double_t xHitCoord = theTrack->GetX() + theTrack->GetTheta() *
-	    ( zposition ); // Line 183
-
-	  Double_t yHitCoord = theTrack->GetY() + theTrack->GetPhi() *
-	    ( zposition ); // Line 184
-
-	  Double_t scinTrnsCoord, scinLongCoord;
-	  if ( ( ip == 0 ) || ( ip == 2 ) ){ // !x plane. Line 185
-	    scinTrnsCoord = xHitCoord;
-	    scinLongCoord = yHitCoord;
-	  } else if ( ( ip == 1 ) || ( ip == 3 ) ){ // !y plane. Line 188
-	    scinTrnsCoord = yHitCoord;
-	    scinLongCoord = xHitCoord;
-	  } else { return -1; } // Line 195
-
-	  fTOFPInfo[ihhit].scinTrnsCoord = scinTrnsCoord;
-	  fTOFPInfo[ihhit].scinLongCoord = scinLongCoord;
-
-	  Double_t scinCenter = fPlanes[ip]->GetPosCenter(paddle) + fPlanes[ip]->GetPosOffset();
-
-	  // Index to access the 2d arrays of paddle/scintillator properties
-	  Int_t fPIndex = GetScinIndex(ip,paddle);
-          Double_t betatrack = theTrack->GetP()/TMath::Sqrt(theTrack->GetP()*theTrack->GetP()+fPartMass*fPartMass);
-          
-	  if ( TMath::Abs( scinCenter - scinTrnsCoord ) <
-	       ( fPlanes[ip]->GetSize() * 0.5 + fPlanes[ip]->GetHodoSlop() ) ){ // Line 293
-
-	    fTOFPInfo[ihhit].onTrack = kTRUE;
-	    Double_t zcor = zposition/(29.979*betatrack)*
-	      TMath::Sqrt(1. + theTrack->GetTheta()*theTrack->GetTheta()
-			  + theTrack->GetPhi()*theTrack->GetPhi());
-	    fTOFPInfo[ihhit].zcor = zcor;
-	    if (fCosmicFlag) {
-	      Double_t zcor = -zposition/(29.979*1.0)*
-		TMath::Sqrt(1. + theTrack->GetTheta()*theTrack->GetTheta()
-			    + theTrack->GetPhi()*theTrack->GetPhi());
-	      fTOFPInfo[ihhit].zcor = zcor;
-	    }
-	    Double_t tdc_pos = hit->GetPosTDC();
-	    Double_t tdc_neg = hit->GetNegTDC();
-	    //
-	    if( (tdc_pos >=fScinTdcMin && tdc_pos <= fScinTdcMax) &&
-                 (tdc_neg >=fScinTdcMin && tdc_neg <= fScinTdcMax )) {
-	      fTOFPInfo[ihhit].scin_pos_time = hit->GetPosCorrectedTime();
- 	      Double_t timep = hit->GetPosCorrectedTime()-zcor;
-	      fTOFPInfo[ihhit].time_pos = timep;
-              hTime->Fill(timep);
-	      fTOFPInfo[ihhit].scin_neg_time = hit->GetNegCorrectedTime();
- 	      Double_t timen = hit->GetNegCorrectedTime()-zcor;
-	      fTOFPInfo[ihhit].time_neg = timen;
-              hTime->Fill(timen);
-	    } else {
-	    //
-	      if (fTrackBetaIncludeSinglePmtHits==1) {
-	      if(tdc_pos >=fScinTdcMin && tdc_pos <= fScinTdcMax ) {
-	      Double_t adc_pos = hit->GetPosADC();
-	      Double_t adcamp_pos = hit->GetPosADCpeak();
-	      Double_t pathp = fPlanes[ip]->GetPosLeft() - scinLongCoord;
-	      fTOFPInfo[ihhit].pathp = pathp;
-	      Double_t timep = tdc_pos*fScinTdcToTime;
-	      if(fTofUsingInvAdc) {
-		timep -= fHodoPosInvAdcOffset[fPIndex]
-		  + pathp/fHodoPosInvAdcLinear[fPIndex]
-		  + fHodoPosInvAdcAdc[fPIndex]
-		  /TMath::Sqrt(TMath::Max(20.0*.020,adc_pos));
-	      } else {
-	        //Double_t tw_corr_pos = fHodoPos_c1[fPIndex]/pow(adcamp_pos/fTdc_Thrs,fHodoPos_c2[fPIndex]) -  fHodoPos_c1[fPIndex]/pow(200./fTdc_Thrs, fHodoPos_c2[fPIndex]);
-		Double_t tw_corr_pos=0.;
-		pathp=scinLongCoord;
-		if (adcamp_pos>0) tw_corr_pos = 1./pow(adcamp_pos/fTdc_Thrs,fHodoPos_c2[fPIndex]) -  1./pow(200./fTdc_Thrs, fHodoPos_c2[fPIndex]);            
-		timep += -tw_corr_pos + fHodo_LCoeff[fPIndex]+ pathp/fHodoVelFit[fPIndex];
-	      }
-	      fTOFPInfo[ihhit].scin_pos_time = timep;
- 	      timep -= zcor;
-	      fTOFPInfo[ihhit].time_pos = timep;
-
-              hTime->Fill(timep);
-	    }
-	    if(tdc_neg >=fScinTdcMin && tdc_neg <= fScinTdcMax ) {
-	      Double_t adc_neg = hit->GetNegADC();
-	      Double_t adcamp_neg = hit->GetNegADCpeak();
-	      Double_t pathn =  scinLongCoord - fPlanes[ip]->GetPosRight();
-	      fTOFPInfo[ihhit].pathn = pathn;
-	      Double_t timen = tdc_neg*fScinTdcToTime;
-	      if(fTofUsingInvAdc) {
-		timen -= fHodoNegInvAdcOffset[fPIndex]
-		  + pathn/fHodoNegInvAdcLinear[fPIndex]
-		  + fHodoNegInvAdcAdc[fPIndex]
-		  /TMath::Sqrt(TMath::Max(20.0*.020,adc_neg));
-	      } else {
-		pathn=scinLongCoord ;
-		Double_t tw_corr_neg =0 ;
-		if (adcamp_neg >0) tw_corr_neg= 1./pow(adcamp_neg/fTdc_Thrs,fHodoNeg_c2[fPIndex]) -  1./pow(200./fTdc_Thrs, fHodoNeg_c2[fPIndex]);              
-		timen += -tw_corr_neg- 2*fHodoCableFit[fPIndex] + fHodo_LCoeff[fPIndex]- pathn/fHodoVelFit[fPIndex];
-
-	      }
-	      fTOFPInfo[ihhit].scin_neg_time = timen;
-	      timen -=  zcor;
-	      fTOFPInfo[ihhit].time_neg = timen;
-              hTime->Fill(timen);
-	    }
-	      } // new fTrackBetaIncludeSinglePmtHits
-	    } // matches else
-	  } // condition for cenetr on a paddle
-	  ihhit++;
-	} // First loop over hits in a plane <---------
-
-	//-----------------------------------------------------------------------------------------------
-	//------------- First large loop over scintillator hits ends here --------------------
-	//-----------------------------------------------------------------------------------------------
+      hTime->Reset();
+      for(Int_t ih = 0; ih < nhits; ih++) {
+	if ( tofflags[ih] & kTOFHasPos ) hTime->Fill(time_pos[ih]);
+	if ( tofflags[ih] & kTOFHasNeg ) hTime->Fill(time_neg[ih]);
       }
-      Int_t nhits=ihhit;
+      fNTOFHits=nhits;
 
       Double_t TimePeak = DetermineTimePeak(2);
-      if(TimePeak> 0) {
-	
-	for(Int_t ih = 0; ih < nhits; ih++) { // loop over all scintillator hits
-	  if ( ( fTOFPInfo[ih].time_pos > (TimePeak-fTofTolerance) ) && ( fTOFPInfo[ih].time_pos < ( TimePeak + fTofTolerance ) ) ) {
-	    fTOFPInfo[ih].keep_pos=kTRUE;
-	  }
-	  if ( ( fTOFPInfo[ih].time_neg > (TimePeak-fTofTolerance) ) && ( fTOFPInfo[ih].time_neg < ( TimePeak + fTofTolerance ) ) ){
-	    fTOFPInfo[ih].keep_neg=kTRUE;
-	  }
-	}
-      }
+      Double_t keepLo = TimePeak-fTofTolerance;
+      Double_t keepHi = TimePeak+fTofTolerance;
 
       //---------------------------------------------------------------------------------------------
       // ---------------------- Second loop over scint. hits in a plane -----------------------------
       //---------------------------------------------------------------------------------------------
- 
-      fdEdX[itrack].reserve(nhits);
-      fTOFCalc.reserve(nhits);
+
+      // Sums of the beta fit (from h_tof_fit) over the good times
+      Double_t sumW = 0.;
+      Double_t sumT = 0.;
+      Double_t sumZ = 0.;
+      Double_t sumZZ = 0.;
+      Double_t sumTZ = 0.;
+      Int_t nfit = 0;
+
       for(Int_t ih=0; ih < nhits; ih++) {
-	THcHodoHit *hit = fTOFPInfo[ih].hit;
-	Int_t iphit = fTOFPInfo[ih].hitNumInPlane;
-	Int_t ip = fTOFPInfo[ih].planeIndex;
-	//         fDumpOut << " looping over hits = " << ih << " plane = " << ip+1 << endl;
+	Int_t ip = fTOFHits.plane[ih];
+	Int_t iphit = fTOFHits.hitInPlane[ih];
 	// Flags are used by THcHodoEff
-	fGoodFlags[itrack][ip].reserve(nhits);
-	fGoodFlags[itrack][ip].push_back(GoodFlags());
-	assert( iphit >= 0 && (size_t)iphit < fGoodFlags[itrack][ip].size() );
-	fGoodFlags[itrack][ip][iphit].onTrack = kFALSE;
-	fGoodFlags[itrack][ip][iphit].goodScinTime = kFALSE;
-	fGoodFlags[itrack][ip][iphit].goodTdcNeg = kFALSE;
-	fGoodFlags[itrack][ip][iphit].goodTdcPos = kFALSE;
-
-	fTOFCalc.push_back(TOFCalc());
-	// Do we set back to false for each track, or just once per event?
-	assert( ih >= 0 && (size_t)ih < fTOFCalc.size() );
-	fTOFCalc[ih].good_scin_time = kFALSE;
-	// These need a track index too to calculate efficiencies
-	fTOFCalc[ih].good_tdc_pos = kFALSE;
-	fTOFCalc[ih].good_tdc_neg = kFALSE;
-	fTOFCalc[ih].pindex = ip;
-
-	Int_t paddle = hit->GetPaddleNumber()-1;
-	fTOFCalc[ih].hit_paddle = paddle;
-	fTOFCalc[ih].good_raw_pad = paddle;
-
-	//	Double_t scinCenter = fPlanes[ip]->GetPosCenter(paddle) + fPlanes[ip]->GetPosOffset();
-	//	Double_t scinTrnsCoord = fTOFPInfo[ih].scinTrnsCoord;
-	//	Double_t scinLongCoord = fTOFPInfo[ih].scinLongCoord;
-
-	Int_t fPIndex = GetScinIndex(ip,paddle);
-
-	if (fTOFPInfo[ih].onTrack) {
-	  fGoodFlags[itrack][ip][iphit].onTrack = kTRUE;
-	  if ( fTOFPInfo[ih].keep_pos ) { // 301
-	    fTOFCalc[ih].good_tdc_pos = kTRUE;
-	    fGoodFlags[itrack][ip][iphit].goodTdcPos = kTRUE;
-	  }
-	  if ( fTOFPInfo[ih].keep_neg ) { //
-	    fTOFCalc[ih].good_tdc_neg = kTRUE;
-	    fGoodFlags[itrack][ip][iphit].goodTdcNeg = kTRUE;
-	  }
+	assert( iphit >= 0 && iphit < fArenaHitsPerPlane );
+	GoodFlags& goodflags = fGoodFlags[GoodFlagsIndex(itrack,ip,iphit)];
+	goodflags = GoodFlags();
+
+	Bool_t keep_pos = ( TimePeak > 0 && time_pos[ih] > keepLo && time_pos[ih] < keepHi );
+	Bool_t keep_neg = ( TimePeak > 0 && time_neg[ih] > keepLo && time_neg[ih] < keepHi );
+	Bool_t good_tdc_pos = kFALSE;
+	Bool_t good_tdc_neg = kFALSE;
+	Double_t scin_time = 0., scin_time_fp = 0., scin_sigma = 0.;
+	Int_t iend = -1;	// Good ends: 0 both, 1 pos, 2 neg
+
+	if ( tofflags[ih] & kTOFOnTrack ) {
+	  goodflags.onTrack = kTRUE;
+	  good_tdc_pos = goodflags.goodTdcPos = keep_pos;
+	  good_tdc_neg = goodflags.goodTdcNeg = keep_neg;
 	  // ** Calculate ave time for scin and error.
-	  if ( fTOFCalc[ih].good_tdc_pos ){
-	    if ( fTOFCalc[ih].good_tdc_neg ){
-	      fTOFCalc[ih].scin_time  = ( fTOFPInfo[ih].scin_pos_time +
-					  fTOFPInfo[ih].scin_neg_time ) / 2.;
-	      fTOFCalc[ih].scin_time_fp  = ( fTOFPInfo[ih].time_pos +
-					     fTOFPInfo[ih].time_neg ) / 2.;
-	      
-	      if (fTofUsingInvAdc){
-		fTOFCalc[ih].scin_sigma = TMath::Sqrt( fHodoPosSigma[fPIndex] * fHodoPosSigma[fPIndex] +
-						       fHodoNegSigma[fPIndex] * fHodoNegSigma[fPIndex] )/2.;
-	      }
-	      else {
-		fTOFCalc[ih].scin_sigma = TMath::Sqrt( fHodoSigmaPos[fPIndex] * fHodoSigmaPos[fPIndex] +
-						       fHodoSigmaNeg[fPIndex] * fHodoSigmaNeg[fPIndex] )/2.;
-	      }
-
-	      fTOFCalc[ih].good_scin_time = kTRUE;
-	      fGoodFlags[itrack][ip][iphit].goodScinTime = kTRUE;
-	    } else{
-	      fTOFCalc[ih].scin_time = fTOFPInfo[ih].scin_pos_time;
-	      fTOFCalc[ih].scin_time_fp = fTOFPInfo[ih].time_pos;
-	      
-	      if (fTofUsingInvAdc){
-		fTOFCalc[ih].scin_sigma = fHodoPosSigma[fPIndex];
-	      }
-	      else{
-		fTOFCalc[ih].scin_sigma = fHodoSigmaPos[fPIndex];
-	      }
-	      
-	      fTOFCalc[ih].good_scin_time = kTRUE;
-	      fGoodFlags[itrack][ip][iphit].goodScinTime = kTRUE;
-	    }
-	  } else {
-	    if ( fTOFCalc[ih].good_tdc_neg ){
-	      fTOFCalc[ih].scin_time = fTOFPInfo[ih].scin_neg_time;
-	      fTOFCalc[ih].scin_time_fp = fTOFPInfo[ih].time_neg;
-	      if (fTofUsingInvAdc){
-		fTOFCalc[ih].scin_sigma = fHodoNegSigma[fPIndex];
-	      }
-	      else{
-		fTOFCalc[ih].scin_sigma = fHodoSigmaNeg[fPIndex];
-	      }
-	      fTOFCalc[ih].good_scin_time = kTRUE;
-	      fGoodFlags[itrack][ip][iphit].goodScinTime = kTRUE;
-	    }
-	  } // In h_tof.f this includes the following if condition for time at focal plane
-	    // // because it is written in FORTRAN code
-
-	    // c     Get time at focal plane
-	  if ( fTOFCalc[ih].good_scin_time ){
-
-	    // scin_time_fp doesn't need to be an array
-	    // Is this any different than the average of time_pos and time_neg?
-	    //	    Double_t scin_time_fp = ( fTOFPInfo[ih].time_pos +
-	    //				      fTOFPInfo[ih].time_neg ) / 2.;
-	    Double_t scin_time_fp = fTOFCalc[ih].scin_time_fp;
-
-	    sumFPTime = sumFPTime + scin_time_fp;
-	    nFPTime ++;
+	  if ( good_tdc_pos && good_tdc_neg ) {
+	    scin_time = ( scin_pos_time[ih] + scin_neg_time[ih] ) / 2.;
+	    scin_time_fp = ( time_pos[ih] + time_neg[ih] ) / 2.;
+	    iend = 0;
+	  } else if ( good_tdc_pos ) {
+	    scin_time = scin_pos_time[ih];
+	    scin_time_fp = time_pos[ih];
+	    iend = 1;
+	  } else if ( good_tdc_neg ) {
+	    scin_time = scin_neg_time[ih];
+	    scin_time_fp = time_neg[ih];
+	    iend = 2;
+	  }
+	  // c     Get time at focal plane
+	  if ( iend >= 0 ) {
+	    goodflags.goodScinTime = kTRUE;
+	    scin_sigma = fTOFHits.sigma[3*ih+iend];
 
 	    fSumPlaneTime[ip] = fSumPlaneTime[ip] + scin_time_fp;
 	    fNPlaneTime[ip] ++;
 	    fNScinHit[itrack] ++;
+	    nPmtHit = nPmtHit + ( iend == 0 ? 2 : 1 );
 
-	    if ( ( fTOFCalc[ih].good_tdc_pos ) && ( fTOFCalc[ih].good_tdc_neg ) ){
-	      nPmtHit[itrack] = nPmtHit[itrack] + 2;
-	    } else {
-	      nPmtHit[itrack] = nPmtHit[itrack] + 1;
-	    }
-
-	    fdEdX[itrack].push_back(0.0);
-	    assert( fNScinHit[itrack] > 0 && (size_t)fNScinHit[itrack] < fdEdX[itrack].size()+1 );
-
-	    // --------------------------------------------------------------------------------------------
-	    if ( fTOFCalc[ih].good_tdc_pos ){
-	      if ( fTOFCalc[ih].good_tdc_neg ){
-		fdEdX[itrack][fNScinHit[itrack]-1]=
-		  TMath::Sqrt( TMath::Max( 0., hit->GetPosADC() * hit->GetNegADC() ) );
-	      } else{
-		fdEdX[itrack][fNScinHit[itrack]-1]=
-		  TMath::Max( 0., hit->GetPosADC() );
-	      }
-	    } else{
-	      if ( fTOFCalc[ih].good_tdc_neg ){
-		fdEdX[itrack][fNScinHit[itrack]-1]=
-		  TMath::Max( 0., hit->GetNegADC() );
-	      } else{
-		fdEdX[itrack][fNScinHit[itrack]-1]=0.0;
-	      }
-	    }
-	    // --------------------------------------------------------------------------------------------
+	    assert( fNScinHit[itrack] > 0 && fNScinHit[itrack] <= fArenaHitsPerTrack );
+	    dedx_track[fNScinHit[itrack]-1] = fTOFHits.dedx[3*ih+iend];
 
+	    // ** See if there are any good time measurements in the plane.
+	    fGoodPlaneTime[ip] = kTRUE;
 
-	  } // time at focal plane condition
+	    Double_t scinWeight = 1 / ( scin_sigma * scin_sigma );
+	    Double_t zPosition = fTOFHits.z[ih];
+	    sumW  += scinWeight;
+	    sumT  += scinWeight * scin_time;
+	    sumZ  += scinWeight * zPosition;
+	    sumZZ += scinWeight * ( zPosition * zPosition );
+	    sumTZ += scinWeight * zPosition * scin_time;
+	    fTOFFitZ[nfit] = zPosition;
+	    fTOFFitTime[nfit] = scin_time;
+	    fTOFFitSigma[nfit] = scin_sigma;
+	    nfit++;
+	  }
 	} // on track condition
 
-	  // ** See if there are any good time measurements in the plane.
-	if ( fTOFCalc[ih].good_scin_time ){
-	  fGoodPlaneTime[ip] = kTRUE;
-	  fTOFCalc[ih].dedx = fdEdX[itrack][fNScinHit[itrack]-1];
-	} else {
-	  fTOFCalc[ih].dedx = 0.0;
+	if (lastTrack) {
+	  fTOFPInfo[ih].keep_pos = keep_pos;
+	  fTOFPInfo[ih].keep_neg = keep_neg;
+	  TOFCalc& calc = fTOFCalc[ih];
+	  calc = TOFCalc();
+	  calc.pindex = ip;
+	  calc.hit_paddle = calc.good_raw_pad = fTOFHits.paddle[ih];
+	  calc.good_tdc_pos = good_tdc_pos;
+	  calc.good_tdc_neg = good_tdc_neg;
+	  calc.good_scin_time = ( iend >= 0 );
+	  calc.scin_time = scin_time;
+	  calc.scin_time_fp = scin_time_fp;
+	  calc.scin_sigma = scin_sigma;
+	  calc.dedx = ( iend >= 0 ) ? dedx_track[fNScinHit[itrack]-1] : 0.0;
 	}
-	
       } // Second loop over hits of a scintillator plane ends here
       theTrack->SetGoodPlane3( fGoodPlaneTime[2] ? 1 : 0 );
       if (fNumPlanesBetaCalc==4) theTrack->SetGoodPlane4( fGoodPlaneTime[3] ? 1 : 0 );
-      //
-      //------------------------------------------------------------------------------
-      //------------------------------------------------------------------------------
-      //------------------------------------------------------------------------------
-      //------------------------------------------------------------------------------
-      //------------------------------------------------------------------------------
-      //------------------------------------------------------------------------------
-      //------------------------------------------------------------------------------
-      //------------------------------------------------------------------------------
 
       // * * Fit beta if there are enough time measurements (one upper, one lower)
       // From h_tof_fit
       if ( ( ( fGoodPlaneTime[0] ) || ( fGoodPlaneTime[1] ) ) &&
 	   ( ( fGoodPlaneTime[2] ) || ( fGoodPlaneTime[3] ) ) ){
 
-	Double_t sumW = 0.;
-	Double_t sumT = 0.;
-	Double_t sumZ = 0.;
-	Double_t sumZZ = 0.;
-	Double_t sumTZ = 0.;
-
-	for(Int_t ih=0; ih < nhits; ih++) {
-	  Int_t ip = fTOFPInfo[ih].planeIndex;
-
-	  if ( fTOFCalc[ih].good_scin_time ) {
-
-	    Double_t scinWeight = 1 / ( fTOFCalc[ih].scin_sigma * fTOFCalc[ih].scin_sigma );
-	    Double_t zPosition = ( fPlanes[ip]->GetZpos()
-				   +( fTOFCalc[ih].hit_paddle % 2 ) *
-				   fPlanes[ip]->GetDzpos() );
-
-	    sumW  += scinWeight;
-	    sumT  += scinWeight * fTOFCalc[ih].scin_time;
-	    sumZ  += scinWeight * zPosition;
-	    sumZZ += scinWeight * ( zPosition * zPosition );
-	    sumTZ += scinWeight * zPosition * fTOFCalc[ih].scin_time;
-
-	  } // condition of good scin time
-	} // loop over hits
-
 	Double_t tmp = sumW * sumZZ - sumZ * sumZ ;
 	Double_t t0 = ( sumT * sumZZ - sumZ * sumTZ ) / tmp ;
 	Double_t tmpDenom = sumW * sumTZ - sumZ * sumT;
@@ -1616,25 +1549,15 @@ Int_t THcHodoscope::CoarseProcess( TClonesArray& tracks )
 	  beta = tmp / tmpDenom;
 	  betaChiSq = 0.;
 
-	  for(Int_t ih=0; ih < nhits; ih++) {
-	    Int_t ip = fTOFPInfo[ih].planeIndex;
-
-	    if ( fTOFCalc[ih].good_scin_time ){
-
-	      Double_t zPosition = ( fPlanes[ip]->GetZpos() + ( fTOFCalc[ih].hit_paddle % 2 ) *
-				     fPlanes[ip]->GetDzpos() );
-	      Double_t timeDif = ( fTOFCalc[ih].scin_time - t0 );
-	      betaChiSq += ( ( zPosition / beta - timeDif ) *
-			     ( zPosition / beta - timeDif ) )  /
-		( fTOFCalc[ih].scin_sigma * fTOFCalc[ih].scin_sigma );
-
-	    } // condition for good scin time
-	  } // loop over hits
+	  for(Int_t i=0; i < nfit; i++) {
+	    Double_t timeDif = ( fTOFFitTime[i] - t0 );
+	    betaChiSq += ( ( fTOFFitZ[i] / beta - timeDif ) *
+			   ( fTOFFitZ[i] / beta - timeDif ) )  /
+	      ( fTOFFitSigma[i] * fTOFFitSigma[i] );
+	  }
 
-	  Double_t pathNorm = TMath::Sqrt( 1. + theTrack->GetTheta() * theTrack->GetTheta() +
-					   theTrack->GetPhi()   * theTrack->GetPhi() );
 	  // Take angle into account
-	  beta = beta / pathNorm;
+	  beta = beta / fTOFTracks.pathNorm[itrack];
 	  beta = beta / 29.979;    // velocity / c
 
 	} // condition for fTmpDenom
@@ -1647,9 +1570,6 @@ Int_t THcHodoscope::CoarseProcess( TClonesArray& tracks )
 	betaChiSq = -1;
       }
 
-      if ( nFPTime != 0 ){
-      	timeAtFP[itrack] = ( sumFPTime / nFPTime );
-      }
       //
       // ---------------------------------------------------------------------------
 
@@ -1670,18 +1590,13 @@ Int_t THcHodoscope::CoarseProcess( TClonesArray& tracks )
       fptime=fStartTime;
       if (nGoodPlanesHit>=3) fptime = FPTimeSum/nFPTimeSum;
       fFPTimeAll = fptime;
-      Double_t dedx=0.0;
-      for(UInt_t ih=0;ih<fTOFCalc.size();ih++) {
-	if(fTOFCalc[ih].good_scin_time) {
-	  dedx = fTOFCalc[ih].dedx;
-	  break;
-	}
-      }
+      // dE/dx of the first good hit
+      Double_t dedx = ( fNScinHit[itrack] > 0 ) ? dedx_track[0] : 0.0;
       theTrack->SetDedx(dedx);
       theTrack->SetFPTime(fptime);
       theTrack->SetBeta(beta);
       theTrack->SetBetaChi2( betaChiSq );
-      theTrack->SetNPMT(nPmtHit[itrack]);
+      theTrack->SetNPMT(nPmtHit);
 
 
     } // Main loop over tracks ends here.
@@ -1694,6 +1609,7 @@ Int_t THcHodoscope::CoarseProcess( TClonesArray& tracks )
   //
   CalcCluster();
 
+  fNArenaEvents++;
   return 0;
 
 }
@@ -1702,14 +1618,15 @@ void THcHodoscope::CalcCluster(void)
 {
   //    THcHallCSpectrometer *app = dynamic_cast<THcHallCSpectrometer*>(GetApparatus());
   //    cout << app->GetName() << endl;
-   const Int_t MaxNCluster=5;
-  std::vector<Int_t > iw(MaxNCluster,0);
-  std::vector<Double_t > dw(MaxNCluster,0);
-  for(Int_t ip = 0; ip < fNumPlanesBetaCalc; ip++ ) {
-    fNCluster.push_back(0);
-    fClusterSize.push_back(iw);
-    fClusterXPos.push_back(dw);
-    fClusterYPos.push_back(dw);
+  // Cluster arrays are flat [plane][cluster] arrays allocated in Init
+  const Int_t MaxNCluster=kMaxNCluster;
+  for(Int_t ip = 0; ip < fNPlanes; ip++ ) {
+    fNCluster[ip] = 0;
+  }
+  for(Int_t ic = 0; ic < fNPlanes*MaxNCluster; ic++ ) {
+    fClusterSize[ic] = 0;
+    fClusterXPos[ic] = 0;
+    fClusterYPos[ic] = 0;
   }
      for (Int_t ip = 0; ip < fNumPlanesBetaCalc; ip++ ){
 	Double_t pl_xypos=0;
@@ -1719,10 +1636,11 @@ void THcHodoscope::CalcCluster(void)
 	Double_t pl_x=0,pl_y=0;
 	TClonesArray* hodoHits = fPlanes[ip]->GetHits();
         Int_t prev_padnum=-100;
-	for (Int_t iphit = 0; iphit < fPlanes[ip]->GetNScinHits(); iphit++ ){	  
-          THcHodoHit *hit = (THcHodoHit*)hodoHits->At(iphit);
-	  if ( hit->GetTwoGoodTimes() ) {
-	    Int_t padind = hit->GetPaddleNumber()-1;
+	// Paddles with two good times, in paddle order
+	const ULong64_t* good = OccupancyWords(ip,kOccTwoGoodTimes);
+	for (Int_t padind = NextPaddle(good,fOccWords,0); padind >= 0;
+	     padind = NextPaddle(good,fOccWords,padind+1) ){
+	    Int_t iphit = fPaddleHit[ip*fMaxScinPerPlane+padind];
             Int_t padnum  = padind+1;
 	    if (ip==0 || ip==2) pl_x = fPlanes[ip]->GetPosCenter(padind)+ fPlanes[ip]->GetPosOffset();
 	    if (ip==0 || ip==2) pl_y = ((THcHodoHit*)hodoHits->At(iphit))->GetCalcPosition();
@@ -1732,26 +1650,25 @@ void THcHodoscope::CalcCluster(void)
 	    pl_calcpos=((THcHodoHit*)hodoHits->At(iphit))->GetCalcPosition();
 	    pl_zpos+=fPlanes[ip]->GetZpos()+ (padind%2)*fPlanes[ip]->GetDzpos();
 	    num_good_pad++; 
-	    if ( fNCluster[ip]>0 && abs(padnum-prev_padnum)==1 && fClusterSize[ip][fNCluster[ip]-1]==1) {
-	      fClusterSize[ip][fNCluster[ip]-1]=fClusterSize[ip][fNCluster[ip]-1]+1;
-	      fClusterXPos[ip][fNCluster[ip]-1]+=pl_x;
-	      fClusterYPos[ip][fNCluster[ip]-1]+=pl_y;
-	      //	      cout << "Add to cluster  pl = " << ip+1 << " hit = " << iphit << " pad = " << padnum << " clus =  " << fNCluster[ip] << " cl size = " << fClusterSize[ip][fNCluster[ip]-1] << " Xpos " << pl_x << " Ypos = " << pl_y << " postime = " << hit->GetPosTOFCorrectedTime() << " negtime = " << hit->GetNegTOFCorrectedTime() << endl;
+	    if ( fNCluster[ip]>0 && abs(padnum-prev_padnum)==1 && fClusterSize[ip*MaxNCluster+fNCluster[ip]-1]==1) {
+	      fClusterSize[ip*MaxNCluster+fNCluster[ip]-1]=fClusterSize[ip*MaxNCluster+fNCluster[ip]-1]+1;
+	      fClusterXPos[ip*MaxNCluster+fNCluster[ip]-1]+=pl_x;
+	      fClusterYPos[ip*MaxNCluster+fNCluster[ip]-1]+=pl_y;
+	      //	      cout << "Add to cluster  pl = " << ip+1 << " hit = " << iphit << " pad = " << padnum << " clus =  " << fNCluster[ip] << " cl size = " << fClusterSize[ip*MaxNCluster+fNCluster[ip]-1] << " Xpos " << pl_x << " Ypos = " << pl_y << " postime = " << hit->GetPosTOFCorrectedTime() << " negtime = " << hit->GetNegTOFCorrectedTime() << endl;
 	    } else {
 	      if (fNCluster[ip]<MaxNCluster) fNCluster[ip]++;
-	      fClusterSize[ip][fNCluster[ip]-1]=1;
-	      fClusterXPos[ip][fNCluster[ip]-1]=pl_x;
-	      fClusterYPos[ip][fNCluster[ip]-1]=pl_y;
-	      //	       cout << " New clus pl = " << ip+1 << " hit = " << iphit << " pad = " << padnum << " clus = " << fNCluster[ip] << " cl size = " << fClusterSize[ip][fNCluster[ip]-1] << " Xpos = " << pl_x << " Ypos = " << pl_y  << " postime = " << hit->GetPosTOFCorrectedTime() << " negtime = " << hit->GetNegTOFCorrectedTime() << endl;
+	      fClusterSize[ip*MaxNCluster+fNCluster[ip]-1]=1;
+	      fClusterXPos[ip*MaxNCluster+fNCluster[ip]-1]=pl_x;
+	      fClusterYPos[ip*MaxNCluster+fNCluster[ip]-1]=pl_y;
+	      //	       cout << " New clus pl = " << ip+1 << " hit = " << iphit << " pad = " << padnum << " clus = " << fNCluster[ip] << " cl size = " << fClusterSize[ip*MaxNCluster+fNCluster[ip]-1] << " Xpos = " << pl_x << " Ypos = " << pl_y  << " postime = " << hit->GetPosTOFCorrectedTime() << " negtime = " << hit->GetNegTOFCorrectedTime() << endl;
 	   }
 	    prev_padnum=padnum;
-	  }
 	}
 	//
 	   for (Int_t ic = 0; ic < fNCluster[ip]; ic++ ){
-	     fClusterXPos[ip][ic]/=fClusterSize[ip][ic];
-	     fClusterYPos[ip][ic]/=fClusterSize[ip][ic];
-	     //	     cout << " Cluster = " << ic+1 << " Xpos = " << fClusterXPos[ip][ic] << " Ypos = " << fClusterYPos[ip][ic] << endl; 
+	     fClusterXPos[ip*MaxNCluster+ic]/=fClusterSize[ip*MaxNCluster+ic];
+	     fClusterYPos[ip*MaxNCluster+ic]/=fClusterSize[ip*MaxNCluster+ic];
+	     //	     cout << " Cluster = " << ic+1 << " Xpos = " << fClusterXPos[ip*MaxNCluster+ic] << " Ypos = " << fClusterYPos[ip*MaxNCluster+ic] << endl; 
 	   }
 	//
  	if (num_good_pad !=0 ) {
@@ -1783,8 +1700,8 @@ void THcHodoscope::CalcCluster(void)
 	 if ( fNCluster[pl1]>=1 && fNCluster[pl2]>=1 ) {
 	   for (Int_t ic1 = 0; ic1 < fNCluster[pl1]; ic1++ ){
 	   for (Int_t ic2 = 0; ic2 < fNCluster[pl2]; ic2++ ){
-	     diffx= abs(fClusterXPos[pl1][ic1]-fClusterXPos[pl2][ic2]);
-	     diffy= abs(fClusterYPos[pl1][ic1]-fClusterYPos[pl2][ic2]);
+	     diffx= abs(fClusterXPos[pl1*MaxNCluster+ic1]-fClusterXPos[pl2*MaxNCluster+ic2]);
+	     diffy= abs(fClusterYPos[pl1*MaxNCluster+ic1]-fClusterYPos[pl2*MaxNCluster+ic2]);
 	     if ( (ic1==0 && ic2==0) || (diffx <=diffx_test && diffy <=diffy_test)) {
 	       diffx_test=diffx;
 	       diffy_test=diffy;
@@ -1807,8 +1724,8 @@ void THcHodoscope::CalcCluster(void)
             diffx_test=1000;
             diffy_test=1000;
 	    for (Int_t ic1 = 0; ic1 < fNCluster[pl1]; ic1++ ){
-	     diffx= abs(fClusterXPos[pl1][ic1]-fClusterXPos[pl2][best_cluster[pl2]]);
-	     diffy= abs(fClusterYPos[pl1][ic1]-fClusterYPos[pl2][best_cluster[pl2]]);
+	     diffx= abs(fClusterXPos[pl1*MaxNCluster+ic1]-fClusterXPos[pl2*MaxNCluster+best_cluster[pl2]]);
+	     diffy= abs(fClusterYPos[pl1*MaxNCluster+ic1]-fClusterYPos[pl2*MaxNCluster+best_cluster[pl2]]);
 	     if ( (diffx <=diffx_test && diffy <=diffy_test)) {
 	       diffx_test=diffx;
 	       diffy_test=diffy;
@@ -1826,19 +1743,22 @@ void THcHodoscope::CalcCluster(void)
 	   if (best_cluster[npl]==-1) {
 	     cout << " PLane = " << npl+1 << " no best cluster " << endl;
 	   } else {
-	     cout << " plane = " << npl+1 << " xpos = " << fClusterXPos[npl][best_cluster[npl]] << " ypos = " << fClusterYPos[npl][best_cluster[npl]] << endl;
+	     cout << " plane = " << npl+1 << " xpos = " << fClusterXPos[npl*MaxNCluster+best_cluster[npl]] << " ypos = " << fClusterYPos[npl*MaxNCluster+best_cluster[npl]] << endl;
 	   }
 	   */
-	   if (best_cluster[npl]!=-1) fPlanes[npl]->SetScinYPos( fClusterYPos[npl][best_cluster[npl]] );
-	   if (best_cluster[npl]!=-1) fPlanes[npl]->SetScinXPos( fClusterXPos[npl][best_cluster[npl]] );
+	   if (best_cluster[npl]!=-1) fPlanes[npl]->SetScinYPos( fClusterYPos[npl*MaxNCluster+best_cluster[npl]] );
+	   if (best_cluster[npl]!=-1) fPlanes[npl]->SetScinXPos( fClusterXPos[npl*MaxNCluster+best_cluster[npl]] );
 	 }
   //
 }
 //
 void THcHodoscope::TrackEffTest(void)
 {
-  Double_t PadLow[4];
-  Double_t PadHigh[4];
+  // The tests read planes 0 to 3 also when fewer are used for beta,
+  // the missing ones have no clusters
+  const Int_t nplanes = TMath::Max(fNumPlanesBetaCalc,4);
+  vector<Double_t> PadLow(nplanes);
+  vector<Double_t> PadHigh(nplanes);
   // assume X planes are 0,2 and Y planes are 1,3
   PadLow[0]=fxLoScin[0];
   PadLow[2]=fxLoScin[1];
@@ -1851,8 +1771,8 @@ void THcHodoscope::TrackEffTest(void)
   //
   Bool_t efftest_debug = kFALSE;
   if (efftest_debug) cout << " spec = " << GetApparatus()->GetName()[0] << endl;
-  Double_t PadPosLo[4];
-  Double_t PadPosHi[4];
+  vector<Double_t> PadPosLo(nplanes);
+  vector<Double_t> PadPosHi(nplanes);
   for (Int_t ip = 0; ip < fNumPlanesBetaCalc; ip++ ){
     Double_t lowtemp=fPlanes[ip]->GetPosCenter(PadLow[ip]-1)+ fPlanes[ip]->GetPosOffset();
     Double_t hitemp=fPlanes[ip]->GetPosCenter(PadHigh[ip]-1)+ fPlanes[ip]->GetPosOffset();
@@ -1865,64 +1785,51 @@ void THcHodoscope::TrackEffTest(void)
     }
   }  
   //
+  // Clusters are the runs of adjacent paddles with two good times that
+  // FillOccupancy collected.  Past MaxNClus, the last slot holds the
+  // last cluster of the plane.
   const Int_t MaxNClus=5;
-  std::vector<Int_t > iw(MaxNClus,0);
-  std::vector<Double_t > dw(MaxNClus,0);
-  for(Int_t ip = 0; ip < fNumPlanesBetaCalc; ip++ ) {
-    fNClust.push_back(0);
-    fClustSize.push_back(iw);
-    fClustPos.push_back(dw);
-  }
+  vector<Int_t> nclust(nplanes,0);
+  vector<Int_t> clustsize(nplanes*MaxNClus);	// [plane][cluster]
+  vector<Double_t> clustpos(nplanes*MaxNClus);
   for (Int_t ip = 0; ip < fNumPlanesBetaCalc; ip++ ){
-    TClonesArray* hodoHits = fPlanes[ip]->GetHits();
-    Int_t prev_padnum=-100;
-    for (Int_t iphit = 0; iphit < fPlanes[ip]->GetNScinHits(); iphit++ ){
-      THcHodoHit *hit = (THcHodoHit*)hodoHits->At(iphit);
-      Int_t padnum  = hit->GetPaddleNumber();
-      if ( hit->GetTwoGoodTimes() ) {
-	if ( padnum==prev_padnum+1 ) {
-	  fClustSize[ip][fNClust[ip]-1]=fClustSize[ip][fNClust[ip]-1]+1;
-	  fClustPos[ip][fNClust[ip]-1]+=fPlanes[ip]->GetPosCenter(padnum-1)+ fPlanes[ip]->GetPosOffset();
-	   if (efftest_debug) cout << "Add to cluster  pl = " << ip+1 << " hit = " << iphit << " pad = " << padnum << " clus =  " << fNClust[ip] << " cl size = " << fClustSize[ip][fNClust[ip]-1] << " pos " << fPlanes[ip]->GetPosCenter(padnum-1)+ fPlanes[ip]->GetPosOffset() << endl;
-	} else {
-	  if (fNClust[ip]<MaxNClus) fNClust[ip]++;
-	  fClustSize[ip][fNClust[ip]-1]=1;
-	  fClustPos[ip][fNClust[ip]-1]=fPlanes[ip]->GetPosCenter(padnum-1)+ fPlanes[ip]->GetPosOffset();
-	   if (efftest_debug) cout << " New clus pl = " << ip+1 << " hit = " << iphit << " pad = " << padnum << " clus = " << fNClust[ip] << " cl size = " << fClustSize[ip][fNClust[ip]-1] << " pos " << fPlanes[ip]->GetPosCenter(padnum-1)+ fPlanes[ip]->GetPosOffset() << endl;
-	}
-	prev_padnum=padnum;
-      }
-      if (!(hit->GetTwoGoodTimes()) && efftest_debug)  cout << "no two good times  plane = " << ip+1 << " hit = " << iphit << endl;
+    Int_t nc = GetNClusters(ip);
+    for (Int_t ic = 0; ic < nc; ic++ ){
+      const HodoCluster& clus = GetCluster(ip,ic);
+      Int_t slot = TMath::Min(ic,MaxNClus-1);
+      clustsize[ip*MaxNClus+slot] = clus.size;
+      clustpos[ip*MaxNClus+slot] = clus.pos;
+      if (efftest_debug) cout << " clus pl = " << ip+1 << " first pad = " << clus.first+1 << " clus = " << slot+1 << " cl size = " << clus.size << " pos " << clus.pos << endl;
     }
+    nclust[ip] = TMath::Min(nc,MaxNClus);
   }
   //
-  Bool_t inside_bound[4][MaxNClus];
+  vector<Bool_t> inside_bound(nplanes*MaxNClus);
   for(Int_t ip = 0; ip < fNumPlanesBetaCalc; ip++ ) {	 
-    fPlanes[ip]->SetNumberClusters(fNClust[ip]);
-    for(Int_t ic = 0; ic <fNClust[ip] ; ic++ ) {
-      fClustPos[ip][ic]=fClustPos[ip][ic]/fClustSize[ip][ic];
-      fPlanes[ip]->SetCluster(ic,fClustPos[ip][ic]);
-      fPlanes[ip]->SetClusterSize(ic,fClustSize[ip][ic]);
-     inside_bound[ip][ic] = fClustPos[ip][ic]>=PadPosLo[ip] &&  fClustPos[ip][ic]<=PadPosHi[ip];
-      if (efftest_debug) cout << "plane = " << ip+1 << " Cluster = " << ic+1 << " size = " << fClustSize[ip][ic]<< " pos = " << fClustPos[ip][ic] << " inside = " << inside_bound[ip][ic] << " lo = " << PadPosLo[ip]<< " hi = " << PadPosHi[ip]<< endl;
+    fPlanes[ip]->SetNumberClusters(nclust[ip]);
+    for(Int_t ic = 0; ic <nclust[ip] ; ic++ ) {
+      fPlanes[ip]->SetCluster(ic,clustpos[ip*MaxNClus+ic]);
+      fPlanes[ip]->SetClusterSize(ic,clustsize[ip*MaxNClus+ic]);
+     inside_bound[ip*MaxNClus+ic] = clustpos[ip*MaxNClus+ic]>=PadPosLo[ip] &&  clustpos[ip*MaxNClus+ic]<=PadPosHi[ip];
+      if (efftest_debug) cout << "plane = " << ip+1 << " Cluster = " << ic+1 << " size = " << clustsize[ip*MaxNClus+ic]<< " pos = " << clustpos[ip*MaxNClus+ic] << " inside = " << inside_bound[ip*MaxNClus+ic] << " lo = " << PadPosLo[ip]<< " hi = " << PadPosHi[ip]<< endl;
     }
   }
   //
   Int_t MaxClusterSize=3;
-  Int_t good_for_track_test[4][MaxNClus];
-  Int_t sum_good_track_test[4]={0,0,0,0};
+  vector<Int_t> good_for_track_test(nplanes*MaxNClus,0);
+  vector<Int_t> sum_good_track_test(nplanes,0);
   Int_t num_good_plane_hit=0;
   for(Int_t ip = 0; ip < fNumPlanesBetaCalc; ip++ ) {
-    for(Int_t ic = 0; ic <fNClust[ip] ; ic++ ) {
-      if (inside_bound[ip][ic] && fClustSize[ip][ic]<=MaxClusterSize) {
+    for(Int_t ic = 0; ic <nclust[ip] ; ic++ ) {
+      if (inside_bound[ip*MaxNClus+ic] && clustsize[ip*MaxNClus+ic]<=MaxClusterSize) {
          fPlanes[ip]->SetClusterFlag(ic,1.);
-         good_for_track_test[ip][ic]=1;
+         good_for_track_test[ip*MaxNClus+ic]=1;
 	  sum_good_track_test[ip]++;
 	  if (sum_good_track_test[ip]==1) num_good_plane_hit++;
       } else {
-           good_for_track_test[ip][ic]=0;
+           good_for_track_test[ip*MaxNClus+ic]=0;
      }
-      if (efftest_debug) cout << " ip " << ip+1 << " clus = " << ic << " good for track = " << good_for_track_test[ip][ic] << endl;
+      if (efftest_debug) cout << " ip " << ip+1 << " clus = " << ic << " good for track = " << good_for_track_test[ip*MaxNClus+ic] << endl;
     }
     if (efftest_debug) cout << " ip = " << ip+1 << "  sum_good_track_test = " << sum_good_track_test[ip] << endl;
   }	 
@@ -1935,21 +1842,21 @@ void THcHodoscope::TrackEffTest(void)
   if ( (fTrackEffTestNScinPlanes == 4 || fTrackEffTestNScinPlanes == 3) && num_good_plane_hit==4) {
     
     // check for matching clusters in the X planes assumed to be planes 0 and 2
-    for(Int_t ic0 = 0; ic0 <fNClust[0] ; ic0++ ) {
-    for(Int_t ic2 = 0; ic2 <fNClust[2] ; ic2++ ) {
-      if (good_for_track_test[0][ic0] && good_for_track_test[2][ic2]) {
-           Double_t x1_proj = fClustPos[0][ic0]*(1+fRatio_xpfp_to_xfp*(fPlanes[2]->GetZpos()-fPlanes[0]->GetZpos())); // project X1 to X2 Z position
-           xdiffTest= TMath::Abs(x1_proj-fClustPos[2][ic2])<trackeff_scint_xdiff_max;
+    for(Int_t ic0 = 0; ic0 <nclust[0] ; ic0++ ) {
+    for(Int_t ic2 = 0; ic2 <nclust[2] ; ic2++ ) {
+      if (good_for_track_test[ic0] && good_for_track_test[2*MaxNClus+ic2]) {
+           Double_t x1_proj = clustpos[ic0]*(1+fRatio_xpfp_to_xfp*(fPlanes[2]->GetZpos()-fPlanes[0]->GetZpos())); // project X1 to X2 Z position
+           xdiffTest= TMath::Abs(x1_proj-clustpos[2*MaxNClus+ic2])<trackeff_scint_xdiff_max;
           if (xdiffTest) fPlanes[0]->SetClusterUsedFlag(ic0,1.);
           if (xdiffTest) fPlanes[2]->SetClusterUsedFlag(ic2,1.);
       }
     }
     }
     // check for matching clusters in the Y planes assumed to be planes 1 and 3
-    for(Int_t ic1 = 0; ic1 <fNClust[1] ; ic1++ ) {
-    for(Int_t ic3 = 0; ic3 <fNClust[3] ; ic3++ ) {
-       if (good_for_track_test[1][ic1] && good_for_track_test[3][ic3]) {
-           ydiffTest= TMath::Abs(fClustPos[1][ic1]-fClustPos[3][ic3])<trackeff_scint_ydiff_max;
+    for(Int_t ic1 = 0; ic1 <nclust[1] ; ic1++ ) {
+    for(Int_t ic3 = 0; ic3 <nclust[3] ; ic3++ ) {
+       if (good_for_track_test[MaxNClus+ic1] && good_for_track_test[3*MaxNClus+ic3]) {
+           ydiffTest= TMath::Abs(clustpos[MaxNClus+ic1]-clustpos[3*MaxNClus+ic3])<trackeff_scint_ydiff_max;
           if (ydiffTest) fPlanes[1]->SetClusterUsedFlag(ic1,1.);
           if (ydiffTest) fPlanes[3]->SetClusterUsedFlag(ic3,1.);
        }
@@ -1964,10 +1871,10 @@ void THcHodoscope::TrackEffTest(void)
     ydiffTest=kFALSE;
     // Check if two X planes hit
     if (sum_good_track_test[0]>0&&sum_good_track_test[2]>0) {
-       for(Int_t ic0 = 0; ic0 <fNClust[0] ; ic0++ ) {
-       for(Int_t ic2 = 0; ic2 <fNClust[2] ; ic2++ ) {
-         if (good_for_track_test[0][ic0] && good_for_track_test[2][ic2]) {
-          xdiffTest= TMath::Abs(fClustPos[0][ic0]-fClustPos[2][ic2])<trackeff_scint_xdiff_max;
+       for(Int_t ic0 = 0; ic0 <nclust[0] ; ic0++ ) {
+       for(Int_t ic2 = 0; ic2 <nclust[2] ; ic2++ ) {
+         if (good_for_track_test[ic0] && good_for_track_test[2*MaxNClus+ic2]) {
+          xdiffTest= TMath::Abs(clustpos[ic0]-clustpos[2*MaxNClus+ic2])<trackeff_scint_xdiff_max;
          }
        }
        }
@@ -1975,10 +1882,10 @@ void THcHodoscope::TrackEffTest(void)
     }
     // Check if two Y planes hit
     if ((sum_good_track_test[1]>0||sum_good_track_test[3]>0)) {
-    for(Int_t ic1 = 0; ic1 <fNClust[1] ; ic1++ ) {
-    for(Int_t ic3 = 0; ic3 <fNClust[3] ; ic3++ ) {
-       if (good_for_track_test[1][ic1] && good_for_track_test[3][ic3]) {
-           ydiffTest= TMath::Abs(fClustPos[1][ic1]-fClustPos[3][ic3])<trackeff_scint_ydiff_max;
+    for(Int_t ic1 = 0; ic1 <nclust[1] ; ic1++ ) {
+    for(Int_t ic3 = 0; ic3 <nclust[3] ; ic3++ ) {
+       if (good_for_track_test[MaxNClus+ic1] && good_for_track_test[3*MaxNClus+ic3]) {
+           ydiffTest= TMath::Abs(clustpos[MaxNClus+ic1]-clustpos[3*MaxNClus+ic3])<trackeff_scint_ydiff_max;
        }
     }
       xdiffTest = kTRUE;
@@ -2015,7 +1922,6 @@ void THcHodoscope::OriginalTrackEffTest(void)
     for (Int_t iphit = 0; iphit < fNScinHits[ip]; iphit++ ){
       Int_t paddle = ((THcHodoHit*)hodoHits->At(iphit))->GetPaddleNumber()-1;
 
-      fScinHitPaddle[ip][paddle] = 1;
       cout << " hit =  " << iphit+1 << " " << paddle+1   << endl;
     }
   }
@@ -2038,13 +1944,13 @@ void THcHodoscope::OriginalTrackEffTest(void)
   Int_t icount;
   for (Int_t ip = 0; ip < 3; ip +=2 ) {
     icount = 0;
-    if ( fScinHitPaddle[ip][0] == 1 ) icount ++;
+    if ( IsPaddleHit(ip,0) ) icount ++;
     cout << "plane =" << ip <<  "check if paddle 1 hit " << icount << endl;
 
     for (Int_t ipaddle = 0; ipaddle < (Int_t) fNPaddle[ip] - 1; ipaddle++ ){
       // !look for number of clusters of 1 or more hits
-      if ( ( fScinHitPaddle[ip][ipaddle] == 0 ) &&
-	   ( fScinHitPaddle[ip][ipaddle + 1] == 1 ) )
+      if ( !IsPaddleHit(ip,ipaddle) &&
+	   IsPaddleHit(ip,ipaddle + 1) )
 	icount ++;
       cout << " paddle =  " << ipaddle+1 << " " << icount << endl;
  
@@ -2056,9 +1962,9 @@ void THcHodoscope::OriginalTrackEffTest(void)
     for (Int_t ipaddle = 0; ipaddle < (Int_t) fNPaddle[ip] - 2; ipaddle++ ){
       // !look for three or more adjacent hits
 
-      if ( ( fScinHitPaddle[ip][ipaddle] == 1 ) &&
-	   ( fScinHitPaddle[ip][ipaddle + 1] == 1 ) &&
-	   ( fScinHitPaddle[ip][ipaddle + 2] == 1 ) )
+      if ( IsPaddleHit(ip,ipaddle) &&
+	   IsPaddleHit(ip,ipaddle + 1) &&
+	   IsPaddleHit(ip,ipaddle + 2) )
 	icount ++;
     } // Second loop over paddles
     cout << "Three  clusters in plane =  " << ip+1 << " " << icount << endl;
@@ -2077,14 +1983,14 @@ void THcHodoscope::OriginalTrackEffTest(void)
     // Planes ip = 3 = 2Y
 
     icount = 0;
-    if ( fScinHitPaddle[ip][0] == 1 ) icount ++;
+    if ( IsPaddleHit(ip,0) ) icount ++;
     cout << "plane =" << ip <<  "check if paddle 1 hit " << icount << endl;
 
     for (Int_t ipaddle = 0; ipaddle < (Int_t) fNPaddle[ip] - 1; ipaddle++ ){
       //  !look for number of clusters of 1 or more hits
 
-      if ( ( fScinHitPaddle[ip][ipaddle] == 0 ) &&
-	   ( fScinHitPaddle[ip][ipaddle + 1] == 1 ) )
+      if ( !IsPaddleHit(ip,ipaddle) &&
+	   IsPaddleHit(ip,ipaddle + 1) )
 	icount ++;
       cout << " paddle =  " << ipaddle+1 << " " << icount << endl;
 
@@ -2097,9 +2003,9 @@ void THcHodoscope::OriginalTrackEffTest(void)
     for (Int_t ipaddle = 0; ipaddle < (Int_t) fNPaddle[ip] - 2; ipaddle++ ){
       // !look for three or more adjacent hits
 
-      if ( ( fScinHitPaddle[ip][ipaddle] == 1 ) &&
-	   ( fScinHitPaddle[ip][ipaddle + 1] == 1 ) &&
-	   ( fScinHitPaddle[ip][ipaddle + 2] == 1 ) )
+      if ( IsPaddleHit(ip,ipaddle) &&
+	   IsPaddleHit(ip,ipaddle + 1) &&
+	   IsPaddleHit(ip,ipaddle + 2) )
 	icount ++;
 
     } // Second loop over Y paddles
@@ -2126,7 +2032,7 @@ void THcHodoscope::OriginalTrackEffTest(void)
   fHitSweet2Y=0;
   // *first x plane.  first see if there are hits inside the scin region
   for (Int_t ifidx = fxLoScin[0]-1; ifidx < fxHiScin[0]; ifidx ++ ){
-    if ( fScinHitPaddle[0][ifidx] == 1 ){
+    if ( IsPaddleHit(0,ifidx) ){
       fHitSweet1X = 1;
       fSweet1XScin = ifidx + 1;
     }
@@ -2134,45 +2040,45 @@ void THcHodoscope::OriginalTrackEffTest(void)
 
   // *  next make sure nothing fired outside the good region
   for (Int_t ifidx = 0; ifidx < fxLoScin[0]-1; ifidx ++ ){
-    if ( fScinHitPaddle[0][ifidx] == 1 ){ fHitSweet1X = -1; }
+    if ( IsPaddleHit(0,ifidx) ){ fHitSweet1X = -1; }
   }
   for (Int_t ifidx = fxHiScin[0]; ifidx < (Int_t) fNPaddle[0]; ifidx ++ ){
-    if ( fScinHitPaddle[0][ifidx] == 1 ){ fHitSweet1X = -1; }
+    if ( IsPaddleHit(0,ifidx) ){ fHitSweet1X = -1; }
   }
 
   // *second x plane.  first see if there are hits inside the scin region
   for (Int_t ifidx = fxLoScin[1]-1; ifidx < fxHiScin[1]; ifidx ++ ){
-    if ( fScinHitPaddle[2][ifidx] == 1 ){
+    if ( IsPaddleHit(2,ifidx) ){
       fHitSweet2X = 1;
       fSweet2XScin = ifidx + 1;
     }
   }
   // *  next make sure nothing fired outside the good region
   for (Int_t ifidx = 0; ifidx < fxLoScin[1]-1; ifidx ++ ){
-    if ( fScinHitPaddle[2][ifidx] == 1 ){ fHitSweet2X = -1; }
+    if ( IsPaddleHit(2,ifidx) ){ fHitSweet2X = -1; }
   }
   for (Int_t ifidx = fxHiScin[1]; ifidx < (Int_t) fNPaddle[2]; ifidx ++ ){
-    if ( fScinHitPaddle[2][ifidx] == 1 ){ fHitSweet2X = -1; }
+    if ( IsPaddleHit(2,ifidx) ){ fHitSweet2X = -1; }
   }
 
   // *first y plane.  first see if there are hits inside the scin region
   for (Int_t ifidx = fyLoScin[0]-1; ifidx < fyHiScin[0]; ifidx ++ ){
-    if ( fScinHitPaddle[1][ifidx] == 1 ){
+    if ( IsPaddleHit(1,ifidx) ){
       fHitSweet1Y = 1;
       fSweet1YScin = ifidx + 1;
     }
   }
   // *  next make sure nothing fired outside the good region
   for (Int_t ifidx = 0; ifidx < fyLoScin[0]-1; ifidx ++ ){
-    if ( fScinHitPaddle[1][ifidx] == 1 ){ fHitSweet1Y = -1; }
+    if ( IsPaddleHit(1,ifidx) ){ fHitSweet1Y = -1; }
   }
   for (Int_t ifidx = fyHiScin[0]; ifidx < (Int_t) fNPaddle[1]; ifidx ++ ){
-    if ( fScinHitPaddle[1][ifidx] == 1 ){ fHitSweet1Y = -1; }
+    if ( IsPaddleHit(1,ifidx) ){ fHitSweet1Y = -1; }
   }
 
   // *second y plane.  first see if there are hits inside the scin region
   for (Int_t ifidx = fyLoScin[1]-1; ifidx < fyHiScin[1]; ifidx ++ ){
-    if ( fScinHitPaddle[3][ifidx] == 1 ){
+    if ( IsPaddleHit(3,ifidx) ){
       fHitSweet2Y = 1;
       fSweet2YScin = ifidx + 1;
     }
@@ -2180,10 +2086,10 @@ void THcHodoscope::OriginalTrackEffTest(void)
 
   // *  next make sure nothing fired outside the good region
   for (Int_t ifidx = 0; ifidx < fyLoScin[1]-1; ifidx ++ ){
-    if ( fScinHitPaddle[3][ifidx] == 1 ){ fHitSweet2Y = -1; }
+    if ( IsPaddleHit(3,ifidx) ){ fHitSweet2Y = -1; }
   }
   for (Int_t ifidx = fyHiScin[1]; ifidx < (Int_t) fNPaddle[3]; ifidx ++ ){
-    if ( fScinHitPaddle[3][ifidx] == 1 ){ fHitSweet2Y = -1; }
+    if ( IsPaddleHit(3,ifidx) ){ fHitSweet2Y = -1; }
   }
 
   fTestSum = fHitSweet1X + fHitSweet2X + fHitSweet1Y + fHitSweet2Y;
@@ -2283,11 +2189,282 @@ Double_t THcHodoscope::GetPathLengthCentral() {
   return fPathLengthCentral;
 }
 
+//_____________________________________________________________________________
+Int_t THcHodoscope::FillTOFHitTable()
+{
+  // Tabulate the hits of the planes used for beta, in plane order, with
+  // the paddle geometry and the parts of the time corrections that do
+  // not depend on the track.  Returns the number of hits, or -1 if a
+  // plane other than the first four has hits.
+  Int_t ih = 0;
+  for(Int_t ip = 0; ip < fNumPlanesBetaCalc; ip++ ) {
+    THcScintillatorPlane* plane = fPlanes[ip];
+    Int_t nphits = plane->GetNScinHits();
+    if ( nphits > 0 && ip > 3 ) return -1;
+    TClonesArray* hodoHits = plane->GetHits();
+    Double_t zPos = plane->GetZpos();
+    Double_t dzPos = plane->GetDzpos();
+    Double_t halfWidth = plane->GetSize() * 0.5 + plane->GetHodoSlop();
+
+    for (Int_t iphit = 0; iphit < nphits; iphit++, ih++ ){
+      THcHodoHit *hit = (THcHodoHit*)hodoHits->At(iphit);
+      Int_t paddle = hit->GetPaddleNumber()-1;
+      // Index to access the 2d arrays of paddle/scintillator properties
+      Int_t fPIndex = GetScinIndex(ip,paddle);
+
+      fTOFHits.hit[ih] = hit;
+      fTOFHits.plane[ih] = ip;
+      fTOFHits.hitInPlane[ih] = iphit;
+      fTOFHits.paddle[ih] = paddle;
+      fTOFHits.z[ih] = zPos + (paddle%2)*dzPos;
+      fTOFHits.center[ih] = plane->GetPosCenter(paddle) + plane->GetPosOffset();
+      fTOFHits.halfWidth[ih] = halfWidth;
+
+      UChar_t flags = ( ip%2 == 0 ) ? kTOFXPlane : 0; // x planes are 0 and 2
+      Double_t tdc_pos = hit->GetPosTDC();
+      Double_t tdc_neg = hit->GetNegTDC();
+      if ( tdc_pos >=fScinTdcMin && tdc_pos <= fScinTdcMax ) flags |= kTOFPosTdc;
+      if ( tdc_neg >=fScinTdcMin && tdc_neg <= fScinTdcMax ) flags |= kTOFNegTdc;
+      fTOFHits.flags[ih] = flags;
+
+      if ( (flags & kTOFPosTdc) && (flags & kTOFNegTdc) ) {
+	fTOFHits.posTime[ih] = hit->GetPosCorrectedTime();
+	fTOFHits.negTime[ih] = hit->GetNegCorrectedTime();
+      } else if (fTrackBetaIncludeSinglePmtHits==1) {
+	fTOFHits.posTime[ih] = tdc_pos*fScinTdcToTime;
+	fTOFHits.negTime[ih] = tdc_neg*fScinTdcToTime;
+	if ( flags & kTOFPosTdc ) {
+	  if(fTofUsingInvAdc) {
+	    fTOFHits.posOffset[ih] = fHodoPosInvAdcOffset[fPIndex];
+	    fTOFHits.posSlope[ih] = fHodoPosInvAdcLinear[fPIndex];
+	    fTOFHits.posAdcTerm[ih] = fHodoPosInvAdcAdc[fPIndex]
+	      /TMath::Sqrt(TMath::Max(20.0*.020,hit->GetPosADC()));
+	  } else {
+	    Double_t adcamp_pos = hit->GetPosADCpeak();
+	    Double_t tw_corr_pos=0.;
+	    if (adcamp_pos>0) tw_corr_pos = 1./pow(adcamp_pos/fTdc_Thrs,fHodoPos_c2[fPIndex]) -  1./pow(200./fTdc_Thrs, fHodoPos_c2[fPIndex]);
+	    fTOFHits.posOffset[ih] = -tw_corr_pos + fHodo_LCoeff[fPIndex];
+	    fTOFHits.posSlope[ih] = fHodoVelFit[fPIndex];
+	  }
+	}
+	if ( flags & kTOFNegTdc ) {
+	  if(fTofUsingInvAdc) {
+	    fTOFHits.negOffset[ih] = fHodoNegInvAdcOffset[fPIndex];
+	    fTOFHits.negSlope[ih] = fHodoNegInvAdcLinear[fPIndex];
+	    fTOFHits.negAdcTerm[ih] = fHodoNegInvAdcAdc[fPIndex]
+	      /TMath::Sqrt(TMath::Max(20.0*.020,hit->GetNegADC()));
+	  } else {
+	    Double_t adcamp_neg = hit->GetNegADCpeak();
+	    Double_t tw_corr_neg =0 ;
+	    if (adcamp_neg >0) tw_corr_neg= 1./pow(adcamp_neg/fTdc_Thrs,fHodoNeg_c2[fPIndex]) -  1./pow(200./fTdc_Thrs, fHodoNeg_c2[fPIndex]);
+	    fTOFHits.negOffset[ih] = -tw_corr_neg- 2*fHodoCableFit[fPIndex] + fHodo_LCoeff[fPIndex];
+	    fTOFHits.negSlope[ih] = fHodoVelFit[fPIndex];
+	  }
+	}
+      }
+
+      Double_t* sigma = &fTOFHits.sigma[3*ih];
+      if (fTofUsingInvAdc) {
+	sigma[0] = TMath::Sqrt( fHodoPosSigma[fPIndex] * fHodoPosSigma[fPIndex] +
+				fHodoNegSigma[fPIndex] * fHodoNegSigma[fPIndex] )/2.;
+	sigma[1] = fHodoPosSigma[fPIndex];
+	sigma[2] = fHodoNegSigma[fPIndex];
+      } else {
+	sigma[0] = TMath::Sqrt( fHodoSigmaPos[fPIndex] * fHodoSigmaPos[fPIndex] +
+				fHodoSigmaNeg[fPIndex] * fHodoSigmaNeg[fPIndex] )/2.;
+	sigma[1] = fHodoSigmaPos[fPIndex];
+	sigma[2] = fHodoSigmaNeg[fPIndex];
+      }
+      Double_t* dedx = &fTOFHits.dedx[3*ih];
+      dedx[0] = TMath::Sqrt( TMath::Max( 0., hit->GetPosADC() * hit->GetNegADC() ) );
+      dedx[1] = TMath::Max( 0., hit->GetPosADC() );
+      dedx[2] = TMath::Max( 0., hit->GetNegADC() );
+    }
+  }
+  return ih;
+}
+
+//_____________________________________________________________________________
+void THcHodoscope::ProjectTracks(Int_t ntracks, Int_t nhits)
+{
+  // Project all tracks of the track table onto all hits of the hit table
+  // and fill the [track][hit] columns: whether the hit is on the track
+  // and its times corrected for the position on the bar (scin_*_time)
+  // and also for the flight time (time_*).
+  for ( Int_t itrack = 0; itrack < ntracks; itrack++ ) {
+    Double_t x = fTOFTracks.x[itrack];
+    Double_t y = fTOFTracks.y[itrack];
+    Double_t theta = fTOFTracks.theta[itrack];
+    Double_t phi = fTOFTracks.phi[itrack];
+    Double_t pathNorm = fTOFTracks.pathNorm[itrack];
+    Double_t zcorDenom = fTOFTracks.zcorDenom[itrack];
+    UChar_t* tofflags = &fTOFFlags[itrack*fArenaHitsPerTrack];
+    Double_t* time_pos = &fTOFTimePos[itrack*fArenaHitsPerTrack];
+    Double_t* time_neg = &fTOFTimeNeg[itrack*fArenaHitsPerTrack];
+    Double_t* scin_pos_time = &fTOFScinPosTime[itrack*fArenaHitsPerTrack];
+    Double_t* scin_neg_time = &fTOFScinNegTime[itrack*fArenaHitsPerTrack];
+
+    for (Int_t ih = 0; ih < nhits; ih++ ) {
+      UChar_t hitflags = fTOFHits.flags[ih];
+      Double_t zposition = fTOFHits.z[ih];
+      Double_t xHitCoord = x + theta * zposition;
+      Double_t yHitCoord = y + phi * zposition;
+      Bool_t xplane = ( hitflags & kTOFXPlane );
+      Double_t scinTrnsCoord = xplane ? xHitCoord : yHitCoord;
+      Double_t scinLongCoord = xplane ? yHitCoord : xHitCoord;
+
+      tofflags[ih] = 0;
+      time_pos[ih] = time_neg[ih] = -99.0;
+      scin_pos_time[ih] = scin_neg_time[ih] = 0.0;
+      if ( !( TMath::Abs( fTOFHits.center[ih] - scinTrnsCoord ) <
+	      fTOFHits.halfWidth[ih] ) ) continue;
+
+      tofflags[ih] = kTOFOnTrack;
+      // The times are corrected with zcor of the particle hypothesis also
+      // for cosmics, only fTOFPInfo gets the cosmic zcor (see FillTOFPInfo)
+      Double_t zcor = zposition/zcorDenom*pathNorm;
+      if ( (hitflags & kTOFPosTdc) && (hitflags & kTOFNegTdc) ) {
+	scin_pos_time[ih] = fTOFHits.posTime[ih];
+	time_pos[ih] = fTOFHits.posTime[ih]-zcor;
+	scin_neg_time[ih] = fTOFHits.negTime[ih];
+	time_neg[ih] = fTOFHits.negTime[ih]-zcor;
+	tofflags[ih] |= kTOFHasPos | kTOFHasNeg;
+      } else if (fTrackBetaIncludeSinglePmtHits==1) {
+	Int_t ip = fTOFHits.plane[ih];
+	if ( hitflags & kTOFPosTdc ) {
+	  Double_t timep = fTOFHits.posTime[ih];
+	  if(fTofUsingInvAdc) {
+	    Double_t pathp = fPlanes[ip]->GetPosLeft() - scinLongCoord;
+	    timep -= fTOFHits.posOffset[ih] + pathp/fTOFHits.posSlope[ih]
+	      + fTOFHits.posAdcTerm[ih];
+	  } else {
+	    timep += fTOFHits.posOffset[ih] + scinLongCoord/fTOFHits.posSlope[ih];
+	  }
+	  scin_pos_time[ih] = timep;
+	  time_pos[ih] = timep - zcor;
+	  tofflags[ih] |= kTOFHasPos;
+	}
+	if ( hitflags & kTOFNegTdc ) {
+	  Double_t timen = fTOFHits.negTime[ih];
+	  if(fTofUsingInvAdc) {
+	    Double_t pathn = scinLongCoord - fPlanes[ip]->GetPosRight();
+	    timen -= fTOFHits.negOffset[ih] + pathn/fTOFHits.negSlope[ih]
+	      + fTOFHits.negAdcTerm[ih];
+	  } else {
+	    timen += fTOFHits.negOffset[ih] - scinLongCoord/fTOFHits.negSlope[ih];
+	  }
+	  scin_neg_time[ih] = timen;
+	  time_neg[ih] = timen - zcor;
+	  tofflags[ih] |= kTOFHasNeg;
+	}
+      }
+    }
+  }
+}
+
+//_____________________________________________________________________________
+void THcHodoscope::FillTOFPInfo(Int_t itrack, Int_t nhits)
+{
+  // Copy the columns of track itrack to fTOFPInfo, with the track
+  // coordinates at the paddles, for FineProcess and the TOF dump.
+  // keep_pos/keep_neg are set by CoarseProcess.
+  Int_t base = itrack*fArenaHitsPerTrack;
+  for (Int_t ih = 0; ih < nhits; ih++ ) {
+    TOFPInfo& info = fTOFPInfo[ih];
+    info = TOFPInfo();
+    Int_t ip = fTOFHits.plane[ih];
+    UChar_t hitflags = fTOFHits.flags[ih];
+    info.hit = fTOFHits.hit[ih];
+    info.planeIndex = ip;
+    info.hitNumInPlane = fTOFHits.hitInPlane[ih];
+
+    Double_t zposition = fTOFHits.z[ih];
+    Double_t xHitCoord = fTOFTracks.x[itrack] + fTOFTracks.theta[itrack] * zposition;
+    Double_t yHitCoord = fTOFTracks.y[itrack] + fTOFTracks.phi[itrack] * zposition;
+    Bool_t xplane = ( hitflags & kTOFXPlane );
+    info.scinTrnsCoord = xplane ? xHitCoord : yHitCoord;
+    info.scinLongCoord = xplane ? yHitCoord : xHitCoord;
+
+    info.onTrack = ( fTOFFlags[base+ih] & kTOFOnTrack );
+    info.time_pos = fTOFTimePos[base+ih];
+    info.time_neg = fTOFTimeNeg[base+ih];
+    info.scin_pos_time = fTOFScinPosTime[base+ih];
+    info.scin_neg_time = fTOFScinNegTime[base+ih];
+    if ( info.onTrack ) {
+      if (fCosmicFlag)
+	info.zcor = -zposition/(29.979*1.0)*fTOFTracks.pathNorm[itrack];
+      else
+	info.zcor = zposition/fTOFTracks.zcorDenom[itrack]*fTOFTracks.pathNorm[itrack];
+      if ( !( (hitflags & kTOFPosTdc) && (hitflags & kTOFNegTdc) ) &&
+	   fTrackBetaIncludeSinglePmtHits==1 ) {
+	if ( hitflags & kTOFPosTdc )
+	  info.pathp = fPlanes[ip]->GetPosLeft() - info.scinLongCoord;
+	if ( hitflags & kTOFNegTdc )
+	  info.pathn = info.scinLongCoord - fPlanes[ip]->GetPosRight();
+      }
+    }
+  }
+}
+
+//_____________________________________________________________________________
+void THcHodoscope::ResizeArenas(Int_t ntracks, Int_t nhitsperplane)
+{
+  // Grow the per-event arenas used by CoarseProcess so that they hold
+  // ntracks tracks with up to nhitsperplane hits in each plane.
+  // The arenas never shrink, so reallocation only happens the first
+  // time an event exceeds the previous maximum.
+  if(ntracks <= fArenaTracks && nhitsperplane <= fArenaHitsPerPlane) return;
+
+  fArenaTracks = TMath::Max(ntracks, fArenaTracks);
+  fArenaHitsPerPlane = TMath::Max(nhitsperplane, fArenaHitsPerPlane);
+  fArenaHitsPerTrack = fNPlanes*fArenaHitsPerPlane;
+
+  fTOFPInfo.resize(fArenaHitsPerTrack);
+  fTOFCalc.resize(fArenaHitsPerTrack);
+  fdEdX.resize(fArenaTracks*fArenaHitsPerTrack);
+  fGoodFlags.resize(fArenaTracks*fArenaHitsPerTrack);
+  fNArenaAllocs += 4;
+
+  // Column tables of the batched TOF/beta fit
+  fNArenaAllocs += fTOFHits.Resize(fArenaHitsPerTrack);
+  fNArenaAllocs += fTOFTracks.Resize(fArenaTracks);
+  fTOFFlags.resize(fArenaTracks*fArenaHitsPerTrack);
+  fTOFTimePos.resize(fArenaTracks*fArenaHitsPerTrack);
+  fTOFTimeNeg.resize(fArenaTracks*fArenaHitsPerTrack);
+  fTOFScinPosTime.resize(fArenaTracks*fArenaHitsPerTrack);
+  fTOFScinNegTime.resize(fArenaTracks*fArenaHitsPerTrack);
+  fTOFFitZ.resize(fArenaHitsPerTrack);
+  fTOFFitTime.resize(fArenaHitsPerTrack);
+  fTOFFitSigma.resize(fArenaHitsPerTrack);
+  fNArenaAllocs += 8;
+}
+
 //_____________________________________________________________________________
 Int_t THcHodoscope::End(THaRunBase* run)
 {
   MissReport(Form("%s.%s", GetApparatus()->GetName(), GetName()));
+  if(fDebug >= 1 && fNArenaEvents > 0) {
+    cout << GetApparatus()->GetName() << "." << GetName()
+	 << " CoarseProcess arena allocations per event: "
+	 << Form("%.3f", (Double_t)fNArenaAllocs/fNArenaEvents) << endl;
+  }
   return 0;
 }
+
+//_____________________________________________________________________________
+void THcHodoscope::AccountMemory( THcMemoryReport& report ) const
+{
+  // Raw hits, the planes and the CoarseProcess arenas, which grow with
+  // the largest number of hits times tracks
+  THcHitList::AccountMemory(report);
+  for(Int_t ip=0;ip<fNPlanes;ip++) fPlanes[ip]->AccountMemory(report);
+  Long64_t bytes = THcMemoryReport::Bytes(fTOFPInfo) + THcMemoryReport::Bytes(fTOFCalc)
+    + fTOFHits.Bytes() + fTOFTracks.Bytes() + THcMemoryReport::Bytes(fTOFFlags)
+    + THcMemoryReport::Bytes(fTOFTimePos) + THcMemoryReport::Bytes(fTOFTimeNeg)
+    + THcMemoryReport::Bytes(fTOFScinPosTime) + THcMemoryReport::Bytes(fTOFScinNegTime)
+    + THcMemoryReport::Bytes(fTOFFitZ) + THcMemoryReport::Bytes(fTOFFitTime)
+    + THcMemoryReport::Bytes(fTOFFitSigma);
+  report.Add("TOF arenas", bytes, THcMemoryReport::kDynamic);
+}
 ClassImp(THcHodoscope)
 ////////////////////////////////////////////////////////////////////////////////
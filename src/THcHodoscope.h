@@ -33,6 +33,7 @@
 
 
 class THaScCalib;
+class THaTrack;
 
 class THcHodoscope : public THaNonTrackingDetector, public THcHitList {
 
@@ -48,6 +49,7 @@ public:
   virtual Int_t      CoarseProcess( TClonesArray& tracks );
   virtual Int_t      FineProcess( TClonesArray& tracks );
   virtual Int_t      End(THaRunBase* run=0);
+  virtual void       AccountMemory( THcMemoryReport& report ) const;
 
   Double_t DetermineTimePeak(Int_t FillFlag);
   void EstimateFocalPlaneTime(void);
@@ -105,7 +107,7 @@ public:
   Int_t GetGoodRawPad(Int_t iii){return fTOFCalc[iii].good_raw_pad;}
   Int_t GetGoodRawPlane(Int_t iii){return fTOFCalc[iii].pindex;}
   Int_t GetNScinHits(Int_t iii){return fNScinHits[iii];}
-  Int_t GetTotHits(){return fTOFCalc.size();}
+  Int_t GetTotHits(){return fNTOFHits;}
 
   Int_t GetNPlanes() { return fNPlanes;}
   THcScintillatorPlane* GetPlane(Int_t ip) { return fPlanes[ip];}
@@ -126,15 +128,51 @@ public:
   Bool_t GetFlags(Int_t itrack, Int_t iplane, Int_t ihit,
 		  Bool_t& onTrack, Bool_t& goodScinTime,
 		  Bool_t& goodTdcNeg, Bool_t& goodTdcPos) const {
-    onTrack = fGoodFlags[itrack][iplane][ihit].onTrack;
-    goodScinTime = fGoodFlags[itrack][iplane][ihit].goodScinTime;
-    goodTdcNeg = fGoodFlags[itrack][iplane][ihit].goodTdcNeg;
-    goodTdcPos = fGoodFlags[itrack][iplane][ihit].goodTdcPos;
+    const GoodFlags& flags = fGoodFlags[GoodFlagsIndex(itrack,iplane,ihit)];
+    onTrack = flags.onTrack;
+    goodScinTime = flags.goodScinTime;
+    goodTdcNeg = flags.goodTdcNeg;
+    goodTdcPos = flags.goodTdcPos;
     return(kTRUE);
   }
 
   const TClonesArray* GetTrackHits() const { return fTrackProj; }
 
+  // Paddle occupancy of the current event, built at the end of Decode.
+  // Paddles are counted from 0.
+  enum EOccupancy { kOccAny = 0,	// any hit on the paddle
+		    kOccBothEnds,	// corrected times on both ends
+		    kOccTwoGoodTimes,	// both times in the focal plane peak
+		    kOccPosTdc,		// good TDC on the positive end
+		    kOccNegTdc,		// good TDC on the negative end
+		    kOccPosAdc,		// good ADC on the positive end
+		    kOccNegAdc,		// good ADC on the negative end
+		    kNOccupancy };
+  struct HodoCluster {		// Run of adjacent kOccTwoGoodTimes paddles
+    Int_t    first;		// first paddle
+    Int_t    size;		// # paddles
+    Double_t pos;		// mean paddle center
+  };
+  Bool_t IsPaddleHit(Int_t ip, Int_t ipad, Int_t kind=kOccAny) const {
+    if( ip < 0 || ip >= fNPlanes || ipad < 0 || ipad >= (Int_t)fMaxScinPerPlane
+	|| kind < 0 || kind >= kNOccupancy || fOccupancy.empty() )
+      return kFALSE;
+    const ULong64_t* w = OccupancyWords(ip,kind);
+    return (w[ipad>>6] >> (ipad&63)) & 1;
+  }
+  Int_t  GetPaddleDistance(Int_t ip, Int_t ipad, Int_t kind=kOccAny) const;
+  Int_t  GetFirstHitPaddle(Int_t ip, Int_t lo, Int_t hi,
+			   Int_t kind=kOccAny) const;
+  Int_t  GetPaddleHitIndex(Int_t ip, Int_t ipad) const {
+    return IsPaddleHit(ip,ipad) ? fPaddleHit[ip*fMaxScinPerPlane+ipad] : -1;
+  }
+  Int_t  GetNClusters(Int_t ip) const {
+    return fFirstCluster[ip+1]-fFirstCluster[ip];
+  }
+  const HodoCluster& GetCluster(Int_t ip, Int_t ic) const {
+    return fClusters[fFirstCluster[ip]+ic];
+  }
+
   friend class THaScCalib;
 
   THcHodoscope();  // for ROOT I/O
@@ -358,7 +396,7 @@ protected:
 		  time_pos(-99.0), time_neg(-99.0), scin_pos_time(0.0),
 		  scin_neg_time(0.0) {}
   };
-  std::vector<TOFPInfo> fTOFPInfo;
+  std::vector<TOFPInfo> fTOFPInfo;	// Arena over hits, filled for the last track
 
   // Used to hold information about all hits within the hodoscope for the TOF
   struct TOFCalc {
@@ -375,20 +413,91 @@ protected:
     TOFCalc() : good_scin_time(kFALSE), good_tdc_pos(kFALSE),
 		good_tdc_neg(kFALSE) {}
   };
-  std::vector<TOFCalc> fTOFCalc;
-    // This doesn't work because we clear this structure each track
-    // Do we need an vector of vectors of structures?
-    // Start with a separate vector of vectors for now.
-  std::vector<std::vector<Double_t> > fdEdX;	        // Vector over track #
+  std::vector<TOFCalc> fTOFCalc;	// Arena over hits, filled for the last track
+  Int_t fNTOFHits;			// # entries of fTOFPInfo/fTOFCalc in use
+
+  // Column tables of the batched TOF/beta fit in CoarseProcess.  The
+  // hits of the beta planes are tabulated once per event with everything
+  // that does not depend on the track, the tracks once with what the
+  // projection needs, and the track dependent times go to flat
+  // [track][hit] columns.
+  enum { kTOFPosTdc = 1, kTOFNegTdc = 2, kTOFXPlane = 4, // Hit table
+	 kTOFOnTrack = 8, kTOFHasPos = 16, kTOFHasNeg = 32 };	// Per track
+  struct TOFHitTable {
+    std::vector<THcHodoHit*> hit;
+    std::vector<Int_t>    plane;
+    std::vector<Int_t>    hitInPlane;
+    std::vector<Int_t>    paddle;
+    std::vector<UChar_t>  flags;	// kTOFPosTdc|kTOFNegTdc|kTOFXPlane
+    std::vector<Double_t> z;		// Paddle z, including the stagger
+    std::vector<Double_t> center;	// Paddle center plus plane offset
+    std::vector<Double_t> halfWidth;	// Half paddle size plus slop
+    std::vector<Double_t> posTime;	// Corrected times if both TDCs are
+    std::vector<Double_t> negTime;	// good, else TDC times of single PMTs
+    std::vector<Double_t> posOffset;	// Single PMT corrections that do not
+    std::vector<Double_t> negOffset;	// depend on the track
+    std::vector<Double_t> posSlope;	// Divides the path along the paddle
+    std::vector<Double_t> negSlope;
+    std::vector<Double_t> posAdcTerm;	// Inverse ADC amplitude term
+    std::vector<Double_t> negAdcTerm;
+    std::vector<Double_t> sigma;	// [3*hit] both ends, pos only, neg only
+    std::vector<Double_t> dedx;		// [3*hit] same
+    Int_t Resize(Int_t n) {
+      hit.resize(n); plane.resize(n); hitInPlane.resize(n); paddle.resize(n);
+      flags.resize(n); z.resize(n); center.resize(n);
+      halfWidth.resize(n); posTime.resize(n); negTime.resize(n);
+      posOffset.resize(n); negOffset.resize(n); posSlope.resize(n);
+      negSlope.resize(n); posAdcTerm.resize(n); negAdcTerm.resize(n);
+      sigma.resize(3*n); dedx.resize(3*n);
+      return 18;		// # columns
+    }
+    Long64_t Bytes() const {
+      return (Long64_t)hit.capacity()*(sizeof(THcHodoHit*)+3*sizeof(Int_t)
+				       +sizeof(UChar_t)+11*sizeof(Double_t))
+	+ (Long64_t)(sigma.capacity()+dedx.capacity())*sizeof(Double_t);
+    }
+  };
+  TOFHitTable fTOFHits;
+  struct TOFTrackTable {
+    std::vector<THaTrack*> track;
+    std::vector<Double_t> x;
+    std::vector<Double_t> y;
+    std::vector<Double_t> theta;
+    std::vector<Double_t> phi;
+    std::vector<Double_t> pathNorm;	// sqrt(1+theta^2+phi^2)
+    std::vector<Double_t> zcorDenom;	// 29.979*beta of the particle hypothesis
+    Int_t Resize(Int_t n) {
+      track.resize(n); x.resize(n); y.resize(n); theta.resize(n);
+      phi.resize(n); pathNorm.resize(n); zcorDenom.resize(n);
+      return 7;
+    }
+    Long64_t Bytes() const {
+      return (Long64_t)track.capacity()*(sizeof(THaTrack*)+6*sizeof(Double_t));
+    }
+  };
+  TOFTrackTable fTOFTracks;
+  // Flat [track][hit] columns, see TOFPInfo for the times
+  std::vector<UChar_t>  fTOFFlags;	// kTOFOnTrack|kTOFHasPos|kTOFHasNeg
+  std::vector<Double_t> fTOFTimePos;
+  std::vector<Double_t> fTOFTimeNeg;
+  std::vector<Double_t> fTOFScinPosTime;
+  std::vector<Double_t> fTOFScinNegTime;
+  // Good time measurements of the track being fit
+  std::vector<Double_t> fTOFFitZ;
+  std::vector<Double_t> fTOFFitTime;
+  std::vector<Double_t> fTOFFitSigma;
+  Int_t FillTOFHitTable();
+  void  ProjectTracks(Int_t ntracks, Int_t nhits);
+  void  FillTOFPInfo(Int_t itrack, Int_t nhits);
+  // Flat [track][hit] array of dE/dx of the good hits on each track
+  std::vector<Double_t> fdEdX;
   std::vector<Int_t > fNScinHit;		        // # scins hit for the track
-  std::vector<std::vector<Int_t> > fScinHitPaddle;	// Vector over hits in a plane #
   std::vector<Int_t > fNClust;		                // # scins clusters for the plane
-  std::vector<std::vector<Int_t> > fClustSize;		                // # scin cluster size
-  std::vector<std::vector<Double_t> > fClustPos;		                // # scin cluster position
-  std::vector<Int_t > fNCluster;		                // # scins clusters for the plane
-  std::vector<std::vector<Int_t> > fClusterSize;		                // # scin cluster size
-  std::vector<std::vector<Double_t> > fClusterXPos;		                // # scin cluster position
-  std::vector<std::vector<Double_t> > fClusterYPos;		                // # scin cluster position
+  enum { kMaxNCluster = 5 };                            // Max # clusters per plane
+  Int_t* fNCluster;		                        // [fNPlanes] # scins clusters for the plane
+  Int_t* fClusterSize;		                        // scin cluster size, index plane*kMaxNCluster+cluster
+  Double_t* fClusterXPos;		                // scin cluster position, same indexing
+  Double_t* fClusterYPos;		                // scin cluster position, same indexing
   std::vector<Int_t > fThreeScin;	                // # scins three clusters for the plane
   std::vector<Int_t > fGoodScinHitsX;                   // # hits in fid x range
   // Could combine the above into a structure
@@ -401,7 +510,38 @@ protected:
     GoodFlags() : onTrack(false), goodScinTime(false),
 		  goodTdcNeg(false), goodTdcPos(false) {}
   };
-  std::vector<std::vector<std::vector<GoodFlags> > > fGoodFlags;
+  // Flat [track][plane][hit] array, see GoodFlagsIndex
+  std::vector<GoodFlags> fGoodFlags;
+  Int_t GoodFlagsIndex(Int_t itrack, Int_t iplane, Int_t ihit) const {
+    return (itrack*fNPlanes+iplane)*fArenaHitsPerPlane+ihit;
+  }
+
+  // Sizes of the per-event arenas above.  They are allocated in Init
+  // and only grown by ResizeArenas when an event does not fit.  The
+  // nested vectors they replace made 22 heap allocations per event with
+  // one track, 34 with three and 46 with five (container operations of
+  // Clear, CoarseProcess, TrackEffTest and CalcCluster replayed
+  // standalone with a counting operator new).
+  Int_t fArenaTracks;
+  Int_t fArenaHitsPerPlane;
+  Int_t fArenaHitsPerTrack;
+  void  ResizeArenas(Int_t ntracks, Int_t nhitsperplane);
+  Long64_t fNArenaEvents;	// # events through CoarseProcess
+  Long64_t fNArenaAllocs;	// # arena (re)allocations
+
+  // Occupancy bitmaps, flat [plane][kind][word] with fOccWords 64-bit
+  // words per plane and kind, and the hit index of each occupied paddle,
+  // flat [plane][paddle].  Filled by FillOccupancy for every event.
+  std::vector<ULong64_t>   fOccupancy;
+  std::vector<Int_t>       fPaddleHit;
+  Int_t                    fOccWords;
+  std::vector<HodoCluster> fClusters;		// All planes, in plane order
+  std::vector<Int_t>       fFirstCluster;	// [fNPlanes+1] offsets into fClusters
+  const ULong64_t* OccupancyWords(Int_t ip, Int_t kind) const {
+    return &fOccupancy[(ip*kNOccupancy+kind)*fOccWords];
+  }
+  void  FillOccupancy();
+  void  ClearOccupancy();
   //
 
   void           DeleteArrays();
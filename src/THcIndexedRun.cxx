@@ -0,0 +1,201 @@
+/** \class THcIndexedRun
+    \ingroup Base
+
+\brief CODA run that reads a range of events through a THcCodaIndex.
+
+THcIndexedRun is used in place of THcRun to replay part of a run.  It
+loads the index of the file (building and saving it the first time)
+and reads only the events of the range, so starting late in a run costs
+nothing.  The control events (types 16-31) and configuration events
+(type 125) before the range are returned first, since the analysis needs
+them to set up decoding, as THcRun does while skipping.
+
+    THcIndexedRun* run = new THcIndexedRun("raw/shms_all_01234.dat");
+    run->SetIndexRange(900000);              // From the 900000th event on
+    analyzer->Process(run);
+
+Independent readers can replay the ranges of THcCodaIndex::Split in
+separate processes; examples/indexedreplay.C shows how.  SkipEvents
+(resuming from a THcCheckpoint) moves the start of the range forward
+without reading the skipped events.  SetReadAhead reads the range in a
+separate thread, as for THcRun.
+*/
+#include "THcIndexedRun.h"
+#include "THcCodaIndex.h"
+#include "TMath.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <iostream>
+
+using namespace std;
+
+//_____________________________________________________________________________
+THcIndexedRun::THcIndexedRun( const char* fname, const char* description ) :
+  THcRun(fname, description), fFirst(0), fLast(-1), fFirstEvNum(0),
+  fLastEvNum(0), fIndex(0), fFd(-1), fBegin(0), fEnd(0), fNext(0),
+  fNControl(0)
+{
+  // Normal & default constructor
+}
+
+//_____________________________________________________________________________
+THcIndexedRun::THcIndexedRun( const THcIndexedRun& rhs ) :
+  THcRun(rhs), fFirst(rhs.fFirst), fLast(rhs.fLast),
+  fFirstEvNum(rhs.fFirstEvNum), fLastEvNum(rhs.fLastEvNum), fIndex(0),
+  fFd(-1), fBegin(0), fEnd(0), fNext(0), fNControl(0)
+{
+  // Copy ctor.  Copies the range, not the read position.
+}
+
+//_____________________________________________________________________________
+THcIndexedRun& THcIndexedRun::operator=(const THaRunBase& rhs)
+{
+  if (this != &rhs) {
+    Close();
+    THcRun::operator=(rhs);
+    const THcIndexedRun* run = dynamic_cast<const THcIndexedRun*>(&rhs);
+    if(run) {
+      fFirst = run->fFirst;
+      fLast = run->fLast;
+      fFirstEvNum = run->fFirstEvNum;
+      fLastEvNum = run->fLastEvNum;
+    }
+  }
+  return *this;
+}
+
+//_____________________________________________________________________________
+THcIndexedRun::~THcIndexedRun()
+{
+  // Destructor.
+  Close();
+  delete fIndex;
+}
+
+//_____________________________________________________________________________
+void THcIndexedRun::SetIndexRange( Long64_t first, Long64_t last )
+{
+  fFirst = TMath::Max(first, (Long64_t)0);
+  fLast = last;
+  fFirstEvNum = fLastEvNum = 0;
+}
+
+//_____________________________________________________________________________
+void THcIndexedRun::SetEvNumRange( UInt_t first, UInt_t last )
+{
+  fFirstEvNum = first;
+  fLastEvNum = last;
+  fFirst = 0;
+  fLast = -1;
+}
+
+//_____________________________________________________________________________
+void THcIndexedRun::QueueControlEvents( Long64_t from, Long64_t to )
+{
+  for(Long64_t i=from; i<to; i++) {
+    UInt_t evtype = fIndex->GetEvType(i);
+    if((evtype >= 16 && evtype <= 31) || evtype == 125) fControl.push_back(i);
+  }
+}
+
+//_____________________________________________________________________________
+Int_t THcIndexedRun::Open()
+{
+  /**
+     Load the index of the file and find the range of events to read.
+  */
+  Close();
+  if(!fIndex) fIndex = new THcCodaIndex;
+  if(fIndex->GetNEvents() == 0 || fFilename != fIndex->GetCodaFile()) {
+    if(fIndex->Load(fFilename) != 0) {
+      Error("Open", "Cannot index CODA file %s", fFilename.Data());
+      return -1;
+    }
+  }
+  fFd = open(fFilename, O_RDONLY);
+  if(fFd < 0) {
+    Error("Open", "Cannot open CODA file %s", fFilename.Data());
+    return -1;
+  }
+
+  Long64_t nev = fIndex->GetNEvents();
+  if(fFirstEvNum > 0 || fLastEvNum > 0) {
+    fBegin = fIndex->FindEvNum(fFirstEvNum);
+    if(fBegin < 0) fBegin = nev;
+    fEnd = (fLastEvNum > 0) ? fIndex->FindEvNum(fLastEvNum+1) : nev;
+    if(fEnd < 0) fEnd = nev;
+  } else {
+    fBegin = TMath::Min(fFirst, nev);
+    fEnd = (fLast < 0) ? nev : TMath::Min(fLast, nev);
+  }
+  if(fEnd < fBegin) fEnd = fBegin;
+
+  fControl.clear();
+  fNControl = 0;
+  QueueControlEvents(0, fBegin);
+  fNext = fBegin;
+  fNEventsRead = 0;
+  fNControlRead = 0;
+  return 0;
+}
+
+//_____________________________________________________________________________
+Int_t THcIndexedRun::Close()
+{
+  StopReadAhead();
+  if(fFd >= 0) {
+    close(fFd);
+    fFd = -1;
+  }
+  fBuffer.clear();
+  fControl.clear();
+  fNControl = 0;
+  return 0;
+}
+
+//_____________________________________________________________________________
+Int_t THcIndexedRun::ReadEventDirect()
+{
+  /**
+     Return the next event: the control events before the range first,
+     then the events of the range.  Events to skip (SkipEvents) are
+     passed over in the index, keeping only their control events.
+  */
+  if(!IsOpen()) {
+    Int_t st = Open();
+    if(st) return READ_FATAL;
+  }
+  if(fNSkip > 0) {
+    Long64_t to = TMath::Min(fNext+fNSkip, fEnd);
+    QueueControlEvents(fNext, to);
+    fNEventsRead += to-fNext;
+    fNext = to;
+    fNSkip = 0;
+    cout << "THcIndexedRun: skipped to event " << fNEventsRead << endl;
+  }
+
+  Long64_t i;
+  if(fNControl < fControl.size()) {
+    i = fControl[fNControl++];
+  } else {
+    if(fNext >= fEnd) return READ_EOF;
+    i = fNext++;
+    fNEventsRead++;
+  }
+  if(fIndex->ReadEvent(fFd, i, fBuffer) < 0) {
+    Error("ReadEvent", "Cannot read event %lld of %s", i, fFilename.Data());
+    return READ_ERROR;
+  }
+  if(IsControlEvent(&fBuffer[0])) fNControlRead++;
+  return READ_OK;
+}
+
+//_____________________________________________________________________________
+const UInt_t* THcIndexedRun::DirectEvBuffer() const
+{
+  return fBuffer.empty() ? 0 : &fBuffer[0];
+}
+
+ClassImp(THcIndexedRun)
@@ -0,0 +1,58 @@
+#ifndef ROOT_THcIndexedRun
+#define ROOT_THcIndexedRun
+
+//////////////////////////////////////////////////////////////////////////
+//
+// THcIndexedRun
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "THcRun.h"
+#include <vector>
+
+class THcCodaIndex;
+
+class THcIndexedRun : public THcRun {
+
+ public:
+  THcIndexedRun( const char* filename="", const char* description="" );
+  THcIndexedRun( const THcIndexedRun& run );
+  THcIndexedRun& operator=( const THaRunBase& rhs );
+  virtual ~THcIndexedRun();
+
+  virtual Int_t  Open();
+  virtual Int_t  Close();
+  virtual Bool_t IsOpen() const { return fFd >= 0; }
+
+  // Replay events first to last-1 by position in the file (last < 0:
+  // to the end of the file) ...
+  void   SetIndexRange( Long64_t first, Long64_t last=-1 );
+  // ... or physics events with numbers first to last (last 0: to the end)
+  void   SetEvNumRange( UInt_t first, UInt_t last=0 );
+
+  THcCodaIndex* GetIndex() const { return fIndex; }
+  Long64_t GetFirstIndex() const { return fBegin; }
+  Long64_t GetEndIndex() const { return fEnd; }
+
+ protected:
+  virtual Int_t  ReadEventDirect();
+  virtual const UInt_t* DirectEvBuffer() const;
+  void   QueueControlEvents( Long64_t from, Long64_t to );
+
+  Long64_t fFirst;		// Requested range, by position
+  Long64_t fLast;
+  UInt_t   fFirstEvNum;		// Requested range, by event number
+  UInt_t   fLastEvNum;
+
+  THcCodaIndex* fIndex;		//! Index of the file
+  Int_t    fFd;			//! Descriptor of the open file
+  Long64_t fBegin;		//! Range found in the index
+  Long64_t fEnd;		//!
+  Long64_t fNext;		//! Next event of the range
+  std::vector<Long64_t> fControl; //! Control events before fNext still to return
+  UInt_t   fNControl;		//! Of these, already returned
+  std::vector<UInt_t> fBuffer;	//! Current event
+
+  ClassDef(THcIndexedRun,1);	// CODA run read through an event index
+};
+#endif
@@ -0,0 +1,463 @@
+/** \class THcInitScheduler
+    \ingroup Base
+
+    \brief Initializes the detectors of the spectrometers concurrently.
+
+    At startup THaAnalyzer initializes the apparatus one after the other,
+    and each apparatus its detectors one after the other.  Every detector
+    loads its parameters from gHcParms, fills its detector map, allocates
+    its arrays and defines its global variables.  For short calibration
+    replays this is a noticeable part of the wall time.
+
+    THcAnalyzer::SetInitThreads(n) runs a THcInitScheduler before the
+    modules are initialized by THaAnalyzer.  It builds a dependency graph
+    of the THcHallCSpectrometer apparatus in gHaApps and their detectors:
+    each detector is initialized after its spectrometer (whose variables,
+    e.g. "H.present", the detectors look up), and after the objects given
+    with AddDependency.  Objects whose dependencies are done are
+    initialized by n worker threads (0: one per core).  The spectrometers
+    then return from their Init at once when THaAnalyzer gets to them.
+    Other apparatus and the physics modules are initialized by THaAnalyzer
+    as usual, after all spectrometers, which is what e.g. THcCoinTime and
+    THcHodoEff need.
+
+    The Init code of the detectors was not written to run concurrently:
+    it creates ROOT objects and defines global variables and parameters.
+    So the workers run it one at a time, except in ParallelSection scopes.
+    THcParmList::LoadParmValues and THcDetectorMap::FillMap, which only
+    read the parameters and the map, are such sections.  While one worker
+    loads parameters or fills a map, the others can do the same, and the
+    rest of the initialization, including all global variable
+    definitions, stays serial.  The order in which objects define their
+    variables may differ from the serial order; each object still defines
+    its own variables together.
+
+    If an Init fails or throws (e.g. a missing parameter), no further
+    objects are started and the spectrometers that were not completely
+    initialized are initialized again by THaAnalyzer, which reports the
+    error as usual.  An exception is passed on by Run; THcAnalyzer::Init
+    catches it, forgets all initialized spectrometers and lets
+    THaAnalyzer initialize them serially.  Without C++11 the graph is
+    initialized in one thread.
+
+    Only the parameter loading and map filling overlap, so the gain is
+    at most the share of those in the Init time, and none if the Init is
+    dominated by the serial part.  It has not been measured for the
+    standard replays, so the scheduler is off by default (init_threads
+    1 in THcReplayConfig).  Compare the wall time of the
+    "THcInitScheduler:" line, and the startup time, with 1 and with n
+    threads before using it.
+
+        analyzer->SetInitThreads(0);
+        analyzer->GetInitScheduler()->AddDependency("H.cal", "H.hod");
+*/
+
+#include "THcInitScheduler.h"
+#include "THcHallCSpectrometer.h"
+#include "THaAnalysisObject.h"
+#include "THaGlobals.h"
+#include "TList.h"
+#include "TDatime.h"
+#include "TError.h"
+#include <set>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <ctime>
+#if __cplusplus >= 201103L
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <chrono>
+#endif
+
+using namespace std;
+
+// Apparatus initialized by the last Run, until their Init is called
+static set<const THaAnalysisObject*> fgInitialized;
+
+#if __cplusplus >= 201103L
+namespace {
+  // Shared/exclusive lock.  Workers hold it exclusively while they
+  // initialize an object and shared within parallel sections.
+  class Gate {
+  public:
+    Gate() : fNShared(0), fExclusive(false) {}
+    void LockExclusive() {
+      unique_lock<mutex> lock(fMutex);
+      fFree.wait(lock, [this]{ return !fExclusive && fNShared == 0; });
+      fExclusive = true;
+    }
+    void UnlockExclusive() {
+      { lock_guard<mutex> lock(fMutex); fExclusive = false; }
+      fFree.notify_all();
+    }
+    void LockShared() {
+      unique_lock<mutex> lock(fMutex);
+      fFree.wait(lock, [this]{ return !fExclusive; });
+      fNShared++;
+    }
+    void UnlockShared() {
+      { lock_guard<mutex> lock(fMutex); fNShared--; }
+      fFree.notify_all();
+    }
+  private:
+    mutex fMutex;
+    condition_variable fFree;
+    Int_t fNShared;
+    bool  fExclusive;
+  };
+}
+
+static Gate fgGate;
+static thread_local Bool_t fgInWorker = kFALSE;
+static thread_local Int_t fgParallelDepth = 0;
+
+struct THcInitScheduler::Sync {
+  mutex lock;
+  condition_variable changed;	// A node finished or became ready
+  Int_t nrunning;
+  vector<exception_ptr> errors;	// By node
+};
+
+typedef chrono::steady_clock Clock;
+
+static Double_t Seconds( Clock::time_point t0 )
+{
+  return chrono::duration<Double_t>(Clock::now() - t0).count();
+}
+#else
+struct THcInitScheduler::Sync {};
+#endif
+
+//_____________________________________________________________________________
+THcInitScheduler::ParallelSection::ParallelSection() : fActive(kFALSE)
+{
+  // Let other workers in while this one is in the section.  Does nothing
+  // outside the workers of a THcInitScheduler.
+#if __cplusplus >= 201103L
+  fActive = fgInWorker;
+  if(fActive && fgParallelDepth++ == 0) {
+    fgGate.UnlockExclusive();
+    fgGate.LockShared();
+  }
+#endif
+}
+
+//_____________________________________________________________________________
+THcInitScheduler::ParallelSection::~ParallelSection()
+{
+#if __cplusplus >= 201103L
+  if(fActive && --fgParallelDepth == 0) {
+    fgGate.UnlockShared();
+    fgGate.LockExclusive();
+  }
+#endif
+}
+
+//_____________________________________________________________________________
+THcInitScheduler::THcInitScheduler( Int_t nthreads )
+  : fNThreads(nthreads), fFailed(kFALSE), fWallTime(0),
+    fSync(new Sync)
+{
+}
+
+//_____________________________________________________________________________
+THcInitScheduler::~THcInitScheduler()
+{
+  delete fSync;
+}
+
+//_____________________________________________________________________________
+void THcInitScheduler::AddDependency( const char* obj, const char* dep )
+{
+  fDependencies.push_back(make_pair(string(obj), string(dep)));
+}
+
+//_____________________________________________________________________________
+Bool_t THcInitScheduler::TakeInitialized( const THaAnalysisObject* obj )
+{
+  set<const THaAnalysisObject*>::iterator it = fgInitialized.find(obj);
+  if(it == fgInitialized.end()) return kFALSE;
+  fgInitialized.erase(it);
+  return kTRUE;
+}
+
+//_____________________________________________________________________________
+void THcInitScheduler::ClearInitialized()
+{
+  fgInitialized.clear();
+}
+
+//_____________________________________________________________________________
+Int_t THcInitScheduler::AddNode( THaAnalysisObject* obj, const string& name,
+				 Bool_t self )
+{
+  Node node;
+  node.obj = obj;
+  node.name = name;
+  node.self = self;
+  node.nwait = 0;
+  node.status = THaAnalysisObject::kNotinit;
+  node.time = 0;
+  fNodes.push_back(node);
+  return fNodes.size()-1;
+}
+
+//_____________________________________________________________________________
+Int_t THcInitScheduler::FindNode( const string& name ) const
+{
+  for(UInt_t i=0;i<fNodes.size();i++) {
+    if(fNodes[i].name == name) return i;
+  }
+  return -1;
+}
+
+//_____________________________________________________________________________
+void THcInitScheduler::AddEdge( Int_t from, Int_t to )
+{
+  // to is initialized after from
+  fNodes[from].dependents.push_back(to);
+  fNodes[to].nwait++;
+}
+
+//_____________________________________________________________________________
+void THcInitScheduler::BuildGraph()
+{
+  /**
+     One node for each THcHallCSpectrometer in gHaApps (its own Init,
+     without the detectors) and one for each of its detectors, which
+     depends on it.  Then the edges of AddDependency.  If there is a
+     cycle, the graph is dropped and THaAnalyzer initializes everything.
+  */
+  fNodes.clear();
+  TIter next(gHaApps);
+  while(TObject* obj = next()) {
+    THcHallCSpectrometer* app = dynamic_cast<THcHallCSpectrometer*>(obj);
+    if(!app || app->IsZombie()) continue;
+    Int_t iapp = AddNode(app, app->GetName(), kTRUE);
+    TIter nextdet(app->GetDetectors());
+    while(THaAnalysisObject* det = dynamic_cast<THaAnalysisObject*>(nextdet())) {
+      Int_t idet = AddNode(det, string(app->GetName())+"."+det->GetName(), kFALSE);
+      AddEdge(iapp, idet);
+    }
+  }
+  for(UInt_t i=0;i<fDependencies.size();i++) {
+    Int_t to = FindNode(fDependencies[i].first);
+    Int_t from = FindNode(fDependencies[i].second);
+    if(to < 0 || from < 0) {
+      ::Warning("THcInitScheduler::BuildGraph", "No object %s, ignoring %s after %s",
+		(to < 0 ? fDependencies[i].first : fDependencies[i].second).c_str(),
+		fDependencies[i].first.c_str(), fDependencies[i].second.c_str());
+      continue;
+    }
+    AddEdge(from, to);
+  }
+
+  // Check for cycles by sorting
+  vector<Int_t> nwait(fNodes.size());
+  vector<Int_t> ready;
+  for(UInt_t i=0;i<fNodes.size();i++) {
+    nwait[i] = fNodes[i].nwait;
+    if(nwait[i] == 0) ready.push_back(i);
+  }
+  UInt_t nsorted = 0;
+  while(!ready.empty()) {
+    Int_t i = ready.back();
+    ready.pop_back();
+    nsorted++;
+    for(UInt_t j=0;j<fNodes[i].dependents.size();j++) {
+      if(--nwait[fNodes[i].dependents[j]] == 0) ready.push_back(fNodes[i].dependents[j]);
+    }
+  }
+  if(nsorted != fNodes.size()) {
+    ::Error("THcInitScheduler::BuildGraph", "Dependencies form a cycle, "
+	    "initializing serially");
+    fNodes.clear();
+  }
+}
+
+//_____________________________________________________________________________
+void THcInitScheduler::InitNode( Node& node, const TDatime& date )
+{
+#if __cplusplus >= 201103L
+  Clock::time_point t0 = Clock::now();
+#else
+  clock_t t0 = clock();
+#endif
+  if(node.self) {
+    // What THaApparatus::Init does before initializing its detectors
+    node.status = node.obj->THaAnalysisObject::Init(date);
+  } else {
+    node.status = node.obj->Init(date);
+  }
+#if __cplusplus >= 201103L
+  node.time = Seconds(t0);
+#else
+  node.time = Double_t(clock()-t0)/CLOCKS_PER_SEC;
+#endif
+}
+
+//_____________________________________________________________________________
+void THcInitScheduler::Work( const TDatime& date )
+{
+  // Body of the worker threads.  Takes the ready node that comes first
+  // in gHaApps order until none is ready and none is running.
+#if __cplusplus >= 201103L
+  Sync& s = *fSync;
+  fgInWorker = kTRUE;
+  while(1) {
+    Int_t inode;
+    {
+      unique_lock<mutex> lock(s.lock);
+      s.changed.wait(lock, [this,&s]{
+	  return fFailed || !fReady.empty() || s.nrunning == 0; });
+      if(fFailed || fReady.empty()) break;
+      vector<Int_t>::iterator first = min_element(fReady.begin(), fReady.end());
+      inode = *first;
+      fReady.erase(first);
+      s.nrunning++;
+    }
+    Node& node = fNodes[inode];
+    fgGate.LockExclusive();
+    try {
+      InitNode(node, date);
+    } catch(...) {
+      node.status = THaAnalysisObject::kInitError;
+      s.errors[inode] = current_exception();
+    }
+    fgGate.UnlockExclusive();
+    {
+      lock_guard<mutex> lock(s.lock);
+      s.nrunning--;
+      if(node.status != THaAnalysisObject::kOK) {
+	fFailed = kTRUE;
+      } else {
+	for(UInt_t j=0;j<node.dependents.size();j++) {
+	  if(--fNodes[node.dependents[j]].nwait == 0) fReady.push_back(node.dependents[j]);
+	}
+      }
+    }
+    s.changed.notify_all();
+  }
+  fgInWorker = kFALSE;
+#endif
+}
+
+//_____________________________________________________________________________
+Int_t THcInitScheduler::Run( const TDatime& date )
+{
+  /**
+     Initialize the graph for date.  Returns 0 if all objects were
+     initialized, -1 otherwise; THaAnalyzer initializes the apparatus
+     not completely done.  Rethrows the first exception of an Init.
+  */
+  ClearInitialized();
+  BuildGraph();
+  if(fNodes.empty()) return 0;
+
+  Int_t nthreads = fNThreads;
+#if __cplusplus >= 201103L
+  if(nthreads <= 0) nthreads = thread::hardware_concurrency();
+  Clock::time_point t0 = Clock::now();
+#else
+  nthreads = 1;
+  clock_t t0 = clock();
+#endif
+  if(nthreads < 1) nthreads = 1;
+  if(nthreads > (Int_t)fNodes.size()) nthreads = fNodes.size();
+
+  fReady.clear();
+  for(UInt_t i=0;i<fNodes.size();i++) {
+    if(fNodes[i].nwait == 0) fReady.push_back(i);
+  }
+  fFailed = kFALSE;
+
+#if __cplusplus >= 201103L
+  if(nthreads > 1) {
+    fSync->nrunning = 0;
+    fSync->errors.assign(fNodes.size(), exception_ptr());
+    vector<thread> workers;
+    for(Int_t i=0;i<nthreads;i++) {
+      workers.push_back(thread(&THcInitScheduler::Work, this, cref(date)));
+    }
+    for(Int_t i=0;i<nthreads;i++) workers[i].join();
+  } else
+#endif
+  {
+    while(!fReady.empty() && !fFailed) {
+      vector<Int_t>::iterator first = min_element(fReady.begin(), fReady.end());
+      Node& node = fNodes[*first];
+      fReady.erase(first);
+      InitNode(node, date);
+      if(node.status != THaAnalysisObject::kOK) {
+	fFailed = kTRUE;
+      } else {
+	for(UInt_t j=0;j<node.dependents.size();j++) {
+	  if(--fNodes[node.dependents[j]].nwait == 0) fReady.push_back(node.dependents[j]);
+	}
+      }
+    }
+  }
+#if __cplusplus >= 201103L
+  fWallTime = Seconds(t0);
+#else
+  fWallTime = Double_t(clock()-t0)/CLOCKS_PER_SEC;
+#endif
+
+  // A spectrometer counts as initialized if it and all its detectors are
+  Int_t iapp = -1;
+  Bool_t complete = kFALSE;
+  for(UInt_t i=0;i<=fNodes.size();i++) {
+    if(i == fNodes.size() || fNodes[i].self) {
+      if(iapp >= 0 && complete) fgInitialized.insert(fNodes[iapp].obj);
+      if(i == fNodes.size()) break;
+      iapp = i;
+      complete = kTRUE;
+    }
+    if(fNodes[i].status != THaAnalysisObject::kOK) complete = kFALSE;
+  }
+
+  Double_t sum = 0;
+  Int_t nok = 0;
+  for(UInt_t i=0;i<fNodes.size();i++) {
+    sum += fNodes[i].time;
+    if(fNodes[i].status == THaAnalysisObject::kOK) nok++;
+  }
+  cout << "THcInitScheduler: " << nok << " of " << fNodes.size()
+       << " objects initialized by " << nthreads << " threads in "
+       << fWallTime << " s (" << sum << " s in Init)" << endl;
+
+#if __cplusplus >= 201103L
+  if(nthreads > 1) {
+    for(UInt_t i=0;i<fNodes.size();i++) {
+      if(fSync->errors[i]) {
+	exception_ptr e = fSync->errors[i];
+	fSync->errors.clear();
+	rethrow_exception(e);
+      }
+    }
+  }
+#endif
+  return (nok == (Int_t)fNodes.size()) ? 0 : -1;
+}
+
+//_____________________________________________________________________________
+void THcInitScheduler::Print() const
+{
+  // Init time and status of each object of the last Run
+  cout << "THcInitScheduler: " << fNodes.size() << " objects, "
+       << fWallTime << " s" << endl;
+  for(UInt_t i=0;i<fNodes.size();i++) {
+    const Node& node = fNodes[i];
+    cout << "  " << setw(12) << left << node.name << right << " "
+	 << setw(10) << node.time << " s";
+    if(node.status == THaAnalysisObject::kNotinit) cout << "  not run";
+    else if(node.status != THaAnalysisObject::kOK) cout << "  status " << node.status;
+    cout << endl;
+  }
+}
+
+ClassImp(THcInitScheduler)
@@ -0,0 +1,89 @@
+#ifndef ROOT_THcInitScheduler
+#define ROOT_THcInitScheduler
+
+//////////////////////////////////////////////////////////////////////////
+//
+// THcInitScheduler
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "Rtypes.h"
+#include <vector>
+#include <string>
+#include <utility>
+
+class THaAnalysisObject;
+class TDatime;
+
+class THcInitScheduler {
+
+public:
+
+  THcInitScheduler( Int_t nthreads=0 );
+  virtual ~THcInitScheduler();
+
+  void   SetNThreads( Int_t nthreads ) { fNThreads = nthreads; }
+  Int_t  GetNThreads() const { return fNThreads; }
+
+  // Initialize obj after dep, both by full name ("H.cal", "H.hod", "H")
+  void   AddDependency( const char* obj, const char* dep );
+
+  Int_t  Run( const TDatime& date );
+  void   Print() const;
+
+  // For the Init of scheduled apparatus: true if the object was
+  // initialized by the last Run and has not been asked since
+  static Bool_t TakeInitialized( const THaAnalysisObject* obj );
+  static void   ClearInitialized();
+
+  // Code in the scope of a ParallelSection may run at the same time as
+  // other parallel sections.  The rest of the Init of the scheduled
+  // objects runs one thread at a time.
+  class ParallelSection {
+  public:
+    ParallelSection();
+    ~ParallelSection();
+  private:
+    Bool_t fActive;
+    ParallelSection( const ParallelSection& );
+    ParallelSection& operator=( const ParallelSection& );
+  };
+
+  // One object to initialize
+  struct Node {
+    THaAnalysisObject* obj;
+    std::string name;
+    Bool_t   self;		// Apparatus only, not its detectors
+    std::vector<Int_t> dependents;
+    Int_t    nwait;		// Dependencies not yet initialized
+    Int_t    status;		// Of Init, kNotinit if not run
+    Double_t time;		// s
+  };
+
+protected:
+
+  Int_t  AddNode( THaAnalysisObject* obj, const std::string& name, Bool_t self );
+  Int_t  FindNode( const std::string& name ) const;
+  void   AddEdge( Int_t from, Int_t to );
+  void   BuildGraph();
+  void   InitNode( Node& node, const TDatime& date );
+  void   Work( const TDatime& date );
+
+  Int_t    fNThreads;		// 0: one per core
+  std::vector<std::pair<std::string,std::string> > fDependencies;
+  std::vector<Node> fNodes;
+  std::vector<Int_t> fReady;	// Nodes whose dependencies are done
+  Bool_t   fFailed;		// An Init failed; start no more
+  Double_t fWallTime;		// s, of the last Run
+
+  struct Sync;
+  Sync*    fSync;		//! Workers, mutex and exceptions
+
+private:
+  THcInitScheduler( const THcInitScheduler& );
+  THcInitScheduler& operator=( const THcInitScheduler& );
+
+  ClassDef(THcInitScheduler,0)	// Initializes independent detectors concurrently
+};
+
+#endif
@@ -13,6 +13,8 @@ for the Hall C style parameter database.
 #include "TInterpreter.h"
 #include "THcParmList.h"
 #include "THcDetectorMap.h"
+#include "THcHitCache.h"
+#include "THcCheckpoint.h"
 #include "THcGlobals.h"
 #include "ha_compiledata.h"
 #include "hc_compiledata.h"
@@ -28,6 +30,8 @@ using namespace std;
 
 THcParmList* gHcParms     = NULL;  // List of symbolic analyzer variables
 THcDetectorMap* gHcDetectorMap = NULL; // Global (Hall C style) detector map
+THcHitCache* gHcHitCache = NULL; // Decoded hit cache for reprocessing
+THcCheckpoint* gHcCheckpoint = NULL; // Run state snapshots for resuming
 
 //_____________________________________________________________________________
 THcInterface::THcInterface( const char* appClassName, int* argc, char** argv,
@@ -63,6 +67,8 @@ THcInterface::~THcInterface()
 
   if( fgAint == this ) {
     delete gHcDetectorMap;   gHcDetectorMap=0;
+    delete gHcHitCache;      gHcHitCache=0;
+    delete gHcCheckpoint;    gHcCheckpoint=0;
   }
 }
 
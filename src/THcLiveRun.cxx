@@ -0,0 +1,367 @@
+/** \class THcLiveRun
+    \ingroup Base
+
+\brief CODA run that is replayed while the DAQ is still writing it.
+
+THcLiveRun is used in place of THcRun for online monitoring.  It reads
+the CODA file block by block as it grows.  When it has read all complete
+blocks, it waits for more data instead of ending the run.  Events are
+passed to the analyzer as soon as the DAQ has written their block, so
+the delay is one poll interval (SetPollInterval, default 200 ms) plus
+the time the DAQ takes to fill a block.
+
+File rollovers are followed.  If the file name ends in a segment number
+(run.dat.0), the replay moves on to run.dat.1 when that file appears,
+after the rest of the current segment has been read.  The replay ends
+after the CODA end event, after the last block of a file without a
+segment number, or when no new data came for SetIdleTimeout seconds.
+
+Every SetFlushInterval seconds while events come in, and every time the
+replay catches up with the DAQ, Update() writes the output tree and
+histograms to the output file.  It also regenerates the THcPeriodicReport
+reports, so both stay current without restarting the replay.
+
+    THcLiveRun* run = new THcLiveRun("raw/shms_all_01234.dat.0");
+    run->SetRunParamClass("THcRunParameters");
+    run->SetFlushInterval(5);
+    analyzer->Process(run);
+
+examples/livereplay.C does this.  examples/codatrickle.C copies an
+existing CODA file into a slowly growing copy, optionally in segments,
+to try it out without the DAQ.  evio version 1-3 and 4 files in either
+byte order are understood.
+*/
+#include "THcLiveRun.h"
+#include "THcAnalyzer.h"
+#include "THcPeriodicReport.h"
+#include "THaGlobals.h"
+#include "TSystem.h"
+#include "TList.h"
+#include "TMath.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <ctime>
+#include <iostream>
+
+using namespace std;
+
+static const UInt_t kEvioMagic = 0xc0da0100;
+static const UInt_t kEndEventType = 20;
+
+static inline UInt_t SwapWord(UInt_t w)
+{
+  return ((w>>24)&0xff) | ((w>>8)&0xff00) | ((w<<8)&0xff0000) | (w<<24);
+}
+
+//_____________________________________________________________________________
+THcLiveRun::THcLiveRun( const char* fname, const char* description ) :
+  THcRun(fname, description), fPollInterval(200), fFlushInterval(10),
+  fIdleTimeout(300), fFd(-1), fSegment(-1), fOffset(0), fSwapped(kFALSE),
+  fVersion(0), fLastBlock(kFALSE), fEndSeen(kFALSE), fPos(0), fEnd(0),
+  fEvNeed(0), fEvent(0), fNEvents(0), fNEventsFlushed(0), fLastData(0),
+  fLastFlush(0)
+{
+  // Normal & default constructor
+}
+
+//_____________________________________________________________________________
+THcLiveRun::THcLiveRun( const THcLiveRun& rhs ) :
+  THcRun(rhs), fPollInterval(rhs.fPollInterval),
+  fFlushInterval(rhs.fFlushInterval), fIdleTimeout(rhs.fIdleTimeout),
+  fFd(-1), fSegment(-1), fOffset(0), fSwapped(kFALSE), fVersion(0),
+  fLastBlock(kFALSE), fEndSeen(kFALSE), fPos(0), fEnd(0), fEvNeed(0),
+  fEvent(0), fNEvents(0), fNEventsFlushed(0), fLastData(0), fLastFlush(0)
+{
+  // Copy ctor.  Copies the settings, not the read position.
+}
+
+//_____________________________________________________________________________
+THcLiveRun& THcLiveRun::operator=(const THaRunBase& rhs)
+{
+  if (this != &rhs) {
+    Close();
+    THcRun::operator=(rhs);
+    const THcLiveRun* live = dynamic_cast<const THcLiveRun*>(&rhs);
+    if(live) {
+      fPollInterval = live->fPollInterval;
+      fFlushInterval = live->fFlushInterval;
+      fIdleTimeout = live->fIdleTimeout;
+    }
+  }
+  return *this;
+}
+
+//_____________________________________________________________________________
+THcLiveRun::~THcLiveRun()
+{
+  // Destructor.
+  Close();
+}
+
+//_____________________________________________________________________________
+TString THcLiveRun::SegmentName( Int_t segment ) const
+{
+  if(segment < 0) return fBaseName;
+  return TString::Format("%s.%d", fBaseName.Data(), segment);
+}
+
+//_____________________________________________________________________________
+Bool_t THcLiveRun::NextSegmentExists() const
+{
+  if(fSegment < 0) return kFALSE;
+  return !gSystem->AccessPathName(SegmentName(fSegment+1));
+}
+
+//_____________________________________________________________________________
+Int_t THcLiveRun::Open()
+{
+  /**
+     Open the file and start reading at its first event.  A file that
+     does not exist yet is waited for, up to the idle timeout.
+  */
+  Close();
+  fBaseName = fFilename;
+  fSegment = -1;
+  Ssiz_t dot = fBaseName.Last('.');
+  if(dot != kNPOS && dot+1 < fBaseName.Length()) {
+    TString suffix = fBaseName(dot+1, fBaseName.Length()-dot-1);
+    if(suffix.IsDigit()) {
+      fSegment = suffix.Atoi();
+      fBaseName.Remove(dot);
+    }
+  }
+  fEndSeen = kFALSE;
+  fNEvents = fNEventsFlushed = 0;
+  fLastData = fLastFlush = time(0);
+
+  while(OpenSegment(fSegment) != 0) {
+    if(fIdleTimeout == 0 || time(0) - fLastData >= (Long64_t)fIdleTimeout) {
+      Error("Open", "Cannot open CODA file %s", fFilename.Data());
+      return -1;
+    }
+    gSystem->Sleep(fPollInterval);
+  }
+  return 0;
+}
+
+//_____________________________________________________________________________
+Int_t THcLiveRun::OpenSegment( Int_t segment )
+{
+  if(fFd >= 0) close(fFd);
+  fFd = open(SegmentName(segment), O_RDONLY);
+  if(fFd < 0) return -1;
+  fSegment = segment;
+  fOffset = 0;
+  fVersion = 0;
+  fLastBlock = kFALSE;
+  fBlock.clear();
+  fPos = fEnd = 0;
+  fEvBuffer.clear();
+  fEvNeed = 0;
+  return 0;
+}
+
+//_____________________________________________________________________________
+Int_t THcLiveRun::Close()
+{
+  if(fFd >= 0) {
+    close(fFd);
+    fFd = -1;
+  }
+  fBlock.clear();
+  fEvBuffer.clear();
+  fEvent = 0;
+  return 0;
+}
+
+//_____________________________________________________________________________
+Int_t THcLiveRun::ReadBlock()
+{
+  /**
+     Read the next block of the segment if the DAQ has written all of it.
+     Returns 1 if a block was read, 0 if there is no complete block yet
+     and -1 if the file is not a CODA file.
+  */
+  struct stat st;
+  if(fstat(fFd, &st) != 0) return -1;
+  Long64_t avail = st.st_size - fOffset;
+  UInt_t head[8];
+  if(avail < (Long64_t)sizeof(head)) return 0;
+  if(pread(fFd, head, sizeof(head), fOffset) != (ssize_t)sizeof(head)) return 0;
+  if(fVersion == 0) {
+    if(head[7] == kEvioMagic) {
+      fSwapped = kFALSE;
+    } else if(SwapWord(head[7]) == kEvioMagic) {
+      fSwapped = kTRUE;
+    } else {
+      Error("ReadBlock", "%s is not a CODA (evio) file",
+	    SegmentName(fSegment).Data());
+      return -1;
+    }
+    fVersion = (fSwapped ? SwapWord(head[5]) : head[5]) & 0xff;
+  } else if((fSwapped ? SwapWord(head[7]) : head[7]) != kEvioMagic) {
+    Error("ReadBlock", "Bad block at byte %lld of %s", fOffset,
+	  SegmentName(fSegment).Data());
+    return -1;
+  }
+  Long64_t blen = fSwapped ? SwapWord(head[0]) : head[0];
+  if(blen < 8) {
+    Error("ReadBlock", "Bad block length at byte %lld of %s", fOffset,
+	  SegmentName(fSegment).Data());
+    return -1;
+  }
+  if(avail < blen*(Long64_t)sizeof(UInt_t)) return 0; // Still being written
+
+  fBlock.resize(blen);
+  ssize_t nbytes = blen*sizeof(UInt_t);
+  if(pread(fFd, &fBlock[0], nbytes, fOffset) != nbytes) return 0;
+  if(fSwapped) {
+    for(Long64_t i=0;i<blen;i++) fBlock[i] = SwapWord(fBlock[i]);
+  }
+  Bool_t first = (fOffset == 0);
+  fOffset += nbytes;
+  if(fVersion >= 4) {
+    fPos = fBlock[2];
+    fEnd = blen;
+    fLastBlock = (fBlock[5] & 0x200) != 0;
+  } else {
+    // Events run on from block to block.  Word 3 of the first block
+    // points to the first event, word 4 is the number of words used.
+    fPos = first ? fBlock[3] : fBlock[2];
+    fEnd = TMath::Min((Long64_t)fBlock[4], blen);
+  }
+  return 1;
+}
+
+//_____________________________________________________________________________
+Int_t THcLiveRun::NextEvent()
+{
+  /**
+     Find the next event in the blocks read so far, reading another
+     block when needed.  Returns 1 if fEvent is set, 0 if the rest of the
+     event has not been written yet, 2 at the end of a finished segment
+     and -1 on errors.
+  */
+  for(;;) {
+    if(fPos >= fEnd) {
+      if(fLastBlock) return 2;
+      Int_t st = ReadBlock();
+      if(st <= 0) return st;
+      continue;
+    }
+    if(fEvNeed > 0) {		// Rest of an event spanning blocks
+      Long64_t n = TMath::Min(fEvNeed, fEnd-fPos);
+      fEvBuffer.insert(fEvBuffer.end(), &fBlock[0]+fPos, &fBlock[0]+fPos+n);
+      fPos += n;
+      fEvNeed -= n;
+      if(fEvNeed == 0) {
+	fEvent = &fEvBuffer[0];
+	return 1;
+      }
+      continue;
+    }
+    Long64_t evwords = (Long64_t)fBlock[fPos]+1;
+    if(evwords == 1) {		// Padding
+      fPos++;
+      continue;
+    }
+    if(fPos+evwords <= fEnd) {
+      fEvent = &fBlock[fPos];
+      fPos += evwords;
+      return 1;
+    }
+    if(fVersion >= 4) {
+      Warning("NextEvent", "Event at byte %lld overruns its block",
+	      fOffset-(Long64_t)(fBlock.size()-fPos)*(Long64_t)sizeof(UInt_t));
+      fPos = fEnd;
+      continue;
+    }
+    fEvBuffer.assign(&fBlock[0]+fPos, &fBlock[0]+fEnd);
+    fEvNeed = evwords-(fEnd-fPos);
+    fPos = fEnd;
+  }
+}
+
+//_____________________________________________________________________________
+Int_t THcLiveRun::ReadEvent()
+{
+  /**
+     Return the next event, waiting for the DAQ to write it if needed.
+  */
+  if(!IsOpen()) {
+    Int_t st = Open();
+    if(st) return READ_FATAL;
+  }
+  if(fEndSeen) return READ_EOF;
+
+  Bool_t drained = kFALSE;
+  for(;;) {
+    Int_t st = NextEvent();
+    Long64_t now = time(0);
+    if(st == 1) {
+      fNEvents++;
+      fLastData = now;
+      if(fFlushInterval > 0 && now - fLastFlush >= (Long64_t)fFlushInterval) {
+	Update();
+      }
+      if((fEvent[1]>>16) == kEndEventType) fEndSeen = kTRUE;
+      return READ_OK;
+    }
+    if(st < 0) return READ_ERROR;
+
+    // Caught up.  Move to the next segment when the DAQ has rolled over,
+    // after one more look for blocks written just before the rollover.
+    if(fSegment >= 0 && (st == 2 || NextSegmentExists())) {
+      if(st == 0 && !drained) {
+	drained = kTRUE;
+	continue;
+      }
+      if(NextSegmentExists()) {
+	cout << "THcLiveRun: " << fNEvents << " events read, continuing with "
+	     << SegmentName(fSegment+1) << endl;
+	OpenSegment(fSegment+1);
+	fLastData = now;
+	drained = kFALSE;
+	continue;
+      }
+    } else if(st == 2) {
+      return READ_EOF;
+    }
+
+    if(fNEvents > fNEventsFlushed) Update();
+    if(fIdleTimeout > 0 && now - fLastData >= (Long64_t)fIdleTimeout) {
+      cout << "THcLiveRun: no new data in " << fIdleTimeout
+	   << " s, ending the replay after " << fNEvents << " events" << endl;
+      return READ_EOF;
+    }
+    gSystem->Sleep(fPollInterval);
+  }
+}
+
+//_____________________________________________________________________________
+const UInt_t* THcLiveRun::GetEvBuffer() const
+{
+  return fEvent;
+}
+
+//_____________________________________________________________________________
+void THcLiveRun::Update()
+{
+  /**
+     Write the output tree and histograms and regenerate the periodic
+     reports, so that they include all events read so far.
+  */
+  THcAnalyzer* analyzer = dynamic_cast<THcAnalyzer*>(THaAnalyzer::GetInstance());
+  if(analyzer) analyzer->FlushOutput();
+  TIter next(gHaPhysics);
+  while(TObject* obj = next()) {
+    THcPeriodicReport* report = dynamic_cast<THcPeriodicReport*>(obj);
+    if(report) report->PrintReport();
+  }
+  fNEventsFlushed = fNEvents;
+  fLastFlush = time(0);
+}
+
+ClassImp(THcLiveRun)
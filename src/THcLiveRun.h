@@ -0,0 +1,69 @@
+#ifndef ROOT_THcLiveRun
+#define ROOT_THcLiveRun
+
+//////////////////////////////////////////////////////////////////////////
+//
+// THcLiveRun
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "THcRun.h"
+#include <vector>
+
+class THcLiveRun : public THcRun {
+
+ public:
+  THcLiveRun( const char* filename="", const char* description="" );
+  THcLiveRun( const THcLiveRun& run );
+  THcLiveRun& operator=( const THaRunBase& rhs );
+  virtual ~THcLiveRun();
+
+  virtual Int_t  Open();
+  virtual Int_t  Close();
+  virtual Int_t  ReadEvent();
+  virtual const UInt_t* GetEvBuffer() const;
+  virtual Bool_t IsOpen() const { return fFd >= 0; }
+
+  // Wait this long between looks at a file that has no new data
+  void   SetPollInterval( UInt_t ms )   { fPollInterval = ms; }
+  // Write the output file and reports this often while events come in,
+  // and whenever the replay catches up with the DAQ
+  void   SetFlushInterval( UInt_t s )   { fFlushInterval = s; }
+  // End the replay when no new data came for this long (0: never)
+  void   SetIdleTimeout( UInt_t s )     { fIdleTimeout = s; }
+
+  void   Update();
+
+ protected:
+  Int_t  NextEvent();
+  Int_t  ReadBlock();
+  Int_t  OpenSegment( Int_t segment );
+  Bool_t NextSegmentExists() const;
+  TString SegmentName( Int_t segment ) const;
+
+  UInt_t fPollInterval;		// ms
+  UInt_t fFlushInterval;	// s
+  UInt_t fIdleTimeout;		// s
+
+  Int_t  fFd;			//! Descriptor of the open segment
+  TString fBaseName;		//! File name without the segment number
+  Int_t  fSegment;		//! Current segment, -1 if the name has none
+  Long64_t fOffset;		//! Bytes of the segment read so far
+  Bool_t fSwapped;		//! File has the other byte order
+  Int_t  fVersion;		//! evio version
+  Bool_t fLastBlock;		//! Last block of the segment was read
+  Bool_t fEndSeen;		//! CODA end event was read
+  std::vector<UInt_t> fBlock;	//! Current block
+  Long64_t fPos;		//! Next word in fBlock
+  Long64_t fEnd;		//! End of the events in fBlock
+  std::vector<UInt_t> fEvBuffer; //! Event spanning blocks
+  Long64_t fEvNeed;		//! Words of it still to come
+  const UInt_t* fEvent;		//! Current event
+  Long64_t fNEvents;		//! Events read
+  Long64_t fNEventsFlushed;	//! Events read at the last update
+  Long64_t fLastData;		//! Time new data was last seen
+  Long64_t fLastFlush;		//! Time of the last update
+
+  ClassDef(THcLiveRun,1);	// CODA run read while the DAQ writes it
+};
+#endif
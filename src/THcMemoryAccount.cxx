@@ -0,0 +1,25 @@
+/** \class THcMemoryAccount
+    \ingroup Base
+
+\brief Interface of the objects that report their memory to THcMemoryReport.
+
+THcMemoryReport::Collect counts the class size of every apparatus,
+detector, physics module and event type handler.  Objects that also own
+memory on the heap (hit lists, signal hit arrays, buffered events)
+implement AccountMemory and add it there by category, for example
+
+    void THcMyDetector::AccountMemory( THcMemoryReport& report ) const
+    {
+      THcHitList::AccountMemory(report);
+      report.Add("tracks", THcMemoryReport::Bytes(fTracks), THcMemoryReport::kDynamic);
+    }
+
+Large arrays that are members of the object itself are added as
+THcMemoryReport::kInline, so that they are listed by name without
+being counted twice.  THcHitList implements it for all detectors with
+a raw hit list.
+*/
+
+#include "THcMemoryAccount.h"
+
+ClassImp(THcMemoryAccount)
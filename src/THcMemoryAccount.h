@@ -0,0 +1,27 @@
+#ifndef ROOT_THcMemoryAccount
+#define ROOT_THcMemoryAccount
+
+//////////////////////////////////////////////////////////////////////////
+//
+// THcMemoryAccount
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "Rtypes.h"
+
+class THcMemoryReport;
+
+class THcMemoryAccount {
+
+public:
+
+  virtual ~THcMemoryAccount() {}
+
+  // Add the memory this object owns outside of its class size, by
+  // category, to report (THcMemoryReport::Add)
+  virtual void AccountMemory( THcMemoryReport& report ) const = 0;
+
+  ClassDef(THcMemoryAccount,0)	// Object reporting its memory to THcMemoryReport
+};
+
+#endif
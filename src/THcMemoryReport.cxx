@@ -0,0 +1,244 @@
+/** \class THcMemoryReport
+    \ingroup Base
+
+\brief Memory of the analysis objects, by apparatus, object and category.
+
+Collect walks the apparatus in gHaApps with their detectors, the
+physics modules in gHaPhysics and the event type handlers in
+gHaEvtHandlers.  Each object is counted with its class size, and the
+objects implementing THcMemoryAccount add the memory they own by
+category, for example the raw hit list of a detector (THcHitList), the
+signal hit arrays of the hodoscope, calorimeter, Cherenkov and aerogel
+detectors, the hits and space points of the drift chambers or the
+events buffered by the scaler handlers.  Subdetectors (planes,
+chambers, the fly's eye array) are added by their parent.  Other
+detectors with a hit list only report their raw hits.
+
+Static memory is what the parameters fix at Init.  Dynamic memory
+grows with the data; each Collect updates its high-water mark.  Print
+lists, in kB,
+
+    static   dynamic   peak   total
+
+where dynamic is from the last Collect, peak the high-water mark and
+total = static + peak.  The peak of an apparatus or object is the sum
+of the peaks of its categories, which need not have been reached in the
+same event, so it is an upper bound.  Option "all" also lists the
+categories of each object.
+
+THcAnalyzer::SetMemoryReport collects and prints the report at the end
+of each run, and during the replay every interval seconds if wanted.
+*/
+
+#include "THcMemoryReport.h"
+#include "THcMemoryAccount.h"
+#include "THaApparatus.h"
+#include "THaGlobals.h"
+#include "TClonesArray.h"
+#include "TClass.h"
+#include "TList.h"
+#include "TString.h"
+#include <iostream>
+#include <algorithm>
+
+using namespace std;
+
+//_____________________________________________________________________________
+THcMemoryReport::THcMemoryReport( Int_t interval )
+  : fInterval(interval), fNCalls(0), fLastDump(time(0)), fNCollect(0),
+    fInlineBytes(0)
+{
+  // Constructor
+}
+
+//_____________________________________________________________________________
+THcMemoryReport::~THcMemoryReport()
+{
+  // Destructor
+}
+
+//_____________________________________________________________________________
+void THcMemoryReport::Add( const char* category, Long64_t bytes, EKind kind )
+{
+  // Add bytes of category to the object being accounted.  Repeated
+  // calls for the same category in one Collect add up.
+  string key = fApparatus + "/" + fObject + "/" + category;
+  map<string, Int_t>::iterator it = fIndex.find(key);
+  if(it == fIndex.end()) {
+    Entry e;
+    e.apparatus = fApparatus;
+    e.object = fObject;
+    e.category = category;
+    e.staticBytes = e.dynamicBytes = e.peakBytes = 0;
+    it = fIndex.insert(make_pair(key, (Int_t)fEntries.size())).first;
+    fEntries.push_back(e);
+  }
+  Entry& e = fEntries[it->second];
+  if(kind == kDynamic) {
+    e.dynamicBytes += bytes;
+  } else {
+    e.staticBytes += bytes;
+    if(kind == kInline) fInlineBytes += bytes;
+  }
+}
+
+//_____________________________________________________________________________
+void THcMemoryReport::Account( TObject* obj, const char* apparatus,
+			       const char* name )
+{
+  // Class size of obj, less its kInline categories, and what it adds
+  // itself
+  fApparatus = apparatus;
+  fObject = name;
+  fInlineBytes = 0;
+  Add("object", 0, kStatic);	// List it first
+  THcMemoryAccount* account = dynamic_cast<THcMemoryAccount*>(obj);
+  if(account) account->AccountMemory(*this);
+  TClass* cl = obj->IsA();
+  Long64_t size = cl ? cl->Size() : 0;
+  Add("object", max(size-fInlineBytes, (Long64_t)0), kStatic);
+}
+
+//_____________________________________________________________________________
+void THcMemoryReport::Collect()
+{
+  // Account the memory of all analysis objects now
+  for(UInt_t i=0;i<fEntries.size();i++) {
+    fEntries[i].staticBytes = fEntries[i].dynamicBytes = 0;
+  }
+  TIter next(gHaApps);
+  while(TObject* obj = next()) {
+    Account(obj, obj->GetName(), obj->GetName());
+    THaApparatus* app = dynamic_cast<THaApparatus*>(obj);
+    if(!app) continue;
+    TIter nextdet(app->GetDetectors());
+    while(TObject* det = nextdet()) {
+      Account(det, app->GetName(), Form("%s.%s", app->GetName(), det->GetName()));
+    }
+  }
+  TIter nextphys(gHaPhysics);
+  while(TObject* obj = nextphys()) Account(obj, "physics", obj->GetName());
+  TIter nexthandler(gHaEvtHandlers);
+  while(TObject* obj = nexthandler()) Account(obj, "handlers", obj->GetName());
+  fApparatus.clear();
+  fObject.clear();
+
+  for(UInt_t i=0;i<fEntries.size();i++) {
+    fEntries[i].peakBytes = max(fEntries[i].peakBytes, fEntries[i].dynamicBytes);
+  }
+  fNCollect++;
+}
+
+//_____________________________________________________________________________
+Bool_t THcMemoryReport::IsDue()
+{
+  // True once the interval has passed since the last periodic dump.
+  // The clock is only read every 100 calls.
+  if(fInterval <= 0 || ++fNCalls < 100) return kFALSE;
+  fNCalls = 0;
+  if(difftime(time(0), fLastDump) < fInterval) return kFALSE;
+  fLastDump = time(0);
+  return kTRUE;
+}
+
+//_____________________________________________________________________________
+void THcMemoryReport::Reset()
+{
+  // Forget all entries and high-water marks
+  fEntries.clear();
+  fIndex.clear();
+  fNCollect = 0;
+  fNCalls = 0;
+  fLastDump = time(0);
+}
+
+//_____________________________________________________________________________
+Long64_t THcMemoryReport::GetStatic( const char* apparatus ) const
+{
+  // Static bytes of apparatus, or of everything if 0
+  Long64_t sum = 0;
+  for(UInt_t i=0;i<fEntries.size();i++) {
+    if(!apparatus || fEntries[i].apparatus == apparatus) sum += fEntries[i].staticBytes;
+  }
+  return sum;
+}
+
+//_____________________________________________________________________________
+Long64_t THcMemoryReport::GetPeak( const char* apparatus ) const
+{
+  // Dynamic high-water bytes of apparatus, or of everything if 0
+  Long64_t sum = 0;
+  for(UInt_t i=0;i<fEntries.size();i++) {
+    if(!apparatus || fEntries[i].apparatus == apparatus) sum += fEntries[i].peakBytes;
+  }
+  return sum;
+}
+
+//_____________________________________________________________________________
+Long64_t THcMemoryReport::Bytes( const TClonesArray* array )
+{
+  // Slots of array, each with a pointer in its list of objects and its
+  // list of kept objects, and an object
+  if(!array) return 0;
+  TClass* cl = array->GetClass();
+  return (Long64_t)array->GetSize()*(2*sizeof(TObject*) + (cl ? cl->Size() : 0));
+}
+
+//_____________________________________________________________________________
+static void PrintLine( const string& name, Long64_t s, Long64_t d, Long64_t p )
+{
+  cout << Form("%-36s %11.1f %11.1f %11.1f %11.1f", name.c_str(),
+	       s/1024., d/1024., p/1024., (s+p)/1024.) << endl;
+}
+
+//_____________________________________________________________________________
+void THcMemoryReport::Print( Option_t* opt ) const
+{
+  // Totals by apparatus and object, in kB.  Option "all": also by
+  // category.
+  TString option(opt);
+  option.ToLower();
+  Bool_t all = option.Contains("all");
+
+  cout << "THcMemoryReport: kB, " << fNCollect << " collections" << endl;
+  cout << Form("%-36s %11s %11s %11s %11s", "", "static", "dynamic",
+	       "peak", "total") << endl;
+  // Group by apparatus and object, in the order first seen
+  vector<string> apps;
+  for(UInt_t i=0;i<fEntries.size();i++) {
+    if(find(apps.begin(), apps.end(), fEntries[i].apparatus) == apps.end()) {
+      apps.push_back(fEntries[i].apparatus);
+    }
+  }
+  Long64_t ts = 0, td = 0, tp = 0;
+  for(UInt_t ia=0;ia<apps.size();ia++) {
+    vector<string> objs;
+    Long64_t as = 0, ad = 0, ap = 0;
+    for(UInt_t i=0;i<fEntries.size();i++) {
+      const Entry& e = fEntries[i];
+      if(e.apparatus != apps[ia]) continue;
+      as += e.staticBytes; ad += e.dynamicBytes; ap += e.peakBytes;
+      if(find(objs.begin(), objs.end(), e.object) == objs.end()) objs.push_back(e.object);
+    }
+    PrintLine(apps[ia], as, ad, ap);
+    ts += as; td += ad; tp += ap;
+    for(UInt_t io=0;io<objs.size();io++) {
+      Long64_t os = 0, od = 0, op = 0;
+      for(UInt_t i=0;i<fEntries.size();i++) {
+	const Entry& e = fEntries[i];
+	if(e.apparatus != apps[ia] || e.object != objs[io]) continue;
+	os += e.staticBytes; od += e.dynamicBytes; op += e.peakBytes;
+      }
+      PrintLine("  "+objs[io], os, od, op);
+      if(!all) continue;
+      for(UInt_t i=0;i<fEntries.size();i++) {
+	const Entry& e = fEntries[i];
+	if(e.apparatus != apps[ia] || e.object != objs[io]) continue;
+	PrintLine("    "+e.category, e.staticBytes, e.dynamicBytes, e.peakBytes);
+      }
+    }
+  }
+  PrintLine("Total", ts, td, tp);
+}
+
+ClassImp(THcMemoryReport)
@@ -0,0 +1,86 @@
+#ifndef ROOT_THcMemoryReport
+#define ROOT_THcMemoryReport
+
+//////////////////////////////////////////////////////////////////////////
+//
+// THcMemoryReport
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "Rtypes.h"
+#include <vector>
+#include <string>
+#include <map>
+#include <ctime>
+
+class TObject;
+class TClonesArray;
+
+class THcMemoryReport {
+
+public:
+
+  // Static: sized by the parameters at Init.  Dynamic: grows with the
+  // data, its high-water mark is kept.  Inline: static, and part of the
+  // class size of the object (a member array).
+  enum EKind { kStatic, kDynamic, kInline };
+
+  THcMemoryReport( Int_t interval=0 );
+  virtual ~THcMemoryReport();
+
+  // Called from THcMemoryAccount::AccountMemory
+  void   Add( const char* category, Long64_t bytes, EKind kind=kDynamic );
+
+  void   Collect();
+  void   Print( Option_t* opt="" ) const;
+  void   Reset();
+
+  // Periodic dumps during the replay, every interval seconds (0: none)
+  void   SetInterval( Int_t interval ) { fInterval = interval; }
+  Int_t  GetInterval() const { return fInterval; }
+  Bool_t IsDue();
+
+  Int_t    GetNCollect() const { return fNCollect; }
+  Long64_t GetStatic( const char* apparatus=0 ) const;
+  Long64_t GetPeak( const char* apparatus=0 ) const;
+
+  // Bytes of common containers.  All slots of a TClonesArray are counted
+  // as constructed objects, as THcHitList::InitHitList does.
+  static Long64_t Bytes( const TClonesArray* array );
+  template<class T>
+  static Long64_t Bytes( const std::vector<T>& v ) {
+    return (Long64_t)v.capacity()*sizeof(T);
+  }
+
+  // One category of one object
+  struct Entry {
+    std::string apparatus;	// Or "physics", "handlers"
+    std::string object;
+    std::string category;
+    Long64_t staticBytes;	// Of the last Collect
+    Long64_t dynamicBytes;	// Of the last Collect
+    Long64_t peakBytes;		// Highest dynamicBytes
+  };
+
+protected:
+
+  void   Account( TObject* obj, const char* apparatus, const char* name );
+
+  Int_t    fInterval;		// s between periodic dumps
+  Int_t    fNCalls;		// IsDue calls since the clock was read
+  time_t   fLastDump;
+  Int_t    fNCollect;		// Calls of Collect
+  std::vector<Entry> fEntries;	// In the order first seen
+  std::map<std::string, Int_t> fIndex; // apparatus/object/category -> entry
+  std::string fApparatus;	// Of the object being accounted
+  std::string fObject;
+  Long64_t fInlineBytes;	// kInline bytes added for it
+
+private:
+  THcMemoryReport( const THcMemoryReport& );
+  THcMemoryReport& operator=( const THcMemoryReport& );
+
+  ClassDef(THcMemoryReport,0)	// Memory of the analysis objects by category
+};
+
+#endif
@@ -45,6 +45,7 @@ An instance of THaTextvars is created to hold the string parameters.
 #include "TSystem.h"
 
 #include "THcParmList.h"
+#include "THcInitScheduler.h"
 #include "THaVar.h"
 #include "THaFormula.h"
 
@@ -543,8 +544,14 @@ If a requested parameter is not found in the parameter cache, an error
 is printed.  If the 5th element of a DBRequest structure is true (non
 zero), then there will be no error if the parameter is missing.
 
+Several detectors may load their parameters at the same time when they
+are initialized by a THcInitScheduler.
+
   */
 
+  // Only reads the list; may run concurrently in a THcInitScheduler
+  THcInitScheduler::ParallelSection parallel;
+
   const DBRequest *ti = list;
   Int_t cnt=0;
   Int_t this_cnt=0;
@@ -9,6 +9,8 @@
 
 #include "THaVarList.h"
 #include "THaTextvars.h"
+#include <set>
+#include <string>
 
 #ifdef WITH_CCDB
 #ifdef __CINT__
@@ -40,11 +42,14 @@ public:
   }
 
   Int_t AddString(const std::string& name, const std::string& value) {
+    fStringNames.insert(name);
     return(TextList->Add(name, value));
   }
   void RemoveString(const std::string& name) {
+    fStringNames.erase(name);
     TextList->Remove(name);
   }
+  const std::set<std::string>& GetStringNames() const { return fStringNames; }
 
   Int_t LoadParmValues(const DBRequest* list, const char* prefix=""); // assign values to the variables in list
 
@@ -62,6 +67,7 @@ public:
 private:
 
   THaTextvars* TextList;  //! Dictionary of string parameters
+  std::set<std::string> fStringNames; //! Names in TextList
 
 #ifdef WITH_CCDB
   SQLiteCalibration* CCDB_obj;
@@ -115,6 +115,8 @@ Int_t THcPeriodicReport::Process(const THaEvData &) {
 }
 //_____________________________________________________________________________
 void THcPeriodicReport::PrintReport() {
+  if (!fAnalyzer) // Not initialized yet
+    return;
   fAnalyzer->PrintReport(fTemplateFilename, fOutputFilename);
 }
 ///////////////////////////////////////////////////////////////////////////////
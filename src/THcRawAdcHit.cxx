@@ -246,51 +246,6 @@ void THcRawAdcHit::Clear(Option_t* opt) {
   fHasRefTime = kFALSE;
 }
 
-void THcRawAdcHit::SetData(Int_t data) {
-  if (fNPulses >= fMaxNPulses) {
-    throw std::out_of_range(
-      "`THcRawAdcHit::SetData`: too many pulses!"
-    );
-  }
-  fPulseInt[fNPulses] = data;
-  ++fNPulses;
-}
-
-void THcRawAdcHit::SetRefTime(Int_t refTime) {
-  fRefTime = refTime;
-  fHasRefTime = kTRUE;
-}
-
-void THcRawAdcHit::SetRefDiffTime(Int_t refDiffTime) {
-  fRefDiffTime = refDiffTime;
-}
-
-void THcRawAdcHit::SetSample(Int_t data) {
-  if (fNSamples >= fMaxNSamples) {
-    throw std::out_of_range(
-      "`THcRawAdcHit::SetSample`: too many samples!"
-    );
-  }
-  fSample[fNSamples] = data;
-  ++fNSamples;
-}
-
-void THcRawAdcHit::SetDataTimePedestalPeak(
-  Int_t data, Int_t time, Int_t pedestal, Int_t peak
-) {
-  if (fNPulses >= fMaxNPulses) {
-    throw std::out_of_range(
-      "`THcRawAdcHit::SetDataTimePedestalPeak`: too many pulses!"
-    );
-  }
-  fPulseInt[fNPulses] = data;
-  fPulseTime[fNPulses] = time;
-  fPed = pedestal;
-  fPulseAmp[fNPulses] = peak;
-  fHasMulti = kTRUE;
-  ++fNPulses;
-}
-
 Int_t THcRawAdcHit::GetRawData(UInt_t iPulse) const {
   if (iPulse >= fNPulses && iPulse != 0) {
     TString msg = TString::Format(
@@ -2,6 +2,7 @@
 #define ROOT_THcRawAdcHit
 
 #include "TObject.h"
+#include <stdexcept>
 
 
 class THcRawAdcHit : public TObject {
@@ -92,4 +93,51 @@ class THcRawAdcHit : public TObject {
 };
 
 
+// The setters are called for every decoded channel and are kept inline.
+inline void THcRawAdcHit::SetData(Int_t data) {
+  if (fNPulses >= fMaxNPulses) {
+    throw std::out_of_range(
+      "`THcRawAdcHit::SetData`: too many pulses!"
+    );
+  }
+  fPulseInt[fNPulses] = data;
+  ++fNPulses;
+}
+
+inline void THcRawAdcHit::SetRefTime(Int_t refTime) {
+  fRefTime = refTime;
+  fHasRefTime = kTRUE;
+}
+
+inline void THcRawAdcHit::SetRefDiffTime(Int_t refDiffTime) {
+  fRefDiffTime = refDiffTime;
+}
+
+inline void THcRawAdcHit::SetSample(Int_t data) {
+  if (fNSamples >= fMaxNSamples) {
+    throw std::out_of_range(
+      "`THcRawAdcHit::SetSample`: too many samples!"
+    );
+  }
+  fSample[fNSamples] = data;
+  ++fNSamples;
+}
+
+inline void THcRawAdcHit::SetDataTimePedestalPeak(
+  Int_t data, Int_t time, Int_t pedestal, Int_t peak
+) {
+  if (fNPulses >= fMaxNPulses) {
+    throw std::out_of_range(
+      "`THcRawAdcHit::SetDataTimePedestalPeak`: too many pulses!"
+    );
+  }
+  fPulseInt[fNPulses] = data;
+  fPulseTime[fNPulses] = time;
+  fPed = pedestal;
+  fPulseAmp[fNPulses] = peak;
+  fHasMulti = kTRUE;
+  ++fNPulses;
+}
+
+
 #endif  // ROOT_THcRawAdcHit
@@ -31,6 +31,14 @@ class THcRawDCHit : public THcRawHit {
 
     THcRawTdcHit& GetRawTdcHit();
 
+    // Inline setters for the templated decoding in THcHitList.  Only
+    // signal 0 exists, which THcHitList::InitHitList checks once.
+    void FillData(Int_t, Int_t data) {fTdcHit.SetTime(data);}
+    void FillReference(Int_t, Int_t reference, Int_t referenceDiff) {
+      fTdcHit.SetRefTime(reference);
+      fTdcHit.SetRefDiffTime(referenceDiff);
+    }
+
   protected:
     static const Int_t fNTdcSignals = 1;
 
@@ -45,6 +45,19 @@ public:
 
   virtual void SetF250Params(Int_t NSA, Int_t NSB, Int_t NPED) {};
 
+  // Statically bound setters used by the templated decoding in
+  // THcHitList.  Hit classes with a fixed signal layout hide these with
+  // inline versions; here they just forward to the virtual setters.
+  void FillData(Int_t signal, Int_t data) {SetData(signal, data);}
+  void FillSample(Int_t signal, Int_t data) {SetSample(signal, data);}
+  void FillDataTimePedestalPeak(Int_t signal, Int_t data,
+				Int_t time, Int_t pedestal, Int_t peak)
+  {SetDataTimePedestalPeak(signal, data, time, pedestal, peak);}
+  void FillReference(Int_t signal, Int_t reference, Int_t referenceDiff)
+  {SetReference(signal, reference); SetReferenceDiff(signal, referenceDiff);}
+  void FillF250Params(Int_t NSA, Int_t NSB, Int_t NPED)
+  {SetF250Params(NSA, NSB, NPED);}
+
   // Derived objects must be sortable and supply Compare method
   //  virtual Bool_t  IsSortable () const {return kFALSE; }
   //  virtual Int_t   Compare(const TObject* obj) const {return 0;}
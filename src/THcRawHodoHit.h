@@ -43,6 +43,42 @@ class THcRawHodoHit : public THcRawHit {
 
     void SetF250Params(Int_t NSA, Int_t NSB, Int_t NPED);
 
+    // Inline setters for the templated decoding in THcHitList.  Signal
+    // numbers are checked once in THcHitList::InitHitList.
+    void FillData(Int_t signal, Int_t data) {
+      if (signal < fNAdcSignals) fAdcHits[signal].SetData(data);
+      else fTdcHits[signal-fNAdcSignals].SetTime(data);
+    }
+    // A TDC signal mapped to an FADC channel goes to the checked setter,
+    // which throws
+    void FillSample(Int_t signal, Int_t data) {
+      if (signal < fNAdcSignals) fAdcHits[signal].SetSample(data);
+      else SetSample(signal, data);
+    }
+    void FillDataTimePedestalPeak(
+      Int_t signal, Int_t data, Int_t time, Int_t pedestal, Int_t peak
+    ) {
+      if (signal < fNAdcSignals) {
+        fAdcHits[signal].SetDataTimePedestalPeak(data, time, pedestal, peak);
+      } else {
+        SetDataTimePedestalPeak(signal, data, time, pedestal, peak);
+      }
+    }
+    void FillReference(Int_t signal, Int_t reference, Int_t referenceDiff) {
+      if (signal < fNAdcSignals) {
+        fAdcHits[signal].SetRefTime(reference);
+        fAdcHits[signal].SetRefDiffTime(referenceDiff);
+      } else {
+        fTdcHits[signal-fNAdcSignals].SetRefTime(reference);
+        fTdcHits[signal-fNAdcSignals].SetRefDiffTime(referenceDiff);
+      }
+    }
+    void FillF250Params(Int_t NSA, Int_t NSB, Int_t NPED) {
+      for (Int_t iAdcSig=0; iAdcSig<fNAdcSignals; ++iAdcSig) {
+        fAdcHits[iAdcSig].SetF250Params(NSA, NSB, NPED);
+      }
+    }
+
   protected:
     static const Int_t fNAdcSignals = 2;
     static const Int_t fNTdcSignals = 2;
@@ -34,6 +34,29 @@ class THcRawShowerHit : public THcRawHit {
 
     void SetF250Params(Int_t NSA, Int_t NSB, Int_t NPED);
 
+    // Inline setters for the templated decoding in THcHitList.  Signal
+    // numbers are checked once in THcHitList::InitHitList.
+    void FillData(Int_t signal, Int_t data) {
+      fAdcHits[signal].SetData(data);
+    }
+    void FillSample(Int_t signal, Int_t data) {
+      fAdcHits[signal].SetSample(data);
+    }
+    void FillDataTimePedestalPeak(
+      Int_t signal, Int_t data, Int_t time, Int_t pedestal, Int_t peak
+    ) {
+      fAdcHits[signal].SetDataTimePedestalPeak(data, time, pedestal, peak);
+    }
+    void FillReference(Int_t signal, Int_t reference, Int_t referenceDiff) {
+      fAdcHits[signal].SetRefTime(reference);
+      fAdcHits[signal].SetRefDiffTime(referenceDiff);
+    }
+    void FillF250Params(Int_t NSA, Int_t NSB, Int_t NPED) {
+      for (Int_t iAdcSig=0; iAdcSig<fNAdcSignals; ++iAdcSig) {
+        fAdcHits[iAdcSig].SetF250Params(NSA, NSB, NPED);
+      }
+    }
+
   protected:
     static const Int_t fNAdcSignals = 2;
 
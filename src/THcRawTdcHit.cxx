@@ -120,28 +120,12 @@ void THcRawTdcHit::Clear(Option_t* opt) {
 }
 
 
-void THcRawTdcHit::SetTime(Int_t time) {
-  if (fNHits < fMaxNHits) {
-    fTime[fNHits] = time;
-    ++fNHits;
-  }
-  else {
-    TString msg = TString::Format(
-      "`THcRawTdcHit::SetTime`: Trying to set too many hits! Only %d slots available.",
-      fMaxNHits
-    );
-    throw std::out_of_range(msg.Data());
-  }
-}
-
-
-void THcRawTdcHit::SetRefTime(Int_t refTime) {
-  fRefTime = refTime;
-  fHasRefTime = kTRUE;
-}
-
-void THcRawTdcHit::SetRefDiffTime(Int_t refDiffTime) {
-  fRefDiffTime = refDiffTime;
+void THcRawTdcHit::TooManyHits() const {
+  TString msg = TString::Format(
+    "`THcRawTdcHit::SetTime`: Trying to set too many hits! Only %d slots available.",
+    fMaxNHits
+  );
+  throw std::out_of_range(msg.Data());
 }
 
 
@@ -38,8 +38,31 @@ class THcRawTdcHit : public TObject {
     UInt_t fNHits;
 
   private:
+    void TooManyHits() const;
+
     ClassDef(THcRawTdcHit, 0)
 };
 
 
+// The setters are called for every decoded hit and are kept inline.
+inline void THcRawTdcHit::SetTime(Int_t time) {
+  if (fNHits < fMaxNHits) {
+    fTime[fNHits] = time;
+    ++fNHits;
+  }
+  else {
+    TooManyHits();
+  }
+}
+
+inline void THcRawTdcHit::SetRefTime(Int_t refTime) {
+  fRefTime = refTime;
+  fHasRefTime = kTRUE;
+}
+
+inline void THcRawTdcHit::SetRefDiffTime(Int_t refDiffTime) {
+  fRefDiffTime = refDiffTime;
+}
+
+
 #endif  // ROOT_THcRawTdcHit
@@ -0,0 +1,283 @@
+/** \class THcReadAhead
+    \ingroup Base
+
+\brief Reads the events of a THcRun in a separate thread, ahead of the analysis.
+
+THcRun::ReadEvent normally reads each event just before it is analyzed,
+so the analysis waits for the file (or the network file system) every
+event.  With THcRun::SetReadAhead(depth) the run starts a THcReadAhead on
+its first event.  It reads the events in a reader thread into a ring of
+depth buffers, and ReadEvent then only takes the next buffer from the
+ring.  Reading and analysis overlap; the analysis waits only when the
+reader falls behind.
+
+The reader also checks each event before queueing it: in a bank of banks
+event, the lengths of the top level banks must add up to the event
+length.  Events that fail are still passed on, since the decoder reports
+them better, but they are counted.
+
+The buffer returned by GetEvBuffer stays valid until the next call of
+Next, which is what THaEvData::LoadEvent needs.  The event counts seen
+by the analysis (GetNEventsRead, used by THcCheckpoint) are those of the
+event handed out, not of the reader.
+
+PrintStats reports how often and how long the analysis waited for the
+reader, and the reader for a free buffer.  A mostly empty queue means
+the replay is limited by reading, a mostly full one by the analysis.
+
+The analysis itself stays in the main thread: THaAnalyzer fills its
+THaEvData from the buffer, so decoding cannot move to the reader.
+Without C++11 there is no reader thread and the events are read
+directly.
+*/
+
+#include "THcReadAhead.h"
+#include "THcRun.h"
+#include <iostream>
+#if __cplusplus >= 201103L
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#endif
+
+using namespace std;
+
+#if __cplusplus >= 201103L
+struct THcReadAhead::Sync {
+  thread reader;
+  mutex lock;
+  condition_variable notEmpty;	// An event was queued, or the reader ended
+  condition_variable notFull;	// A slot was freed, or Stop was called
+};
+
+typedef chrono::steady_clock Clock;
+
+// The stage whose reader runs in this thread
+static thread_local const THcReadAhead* fgReader = 0;
+
+static Double_t Seconds( Clock::time_point t0 )
+{
+  return chrono::duration<Double_t>(Clock::now() - t0).count();
+}
+#else
+struct THcReadAhead::Sync {};
+#endif
+
+//_____________________________________________________________________________
+THcReadAhead::THcReadAhead( THcRun* run, Int_t depth )
+  : fRun(run), fDepth(depth < 2 ? 2 : depth), fHead(0), fTail(0),
+    fCurrent(-1), fStop(kFALSE), fDone(kFALSE), fThreaded(kFALSE),
+    fNEvents(0), fNBadEvents(0), fNConsumerWaits(0), fNProducerWaits(0),
+    fConsumerWaitTime(0), fProducerWaitTime(0), fQueueDepthSum(0),
+    fDirectRead(kFALSE), fSync(new Sync)
+{
+  // Constructor.  depth is the number of buffers; one of them holds the
+  // event being analyzed.
+#if __cplusplus < 201103L
+  fDepth = 1;
+#endif
+  fSlots.resize(fDepth);
+  for(Int_t i=0;i<fDepth;i++) {
+    fSlots[i].status = THaRunBase::READ_EOF;
+    fSlots[i].nread = 0;
+    fSlots[i].ncontrol = 0;
+  }
+}
+
+//_____________________________________________________________________________
+THcReadAhead::~THcReadAhead()
+{
+  Stop();
+  delete fSync;
+}
+
+//_____________________________________________________________________________
+void THcReadAhead::Start()
+{
+  // Start the reader thread
+  if(fThreaded) return;
+  fHead = fTail = 0;
+  fCurrent = -1;
+  fStop = fDone = kFALSE;
+#if __cplusplus >= 201103L
+  fSync->reader = thread(&THcReadAhead::Produce, this);
+  fThreaded = kTRUE;
+#endif
+}
+
+//_____________________________________________________________________________
+void THcReadAhead::Stop()
+{
+  // Stop the reader thread and wait for it.  Events still queued are
+  // dropped.
+#if __cplusplus >= 201103L
+  if(!fThreaded) return;
+  {
+    lock_guard<mutex> lock(fSync->lock);
+    fStop = kTRUE;
+  }
+  fSync->notFull.notify_all();
+  fSync->reader.join();
+  fThreaded = kFALSE;
+#endif
+}
+
+//_____________________________________________________________________________
+Bool_t THcReadAhead::InReader() const
+{
+  // True if called from the reader thread, e.g. by a run that opens its
+  // file on the first read.  The run must not stop the stage then.
+#if __cplusplus >= 201103L
+  if(fgReader == this) return kTRUE;
+#endif
+  return fDirectRead;
+}
+
+//_____________________________________________________________________________
+void THcReadAhead::Fill( Slot& slot )
+{
+  // Read one event of the run into slot
+  slot.status = fRun->ReadEventDirect();
+  slot.nread = fRun->fNEventsRead;
+  slot.ncontrol = fRun->fNControlRead;
+  if(slot.status != THaRunBase::READ_OK) {
+    slot.buffer.clear();
+    return;
+  }
+  const UInt_t* buf = fRun->DirectEvBuffer();
+  UInt_t nwords = buf ? buf[0]+1 : 0;
+  slot.buffer.assign(buf, buf+nwords);
+  if(!IsValidEvent(nwords ? &slot.buffer[0] : 0, nwords)) fNBadEvents++;
+}
+
+//_____________________________________________________________________________
+void THcReadAhead::Produce()
+{
+  // Body of the reader thread.  Fills slots until the run ends or Stop
+  // is called.  The slot of the event being analyzed, fHead-1, is never
+  // overwritten, so at most fDepth-1 events are queued.
+#if __cplusplus >= 201103L
+  fgReader = this;
+  Sync& s = *fSync;
+  while(1) {
+    {
+      unique_lock<mutex> lock(s.lock);
+      if(!fStop && fTail-fHead >= fDepth-1) {
+	fNProducerWaits++;
+	Clock::time_point t0 = Clock::now();
+	s.notFull.wait(lock, [this]{ return fStop || fTail-fHead < fDepth-1; });
+	fProducerWaitTime += Seconds(t0);
+      }
+      if(fStop) break;
+    }
+    // The analysis does not touch slots from fTail on
+    Slot& slot = fSlots[fTail%fDepth];
+    Fill(slot);
+    Int_t status = slot.status;
+    {
+      lock_guard<mutex> lock(s.lock);
+      fTail++;
+      if(status != THaRunBase::READ_OK) fDone = kTRUE;
+    }
+    s.notEmpty.notify_one();
+    if(status != THaRunBase::READ_OK) return;
+  }
+  {
+    lock_guard<mutex> lock(s.lock);
+    fDone = kTRUE;
+  }
+  s.notEmpty.notify_one();
+#endif
+}
+
+//_____________________________________________________________________________
+Int_t THcReadAhead::Next()
+{
+  // Take the next event from the queue, waiting for the reader if it is
+  // empty.  Returns the status of THcRun::ReadEvent for the event.  Once
+  // the reader has ended, the status of its last read is returned.
+#if __cplusplus >= 201103L
+  if(fThreaded) {
+    Sync& s = *fSync;
+    unique_lock<mutex> lock(s.lock);
+    if(fHead == fTail && !fDone) {
+      fNConsumerWaits++;
+      Clock::time_point t0 = Clock::now();
+      s.notEmpty.wait(lock, [this]{ return fHead < fTail || fDone; });
+      fConsumerWaitTime += Seconds(t0);
+    }
+    if(fHead == fTail) {
+      return (fTail > 0) ? fSlots[(fTail-1)%fDepth].status
+	: THaRunBase::READ_EOF;
+    }
+    fQueueDepthSum += fTail-fHead;
+    fCurrent = fHead%fDepth;
+    fHead++;
+    lock.unlock();
+    s.notFull.notify_one();
+    if(fSlots[fCurrent].status == THaRunBase::READ_OK) fNEvents++;
+    return fSlots[fCurrent].status;
+  }
+#endif
+  // No reader thread: read directly
+  fDirectRead = kTRUE;
+  Fill(fSlots[0]);
+  fDirectRead = kFALSE;
+  fCurrent = 0;
+  fHead++;
+  fTail++;
+  if(fSlots[0].status == THaRunBase::READ_OK) fNEvents++;
+  return fSlots[0].status;
+}
+
+//_____________________________________________________________________________
+const UInt_t* THcReadAhead::GetEvBuffer() const
+{
+  if(fCurrent < 0 || fSlots[fCurrent].buffer.empty()) return 0;
+  return &fSlots[fCurrent].buffer[0];
+}
+
+//_____________________________________________________________________________
+Long64_t THcReadAhead::GetNEventsRead() const
+{
+  return (fCurrent < 0) ? 0 : fSlots[fCurrent].nread;
+}
+
+//_____________________________________________________________________________
+Long64_t THcReadAhead::GetNControlRead() const
+{
+  return (fCurrent < 0) ? 0 : fSlots[fCurrent].ncontrol;
+}
+
+//_____________________________________________________________________________
+Bool_t THcReadAhead::IsValidEvent( const UInt_t* buffer, UInt_t nwords )
+{
+  /**
+     Check the framing of a CODA event: the length word must match
+     nwords and, for a bank of banks (content type 0x10 or 0x0e), the
+     top level banks must fill the event exactly.
+  */
+  if(!buffer || nwords < 2 || buffer[0]+1 != nwords) return kFALSE;
+  UInt_t dtype = (buffer[1]>>8)&0x3f;
+  if(dtype != 0x10 && dtype != 0x0e) return kTRUE;
+  ULong64_t pos = 2;
+  while(pos < nwords) pos += (ULong64_t)buffer[pos]+1;
+  return pos == nwords;
+}
+
+//_____________________________________________________________________________
+void THcReadAhead::PrintStats() const
+{
+  cout << "THcReadAhead: " << fNEvents << " events, depth " << fDepth
+       << ", mean queued " << GetMeanQueueDepth() << endl;
+  cout << "  analysis waited " << fNConsumerWaits << " times ("
+       << fConsumerWaitTime << " s), reader waited " << fNProducerWaits
+       << " times (" << fProducerWaitTime << " s)" << endl;
+  if(fNBadEvents > 0) {
+    cout << "  " << fNBadEvents << " events with inconsistent bank lengths"
+	 << endl;
+  }
+}
+
+ClassImp(THcReadAhead)
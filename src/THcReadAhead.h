@@ -0,0 +1,88 @@
+#ifndef ROOT_THcReadAhead
+#define ROOT_THcReadAhead
+
+//////////////////////////////////////////////////////////////////////////
+//
+// THcReadAhead
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "Rtypes.h"
+#include <vector>
+
+class THcRun;
+
+class THcReadAhead {
+
+public:
+
+  THcReadAhead( THcRun* run, Int_t depth=64 );
+  virtual ~THcReadAhead();
+
+  void   Start();
+  void   Stop();
+  Int_t  Next();
+  const UInt_t* GetEvBuffer() const;
+  Long64_t GetNEventsRead() const;
+  Long64_t GetNControlRead() const;
+  void   PrintStats() const;
+  Bool_t InReader() const;
+
+  Bool_t   IsThreaded() const { return fThreaded; }
+  Int_t    GetDepth() const { return fDepth; }
+  Long64_t GetNEvents() const { return fNEvents; }
+  Long64_t GetNBadEvents() const { return fNBadEvents; }
+  Long64_t GetNConsumerWaits() const { return fNConsumerWaits; }
+  Long64_t GetNProducerWaits() const { return fNProducerWaits; }
+  Double_t GetConsumerWaitTime() const { return fConsumerWaitTime; }
+  Double_t GetProducerWaitTime() const { return fProducerWaitTime; }
+  Double_t GetMeanQueueDepth() const {
+    return (fHead > 0) ? fQueueDepthSum/fHead : 0.;
+  }
+
+  static Bool_t IsValidEvent( const UInt_t* buffer, UInt_t nwords );
+
+  // One event read ahead
+  struct Slot {
+    std::vector<UInt_t> buffer;
+    Int_t    status;		// Of THcRun::ReadEventDirect
+    Long64_t nread;		// Events the run had read after this one
+    Long64_t ncontrol;		// Control events among them
+  };
+
+protected:
+
+  void   Fill( Slot& slot );
+  void   Produce();
+
+  THcRun*  fRun;
+  Int_t    fDepth;		// Slots in the ring
+  std::vector<Slot> fSlots;
+  Long64_t fHead;		// Events taken by Next
+  Long64_t fTail;		// Events filled by the reader
+  Int_t    fCurrent;		// Slot of the current event, -1 if none
+  Bool_t   fStop;		// Reader is asked to stop
+  Bool_t   fDone;		// Reader has filled its last slot
+  Bool_t   fThreaded;		// A reader thread is running
+
+  // Statistics
+  Long64_t fNEvents;		// Events handed out with status READ_OK
+  Long64_t fNBadEvents;		// Events failing IsValidEvent
+  Long64_t fNConsumerWaits;	// Times Next waited for the reader
+  Long64_t fNProducerWaits;	// Times the reader waited for a free slot
+  Double_t fConsumerWaitTime;	// s
+  Double_t fProducerWaitTime;	// s
+  Double_t fQueueDepthSum;	// Events ready, summed over Next calls
+  Bool_t   fDirectRead;		// Reading without a thread, in Next
+
+  struct Sync;
+  Sync*    fSync;		//! Thread, mutex and conditions
+
+private:
+  THcReadAhead( const THcReadAhead& );
+  THcReadAhead& operator=( const THcReadAhead& );
+
+  ClassDef(THcReadAhead,0)	// Reads events of a THcRun in a separate thread
+};
+
+#endif
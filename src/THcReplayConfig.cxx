@@ -0,0 +1,663 @@
+/** \class THcReplayConfig
+    \ingroup Base
+
+    \brief Sets up and runs a replay from a configuration file, without macros.
+
+    The configuration file lists what a replay script builds, one item
+    per line.  Everything after a # is a comment; words with spaces are
+    quoted.  File names are relative to the working directory, and %d
+    in the run file, output file and report names is the run number.
+
+        database       DBASE/test.database
+        parm_file_from g_ctp_parm_filename
+        parm_file      PARAM/hcana.param
+        exec           ./make_cratemap.pl < ${g_decode_map_filename} > db_cratemap.dat
+
+        apparatus THcHallCSpectrometer H "HMS"
+        detector  H THcHodoscope hod "Hodoscope"
+        detector  H THcShower cal "Shower"
+        detector  H THcDC dc "Drift Chambers"
+        physics   THaGoldenTrack H.gold "HMS Golden Track" H
+        physics   THcHodoEff hhodeff "HMS Hodoscope Efficiencies" H.hod
+        handler   THcScalerEvtHandler HS "HC scaler event type 0" debug_file=HScaler.txt
+
+        run_file  daq04_%d.log.0
+        out_file  hodtest_%d.root
+        odef_file output.def
+        cut_file  hodtest_cuts.def
+        report    report.template report_%d.out
+        count_mode 2
+        runs      50017
+        events    100000
+
+    The parameter files are loaded in the order given: database with
+    the run number, parm_file and parm_file_from (a string parameter
+    naming the file) after it.  The detector map is g_decode_map_filename.
+    exec runs a shell command after the parameters of the first run
+    are loaded; ${name} is replaced by the string parameter name.
+
+    Object lines give the class, the name, the description and the
+    further constructor arguments, followed by key=value options:
+    events= and seconds= for THcPeriodicReport, debug_file= for all
+    event type handlers, delayed_type=, first_event=, only_sync= for
+    the scaler handlers, and scaler= (a handler name) for THcHelicity.
+    Objects are constructed by compiled code registered by class name
+    (AddClass), so no interpreter is involved; classes of other
+    libraries can be added the same way before Setup.
+
+    Analyzer lines: run_file, out_file, odef_file, cut_file,
+    summary_file, report (template and output file), count_mode,
+    lazy_output, request_file, batch_histograms (block size and
+    threads), column_output (file, definition file, chunk size,
+    threads), checkpoint (file and interval), read_ahead (events read
+    ahead in a separate thread), init_threads (threads initializing the
+    detectors), memory_report (optional interval in seconds for dumps
+    during the run), benchmarks, runs (first and last), events (count,
+    or first and last).
+
+    The runs are replayed with THcBatchReplay.  The hcana-replay program
+    reads a configuration file and replays it without starting the
+    interactive interface:
+
+        hcana-replay [-n nevents] [--resume] hodtest.replay [run ...]
+
+    Runs given on the command line replace the runs of the file.
+*/
+
+#include "THcReplayConfig.h"
+#include "THcAnalyzer.h"
+#include "THcBatchReplay.h"
+#include "THcGlobals.h"
+#include "THcParmList.h"
+#include "THcHallCSpectrometer.h"
+#include "THcRasteredBeam.h"
+#include "THcTrigApp.h"
+#include "THcDummySpectrometer.h"
+#include "THcHodoscope.h"
+#include "THcShower.h"
+#include "THcDC.h"
+#include "THcAerogel.h"
+#include "THcCherenkov.h"
+#include "THcRaster.h"
+#include "THcTrigDet.h"
+#include "THcHelicity.h"
+#include "THcHodoEff.h"
+#include "THcPrimaryKine.h"
+#include "THcSecondaryKine.h"
+#include "THcReactionPoint.h"
+#include "THcExtTarCor.h"
+#include "THcCoinTime.h"
+#include "THcBCMCurrent.h"
+#include "THcPeriodicReport.h"
+#include "THcScalerEvtHandler.h"
+#include "THcHelicityScaler.h"
+#include "THcConfigEvtHandler.h"
+#include "THcTimeSyncEvtHandler.h"
+#include "THaGoldenTrack.h"
+#include "THaApparatus.h"
+#include "THaDetector.h"
+#include "THaPhysicsModule.h"
+#include "THaEvtTypeHandler.h"
+#include "THaEvent.h"
+#include "THaGlobals.h"
+#include "TList.h"
+#include "TError.h"
+#include <fstream>
+#include <iostream>
+#include <cstdlib>
+
+using namespace std;
+
+std::map<std::string, THcReplayConfig::Maker>* THcReplayConfig::fgMakers = 0;
+
+//_____________________________________________________________________________
+const char* THcReplayConfig::Args::Str(UInt_t i, const char* def) const
+{
+  return (i < args.size()) ? args[i].Data() : def;
+}
+
+//_____________________________________________________________________________
+Double_t THcReplayConfig::Args::Num(UInt_t i, Double_t def) const
+{
+  return (i < args.size()) ? args[i].Atof() : def;
+}
+
+//_____________________________________________________________________________
+Bool_t THcReplayConfig::Args::IsNum(UInt_t i) const
+{
+  return i < args.size() && args[i].IsFloat();
+}
+
+//_____________________________________________________________________________
+Bool_t THcReplayConfig::Args::HasOption(const char* key) const
+{
+  return options.find(key) != options.end();
+}
+
+//_____________________________________________________________________________
+const char* THcReplayConfig::Args::Option(const char* key, const char* def) const
+{
+  map<string, TString>::const_iterator it = options.find(key);
+  return (it != options.end()) ? it->second.Data() : def;
+}
+
+//_____________________________________________________________________________
+// Compiled constructors of the classes usable in configuration files
+
+static THaAnalysisObject* MakeHallCSpectrometer(const THcReplayConfig::Args& a)
+{ return new THcHallCSpectrometer(a.Str(0), a.Str(1)); }
+static THaAnalysisObject* MakeRasteredBeam(const THcReplayConfig::Args& a)
+{ return new THcRasteredBeam(a.Str(0), a.Str(1)); }
+static THaAnalysisObject* MakeTrigApp(const THcReplayConfig::Args& a)
+{ return new THcTrigApp(a.Str(0), a.Str(1)); }
+static THaAnalysisObject* MakeDummySpectrometer(const THcReplayConfig::Args& a)
+{ return new THcDummySpectrometer(a.Str(0), a.Str(1)); }
+
+static THaAnalysisObject* MakeHodoscope(const THcReplayConfig::Args& a)
+{ return new THcHodoscope(a.Str(0), a.Str(1)); }
+static THaAnalysisObject* MakeShower(const THcReplayConfig::Args& a)
+{ return new THcShower(a.Str(0), a.Str(1)); }
+static THaAnalysisObject* MakeDC(const THcReplayConfig::Args& a)
+{ return new THcDC(a.Str(0), a.Str(1)); }
+static THaAnalysisObject* MakeAerogel(const THcReplayConfig::Args& a)
+{ return new THcAerogel(a.Str(0), a.Str(1)); }
+static THaAnalysisObject* MakeCherenkov(const THcReplayConfig::Args& a)
+{ return new THcCherenkov(a.Str(0), a.Str(1)); }
+static THaAnalysisObject* MakeRaster(const THcReplayConfig::Args& a)
+{ return new THcRaster(a.Str(0), a.Str(1)); }
+static THaAnalysisObject* MakeTrigDet(const THcReplayConfig::Args& a)
+{ return new THcTrigDet(a.Str(0), a.Str(1)); }
+static THaAnalysisObject* MakeHelicity(const THcReplayConfig::Args& a)
+{ return new THcHelicity(a.Str(0), a.Str(1)); }
+
+static THaAnalysisObject* MakeGoldenTrack(const THcReplayConfig::Args& a)
+{ return new THaGoldenTrack(a.Str(0), a.Str(1), a.Str(2)); }
+static THaAnalysisObject* MakeHodoEff(const THcReplayConfig::Args& a)
+{ return new THcHodoEff(a.Str(0), a.Str(1), a.Str(2)); }
+static THaAnalysisObject* MakePrimaryKine(const THcReplayConfig::Args& a)
+{
+  // spectro, particle mass, target mass; or spectro, beam, target mass
+  if(a.args.size() > 3 && !a.IsNum(3)) {
+    return new THcPrimaryKine(a.Str(0), a.Str(1), a.Str(2), a.Str(3), a.Num(4));
+  }
+  return new THcPrimaryKine(a.Str(0), a.Str(1), a.Str(2), a.Num(3), a.Num(4));
+}
+static THaAnalysisObject* MakeSecondaryKine(const THcReplayConfig::Args& a)
+{ return new THcSecondaryKine(a.Str(0), a.Str(1), a.Str(2), a.Str(3), a.Num(4)); }
+static THaAnalysisObject* MakeReactionPoint(const THcReplayConfig::Args& a)
+{ return new THcReactionPoint(a.Str(0), a.Str(1), a.Str(2), a.Str(3)); }
+static THaAnalysisObject* MakeExtTarCor(const THcReplayConfig::Args& a)
+{ return new THcExtTarCor(a.Str(0), a.Str(1), a.Str(2), a.Str(3)); }
+static THaAnalysisObject* MakeCoinTime(const THcReplayConfig::Args& a)
+{ return new THcCoinTime(a.Str(0), a.Str(1), a.Str(2), a.Str(3), a.Str(4)); }
+static THaAnalysisObject* MakeBCMCurrent(const THcReplayConfig::Args& a)
+{ return new THcBCMCurrent(a.Str(0), a.Str(1)); }
+static THaAnalysisObject* MakePeriodicReport(const THcReplayConfig::Args& a)
+{
+  THcPeriodicReport* rep = new THcPeriodicReport(a.Str(0), a.Str(1), a.Str(2), a.Str(3));
+  if(a.HasOption("events")) rep->SetEventPeriod(atoi(a.Option("events")));
+  if(a.HasOption("seconds")) rep->SetTimePeriod(atoi(a.Option("seconds")));
+  return rep;
+}
+
+static THaAnalysisObject* MakeScalerEvtHandler(const THcReplayConfig::Args& a)
+{
+  THcScalerEvtHandler* h = new THcScalerEvtHandler(a.Str(0), a.Str(1));
+  if(a.HasOption("delayed_type")) h->SetDelayedType(atoi(a.Option("delayed_type")));
+  if(a.HasOption("first_event")) h->SetUseFirstEvent(atoi(a.Option("first_event")) != 0);
+  if(a.HasOption("only_sync")) h->SetOnlyUseSyncEvents(atoi(a.Option("only_sync")) != 0);
+  return h;
+}
+static THaAnalysisObject* MakeHelicityScaler(const THcReplayConfig::Args& a)
+{
+  THcHelicityScaler* h = new THcHelicityScaler(a.Str(0), a.Str(1));
+  if(a.HasOption("delayed_type")) h->SetDelayedType(atoi(a.Option("delayed_type")));
+  if(a.HasOption("first_event")) h->SetUseFirstEvent(atoi(a.Option("first_event")) != 0);
+  if(a.HasOption("roc")) h->SetROC(atoi(a.Option("roc")));
+  if(a.HasOption("bank")) h->SetBankID(atoi(a.Option("bank")));
+  if(a.HasOption("channels")) h->SetNScalerChannels(atoi(a.Option("channels")));
+  return h;
+}
+static THaAnalysisObject* MakeConfigEvtHandler(const THcReplayConfig::Args& a)
+{
+  THcConfigEvtHandler* h = new THcConfigEvtHandler(a.Str(0), a.Str(1));
+  if(a.HasOption("evtype")) h->AddEventType(atoi(a.Option("evtype")));
+  return h;
+}
+static THaAnalysisObject* MakeTimeSyncEvtHandler(const THcReplayConfig::Args& a)
+{
+  THcTimeSyncEvtHandler* h = new THcTimeSyncEvtHandler(a.Str(0), a.Str(1));
+  if(a.HasOption("bad_roc")) h->SetBadROC(atoi(a.Option("bad_roc")));
+  if(a.HasOption("resync")) h->SetResync(atoi(a.Option("resync")) != 0);
+  return h;
+}
+
+//_____________________________________________________________________________
+void THcReplayConfig::InitClasses()
+{
+  if(fgMakers) return;
+  fgMakers = new map<string, Maker>;
+  map<string, Maker>& m = *fgMakers;
+  m["THcHallCSpectrometer"] = MakeHallCSpectrometer;
+  m["THcRasteredBeam"] = MakeRasteredBeam;
+  m["THcTrigApp"] = MakeTrigApp;
+  m["THcDummySpectrometer"] = MakeDummySpectrometer;
+  m["THcHodoscope"] = MakeHodoscope;
+  m["THcShower"] = MakeShower;
+  m["THcDC"] = MakeDC;
+  m["THcAerogel"] = MakeAerogel;
+  m["THcCherenkov"] = MakeCherenkov;
+  m["THcRaster"] = MakeRaster;
+  m["THcTrigDet"] = MakeTrigDet;
+  m["THcHelicity"] = MakeHelicity;
+  m["THaGoldenTrack"] = MakeGoldenTrack;
+  m["THcHodoEff"] = MakeHodoEff;
+  m["THcPrimaryKine"] = MakePrimaryKine;
+  m["THcSecondaryKine"] = MakeSecondaryKine;
+  m["THcReactionPoint"] = MakeReactionPoint;
+  m["THcExtTarCor"] = MakeExtTarCor;
+  m["THcCoinTime"] = MakeCoinTime;
+  m["THcBCMCurrent"] = MakeBCMCurrent;
+  m["THcPeriodicReport"] = MakePeriodicReport;
+  m["THcScalerEvtHandler"] = MakeScalerEvtHandler;
+  m["THcHelicityScaler"] = MakeHelicityScaler;
+  m["THcConfigEvtHandler"] = MakeConfigEvtHandler;
+  m["THcTimeSyncEvtHandler"] = MakeTimeSyncEvtHandler;
+}
+
+//_____________________________________________________________________________
+void THcReplayConfig::AddClass(const char* classname, Maker maker)
+{
+  // Make classname usable in configuration files.  maker gets the
+  // arguments of the line and returns the new object.
+  InitClasses();
+  (*fgMakers)[classname] = maker;
+}
+
+//_____________________________________________________________________________
+Bool_t THcReplayConfig::HasClass(const char* classname)
+{
+  InitClasses();
+  return fgMakers->find(classname) != fgMakers->end();
+}
+
+//_____________________________________________________________________________
+THcReplayConfig::THcReplayConfig()
+  : fColumnChunkSize(4096), fColumnThreads(1), fCheckpointInterval(60),
+    fReadAheadDepth(0), fInitThreads(1), fMemoryReport(-1), fHistBlockSize(0), fHistThreads(1), fCountMode(-1), fLazyOutput(kFALSE),
+    fBenchmarks(kFALSE), fNEvents(-1), fFirstEvent(1), fAnalyzer(0),
+    fEvent(0), fBatch(0)
+{
+  InitClasses();
+}
+
+//_____________________________________________________________________________
+THcReplayConfig::~THcReplayConfig()
+{
+  // The apparatus, physics modules and handlers stay in the global lists
+  delete fBatch;
+  delete fAnalyzer;
+  delete fEvent;
+}
+
+//_____________________________________________________________________________
+Int_t THcReplayConfig::Tokenize(const char* line, vector<TString>& tokens)
+{
+  // Split line at white space, keeping quoted strings together and
+  // dropping comments.  Returns -1 for an unterminated quote.
+  tokens.clear();
+  const char* p = line;
+  while(*p) {
+    while(*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+    if(!*p || *p == '#') break;
+    TString token;
+    if(*p == '"') {
+      p++;
+      while(*p && *p != '"') token.Append(*p++);
+      if(*p != '"') return -1;
+      p++;
+    } else {
+      while(*p && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n' && *p != '#') {
+	token.Append(*p++);
+      }
+    }
+    tokens.push_back(token);
+  }
+  return tokens.size();
+}
+
+//_____________________________________________________________________________
+Int_t THcReplayConfig::Load(const char* filename)
+{
+  /**
+     Read the configuration file.  Returns the number of errors, or -1
+     if the file can not be opened.
+  */
+  ifstream ifile(filename);
+  if(!ifile) {
+    ::Error("THcReplayConfig::Load", "Can not open %s", filename);
+    return -1;
+  }
+  fFileName = filename;
+  Int_t nerrors = 0;
+  Int_t lineno = 0;
+  string line;
+  vector<TString> tokens;
+  while(getline(ifile, line)) {
+    lineno++;
+    TString text(line.c_str());
+    text = text.Strip(TString::kBoth);
+    if(text.BeginsWith("exec ") || text.BeginsWith("exec\t")) {
+      // The rest of the line is the command, quotes and all
+      fCommands.push_back(TString(text(5, text.Length()-5)).Strip(TString::kLeading));
+      continue;
+    }
+    if(Tokenize(line.c_str(), tokens) < 0) {
+      ::Error("THcReplayConfig::Load", "%s:%d: unterminated quote", filename, lineno);
+      nerrors++;
+      continue;
+    }
+    if(tokens.empty()) continue;
+    if(ParseLine(tokens, lineno) != 0) {
+      ::Error("THcReplayConfig::Load", "%s:%d: can not use \"%s\"", filename,
+	      lineno, line.c_str());
+      nerrors++;
+    }
+  }
+  return nerrors;
+}
+
+//_____________________________________________________________________________
+Int_t THcReplayConfig::ParseLine(const vector<TString>& tokens, Int_t line)
+{
+  const TString& key = tokens[0];
+  UInt_t n = tokens.size();
+  if(key == "database" && n == 2) {
+    fDatabaseFile = tokens[1];
+  } else if(key == "parm_file" && n == 2) {
+    fParmFiles.push_back(tokens[1]);
+    fParmFromString.push_back(kFALSE);
+  } else if(key == "parm_file_from" && n == 2) {
+    fParmFiles.push_back(tokens[1]);
+    fParmFromString.push_back(kTRUE);
+  } else if(key == "apparatus" || key == "detector" || key == "physics" ||
+	    key == "handler") {
+    Object obj;
+    obj.kind = key;
+    obj.line = line;
+    UInt_t first = 1;
+    if(key == "detector") {
+      if(n < 2) return -1;
+      obj.apparatus = tokens[first++];
+    }
+    if(n < first+2) return -1;	// Class and name at least
+    obj.classname = tokens[first++];
+    for(UInt_t i=first;i<n;i++) {
+      Ssiz_t eq = tokens[i].Index("=");
+      if(i >= first+2 && eq > 0) {
+	obj.args.options[TString(tokens[i](0, eq)).Data()] =
+	  tokens[i](eq+1, tokens[i].Length()-eq-1);
+      } else {
+	obj.args.args.push_back(tokens[i]);
+      }
+    }
+    if(obj.args.args.size() < 2) obj.args.args.push_back(obj.args.args[0]);
+    if(!HasClass(obj.classname.Data())) {
+      ::Error("THcReplayConfig::Load", "Unknown class %s", obj.classname.Data());
+      return -1;
+    }
+    fObjects.push_back(obj);
+  } else if(key == "run_file" && n == 2) {
+    fRunFilePattern = tokens[1];
+  } else if(key == "out_file" && n == 2) {
+    fOutFilePattern = tokens[1];
+  } else if(key == "odef_file" && n == 2) {
+    fOdefFile = tokens[1];
+  } else if(key == "cut_file" && n == 2) {
+    fCutFile = tokens[1];
+  } else if(key == "summary_file" && n == 2) {
+    fSummaryFile = tokens[1];
+  } else if(key == "report" && n == 3) {
+    fReportTemplates.push_back(tokens[1]);
+    fReportPatterns.push_back(tokens[2]);
+  } else if(key == "request_file" && n == 2) {
+    fRequestFiles.push_back(tokens[1]);
+  } else if(key == "lazy_output" && n == 1) {
+    fLazyOutput = kTRUE;
+  } else if(key == "count_mode" && n == 2) {
+    fCountMode = tokens[1].Atoi();
+  } else if(key == "batch_histograms" && (n == 2 || n == 3)) {
+    fHistBlockSize = tokens[1].Atoi();
+    if(n == 3) fHistThreads = tokens[2].Atoi();
+  } else if(key == "column_output" && n >= 3 && n <= 5) {
+    fColumnFile = tokens[1];
+    fColumnDefFile = tokens[2];
+    if(n > 3) fColumnChunkSize = tokens[3].Atoi();
+    if(n > 4) fColumnThreads = tokens[4].Atoi();
+  } else if(key == "checkpoint" && (n == 2 || n == 3)) {
+    fCheckpointFile = tokens[1];
+    if(n == 3) fCheckpointInterval = tokens[2].Atoi();
+  } else if(key == "read_ahead" && n == 2) {
+    fReadAheadDepth = tokens[1].Atoi();
+  } else if(key == "init_threads" && n == 2) {
+    fInitThreads = tokens[1].Atoi();
+  } else if(key == "memory_report" && (n == 1 || n == 2)) {
+    fMemoryReport = (n == 2) ? tokens[1].Atoi() : 0;
+  } else if(key == "benchmarks" && n == 1) {
+    fBenchmarks = kTRUE;
+  } else if(key == "runs" && (n == 2 || n == 3)) {
+    Int_t first = tokens[1].Atoi();
+    Int_t last = (n == 3) ? tokens[2].Atoi() : first;
+    for(Int_t run=first;run<=last;run++) fRuns.push_back(run);
+  } else if(key == "events" && n == 2) {
+    fNEvents = tokens[1].Atoi();
+  } else if(key == "events" && n == 3) {
+    fFirstEvent = tokens[1].Atoi();
+    fNEvents = tokens[2].Atoi() - fFirstEvent + 1;
+  } else {
+    return -1;
+  }
+  return 0;
+}
+
+//_____________________________________________________________________________
+TString THcReplayConfig::Substitute(const TString& text) const
+{
+  // Replace ${name} by the value of the string parameter name
+  TString result;
+  Ssiz_t pos = 0;
+  while(pos < text.Length()) {
+    Ssiz_t start = text.Index("${", pos);
+    Ssiz_t end = (start >= 0) ? text.Index("}", start) : -1;
+    if(start < 0 || end < 0) {
+      result += text(pos, text.Length()-pos);
+      break;
+    }
+    result += text(pos, start-pos);
+    TString name = text(start+2, end-start-2);
+    const char* value = gHcParms->GetString(name.Data());
+    if(value) {
+      result += value;
+    } else {
+      ::Warning("THcReplayConfig::Substitute", "No string parameter %s", name.Data());
+    }
+    pos = end+1;
+  }
+  return result;
+}
+
+//_____________________________________________________________________________
+THaAnalysisObject* THcReplayConfig::Make(const Object& obj) const
+{
+  map<string, Maker>::const_iterator it = fgMakers->find(obj.classname.Data());
+  if(it == fgMakers->end()) return 0;
+  return (*it->second)(obj.args);
+}
+
+//_____________________________________________________________________________
+Int_t THcReplayConfig::BuildObjects()
+{
+  // Construct the objects, apparatus first so that the detector lines
+  // may come before or after their apparatus
+  const char* kinds[] = { "apparatus", "detector", "physics", "handler" };
+  Int_t nerrors = 0;
+  for(Int_t ik=0;ik<4;ik++) {
+    for(UInt_t i=0;i<fObjects.size();i++) {
+      const Object& obj = fObjects[i];
+      if(obj.kind != kinds[ik]) continue;
+      THaAnalysisObject* made = Make(obj);
+      THaApparatus* app = dynamic_cast<THaApparatus*>(made);
+      THaDetector* det = dynamic_cast<THaDetector*>(made);
+      THaPhysicsModule* phys = dynamic_cast<THaPhysicsModule*>(made);
+      THaEvtTypeHandler* handler = dynamic_cast<THaEvtTypeHandler*>(made);
+      if(ik == 0 && app) {
+	gHaApps->Add(app);
+      } else if(ik == 1 && det) {
+	THaApparatus* owner =
+	  static_cast<THaApparatus*>(gHaApps->FindObject(obj.apparatus.Data()));
+	if(!owner) {
+	  ::Error("THcReplayConfig::Setup", "%s:%d: no apparatus %s",
+		  fFileName.Data(), obj.line, obj.apparatus.Data());
+	  delete det;
+	  nerrors++;
+	  continue;
+	}
+	owner->AddDetector(det);
+      } else if(ik == 2 && phys) {
+	gHaPhysics->Add(phys);
+      } else if(ik == 3 && handler) {
+	if(obj.args.HasOption("debug_file")) {
+	  handler->SetDebugFile(obj.args.Option("debug_file"));
+	}
+	gHaEvtHandlers->Add(handler);
+      } else {
+	::Error("THcReplayConfig::Setup", "%s:%d: %s is not a %s", fFileName.Data(),
+		obj.line, obj.classname.Data(), obj.kind.Data());
+	delete made;
+	nerrors++;
+      }
+    }
+  }
+
+  // Helicity detectors take the helicity scaler handler
+  for(UInt_t i=0;i<fObjects.size();i++) {
+    const Object& obj = fObjects[i];
+    if(obj.kind != "detector" || !obj.args.HasOption("scaler")) continue;
+    THaApparatus* owner =
+      static_cast<THaApparatus*>(gHaApps->FindObject(obj.apparatus.Data()));
+    THcHelicity* hel = owner ?
+      dynamic_cast<THcHelicity*>(owner->GetDetector(obj.args.Str(0))) : 0;
+    THcHelicityScaler* scaler = dynamic_cast<THcHelicityScaler*>
+      (gHaEvtHandlers->FindObject(obj.args.Option("scaler")));
+    if(!hel || !scaler) {
+      ::Error("THcReplayConfig::Setup", "%s:%d: no helicity scaler %s",
+	      fFileName.Data(), obj.line, obj.args.Option("scaler"));
+      nerrors++;
+      continue;
+    }
+    hel->SetHelicityScaler(scaler);
+  }
+  return nerrors;
+}
+
+//_____________________________________________________________________________
+Int_t THcReplayConfig::Setup()
+{
+  /**
+     Load the parameters of the first run, run the exec commands, and
+     build the apparatus, detectors, physics modules, handlers and the
+     analyzer.  Returns the number of errors.
+  */
+  if(fRuns.empty()) {
+    ::Error("THcReplayConfig::Setup", "No runs to replay");
+    return 1;
+  }
+  if(fRunFilePattern.IsNull()) {
+    ::Error("THcReplayConfig::Setup", "No run_file");
+    return 1;
+  }
+  fAnalyzer = new THcAnalyzer;
+  fBatch = new THcBatchReplay(fAnalyzer);
+  if(!fDatabaseFile.IsNull()) fBatch->SetDatabase(fDatabaseFile.Data());
+  for(UInt_t i=0;i<fParmFiles.size();i++) {
+    if(fParmFromString[i]) {
+      fBatch->AddParmFileFromString(fParmFiles[i].Data());
+    } else {
+      fBatch->AddParmFile(fParmFiles[i].Data());
+    }
+  }
+  fBatch->SetRunFilePattern(fRunFilePattern.Data());
+  fBatch->SetOutFilePattern(fOutFilePattern.Data());
+  for(UInt_t i=0;i<fReportTemplates.size();i++) {
+    fBatch->AddReport(fReportTemplates[i].Data(), fReportPatterns[i].Data());
+  }
+  fBatch->SetNEvents(fNEvents);
+  fBatch->SetFirstEvent(fFirstEvent);
+  for(UInt_t i=0;i<fRuns.size();i++) fBatch->AddRun(fRuns[i]);
+
+  fBatch->LoadParameters(fRuns[0]);
+  Int_t nerrors = 0;
+  for(UInt_t i=0;i<fCommands.size();i++) {
+    TString command = Substitute(fCommands[i]);
+    if(system(command.Data()) != 0) {
+      ::Error("THcReplayConfig::Setup", "Command failed: %s", command.Data());
+      nerrors++;
+    }
+  }
+
+  nerrors += BuildObjects();
+
+  fEvent = new THaEvent;
+  fAnalyzer->SetEvent(fEvent);
+  if(!fOdefFile.IsNull()) fAnalyzer->SetOdefFile(fOdefFile.Data());
+  if(!fCutFile.IsNull()) fAnalyzer->SetCutFile(fCutFile.Data());
+  if(!fSummaryFile.IsNull()) fAnalyzer->SetSummaryFile(fSummaryFile.Data());
+  if(fCountMode >= 0) fAnalyzer->SetCountMode(fCountMode);
+  fAnalyzer->SetLazyOutput(fLazyOutput);
+  for(UInt_t i=0;i<fRequestFiles.size();i++) {
+    fAnalyzer->AddRequestFile(fRequestFiles[i].Data());
+  }
+  for(UInt_t i=0;i<fReportTemplates.size();i++) {
+    if(fLazyOutput) fAnalyzer->AddRequestFile(fReportTemplates[i].Data());
+  }
+  if(fHistBlockSize > 0) fAnalyzer->SetBatchHistograms(fHistBlockSize, fHistThreads);
+  if(!fColumnFile.IsNull() &&
+     fAnalyzer->SetColumnOutput(fColumnFile.Data(), fColumnDefFile.Data(),
+				fColumnChunkSize, fColumnThreads) != 0) {
+    nerrors++;
+  }
+  if(!fCheckpointFile.IsNull()) {
+    fAnalyzer->SetCheckpoint(fCheckpointFile.Data(), fCheckpointInterval);
+  }
+  if(fReadAheadDepth > 0) fAnalyzer->SetReadAhead(fReadAheadDepth);
+  if(fInitThreads != 1) fAnalyzer->SetInitThreads(fInitThreads);
+  if(fMemoryReport >= 0) fAnalyzer->SetMemoryReport(fMemoryReport);
+  if(fBenchmarks) fAnalyzer->EnableBenchmarks();
+  return nerrors;
+}
+
+//_____________________________________________________________________________
+Int_t THcReplayConfig::Process()
+{
+  // Replay all runs.  Returns the number of runs that failed.
+  if(!fBatch) {
+    ::Error("THcReplayConfig::Process", "Setup not done");
+    return fRuns.size();
+  }
+  return fBatch->Process();
+}
+
+//_____________________________________________________________________________
+void THcReplayConfig::Print() const
+{
+  cout << "Replay configuration " << fFileName << ": " << fRuns.size()
+       << " runs, " << fObjects.size() << " objects" << endl;
+  for(UInt_t i=0;i<fObjects.size();i++) {
+    const Object& obj = fObjects[i];
+    cout << "  " << obj.kind << " " << obj.classname << " ";
+    if(!obj.apparatus.IsNull()) cout << obj.apparatus << ".";
+    cout << obj.args.Str(0) << endl;
+  }
+}
+
+ClassImp(THcReplayConfig)
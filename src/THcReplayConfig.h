@@ -0,0 +1,121 @@
+#ifndef ROOT_THcReplayConfig
+#define ROOT_THcReplayConfig
+
+//////////////////////////////////////////////////////////////////////////
+//
+// THcReplayConfig
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "Rtypes.h"
+#include "TString.h"
+#include <map>
+#include <string>
+#include <vector>
+
+class THcAnalyzer;
+class THcBatchReplay;
+class THaEvent;
+class THaAnalysisObject;
+
+class THcReplayConfig {
+
+public:
+
+  THcReplayConfig();
+  virtual ~THcReplayConfig();
+
+  // Arguments of an object line: name, description, further
+  // arguments, and key=value options
+  struct Args {
+    std::vector<TString> args;
+    std::map<std::string, TString> options;
+    const char* Str(UInt_t i, const char* def="") const;
+    Double_t    Num(UInt_t i, Double_t def=0.0) const;
+    Bool_t      IsNum(UInt_t i) const;
+    Bool_t      HasOption(const char* key) const;
+    const char* Option(const char* key, const char* def="") const;
+  };
+  typedef THaAnalysisObject* (*Maker)(const Args&);
+
+  // Compiled constructors, by class name
+  static void   AddClass(const char* classname, Maker maker);
+  static Bool_t HasClass(const char* classname);
+
+  Int_t  Load(const char* filename);
+  Int_t  Setup();
+  Int_t  Process();
+
+  void   AddRun(Int_t run) {fRuns.push_back(run);}
+  void   ClearRuns() {fRuns.clear();}
+  void   SetNEvents(Int_t nevents) {fNEvents = nevents;}
+  void   SetFirstEvent(Int_t first) {fFirstEvent = first;}
+  Int_t  GetNRuns() const {return fRuns.size();}
+  THcAnalyzer* GetAnalyzer() const {return fAnalyzer;}
+  void   Print() const;
+
+  // One object to construct: apparatus, detector, physics module or
+  // event type handler
+  struct Object {
+    TString kind;
+    TString classname;
+    TString apparatus;		// Detectors: name of their apparatus
+    Args    args;
+    Int_t   line;
+  };
+
+protected:
+
+  Int_t  ParseLine(const std::vector<TString>& tokens, Int_t line);
+  Int_t  BuildObjects();
+  THaAnalysisObject* Make(const Object& obj) const;
+  TString Substitute(const TString& text) const;
+  static Int_t Tokenize(const char* line, std::vector<TString>& tokens);
+  static void  InitClasses();
+
+  TString  fFileName;
+  TString  fDatabaseFile;
+  std::vector<TString> fParmFiles;	// Loaded in this order
+  std::vector<Bool_t>  fParmFromString;	// fParmFiles entry is a string parameter
+  std::vector<TString> fCommands;	// Shell commands after loading parameters
+  std::vector<Object>  fObjects;
+  TString  fRunFilePattern;
+  TString  fOutFilePattern;
+  TString  fOdefFile;
+  TString  fCutFile;
+  TString  fSummaryFile;
+  std::vector<TString> fReportTemplates;
+  std::vector<TString> fReportPatterns;
+  std::vector<TString> fRequestFiles;
+  TString  fColumnFile;
+  TString  fColumnDefFile;
+  Int_t    fColumnChunkSize;
+  Int_t    fColumnThreads;
+  TString  fCheckpointFile;
+  Int_t    fCheckpointInterval;
+  Int_t    fReadAheadDepth;		// Events read ahead if > 0
+  Int_t    fInitThreads;		// Concurrent detector Init if != 1
+  Int_t    fMemoryReport;		// Interval in s, 0: end of run only, -1: off
+  Int_t    fHistBlockSize;		// Batch histograms if > 0
+  Int_t    fHistThreads;
+  Int_t    fCountMode;
+  Bool_t   fLazyOutput;
+  Bool_t   fBenchmarks;
+  std::vector<Int_t> fRuns;
+  Int_t    fNEvents;
+  Int_t    fFirstEvent;
+
+  THcAnalyzer*    fAnalyzer;
+  THaEvent*       fEvent;
+  THcBatchReplay* fBatch;
+
+  static std::map<std::string, Maker>* fgMakers;
+
+private:
+  THcReplayConfig(const THcReplayConfig&);
+  THcReplayConfig& operator=(const THcReplayConfig&);
+
+  ClassDef(THcReplayConfig,0)	// Replay set up from a configuration file
+};
+
+#endif
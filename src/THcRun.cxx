@@ -3,12 +3,22 @@
 
 \brief Description of a CODA run on disk with Hall C parameter DB
 
+Counts the events read since the file was opened and can skip a number
+of them, for resuming a replay from a THcCheckpoint.
+
+With SetReadAhead(depth), the events are read in a separate thread by a
+THcReadAhead, which keeps up to depth of them ready while the current
+one is analyzed.  Subclasses that read differently override
+ReadEventDirect and DirectEvBuffer, which the read-ahead stage calls.
+
 \author S. A. Wood, 31-October-2017
 
 */
 #include "THcRun.h"
 #include "THcGlobals.h"
+#include "THcReadAhead.h"
 #include "TSystem.h"
+#include <iostream>
 
 using namespace std;
 
@@ -19,6 +29,12 @@ THcRun::THcRun( const char* fname, const char* description ) :
   // Normal & default constructor
   
   fHcParms = gHcParms;
+  fNEventsRead = 0;
+  fNControlRead = 0;
+  fNSkip = 0;
+  fReadAheadDepth = 0;
+  fReadAhead = 0;
+  fReadAheadStarted = kFALSE;
 }
 
 //_____________________________________________________________________________
@@ -28,6 +44,12 @@ THcRun::THcRun( const THcRun& rhs ) :
   // Copy ctor
 
   fHcParms = gHcParms;
+  fNEventsRead = 0;
+  fNControlRead = 0;
+  fNSkip = 0;
+  fReadAheadDepth = rhs.fReadAheadDepth;
+  fReadAhead = 0;
+  fReadAheadStarted = kFALSE;
 }
 
 //_____________________________________________________________________________
@@ -37,6 +59,12 @@ THcRun::THcRun( const vector<TString>& pathList, const char* filename,
 {
   
   fHcParms = gHcParms;
+  fNEventsRead = 0;
+  fNControlRead = 0;
+  fNSkip = 0;
+  fReadAheadDepth = 0;
+  fReadAhead = 0;
+  fReadAheadStarted = kFALSE;
 }
 
 //_____________________________________________________________________________
@@ -45,8 +73,15 @@ THcRun& THcRun::operator=(const THaRunBase& rhs)
   // Assignment operator.  Not really sure what I (saw) am doing here.
 
   if (this != &rhs) {
+     StopReadAhead();
      THaRun::operator=(rhs);
      fHcParms = gHcParms;
+     fNEventsRead = 0;
+     fNControlRead = 0;
+     fNSkip = 0;
+     // THaAnalyzer analyzes a copy of the run made with this
+     const THcRun* hcrhs = dynamic_cast<const THcRun*>(&rhs);
+     if(hcrhs) fReadAheadDepth = hcrhs->fReadAheadDepth;
   }
   return *this;
 }
@@ -56,6 +91,104 @@ THcRun::~THcRun()
 {
   // Destructor.
 
+  StopReadAhead();
+}
+
+//_____________________________________________________________________________
+Int_t THcRun::Open()
+{
+  StopReadAhead();
+  fNEventsRead = 0;
+  fNControlRead = 0;
+  fReadAheadStarted = kFALSE;
+  return THaRun::Open();
+}
+
+//_____________________________________________________________________________
+Int_t THcRun::Close()
+{
+  StopReadAhead();
+  return THaRun::Close();
+}
+
+//_____________________________________________________________________________
+void THcRun::StopReadAhead()
+{
+  /// Stop the reader thread, if any.  Must be called before the file
+  /// it reads is closed.  Does nothing in the reader thread itself
+  /// (a run opening its file on the first read).
+  if(fReadAhead && !fReadAhead->InReader()) {
+    fReadAhead->Stop();
+    if(fReadAhead->GetNEvents() > 0) fReadAhead->PrintStats();
+    delete fReadAhead;
+    fReadAhead = 0;
+  }
+}
+
+//_____________________________________________________________________________
+Int_t THcRun::ReadEvent()
+{
+  /// Read the next event, from the read-ahead stage if SetReadAhead
+  /// was called.  The stage starts on the first event.
+  if(fReadAheadDepth <= 0 && !fReadAhead) return ReadEventDirect();
+  if(!fReadAhead) {
+    fReadAhead = new THcReadAhead(this, fReadAheadDepth);
+    fReadAhead->Start();
+    fReadAheadStarted = fReadAhead->IsThreaded();
+    if(!fReadAheadStarted) {
+      Warning("ReadEvent", "No reader thread in this build, reading in the analysis thread");
+    }
+  }
+  return fReadAhead->Next();
+}
+
+//_____________________________________________________________________________
+const UInt_t* THcRun::GetEvBuffer() const
+{
+  return fReadAhead ? fReadAhead->GetEvBuffer() : DirectEvBuffer();
+}
+
+//_____________________________________________________________________________
+Long64_t THcRun::GetNEventsRead() const
+{
+  /// Events read since Open.  With read-ahead, those handed to the
+  /// analysis, not those the reader thread is ahead by.
+  return fReadAhead ? fReadAhead->GetNEventsRead() : fNEventsRead;
+}
+
+//_____________________________________________________________________________
+Long64_t THcRun::GetNControlRead() const
+{
+  /// Control and configuration events among the events read since Open.
+  /// These are the events still returned while skipping.
+  return fReadAhead ? fReadAhead->GetNControlRead() : fNControlRead;
+}
+
+//_____________________________________________________________________________
+Int_t THcRun::ReadEventDirect()
+{
+  /// Read the next event from the file.  While events are to be skipped
+  /// (SkipEvents), only control events (types 16-31) and configuration
+  /// events (125) are returned, since the analysis needs them to set up
+  /// decoding.
+  while(1) {
+    Int_t status = THaRun::ReadEvent();
+    if(status != READ_OK) return status;
+    fNEventsRead++;
+    Bool_t control = IsControlEvent(DirectEvBuffer());
+    if(control) fNControlRead++;
+    if(fNSkip <= 0) return status;
+    if(--fNSkip == 0) {
+      cout << "THcRun: skipped to event " << fNEventsRead << endl;
+    }
+    if(control) return status;
+  }
+}
+
+//_____________________________________________________________________________
+const UInt_t* THcRun::DirectEvBuffer() const
+{
+  return THaRun::GetEvBuffer();
 }
 
 //_____________________________________________________________________________
@@ -10,6 +10,8 @@
 #include "THaRun.h"
 #include "THcParmList.h"
 
+class THcReadAhead;
+
 class THcRun : public THaRun {
 
  public:
@@ -20,8 +22,43 @@ class THcRun : public THaRun {
   THcRun& operator=( const THaRunBase& rhs );
   virtual ~THcRun();
   virtual void         Print( Option_t* opt="" ) const;
+  virtual Int_t        Open();
+  virtual Int_t        Close();
+  virtual Int_t        ReadEvent();
+  virtual const UInt_t* GetEvBuffer() const;
   THcParmList* GetHCParms() const { return fHcParms; }
 
+  // Resuming from a THcCheckpoint
+  void     SkipEvents( Long64_t n ) { fNSkip = n; }
+  Long64_t GetNEventsRead() const;
+  Long64_t GetNControlRead() const;
+
+  // Read up to depth events ahead in a separate thread (0: no read-ahead)
+  void     SetReadAhead( Int_t depth ) { fReadAheadDepth = depth; }
+  Int_t    GetReadAhead() const { return fReadAheadDepth; }
+  THcReadAhead* GetReadAheadStage() const { return fReadAhead; }
+  // True if a reader thread was started since Open
+  Bool_t   IsReadAheadStarted() const { return fReadAheadStarted; }
+
+ protected:
+  friend class THcReadAhead;
+
+  virtual Int_t ReadEventDirect();
+  virtual const UInt_t* DirectEvBuffer() const;
+  void     StopReadAhead();
+  // Control (types 16-31) or configuration (125) event
+  static Bool_t IsControlEvent( const UInt_t* buf ) {
+    UInt_t evtype = buf[1]>>16;
+    return (evtype >= 16 && evtype <= 31) || evtype == 125;
+  }
+
+  Long64_t fNEventsRead;	/* Events read since Open */
+  Long64_t fNControlRead;	/* Control and configuration events among them */
+  Long64_t fNSkip;		/* Events still to skip */
+  Int_t    fReadAheadDepth;	/* Events to read ahead */
+  THcReadAhead* fReadAhead;	/* Read-ahead stage, if started */
+  Bool_t   fReadAheadStarted;	/* A reader thread ran since Open */
+
  private:
   THcParmList* fHcParms;	/* gHcParms object */
   
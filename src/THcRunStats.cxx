@@ -0,0 +1,382 @@
+/** \class THcRunStats
+    \ingroup Base
+
+    \brief Registry of run level counters and histograms, sharded per thread.
+
+    Efficiency and diagnostic counters are booked once, usually in a
+    detector's Init or DefineVariables, with DefineCounter or
+    DefineHistogram.  The returned id is used to increment them every
+    event.  A counter booked later, during a run, starts at zero and the
+    others keep their counts.  Each analysis thread writes only its own
+    shard (selected with SetThreadShard, 0 by default).  The shards are
+    padded to cache lines, so threads never write the same line.  Merge
+    sums the shards in shard order, which makes the result independent
+    of the thread scheduling.
+
+    The merged values are what gHcParms points to, so reports see the
+    state of the last merge.  THcAnalyzer::PrintReport calls MergeAll
+    before substituting a template, which also covers THcPeriodicReport.
+    Objects reading their own counters (e.g. in End) call Merge first.
+
+    A counter defined with n=0 is published as a scalar, otherwise as an
+    array of n elements.  An empty name books a counter that is not
+    published.
+
+    SaveAll and RestoreAll copy the merged values of all registries for
+    THcCheckpoint.
+*/
+
+#include "THcRunStats.h"
+#include "THcGlobals.h"
+#include "THcParmList.h"
+#include "TError.h"
+#include <cstring>
+#include <algorithm>
+#if __cplusplus >= 201103L
+#include <mutex>
+#endif
+
+using namespace std;
+
+// Cells per cache line.  Shards start on their own line.
+static const Int_t kCellsPerLine = 64/sizeof(Int_t);
+
+static Int_t fgDefaultNShards = 1;
+#if __cplusplus >= 201103L
+static thread_local Int_t fgThreadShard = 0;
+#else
+static Int_t fgThreadShard = 0;
+#endif
+
+namespace {
+  // All existing registries, for MergeAll and friends
+  struct Registries {
+    std::vector<THcRunStats*> list;
+#if __cplusplus >= 201103L
+    std::mutex lock;
+#endif
+  };
+  // Created on first use and never deleted, so that registries that are
+  // destroyed at exit, after the static objects of this file, can still
+  // remove themselves
+  Registries& GetRegistries()
+  {
+    static Registries* registries = new Registries;
+    return *registries;
+  }
+}
+
+//_____________________________________________________________________________
+THcRunStats::THcRunStats()
+  : fNCells(0), fStride(0), fNShards(fgDefaultNShards),
+    fShardBuffer(0), fShardData(0)
+{
+  // Constructor.  Registers the object for MergeAll.
+  Registries& reg = GetRegistries();
+#if __cplusplus >= 201103L
+  lock_guard<mutex> lock(reg.lock);
+#endif
+  reg.list.push_back(this);
+}
+
+//_____________________________________________________________________________
+THcRunStats::~THcRunStats()
+{
+  // Destructor.  Removes the published counters from gHcParms.
+  Clear();
+  delete [] fShardBuffer;
+  Registries& reg = GetRegistries();
+#if __cplusplus >= 201103L
+  lock_guard<mutex> lock(reg.lock);
+#endif
+  reg.list.erase(remove(reg.list.begin(), reg.list.end(), this),
+		 reg.list.end());
+}
+
+//_____________________________________________________________________________
+void THcRunStats::Clear()
+{
+  // Drop all counters, e.g. before booking them again in a new Init
+  for(UInt_t id=0;id<fCounters.size();id++) {
+    if(gHcParms && fCounters[id].name.Length() > 0) {
+      gHcParms->RemoveName(fCounters[id].name.Data());
+    }
+    delete [] fCounters[id].values;
+  }
+  fCounters.clear();
+  fOffset.clear();
+  fNCells = 0;
+}
+
+//_____________________________________________________________________________
+Int_t THcRunStats::DefineCounter(const char* name, const char* desc, Int_t n)
+{
+  /**
+     Book a counter, or an array of n counters, and publish it in gHcParms
+     as name (n=0) or name[n].  Returns the id used to increment it.
+  */
+  Int_t id = Book((n > 0 ? n : 1), (n > 0), 0, 0., 0.);
+  Publish(id, name, desc);
+  return id;
+}
+
+//_____________________________________________________________________________
+Int_t THcRunStats::DefineHistogram(const char* name, const char* desc,
+				   Int_t nbins, Double_t xlo, Double_t xhi)
+{
+  /**
+     Book a fixed binning histogram of counts.  It is published as the
+     array name[nbins+2], including the underflow and overflow cells.
+  */
+  if(nbins < 1 || xhi <= xlo) {
+    ::Error("THcRunStats::DefineHistogram",
+	    "Bad binning for %s: %d bins, %f to %f", name, nbins, xlo, xhi);
+    nbins = 1;
+    if(xhi <= xlo) xhi = xlo + 1.;
+  }
+  Int_t id = Book(nbins+2, kTRUE, nbins, xlo, xhi);
+  Publish(id, name, desc);
+  return id;
+}
+
+//_____________________________________________________________________________
+Int_t THcRunStats::Book(Int_t size, Bool_t isarray, Int_t nbins,
+			Double_t xlo, Double_t xhi)
+{
+  Counter c;
+  c.size = size;
+  c.isarray = isarray;
+  c.nbins = nbins;
+  c.xlo = xlo;
+  c.xhi = xhi;
+  c.values = new Int_t[size];
+  memset(c.values, 0, size*sizeof(Int_t));
+  fCounters.push_back(c);
+  fOffset.push_back(fNCells);
+  fNCells += size;
+  AllocateShards(fNShards, fNCells - size);
+  return fCounters.size() - 1;
+}
+
+//_____________________________________________________________________________
+void THcRunStats::Publish(Int_t id, const char* name, const char* desc)
+{
+  /**
+     Register the merged values of counter id in gHcParms, so that they
+     can be used in reports.  Does nothing for an empty name.
+  */
+  Counter& c = fCounters[id];
+  if(!name || !*name || !gHcParms) return;
+  if(c.name.Length() > 0) gHcParms->RemoveName(c.name.Data());
+  c.name = name;
+  if(c.isarray) {
+    gHcParms->Define(Form("%s[%d]", name, c.size), desc, *c.values);
+  } else {
+    gHcParms->Define(name, desc, *c.values);
+  }
+}
+
+//_____________________________________________________________________________
+void THcRunStats::AllocateShards(Int_t nshards, Int_t nkeep)
+{
+  // (Re)allocate nshards shards for the booked cells.  The first nkeep
+  // cells of the existing shards keep their counts and the others start
+  // at zero, so that booking a counter during a run does not lose the
+  // counts of the others.  Must not be called while other threads count.
+  Int_t stride = ((fNCells + kCellsPerLine - 1)/kCellsPerLine)*kCellsPerLine;
+  Cell_t* buffer = new Cell_t[stride*nshards + kCellsPerLine];
+  ULong_t addr = reinterpret_cast<ULong_t>(buffer);
+  ULong_t misalign = addr % (kCellsPerLine*sizeof(Int_t));
+  Cell_t* data = buffer +
+    (misalign ? (kCellsPerLine*sizeof(Int_t) - misalign)/sizeof(Cell_t) : 0);
+  for(Int_t ishard=0;ishard<nshards;ishard++) {
+    for(Int_t i=0;i<stride;i++) {
+      Bool_t keep = (fShardData && ishard < fNShards && i < nkeep);
+      data[ishard*stride + i] = keep ? Int_t(fShardData[ishard*fStride + i]) : 0;
+    }
+  }
+  delete [] fShardBuffer;
+  fShardBuffer = buffer;
+  fShardData = data;
+  fStride = stride;
+  fNShards = nshards;
+}
+
+//_____________________________________________________________________________
+void THcRunStats::SetNShards(Int_t n)
+{
+  // Set the number of shards, i.e. the number of threads that may
+  // increment the counters.  Clears all counts.
+  AllocateShards((n > 0 ? n : 1), 0);
+  Reset();
+}
+
+//_____________________________________________________________________________
+void THcRunStats::Reset()
+{
+  // Zero all shards and merged values, e.g. at the start of a run
+  for(Int_t i=0;i<fStride*fNShards;i++) {
+    fShardData[i] = 0;
+  }
+  for(UInt_t id=0;id<fCounters.size();id++) {
+    memset(fCounters[id].values, 0, fCounters[id].size*sizeof(Int_t));
+  }
+}
+
+//_____________________________________________________________________________
+void THcRunStats::Reset(Int_t id)
+{
+  // Zero one counter, for counters cleared more often than the others
+  Counter& c = fCounters[id];
+  for(Int_t ishard=0;ishard<fNShards;ishard++) {
+    for(Int_t i=0;i<c.size;i++) {
+      fShardData[ishard*fStride + fOffset[id] + i] = 0;
+    }
+  }
+  memset(c.values, 0, c.size*sizeof(Int_t));
+}
+
+//_____________________________________________________________________________
+void THcRunStats::Fill(Int_t id, Double_t x)
+{
+  // Count x in histogram id
+  const Counter& c = fCounters[id];
+  Int_t bin;
+  if(x < c.xlo) {
+    bin = 0;
+  } else if(x >= c.xhi) {
+    bin = c.nbins+1;
+  } else {
+    bin = 1 + Int_t((x - c.xlo)/(c.xhi - c.xlo)*c.nbins);
+    if(bin > c.nbins) bin = c.nbins;
+  }
+  Add(id, bin, 1);
+}
+
+//_____________________________________________________________________________
+void THcRunStats::Merge()
+{
+  /**
+     Sum the shards into the merged values seen by gHcParms.  Cheap
+     (one pass over the cells of each shard) and safe to call while
+     other threads keep counting, e.g. for periodic reports.
+  */
+  for(UInt_t id=0;id<fCounters.size();id++) {
+    Counter& c = fCounters[id];
+    for(Int_t i=0;i<c.size;i++) {
+      Int_t sum = 0;
+      for(Int_t ishard=0;ishard<fNShards;ishard++) {
+#if __cplusplus >= 201103L
+	sum += fShardData[ishard*fStride + fOffset[id] + i].load(memory_order_relaxed);
+#else
+	sum += fShardData[ishard*fStride + fOffset[id] + i];
+#endif
+      }
+      c.values[i] = sum;
+    }
+  }
+}
+
+//_____________________________________________________________________________
+void THcRunStats::MergeAll()
+{
+  // Merge every existing registry
+  Registries& reg = GetRegistries();
+#if __cplusplus >= 201103L
+  lock_guard<mutex> lock(reg.lock);
+#endif
+  for(UInt_t i=0;i<reg.list.size();i++) {
+    reg.list[i]->Merge();
+  }
+}
+
+//_____________________________________________________________________________
+void THcRunStats::ResetAll()
+{
+  // Zero every existing registry, e.g. before the next run of a batch
+  Registries& reg = GetRegistries();
+#if __cplusplus >= 201103L
+  lock_guard<mutex> lock(reg.lock);
+#endif
+  for(UInt_t i=0;i<reg.list.size();i++) {
+    reg.list[i]->Reset();
+  }
+}
+
+//_____________________________________________________________________________
+void THcRunStats::SaveAll(vector<Int_t>& state)
+{
+  // Merged values of every registry, for THcCheckpoint.  Each registry
+  // is stored as its number of cells followed by the values.
+  Registries& reg = GetRegistries();
+#if __cplusplus >= 201103L
+  lock_guard<mutex> lock(reg.lock);
+#endif
+  state.clear();
+  for(UInt_t i=0;i<reg.list.size();i++) {
+    THcRunStats* r = reg.list[i];
+    r->Merge();
+    state.push_back(r->fNCells);
+    for(UInt_t id=0;id<r->fCounters.size();id++) {
+      const Counter& c = r->fCounters[id];
+      state.insert(state.end(), c.values, c.values + c.size);
+    }
+  }
+}
+
+//_____________________________________________________________________________
+Bool_t THcRunStats::RestoreAll(const vector<Int_t>& state)
+{
+  // Set every registry to the values saved by SaveAll.  The registries
+  // must have been booked the same way.  Returns kFALSE (and changes
+  // nothing) if they were not.
+  Registries& reg = GetRegistries();
+#if __cplusplus >= 201103L
+  lock_guard<mutex> lock(reg.lock);
+#endif
+  UInt_t pos = 0;
+  for(UInt_t i=0;i<reg.list.size();i++) {
+    if(pos >= state.size() || state[pos] != reg.list[i]->fNCells) return kFALSE;
+    pos += 1 + state[pos];
+  }
+  if(pos != state.size()) return kFALSE;
+
+  pos = 0;
+  for(UInt_t i=0;i<reg.list.size();i++) {
+    THcRunStats* r = reg.list[i];
+    r->Reset();
+    pos++;
+    for(UInt_t id=0;id<r->fCounters.size();id++) {
+      Counter& c = r->fCounters[id];
+      for(Int_t j=0;j<c.size;j++) {
+	c.values[j] = state[pos+j];
+	r->fShardData[r->fOffset[id] + j] = state[pos+j]; // All in shard 0
+      }
+      pos += c.size;
+    }
+  }
+  return kTRUE;
+}
+
+//_____________________________________________________________________________
+void THcRunStats::SetDefaultNShards(Int_t n)
+{
+  // Number of shards given to registries created from now on
+  fgDefaultNShards = (n > 0 ? n : 1);
+}
+
+//_____________________________________________________________________________
+void THcRunStats::SetThreadShard(Int_t ishard)
+{
+  // Select the shard the calling thread increments.  Must be less
+  // than the number of shards of every registry the thread uses.
+  fgThreadShard = ishard;
+}
+
+//_____________________________________________________________________________
+Int_t THcRunStats::ThreadShard()
+{
+  return fgThreadShard;
+}
+
+ClassImp(THcRunStats)
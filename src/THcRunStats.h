@@ -0,0 +1,100 @@
+#ifndef ROOT_THcRunStats
+#define ROOT_THcRunStats
+
+//////////////////////////////////////////////////////////////////////////
+//
+// THcRunStats
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "Rtypes.h"
+#include "TString.h"
+#include <vector>
+#if __cplusplus >= 201103L
+#include <atomic>
+#endif
+
+class THcRunStats {
+
+public:
+
+  THcRunStats();
+  virtual ~THcRunStats();
+
+  Int_t  DefineCounter(const char* name, const char* desc, Int_t n=0);
+  Int_t  DefineHistogram(const char* name, const char* desc,
+			 Int_t nbins, Double_t xlo, Double_t xhi);
+  void   Publish(Int_t id, const char* name, const char* desc);
+  void   Clear();
+  void   SetNShards(Int_t n);
+  Int_t  GetNShards() const {return fNShards;}
+  void   Reset();
+  void   Reset(Int_t id);
+  void   Merge();
+
+  // Per event.  Each thread only writes the shard selected with
+  // SetThreadShard, so no locks or read-modify-write atomics are needed.
+  void   Increment(Int_t id, Int_t i=0) {Add(id, i, 1);}
+  void   Add(Int_t id, Int_t i, Int_t n) {
+    Cell_t& c = fShardData[ThreadShard()*fStride + fOffset[id] + i];
+#if __cplusplus >= 201103L
+    c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+#else
+    c += n;
+#endif
+  }
+  void   Fill(Int_t id, Double_t x);
+
+  // Merged values, valid after Merge (or MergeAll)
+  Int_t        GetValue(Int_t id, Int_t i=0) const {return fCounters[id].values[i];}
+  const Int_t* GetValues(Int_t id) const {return fCounters[id].values;}
+  Int_t        GetSize(Int_t id) const {return fCounters[id].size;}
+
+  static void  SetDefaultNShards(Int_t n);
+  static void  SetThreadShard(Int_t ishard);
+  static Int_t ThreadShard();
+  static void  MergeAll();
+  static void  ResetAll();
+  static void  SaveAll(std::vector<Int_t>& state);
+  static Bool_t RestoreAll(const std::vector<Int_t>& state);
+
+  // One counter (array) or histogram.  Histograms have nbins+2 cells,
+  // cell 0 is the underflow and cell nbins+1 the overflow.
+  struct Counter {
+    TString  name;		// Name in gHcParms, empty if not published
+    Int_t    size;
+    Bool_t   isarray;		// Published as name[size]
+    Int_t    nbins;		// 0 for plain counters
+    Double_t xlo;
+    Double_t xhi;
+    Int_t*   values;		// Merged values, the storage gHcParms points to
+  };
+
+protected:
+
+#if __cplusplus >= 201103L
+  typedef std::atomic<Int_t> Cell_t;
+#else
+  typedef Int_t Cell_t;
+#endif
+
+  Int_t  Book(Int_t size, Bool_t isarray, Int_t nbins,
+	      Double_t xlo, Double_t xhi);
+  void   AllocateShards(Int_t nshards, Int_t nkeep);
+
+  std::vector<Counter> fCounters;
+  std::vector<Int_t>   fOffset;	// Offset of each counter in a shard
+  Int_t    fNCells;		// Cells used in one shard
+  Int_t    fStride;		// Cells per shard, padded to a cache line
+  Int_t    fNShards;
+  Cell_t*  fShardBuffer;	//! Allocated shard memory
+  Cell_t*  fShardData;		//! First shard, cache line aligned
+
+private:
+  THcRunStats(const THcRunStats&);
+  THcRunStats& operator=(const THcRunStats&);
+
+  ClassDef(THcRunStats,0)	// Sharded, mergeable run counters
+};
+
+#endif
@@ -46,6 +46,8 @@ To enable debugging you may try this in the setup script
 #include "THaEvData.h"
 #include "THcParmList.h"
 #include "THcGlobals.h"
+#include "THcCheckpoint.h"
+#include "THcMemoryReport.h"
 #include "THaGlobals.h"
 #include "TNamed.h"
 #include "TMath.h"
@@ -97,6 +99,7 @@ THcScalerEvtHandler::~THcScalerEvtHandler()
   if (!TROOT::Initialized()) {
     delete fScalerTree;
   }
+  if(gHcCheckpoint) gHcCheckpoint->RemovePrefix(fName + ".scaler.");
   Podd::DeleteContainer(scalers);
   Podd::DeleteContainer(scalerloc);
   delete [] dvars_prev_read;
@@ -885,6 +888,27 @@ void THcScalerEvtHandler::DefVars()
   memset(dvars, 0, Nvars*sizeof(Double_t));
   memset(dvars_prev_read, 0, Nvars*sizeof(UInt_t));
   memset(dvarsFirst, 0, Nvars*sizeof(Double_t));
+  if(gHcCheckpoint) {		// Scaler history to save for resuming
+    TString prefix = fName + ".scaler.";
+    gHcCheckpoint->Define(prefix+"dvars", dvars, Nvars);
+    gHcCheckpoint->Define(prefix+"dvars_prev_read", dvars_prev_read, Nvars);
+    gHcCheckpoint->Define(prefix+"dvarsFirst", dvarsFirst, Nvars);
+    gHcCheckpoint->Define(prefix+"scal_prev_read", &scal_prev_read);
+    gHcCheckpoint->Define(prefix+"scal_present_read", &scal_present_read);
+    gHcCheckpoint->Define(prefix+"scal_overflows", &scal_overflows);
+    if(fNumBCMs > 0) {
+      gHcCheckpoint->Define(prefix+"BCM_delta_charge", fBCM_delta_charge, fNumBCMs);
+    }
+    gHcCheckpoint->Define(prefix+"evcount", &evcount);
+    gHcCheckpoint->Define(prefix+"evcountR", &evcountR);
+    gHcCheckpoint->Define(prefix+"evNumber", &evNumber);
+    gHcCheckpoint->Define(prefix+"evNumberR", &evNumberR);
+    gHcCheckpoint->Define(prefix+"TotalTime", &fTotalTime);
+    gHcCheckpoint->Define(prefix+"PrevTotalTime", &fPrevTotalTime);
+    gHcCheckpoint->Define(prefix+"DeltaTime", &fDeltaTime);
+    gHcCheckpoint->Define(prefix+"LastClock", &fLastClock);
+    gHcCheckpoint->Define(prefix+"ClockOverflows", &fClockOverflows);
+  }
   if (gHaVars) {
     if(fDebugFile) *fDebugFile << "THcScalerEVtHandler:: Have gHaVars "<<gHaVars<<endl;
   } else {
@@ -918,4 +942,15 @@ size_t THcScalerEvtHandler::FindNoCase(const string& sdata, const string& skey)
   return sdatalc.find(skeylc,0);
 };
 
+//_____________________________________________________________________________
+void THcScalerEvtHandler::AccountMemory( THcMemoryReport& report ) const
+{
+  // Events of the delayed type are kept until End
+  Long64_t bytes = THcMemoryReport::Bytes(fDelayedEvents);
+  for( vector<UInt_t*>::const_iterator it = fDelayedEvents.begin();
+       it != fDelayedEvents.end(); ++it )
+    bytes += ((*it)[0]+1)*sizeof(UInt_t);
+  report.Add("delayed events", bytes, THcMemoryReport::kDynamic);
+}
+
 ClassImp(THcScalerEvtHandler)
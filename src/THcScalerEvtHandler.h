@@ -11,6 +11,7 @@
 /////////////////////////////////////////////////////////////////////
 
 #include "THaEvtTypeHandler.h"
+#include "THcMemoryAccount.h"
 #include "Decoder.h"
 #include <string>
 #include <vector>
@@ -31,7 +32,7 @@ class HCScalerLoc { // Utility class used by THcScalerEvtHandler
   UInt_t index, islot, ichan, ikind, ivar;
 };
 
-class THcScalerEvtHandler : public THaEvtTypeHandler {
+class THcScalerEvtHandler : public THaEvtTypeHandler, public THcMemoryAccount {
 
 public:
 
@@ -43,6 +44,7 @@ public:
    virtual EStatus Init( const TDatime& run_time);
    virtual Int_t   ReadDatabase(const TDatime& date );
    virtual Int_t End( THaRunBase* r=0 );
+   virtual void AccountMemory( THcMemoryReport& report ) const;
    virtual void SetUseFirstEvent(Bool_t b = kFALSE) {fUseFirstEvent = b;}
    virtual void SetDelayedType(int evtype);
    virtual void SetOnlyBanks(Bool_t b = kFALSE) {fOnlyBanks = b;fRocSet.clear();}
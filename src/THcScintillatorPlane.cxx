@@ -13,12 +13,15 @@ The THcHodoscope class instatiates one of these objects per plane.
 #include "THcSignalHit.h"
 #include "THcHodoHit.h"
 #include "THcGlobals.h"
+#include "THcCheckpoint.h"
 #include "THcParmList.h"
 #include "THcHitList.h"
 #include "THcHodoscope.h"
 #include "TClass.h"
 #include "THcRawAdcHit.h"
 #include "THcRawTdcHit.h"
+#include "THcAnalyzer.h"
+#include "THcMemoryReport.h"
 
 #include <cstring>
 #include <cstdio>
@@ -29,6 +32,14 @@ using namespace std;
 
 ClassImp(THcScintillatorPlane)
 
+//______________________________________________________________________________
+static Double_t* AlignedBlock( Double_t* block )
+{
+  // First 64-byte aligned element of block, which must have 7 spare
+  // elements
+  return (Double_t*)(((ULong_t)block + 63) & ~(ULong_t)63);
+}
+
 //______________________________________________________________________________
 THcScintillatorPlane::THcScintillatorPlane( const char* name,
 					    const char* description,
@@ -54,7 +65,8 @@ THcScintillatorPlane::THcScintillatorPlane( const char* name,
   fHodoPosInvAdcLinear(0), fHodoNegInvAdcLinear(0),
   fHodoPosInvAdcAdc(0), fHodoNegInvAdcAdc(0), fHodoVelFit(0),
   fHodoCableFit(0), fHodo_LCoeff(0), fHodoPos_c1(0), fHodoNeg_c1(0),
-  fHodoPos_c2(0), fHodoNeg_c2(0), fHodoSigma(0), fPosPedSum(0),
+  fHodoPos_c2(0), fHodoNeg_c2(0), fHodoSigma(0), fCalibBlock(0),
+  fCalib(0), fCalibStride(0), fSelBlock(0), fSel(0), fPosPedSum(0),
   fPosPedSum2(0), fPosPedLimit(0), fPosPedCount(0), fNegPedSum(0),
   fNegPedSum2(0), fNegPedLimit(0), fNegPedCount(0), fPosPed(0),
   fPosSig(0), fPosThresh(0), fNegPed(0), fNegSig(0), fNegThresh(0)
@@ -104,6 +116,7 @@ THcScintillatorPlane::THcScintillatorPlane( const char* name,
   fPlaneNum = planenum;
   fTotPlanes = planenum;
   fNScinHits = 0;
+  fFillRawArrays = kTRUE;
 }
 
 //______________________________________________________________________________
@@ -112,6 +125,7 @@ THcScintillatorPlane::~THcScintillatorPlane()
   // Destructor
   if( fIsSetup )
     RemoveVariables();
+  if(gHcCheckpoint) gHcCheckpoint->RemovePrefix(GetPrefix());
   delete  frPosAdcErrorFlag; frPosAdcErrorFlag = NULL;
   delete  frNegAdcErrorFlag; frNegAdcErrorFlag = NULL;
 
@@ -153,34 +167,9 @@ THcScintillatorPlane::~THcScintillatorPlane()
 
   delete [] fPosCenter; fPosCenter = 0;
 
-  delete [] fHodoPosMinPh; fHodoPosMinPh = NULL;
-  delete [] fHodoNegMinPh; fHodoNegMinPh = NULL;
-  delete [] fHodoPosPhcCoeff; fHodoPosPhcCoeff = NULL;
-  delete [] fHodoNegPhcCoeff; fHodoNegPhcCoeff = NULL;
-  delete [] fHodoPosTimeOffset; fHodoPosTimeOffset = NULL;
-  delete [] fHodoNegTimeOffset; fHodoNegTimeOffset = NULL;
-  delete [] fHodoPosInvAdcOffset; fHodoPosInvAdcOffset = NULL;
-  delete [] fHodoNegInvAdcOffset; fHodoNegInvAdcOffset = NULL;
-  delete [] fHodoPosInvAdcLinear; fHodoPosInvAdcLinear = NULL;
-  delete [] fHodoNegInvAdcLinear; fHodoNegInvAdcLinear = NULL;
-  delete [] fHodoPosAdcTimeWindowMax; fHodoPosAdcTimeWindowMax = NULL;
-  delete [] fHodoPosAdcTimeWindowMin; fHodoPosAdcTimeWindowMin = NULL;
-  delete [] fHodoNegAdcTimeWindowMax; fHodoNegAdcTimeWindowMax = NULL;
-  delete [] fHodoNegAdcTimeWindowMin; fHodoNegAdcTimeWindowMin = NULL;
-  delete [] fHodoNegInvAdcLinear; fHodoNegInvAdcLinear = NULL;
-  delete [] fHodoPosInvAdcAdc; fHodoPosInvAdcAdc = NULL;
-  delete [] fHodoNegInvAdcAdc; fHodoNegInvAdcAdc = NULL;
-  delete [] fHodoVelFit;                 fHodoVelFit = NULL;
-  delete [] fHodoCableFit;               fHodoCableFit = NULL;
-  delete [] fHodo_LCoeff;                fHodo_LCoeff = NULL;
-  delete [] fHodoPos_c1;                 fHodoPos_c1 = NULL;
-  delete [] fHodoNeg_c1;                 fHodoNeg_c1 = NULL;
-  delete [] fHodoPos_c2;                 fHodoPos_c2 = NULL;
-  delete [] fHodoNeg_c2;                 fHodoNeg_c2 = NULL;
-
-
-  delete [] fHodoVelLight; fHodoVelLight = NULL;
-  delete [] fHodoSigma; fHodoSigma = NULL;
+  // The fHodo... calibration arrays are rows of fCalibBlock
+  delete [] fCalibBlock; fCalibBlock = fCalib = NULL;
+  delete [] fSelBlock; fSelBlock = fSel = NULL;
 
   delete [] fPosPedSum; fPosPedSum = 0;
   delete [] fPosPedSum2; fPosPedSum2 = 0;
@@ -213,6 +202,25 @@ THaAnalysisObject::EStatus THcScintillatorPlane::Init( const TDatime& date )
   if( (status=THaSubDetector::Init( date )) )
     return fStatus = status;
 
+  // The raw per-hit arrays are only used by global variables.  Skip
+  // filling them if none of those variables are requested.
+  static const char* const rawvars[] = {
+    "posAdcErrorFlag", "negAdcErrorFlag",
+    "posTdcTimeRaw", "posAdcPedRaw", "posAdcPulseIntRaw", "posAdcPulseAmpRaw", "posAdcPulseTimeRaw",
+    "posTdcTime", "posAdcPed", "posAdcPulseInt", "posAdcPulseAmp", "posAdcPulseTime",
+    "negTdcTimeRaw", "negAdcPedRaw", "negAdcPulseIntRaw", "negAdcPulseAmpRaw", "negAdcPulseTimeRaw",
+    "negTdcTime", "negAdcPed", "negAdcPulseInt", "negAdcPulseAmp", "negAdcPulseTime",
+    "posTdcCounter", "posAdcCounter", "negTdcCounter", "negAdcCounter",
+    0
+  };
+  fFillRawArrays = kFALSE;
+  for(const char* const* var = rawvars; *var; var++) {
+    if(THcAnalyzer::IsOutputRequested(Form("%s%s",GetPrefix(),*var))) {
+      fFillRawArrays = kTRUE;
+      break;
+    }
+  }
+
   // Get the Hodoscope hitlist
   // Can't seem to cast to THcHitList.  What to do if we want to use
   // THcScintillatorPlane as a subdetector to other than THcHodoscope?
@@ -300,34 +308,46 @@ Int_t THcScintillatorPlane::ReadDatabase( const TDatime& date )
   fBetaNominal=parent->GetBetaNominal();
   fStartTimeCenter=parent->GetStartTimeCenter();
   fStartTimeSlop=parent->GetStartTimeSlop();
-  // Parameters for this plane
-  fHodoPosMinPh = new Double_t[fNelem];
-  fHodoNegMinPh = new Double_t[fNelem];
-  fHodoPosPhcCoeff = new Double_t[fNelem];
-  fHodoNegPhcCoeff = new Double_t[fNelem];
-  fHodoPosTimeOffset = new Double_t[fNelem];
-  fHodoNegTimeOffset = new Double_t[fNelem];
-  fHodoVelLight = new Double_t[fNelem];
-  fHodoPosInvAdcOffset = new Double_t[fNelem];
-  fHodoNegInvAdcOffset = new Double_t[fNelem];
-  fHodoPosInvAdcLinear = new Double_t[fNelem];
-  fHodoNegInvAdcLinear = new Double_t[fNelem];
-  fHodoPosAdcTimeWindowMin = new Double_t[fNelem];
-  fHodoNegAdcTimeWindowMin = new Double_t[fNelem];
-  fHodoPosAdcTimeWindowMax = new Double_t[fNelem];
-  fHodoNegAdcTimeWindowMax = new Double_t[fNelem];
-  fHodoPosInvAdcAdc = new Double_t[fNelem];
-  fHodoNegInvAdcAdc = new Double_t[fNelem];
-  fHodoSigma = new Double_t[fNelem];
+  // Parameters for this plane, see ECalibRow
+  fCalibStride = (fNelem+7) & ~7;
+  delete [] fCalibBlock;
+  fCalibBlock = new Double_t[kNCalibRows*fCalibStride+7];
+  fCalib = AlignedBlock(fCalibBlock);
+  for(Int_t i=0;i<kNCalibRows*fCalibStride;i++) fCalib[i] = 0.0;
+  fHodoPosMinPh = CalibRow(kCalPosMinPh);
+  fHodoNegMinPh = CalibRow(kCalNegMinPh);
+  fHodoPosPhcCoeff = CalibRow(kCalPosPhcCoeff);
+  fHodoNegPhcCoeff = CalibRow(kCalNegPhcCoeff);
+  fHodoPosTimeOffset = CalibRow(kCalPosTimeOffset);
+  fHodoNegTimeOffset = CalibRow(kCalNegTimeOffset);
+  fHodoVelLight = CalibRow(kCalVelLight);
+  fHodoPosInvAdcOffset = CalibRow(kCalPosInvAdcOffset);
+  fHodoNegInvAdcOffset = CalibRow(kCalNegInvAdcOffset);
+  fHodoPosInvAdcLinear = CalibRow(kCalPosInvAdcLinear);
+  fHodoNegInvAdcLinear = CalibRow(kCalNegInvAdcLinear);
+  fHodoPosAdcTimeWindowMin = CalibRow(kCalPosAdcTimeWindowMin);
+  fHodoNegAdcTimeWindowMin = CalibRow(kCalNegAdcTimeWindowMin);
+  fHodoPosAdcTimeWindowMax = CalibRow(kCalPosAdcTimeWindowMax);
+  fHodoNegAdcTimeWindowMax = CalibRow(kCalNegAdcTimeWindowMax);
+  fHodoPosInvAdcAdc = CalibRow(kCalPosInvAdcAdc);
+  fHodoNegInvAdcAdc = CalibRow(kCalNegInvAdcAdc);
+  fHodoSigma = CalibRow(kCalSigma);
   
   //New Time-Walk Calibration Parameters
-  fHodoVelFit=new Double_t [fNelem];
-  fHodoCableFit=new Double_t [fNelem];
-  fHodo_LCoeff=new Double_t [fNelem];
-  fHodoPos_c1=new Double_t [fNelem];
-  fHodoNeg_c1=new Double_t [fNelem];
-  fHodoPos_c2=new Double_t [fNelem];
-  fHodoNeg_c2=new Double_t [fNelem];
+  fHodoVelFit = CalibRow(kCalVelFit);
+  fHodoCableFit = CalibRow(kCalCableFit);
+  fHodo_LCoeff = CalibRow(kCalLCoeff);
+  fHodoPos_c1 = CalibRow(kCalPos_c1);
+  fHodoNeg_c1 = CalibRow(kCalNeg_c1);
+  fHodoPos_c2 = CalibRow(kCalPos_c2);
+  fHodoNeg_c2 = CalibRow(kCalNeg_c2);
+
+  // Selected paddles of an event, filled by ProcessHits
+  delete [] fSelBlock;
+  fSelBlock = new Double_t[kNSelRows*fCalibStride+7];
+  fSel = AlignedBlock(fSelBlock);
+  fSelIndex.assign(fNelem, 0);
+  fSelFlags.assign(fNelem, 0);
 
   for(Int_t j=0;j<(Int_t) fNelem;j++) {
     Int_t index=parent->GetScinIndex(fPlaneNum-1,j);
@@ -367,6 +387,19 @@ Int_t THcScintillatorPlane::ReadDatabase( const TDatime& date )
   }
 
   fTdc_Thrs = parent->GetTDCThrs();
+
+  // Derived per-paddle constants for CorrectHitTimes: the time-walk
+  // correction at the 200 channel reference amplitude, and the flight
+  // time to the paddle, signed as it is applied
+  Double_t* postwref = CalibRow(kCalPosTwRef);
+  Double_t* negtwref = CalibRow(kCalNegTwRef);
+  Double_t* tofpath = CalibRow(kCalTofPath);
+  for(Int_t j=0;j<(Int_t) fNelem;j++) {
+    postwref[j] = 1./pow(200./fTdc_Thrs, fHodoPos_c2[j]);
+    negtwref[j] = 1./pow(200./fTdc_Thrs, fHodoNeg_c2[j]);
+    Double_t tof = (fZpos+(j%2)*fDzpos)/(29.979*fBetaNominal);
+    tofpath[j] = fCosmicFlag ? tof : -tof;
+  }
   // cout <<" plane num = "<<fPlaneNum<<endl;
   // cout <<" nelem     = "<<fNelem<<endl;
   // cout <<" zpos      = "<<fZpos<<endl;
@@ -555,6 +588,38 @@ Int_t THcScintillatorPlane::DefineVariables( EMode mode )
   return DefineVarsFromList(vars, mode);
 
 }
+//_____________________________________________________________________________
+void THcScintillatorPlane::AccountMemory( THcMemoryReport& report ) const
+{
+  // Called by THcHodoscope::AccountMemory.  The hit arrays of the plane
+  // grow with the largest event.
+  const TClonesArray* signals[] = {
+    frPosAdcErrorFlag, frNegAdcErrorFlag,
+    frPosTDCHits, frNegTDCHits, frPosADCHits, frNegADCHits,
+    frPosADCSums, frNegADCSums, frPosADCPeds, frNegADCPeds,
+    frPosTdcTimeRaw, frPosAdcPedRaw, frPosAdcPulseIntRaw,
+    frPosAdcPulseAmpRaw, frPosAdcPulseTimeRaw,
+    frPosTdcTime, frPosAdcPed, frPosAdcPulseInt, frPosAdcPulseAmp,
+    frPosAdcPulseTime,
+    frNegTdcTimeRaw, frNegAdcPedRaw, frNegAdcPulseIntRaw,
+    frNegAdcPulseAmpRaw, frNegAdcPulseTimeRaw,
+    frNegTdcTime, frNegAdcPed, frNegAdcPulseInt, frNegAdcPulseAmp,
+    frNegAdcPulseTime
+  };
+  Long64_t bytes = 0;
+  for(UInt_t i=0;i<sizeof(signals)/sizeof(signals[0]);i++) {
+    bytes += THcMemoryReport::Bytes(signals[i]);
+  }
+  report.Add("plane signal hits", bytes, THcMemoryReport::kDynamic);
+  report.Add("plane hits", THcMemoryReport::Bytes(fHodoHits)
+	     + THcMemoryReport::Bytes(fCluster), THcMemoryReport::kDynamic);
+  report.Add("plane selected paddles", THcMemoryReport::Bytes(fSelIndex)
+	     + THcMemoryReport::Bytes(fSelFlags), THcMemoryReport::kDynamic);
+  report.Add("plane calibration", (Long64_t)(kNCalibRows+kNSelRows)*fCalibStride*sizeof(Double_t),
+	     THcMemoryReport::kStatic);
+  report.Add("plane", IsA()->Size(), THcMemoryReport::kStatic);
+}
+
 //_____________________________________________________________________________
 void THcScintillatorPlane::Clear( Option_t* )
 {
@@ -802,6 +867,7 @@ Int_t THcScintillatorPlane::ProcessHits(TClonesArray* rawhits, Int_t nexthit)
   // Use "ihit" as the index over THcRawHodoHit objects.  Use
   // "thit" to index over multiple tdc hits within an "ihit".
     Bool_t problem_flag=kFALSE;
+  Int_t nsel = 0;		// Paddles selected for hits
   while(ihit < nrawhits) {
     THcRawHodoHit* hit = (THcRawHodoHit *) rawhits->At(ihit);
     if(hit->fPlane > fPlaneNum) {
@@ -824,8 +890,10 @@ Int_t THcScintillatorPlane::ProcessHits(TClonesArray* rawhits, Int_t nexthit)
     }
     }
     for (UInt_t thit=0; thit<rawPosTdcHit.GetNHits(); ++thit) {
-      ((THcSignalHit*) frPosTdcTimeRaw->ConstructedAt(nrPosTdcHits))->Set(padnum, rawPosTdcHit.GetTimeRaw(thit));
-      ((THcSignalHit*) frPosTdcTime->ConstructedAt(nrPosTdcHits))->Set(padnum, rawPosTdcHit.GetTime(thit));
+      if(fFillRawArrays) {
+	((THcSignalHit*) frPosTdcTimeRaw->ConstructedAt(nrPosTdcHits))->Set(padnum, rawPosTdcHit.GetTimeRaw(thit));
+	((THcSignalHit*) frPosTdcTime->ConstructedAt(nrPosTdcHits))->Set(padnum, rawPosTdcHit.GetTime(thit));
+      }
       ++nrPosTdcHits;
       fTotNumTdcHits++;
       fTotNumPosTdcHits++;
@@ -843,8 +911,10 @@ Int_t THcScintillatorPlane::ProcessHits(TClonesArray* rawhits, Int_t nexthit)
     }
     // cout << " paddle num = " << padnum << " TDC Neg hits = " << rawNegTdcHit.GetNHits() << endl;
     for (UInt_t thit=0; thit<rawNegTdcHit.GetNHits(); ++thit) {
-      ((THcSignalHit*) frNegTdcTimeRaw->ConstructedAt(nrNegTdcHits))->Set(padnum, rawNegTdcHit.GetTimeRaw(thit));
-      ((THcSignalHit*) frNegTdcTime->ConstructedAt(nrNegTdcHits))->Set(padnum, rawNegTdcHit.GetTime(thit));
+      if(fFillRawArrays) {
+	((THcSignalHit*) frNegTdcTimeRaw->ConstructedAt(nrNegTdcHits))->Set(padnum, rawNegTdcHit.GetTimeRaw(thit));
+	((THcSignalHit*) frNegTdcTime->ConstructedAt(nrNegTdcHits))->Set(padnum, rawNegTdcHit.GetTime(thit));
+      }
       ++nrNegTdcHits;
       fTotNumTdcHits++;
       fTotNumNegTdcHits++;
@@ -862,22 +932,23 @@ Int_t THcScintillatorPlane::ProcessHits(TClonesArray* rawhits, Int_t nexthit)
     }
     // cout << " paddle num = " << padnum << " ADC Pos hits = " << rawPosAdcHit.GetNPulses() << endl;
     for (UInt_t thit=0; thit<rawPosAdcHit.GetNPulses(); ++thit) {
-      ((THcSignalHit*) frPosAdcPedRaw->ConstructedAt(nrPosAdcHits))->Set(padnum, rawPosAdcHit.GetPedRaw());
-      ((THcSignalHit*) frPosAdcPed->ConstructedAt(nrPosAdcHits))->Set(padnum, rawPosAdcHit.GetPed());
+      if(fFillRawArrays) {
+	((THcSignalHit*) frPosAdcPedRaw->ConstructedAt(nrPosAdcHits))->Set(padnum, rawPosAdcHit.GetPedRaw());
+	((THcSignalHit*) frPosAdcPed->ConstructedAt(nrPosAdcHits))->Set(padnum, rawPosAdcHit.GetPed());
 
-      ((THcSignalHit*) frPosAdcPulseIntRaw->ConstructedAt(nrPosAdcHits))->Set(padnum, rawPosAdcHit.GetPulseIntRaw(thit));
-      ((THcSignalHit*) frPosAdcPulseInt->ConstructedAt(nrPosAdcHits))->Set(padnum, rawPosAdcHit.GetPulseInt(thit));
+	((THcSignalHit*) frPosAdcPulseIntRaw->ConstructedAt(nrPosAdcHits))->Set(padnum, rawPosAdcHit.GetPulseIntRaw(thit));
+	((THcSignalHit*) frPosAdcPulseInt->ConstructedAt(nrPosAdcHits))->Set(padnum, rawPosAdcHit.GetPulseInt(thit));
 
-      ((THcSignalHit*) frPosAdcPulseAmpRaw->ConstructedAt(nrPosAdcHits))->Set(padnum, rawPosAdcHit.GetPulseAmpRaw(thit));
+	((THcSignalHit*) frPosAdcPulseAmpRaw->ConstructedAt(nrPosAdcHits))->Set(padnum, rawPosAdcHit.GetPulseAmpRaw(thit));
 
-      ((THcSignalHit*) frPosAdcPulseAmp->ConstructedAt(nrPosAdcHits))->Set(padnum, rawPosAdcHit.GetPulseAmp(thit));
+	((THcSignalHit*) frPosAdcPulseAmp->ConstructedAt(nrPosAdcHits))->Set(padnum, rawPosAdcHit.GetPulseAmp(thit));
 
-      ((THcSignalHit*) frPosAdcPulseTimeRaw->ConstructedAt(nrPosAdcHits))->Set(padnum, rawPosAdcHit.GetPulseTimeRaw(thit));
-      ((THcSignalHit*) frPosAdcPulseTime->ConstructedAt(nrPosAdcHits))->Set(padnum, rawPosAdcHit.GetPulseTime(thit)+fAdcTdcOffset);
-
-      if (rawPosAdcHit.GetPulseAmpRaw(thit) > 0)  ((THcSignalHit*) frPosAdcErrorFlag->ConstructedAt(nrPosAdcHits))->Set(padnum, 0);
-      if (rawPosAdcHit.GetPulseAmpRaw(thit) <= 0) ((THcSignalHit*) frPosAdcErrorFlag->ConstructedAt(nrPosAdcHits))->Set(padnum, 1);
+	((THcSignalHit*) frPosAdcPulseTimeRaw->ConstructedAt(nrPosAdcHits))->Set(padnum, rawPosAdcHit.GetPulseTimeRaw(thit));
+	((THcSignalHit*) frPosAdcPulseTime->ConstructedAt(nrPosAdcHits))->Set(padnum, rawPosAdcHit.GetPulseTime(thit)+fAdcTdcOffset);
 
+	if (rawPosAdcHit.GetPulseAmpRaw(thit) > 0)  ((THcSignalHit*) frPosAdcErrorFlag->ConstructedAt(nrPosAdcHits))->Set(padnum, 0);
+	if (rawPosAdcHit.GetPulseAmpRaw(thit) <= 0) ((THcSignalHit*) frPosAdcErrorFlag->ConstructedAt(nrPosAdcHits))->Set(padnum, 1);
+      }
       ++nrPosAdcHits;
       fTotNumAdcHits++;
       fTotNumPosAdcHits++;
@@ -895,29 +966,30 @@ Int_t THcScintillatorPlane::ProcessHits(TClonesArray* rawhits, Int_t nexthit)
     }
     // cout << " paddle num = " << padnum << " ADC Neg hits = " << rawNegAdcHit.GetNPulses() << endl;
     for (UInt_t thit=0; thit<rawNegAdcHit.GetNPulses(); ++thit) {
-      ((THcSignalHit*) frNegAdcPedRaw->ConstructedAt(nrNegAdcHits))->Set(padnum, rawNegAdcHit.GetPedRaw());
-      ((THcSignalHit*) frNegAdcPed->ConstructedAt(nrNegAdcHits))->Set(padnum, rawNegAdcHit.GetPed());
+      if(fFillRawArrays) {
+	((THcSignalHit*) frNegAdcPedRaw->ConstructedAt(nrNegAdcHits))->Set(padnum, rawNegAdcHit.GetPedRaw());
+	((THcSignalHit*) frNegAdcPed->ConstructedAt(nrNegAdcHits))->Set(padnum, rawNegAdcHit.GetPed());
 
-      ((THcSignalHit*) frNegAdcPulseIntRaw->ConstructedAt(nrNegAdcHits))->Set(padnum, rawNegAdcHit.GetPulseIntRaw(thit));
-      ((THcSignalHit*) frNegAdcPulseInt->ConstructedAt(nrNegAdcHits))->Set(padnum, rawNegAdcHit.GetPulseInt(thit));
+	((THcSignalHit*) frNegAdcPulseIntRaw->ConstructedAt(nrNegAdcHits))->Set(padnum, rawNegAdcHit.GetPulseIntRaw(thit));
+	((THcSignalHit*) frNegAdcPulseInt->ConstructedAt(nrNegAdcHits))->Set(padnum, rawNegAdcHit.GetPulseInt(thit));
 
-      ((THcSignalHit*) frNegAdcPulseAmpRaw->ConstructedAt(nrNegAdcHits))->Set(padnum, rawNegAdcHit.GetPulseAmpRaw(thit));
-      ((THcSignalHit*) frNegAdcPulseAmp->ConstructedAt(nrNegAdcHits))->Set(padnum, rawNegAdcHit.GetPulseAmp(thit));
-      ((THcSignalHit*) frNegAdcPulseTimeRaw->ConstructedAt(nrNegAdcHits))->Set(padnum, rawNegAdcHit.GetPulseTimeRaw(thit));
-      ((THcSignalHit*) frNegAdcPulseTime->ConstructedAt(nrNegAdcHits))->Set(padnum, rawNegAdcHit.GetPulseTime(thit)+fAdcTdcOffset);
-
-      if (rawNegAdcHit.GetPulseAmpRaw(thit) > 0)  ((THcSignalHit*) frNegAdcErrorFlag->ConstructedAt(nrNegAdcHits))->Set(padnum, 0);
-      if (rawNegAdcHit.GetPulseAmpRaw(thit) <= 0) ((THcSignalHit*) frNegAdcErrorFlag->ConstructedAt(nrNegAdcHits))->Set(padnum, 1);
+	((THcSignalHit*) frNegAdcPulseAmpRaw->ConstructedAt(nrNegAdcHits))->Set(padnum, rawNegAdcHit.GetPulseAmpRaw(thit));
+	((THcSignalHit*) frNegAdcPulseAmp->ConstructedAt(nrNegAdcHits))->Set(padnum, rawNegAdcHit.GetPulseAmp(thit));
+	((THcSignalHit*) frNegAdcPulseTimeRaw->ConstructedAt(nrNegAdcHits))->Set(padnum, rawNegAdcHit.GetPulseTimeRaw(thit));
+	((THcSignalHit*) frNegAdcPulseTime->ConstructedAt(nrNegAdcHits))->Set(padnum, rawNegAdcHit.GetPulseTime(thit)+fAdcTdcOffset);
 
+	if (rawNegAdcHit.GetPulseAmpRaw(thit) > 0)  ((THcSignalHit*) frNegAdcErrorFlag->ConstructedAt(nrNegAdcHits))->Set(padnum, 0);
+	if (rawNegAdcHit.GetPulseAmpRaw(thit) <= 0) ((THcSignalHit*) frNegAdcErrorFlag->ConstructedAt(nrNegAdcHits))->Set(padnum, 1);
+      }
       ++nrNegAdcHits;
       fTotNumAdcHits++;
       fTotNumNegAdcHits++;
     }
 
     // Need to be finding first hit in TDC range, not the first hit overall
-    if (hit->GetRawTdcHitPos().GetNHits() > 0)
+    if (fFillRawArrays && hit->GetRawTdcHitPos().GetNHits() > 0)
       ((THcSignalHit*) frPosTDCHits->ConstructedAt(nrPosTDCHits++))->Set(padnum, hit->GetRawTdcHitPos().GetTime()+fTdcOffset);
-    if (hit->GetRawTdcHitNeg().GetNHits() > 0)
+    if (fFillRawArrays && hit->GetRawTdcHitNeg().GetNHits() > 0)
       ((THcSignalHit*) frNegTDCHits->ConstructedAt(nrNegTDCHits++))->Set(padnum, hit->GetRawTdcHitNeg().GetTime()+fTdcOffset);
     // Should we make lists of offset corrected ADC Pulse times here too?  For now
     // the frNegAdcPulseTime frPosAdcPulseTime have that offset correction.
@@ -1054,14 +1126,14 @@ Int_t THcScintillatorPlane::ProcessHits(TClonesArray* rawhits, Int_t nexthit)
       adcint_neg = hit->GetRawAdcHitNeg().GetPulseIntRaw()-fNegPed[index];
       badcraw_pos = badcraw_neg = kTRUE;
     }
-    if (adcint_pos >= fADCDiagCut) {
+    if (fFillRawArrays && adcint_pos >= fADCDiagCut) {
       ((THcSignalHit*) frPosADCHits->ConstructedAt(nrPosADCHits))->Set(padnum, adcint_pos);
       Double_t samplesum=hit->GetRawAdcHitPos().GetSampleIntRaw();
       Double_t pedestal=hit->GetRawAdcHitPos().GetPedRaw();
       ((THcSignalHit*) frPosADCSums->ConstructedAt(nrPosADCHits))->Set(padnum, samplesum);
       ((THcSignalHit*) frPosADCPeds->ConstructedAt(nrPosADCHits++))->Set(padnum, pedestal);
     }
-    if (adcint_neg >= fADCDiagCut) {
+    if (fFillRawArrays && adcint_neg >= fADCDiagCut) {
       ((THcSignalHit*) frNegADCHits->ConstructedAt(nrNegADCHits))->Set(padnum, adcint_neg);
       Double_t samplesum=hit->GetRawAdcHitNeg().GetSampleIntRaw();
       Double_t pedestal=hit->GetRawAdcHitNeg().GetPedRaw();
@@ -1114,170 +1186,113 @@ Int_t THcScintillatorPlane::ProcessHits(TClonesArray* rawhits, Int_t nexthit)
 	//good tdc occupancy
 	fNumGoodNegTdcHits.at(padnum-1) = padnum;
       }
-      new( (*fHodoHits)[fNScinHits]) THcHodoHit(tdc_pos, tdc_neg,
-						adcint_pos, adcint_neg,
-						hit->fCounter, this);
-      ((THcHodoHit*) fHodoHits->At(fNScinHits))->SetPosADCpeak(adcamp_pos);
-      ((THcHodoHit*) fHodoHits->At(fNScinHits))->SetNegADCpeak(adcamp_neg);
-      ((THcHodoHit*) fHodoHits->At(fNScinHits))->SetPosADCtime(adctime_pos);
-      ((THcHodoHit*) fHodoHits->At(fNScinHits))->SetNegADCtime(adctime_neg);
-
-      //CALCULATE TIME-WALK CORRECTIONS HERE!!!!
-      //Define GoodTdcUnCorrTime
-      if(btdcraw_pos&&badcraw_pos) {
-	fGoodPosTdcTimeUnCorr.at(padnum-1) = tdc_pos*fScinTdcToTime;
-	//tw_corr_pos = fHodoPos_c1[padnum-1]/pow(adcamp_pos/fTdc_Thrs,fHodoPos_c2[padnum-1]) -  fHodoPos_c1[padnum-1]/pow(200./fTdc_Thrs, fHodoPos_c2[padnum-1]);
-	
-	tw_corr_pos =  1./pow(adcamp_pos/fTdc_Thrs,fHodoPos_c2[padnum-1]) -  1./pow(200./fTdc_Thrs, fHodoPos_c2[padnum-1]);
-
-	fGoodPosTdcTimeWalkCorr.at(padnum-1) = tdc_pos*fScinTdcToTime -tw_corr_pos;
-      }
-      if(btdcraw_neg&&badcraw_neg) {
-	fGoodNegTdcTimeUnCorr.at(padnum-1) = tdc_neg*fScinTdcToTime;
-	
-	//tw_corr_neg = fHodoNeg_c1[padnum-1]/pow(adcamp_neg/fTdc_Thrs,fHodoNeg_c2[padnum-1]) -  fHodoNeg_c1[padnum-1]/pow(200./fTdc_Thrs, fHodoNeg_c2[padnum-1]);
-		
-	tw_corr_neg =  1./pow(adcamp_neg/fTdc_Thrs,fHodoNeg_c2[padnum-1]) - 1./pow(200./fTdc_Thrs, fHodoNeg_c2[padnum-1]);
-
-	fGoodNegTdcTimeWalkCorr.at(padnum-1) = tdc_neg*fScinTdcToTime -tw_corr_neg;
-
-      }
-
-
-      // Do corrections if valid TDC on both ends of bar
-      if( (btdcraw_pos && btdcraw_neg) && (badcraw_pos && badcraw_neg) ) {
-	// Do the pulse height correction to the time.  (Position dependent corrections later)
-        Double_t adc_timec_pos= adctime_pos;
-        Double_t adc_timec_neg= adctime_neg;
-	Double_t timec_pos, timec_neg;
-	if(fTofUsingInvAdc) {
-	  timec_pos = tdc_pos*fScinTdcToTime
-	    - fHodoPosInvAdcOffset[index]
-	    - fHodoPosInvAdcAdc[index]/TMath::Sqrt(TMath::Max(20.0*.020,adcint_pos));
-	  timec_neg = tdc_neg*fScinTdcToTime
-	    - fHodoNegInvAdcOffset[index]
-	    - fHodoNegInvAdcAdc[index]/TMath::Sqrt(TMath::Max(20.0*.020,adcint_neg));
-	} else {		// FADC style
-	  timec_pos =  tdc_pos*fScinTdcToTime -tw_corr_pos + fHodo_LCoeff[index];
-	  timec_neg =  tdc_neg*fScinTdcToTime -tw_corr_neg- 2*fHodoCableFit[index] + fHodo_LCoeff[index];
-	  adc_timec_pos =  adc_timec_pos -tw_corr_pos + fHodo_LCoeff[index];
-	  adc_timec_neg =  adc_timec_neg -tw_corr_neg- 2*fHodoCableFit[index] + fHodo_LCoeff[index];
-	}
-
- 	Double_t TWCorrDiff = fGoodNegTdcTimeWalkCorr.at(padnum-1) - 2*fHodoCableFit[index] - fGoodPosTdcTimeWalkCorr.at(padnum-1); 
-     	
-        Double_t fHitDistCorr = 0.5*TWCorrDiff*fHodoVelFit[index];  
-
-	
-
-	fGoodDiffDistTrack.at(index) =  fHitDistCorr;
-	
-	Double_t vellight=fHodoVelLight[index]; //read from hodo_cuts.param, where it is set fixed to 15.0 
-	
-	Double_t dist_from_center=0.5*(timec_neg-timec_pos)*vellight;
-	Double_t scint_center=0.5*(fPosLeft+fPosRight);
-	Double_t hit_position=scint_center+dist_from_center;
-	hit_position=TMath::Min(hit_position,fPosLeft);
-	hit_position=TMath::Max(hit_position,fPosRight);
-	Double_t scin_corrected_time, postime, negtime;
-	  Double_t adc_postime=adc_timec_pos;
-	  Double_t adc_negtime=adc_timec_neg;	  
-	if(fTofUsingInvAdc) {
-	  timec_pos -= (fPosLeft-hit_position)/
-	    fHodoPosInvAdcLinear[index];
-	  timec_neg -= (hit_position-fPosRight)/
-	    fHodoNegInvAdcLinear[index];
-	  scin_corrected_time = 0.5*(timec_pos+timec_neg);
-	  if (fCosmicFlag) {
-	    postime = timec_pos + (fZpos+(index%2)*fDzpos)/(29.979*fBetaNominal);
-	    negtime = timec_neg + (fZpos+(index%2)*fDzpos)/(29.979*fBetaNominal);
-	  } else {
-	    postime = timec_pos - (fZpos+(index%2)*fDzpos)/(29.979*fBetaNominal);
-	    negtime = timec_neg - (fZpos+(index%2)*fDzpos)/(29.979*fBetaNominal);
-	  }
-	} else {
-	  scin_corrected_time = 0.5*(timec_neg+timec_pos);  
-	  timec_pos= scin_corrected_time;    
-	  timec_neg= scin_corrected_time;
-	  Double_t adc_time_corrected = 0.5*(adc_timec_pos+adc_timec_neg);
-	  if (fCosmicFlag) {
-	    postime = timec_pos + (fZpos+(index%2)*fDzpos)/(29.979*fBetaNominal);
-	    negtime = timec_neg + (fZpos+(index%2)*fDzpos)/(29.979*fBetaNominal);
-	    adc_postime = adc_time_corrected + (fZpos+(index%2)*fDzpos)/(29.979*fBetaNominal);
-	    adc_negtime = adc_time_corrected + (fZpos+(index%2)*fDzpos)/(29.979*fBetaNominal);
-	  } else {
-	    postime = timec_pos - (fZpos+(index%2)*fDzpos)/(29.979*fBetaNominal);
-	    negtime = timec_neg - (fZpos+(index%2)*fDzpos)/(29.979*fBetaNominal);
-	    adc_postime = adc_time_corrected - (fZpos+(index%2)*fDzpos)/(29.979*fBetaNominal);
-	    adc_negtime = adc_time_corrected - (fZpos+(index%2)*fDzpos)/(29.979*fBetaNominal);
-	  }
-	}
-        ((THcHodoHit*) fHodoHits->At(fNScinHits))->SetPaddleCenter(fPosCenter[index]);
-	((THcHodoHit*) fHodoHits->At(fNScinHits))->SetCorrectedTimes(timec_pos,timec_neg,         
-								     postime, negtime,
-								     scin_corrected_time);
-	((THcHodoHit*) fHodoHits->At(fNScinHits))->SetPosADCpeak(adcamp_pos); 
-	((THcHodoHit*) fHodoHits->At(fNScinHits))->SetNegADCpeak(adcamp_neg); 
-	((THcHodoHit*) fHodoHits->At(fNScinHits))->SetPosADCCorrtime(adc_postime); 
-	((THcHodoHit*) fHodoHits->At(fNScinHits))->SetNegADCCorrtime(adc_negtime); 
-        ((THcHodoHit*) fHodoHits->At(fNScinHits))->SetCalcPosition(fHitDistCorr); // 
-
-	fGoodPosTdcTimeCorr.at(padnum-1) = timec_pos;
-	fGoodNegTdcTimeCorr.at(padnum-1) = timec_neg;
-	fGoodPosTdcTimeTOFCorr.at(padnum-1) = postime;
-	fGoodNegTdcTimeTOFCorr.at(padnum-1) = negtime;
-      } else {
-	Double_t timec_pos,timec_neg;
-        timec_pos=tdc_pos;
-        timec_neg=tdc_neg;
-	if(btdcraw_pos&& badcraw_pos) {
-	  if(fTofUsingInvAdc) {
-	    timec_pos = tdc_pos*fScinTdcToTime
-	      - fHodoPosInvAdcOffset[index]
-	      - fHodoPosInvAdcAdc[index]/TMath::Sqrt(TMath::Max(20.0*.020,adcint_pos));
-	  } else {		// FADC style
-	  timec_pos =  tdc_pos*fScinTdcToTime -tw_corr_pos + fHodo_LCoeff[index];
-	  }
-	}
-	if(btdcraw_neg && badcraw_neg) {
-	  if(fTofUsingInvAdc) {
-	    timec_neg = tdc_neg*fScinTdcToTime
-	      - fHodoNegInvAdcOffset[index]
-	      - fHodoNegInvAdcAdc[index]/TMath::Sqrt(TMath::Max(20.0*.020,adcint_neg));
-	  } else {		// FADC style
-	  timec_neg =  tdc_neg*fScinTdcToTime -tw_corr_neg- 2*fHodoCableFit[index] + fHodo_LCoeff[index];
-	  }
-	}
-        Double_t adc_neg=0.,adc_pos=0.;
-	if (badcraw_neg) adc_neg=adcamp_neg;
-	if (badcraw_pos) adc_pos=adcamp_pos;
-        ((THcHodoHit*) fHodoHits->At(fNScinHits))->SetPaddleCenter(fPosCenter[index]);
-	((THcHodoHit*) fHodoHits->At(fNScinHits))->SetCorrectedTimes(timec_pos,timec_neg);
-        ((THcHodoHit*) fHodoHits->At(fNScinHits))->SetNegADCpeak(adc_neg); // needed for new TWCOrr
-	((THcHodoHit*) fHodoHits->At(fNScinHits))->SetPosADCpeak(adc_pos); // needed for new TWCOrr
-	if (badcraw_neg)  {
-          ((THcHodoHit*) fHodoHits->At(fNScinHits))->SetNegADCtime(adctime_neg);
-         } else {
-           ((THcHodoHit*) fHodoHits->At(fNScinHits))->SetNegADCtime(-999.);
-        }
-	if (badcraw_pos) {
-           ((THcHodoHit*) fHodoHits->At(fNScinHits))->SetPosADCtime(adctime_pos); 
-         } else {
-           ((THcHodoHit*) fHodoHits->At(fNScinHits))->SetPosADCtime(-999.); 
-         }
-        ((THcHodoHit*) fHodoHits->At(fNScinHits))->SetCalcPosition(kBig); // 
-	fGoodPosTdcTimeCorr.at(padnum-1) = timec_pos;
-	fGoodNegTdcTimeCorr.at(padnum-1) = timec_neg;
-	fGoodPosTdcTimeTOFCorr.at(padnum-1) = kBig;
-	fGoodNegTdcTimeTOFCorr.at(padnum-1) = kBig;
-      }
-      //      if ( ((THcHodoHit*) fHodoHits->At(fNScinHits))->GetPosTOFCorrectedTime() != ((THcHodoHit*) fHodoHits->At(fNScinHits))->GetPosTOFCorrectedTime()) cout << " ihit = " << ihit << " scinhit = " << fNScinHits << " plane = " << fPlaneNum << " padnum = " << padnum << " " << tdc_pos<< " "<< tdc_neg<< " " << ((THcHodoHit*) fHodoHits->At(fNScinHits))->GetPosTOFCorrectedTime() << endl;
-      fNScinHits++;		// One or more good time counter
+      // The corrected times of all selected paddles are computed
+      // together after the loop, see CorrectHitTimes
+      fSelIndex[nsel] = index;
+      fSelFlags[nsel] = (btdcraw_pos ? kSelGoodTdcPos : 0)
+	| (btdcraw_neg ? kSelGoodTdcNeg : 0)
+	| (badcraw_pos ? kSelGoodAdcPos : 0)
+	| (badcraw_neg ? kSelGoodAdcNeg : 0);
+      SelRow(kSelTdcPos)[nsel] = tdc_pos;
+      SelRow(kSelTdcNeg)[nsel] = tdc_neg;
+      SelRow(kSelAdcIntPos)[nsel] = adcint_pos;
+      SelRow(kSelAdcIntNeg)[nsel] = adcint_neg;
+      SelRow(kSelAdcAmpPos)[nsel] = adcamp_pos;
+      SelRow(kSelAdcAmpNeg)[nsel] = adcamp_neg;
+      SelRow(kSelAdcTimePos)[nsel] = adctime_pos;
+      SelRow(kSelAdcTimeNeg)[nsel] = adctime_neg;
+      nsel++;
       //
     }
     ihit++;			// Raw hit counter
   }
   //  cout << "THcScintillatorPlane: ihit = " << ihit << endl;
+
+  // Correct the times of all selected paddles, then make their hits
+  CorrectHitTimes(nsel);
+  const Double_t* seltdcpos = SelRow(kSelTdcPos);
+  const Double_t* seltdcneg = SelRow(kSelTdcNeg);
+  const Double_t* seladcintpos = SelRow(kSelAdcIntPos);
+  const Double_t* seladcintneg = SelRow(kSelAdcIntNeg);
+  const Double_t* seladcamppos = SelRow(kSelAdcAmpPos);
+  const Double_t* seladcampneg = SelRow(kSelAdcAmpNeg);
+  const Double_t* seladctimepos = SelRow(kSelAdcTimePos);
+  const Double_t* seladctimeneg = SelRow(kSelAdcTimeNeg);
+  const Double_t* selwalkpos = SelRow(kSelWalkPos);
+  const Double_t* selwalkneg = SelRow(kSelWalkNeg);
+  const Double_t* seltimecpos = SelRow(kSelTimecPos);
+  const Double_t* seltimecneg = SelRow(kSelTimecNeg);
+  const Double_t* selpostime = SelRow(kSelPosTime);
+  const Double_t* selnegtime = SelRow(kSelNegTime);
+  const Double_t* selscintime = SelRow(kSelScinTime);
+  const Double_t* seladcpostime = SelRow(kSelAdcPosTime);
+  const Double_t* seladcnegtime = SelRow(kSelAdcNegTime);
+  const Double_t* selcalcpos = SelRow(kSelCalcPos);
+  for(Int_t isel=0;isel<nsel;isel++) {
+    Int_t index = fSelIndex[isel];
+    Int_t padnum = index+1;
+    Bool_t btdcraw_pos = fSelFlags[isel] & kSelGoodTdcPos;
+    Bool_t btdcraw_neg = fSelFlags[isel] & kSelGoodTdcNeg;
+    Bool_t badcraw_pos = fSelFlags[isel] & kSelGoodAdcPos;
+    Bool_t badcraw_neg = fSelFlags[isel] & kSelGoodAdcNeg;
+    Double_t adcamp_pos = seladcamppos[isel];
+    Double_t adcamp_neg = seladcampneg[isel];
+    Double_t adctime_pos = seladctimepos[isel];
+    Double_t adctime_neg = seladctimeneg[isel];
+    THcHodoHit* hodohit = new( (*fHodoHits)[fNScinHits])
+      THcHodoHit((Int_t)seltdcpos[isel], (Int_t)seltdcneg[isel],
+		 seladcintpos[isel], seladcintneg[isel], padnum, this);
+    hodohit->SetPosADCpeak(adcamp_pos);
+    hodohit->SetNegADCpeak(adcamp_neg);
+    hodohit->SetPosADCtime(adctime_pos);
+    hodohit->SetNegADCtime(adctime_neg);
+    hodohit->SetGoodEnds(btdcraw_pos, btdcraw_neg, badcraw_pos, badcraw_neg);
+
+    //Define GoodTdcUnCorrTime and the time-walk corrected times
+    if(btdcraw_pos&&badcraw_pos) {
+      fGoodPosTdcTimeUnCorr.at(padnum-1) = seltdcpos[isel]*fScinTdcToTime;
+      fGoodPosTdcTimeWalkCorr.at(padnum-1) = selwalkpos[isel];
+    }
+    if(btdcraw_neg&&badcraw_neg) {
+      fGoodNegTdcTimeUnCorr.at(padnum-1) = seltdcneg[isel]*fScinTdcToTime;
+      fGoodNegTdcTimeWalkCorr.at(padnum-1) = selwalkneg[isel];
+    }
+
+    if( (btdcraw_pos && btdcraw_neg) && (badcraw_pos && badcraw_neg) ) {
+      // Valid TDC and ADC on both ends of bar: fully corrected times
+      fGoodDiffDistTrack.at(index) = selcalcpos[isel];
+      hodohit->SetPaddleCenter(fPosCenter[index]);
+      hodohit->SetCorrectedTimes(seltimecpos[isel],seltimecneg[isel],
+				 selpostime[isel], selnegtime[isel],
+				 selscintime[isel]);
+      hodohit->SetPosADCpeak(adcamp_pos);
+      hodohit->SetNegADCpeak(adcamp_neg);
+      hodohit->SetPosADCCorrtime(seladcpostime[isel]);
+      hodohit->SetNegADCCorrtime(seladcnegtime[isel]);
+      hodohit->SetCalcPosition(selcalcpos[isel]); //
+
+      fGoodPosTdcTimeCorr.at(padnum-1) = seltimecpos[isel];
+      fGoodNegTdcTimeCorr.at(padnum-1) = seltimecneg[isel];
+      fGoodPosTdcTimeTOFCorr.at(padnum-1) = selpostime[isel];
+      fGoodNegTdcTimeTOFCorr.at(padnum-1) = selnegtime[isel];
+    } else {
+      Double_t adc_neg=0.,adc_pos=0.;
+      if (badcraw_neg) adc_neg=adcamp_neg;
+      if (badcraw_pos) adc_pos=adcamp_pos;
+      hodohit->SetPaddleCenter(fPosCenter[index]);
+      hodohit->SetCorrectedTimes(seltimecpos[isel],seltimecneg[isel]);
+      hodohit->SetNegADCpeak(adc_neg); // needed for new TWCOrr
+      hodohit->SetPosADCpeak(adc_pos); // needed for new TWCOrr
+      hodohit->SetNegADCtime(badcraw_neg ? adctime_neg : -999.);
+      hodohit->SetPosADCtime(badcraw_pos ? adctime_pos : -999.);
+      hodohit->SetCalcPosition(kBig); //
+      fGoodPosTdcTimeCorr.at(padnum-1) = seltimecpos[isel];
+      fGoodNegTdcTimeCorr.at(padnum-1) = seltimecneg[isel];
+      fGoodPosTdcTimeTOFCorr.at(padnum-1) = kBig;
+      fGoodNegTdcTimeTOFCorr.at(padnum-1) = kBig;
+    }
+    fNScinHits++;		// One or more good time counter
+  }
   if (problem_flag) {
  cout << "THcScintillatorPlane::ProcessHits " << fPlaneNum << " " << nexthit << "/" << nrawhits << endl;
 cout << " Ref problem end *******" << endl;
@@ -1285,6 +1300,129 @@ cout << " Ref problem end *******" << endl;
   return(ihit);
 }
 
+//_____________________________________________________________________________
+void THcScintillatorPlane::CorrectHitTimes( Int_t nsel )
+{
+  /*! \brief Corrected times and positions of the paddles selected by ProcessHits
+   *
+   * Works column by column on the selection rows (see ESelRow) with the
+   * calibration rows (ECalibRow) gathered by paddle index, one loop per
+   * stage over all selected paddles.  The plane-wide choices
+   * (fTofUsingInvAdc, fCosmicFlag) are made outside the loops.
+   * - Time-walk correction of each end with TDC and ADC
+   * - Pulse height and cable corrections of each end; ends without
+   *   both TDC and ADC keep the raw TDC value
+   * - For paddles with TDC and ADC on both ends: hit position,
+   *   propagation and flight time corrections
+   */
+  const Int_t*    index   = &fSelIndex[0];
+  const Int_t*    flags   = &fSelFlags[0];
+  const Double_t* tdcpos  = SelRow(kSelTdcPos);
+  const Double_t* tdcneg  = SelRow(kSelTdcNeg);
+  const Double_t* intpos  = SelRow(kSelAdcIntPos);
+  const Double_t* intneg  = SelRow(kSelAdcIntNeg);
+  const Double_t* amppos  = SelRow(kSelAdcAmpPos);
+  const Double_t* ampneg  = SelRow(kSelAdcAmpNeg);
+  const Double_t* atimepos = SelRow(kSelAdcTimePos);
+  const Double_t* atimeneg = SelRow(kSelAdcTimeNeg);
+  Double_t* walkpos  = SelRow(kSelWalkPos);
+  Double_t* walkneg  = SelRow(kSelWalkNeg);
+  Double_t* twpos    = SelRow(kSelTwCorrPos);
+  Double_t* twneg    = SelRow(kSelTwCorrNeg);
+  Double_t* timecpos = SelRow(kSelTimecPos);
+  Double_t* timecneg = SelRow(kSelTimecNeg);
+  Double_t* atimecpos = SelRow(kSelAdcTimecPos);
+  Double_t* atimecneg = SelRow(kSelAdcTimecNeg);
+  Double_t* postime  = SelRow(kSelPosTime);
+  Double_t* negtime  = SelRow(kSelNegTime);
+  Double_t* scintime = SelRow(kSelScinTime);
+  Double_t* apostime = SelRow(kSelAdcPosTime);
+  Double_t* anegtime = SelRow(kSelAdcNegTime);
+  Double_t* calcpos  = SelRow(kSelCalcPos);
+  const Double_t* postwref = CalibRow(kCalPosTwRef);
+  const Double_t* negtwref = CalibRow(kCalNegTwRef);
+  const Double_t* tofpath  = CalibRow(kCalTofPath);
+  const Int_t kPos = kSelGoodTdcPos|kSelGoodAdcPos;
+  const Int_t kNeg = kSelGoodTdcNeg|kSelGoodAdcNeg;
+
+  // Time-walk corrections
+  for(Int_t i=0;i<nsel;i++) {
+    Int_t j = index[i];
+    if((flags[i] & kPos) == kPos) {
+      twpos[i] = 1./pow(amppos[i]/fTdc_Thrs,fHodoPos_c2[j]) - postwref[j];
+      walkpos[i] = tdcpos[i]*fScinTdcToTime - twpos[i];
+    }
+    if((flags[i] & kNeg) == kNeg) {
+      twneg[i] = 1./pow(ampneg[i]/fTdc_Thrs,fHodoNeg_c2[j]) - negtwref[j];
+      walkneg[i] = tdcneg[i]*fScinTdcToTime - twneg[i];
+    }
+  }
+
+  // Pulse height corrected times of each end
+  if(fTofUsingInvAdc) {
+    for(Int_t i=0;i<nsel;i++) {
+      Int_t j = index[i];
+      timecpos[i] = ((flags[i] & kPos) == kPos) ?
+	tdcpos[i]*fScinTdcToTime
+	- fHodoPosInvAdcOffset[j]
+	- fHodoPosInvAdcAdc[j]/TMath::Sqrt(TMath::Max(20.0*.020,intpos[i]))
+	: tdcpos[i];
+      timecneg[i] = ((flags[i] & kNeg) == kNeg) ?
+	tdcneg[i]*fScinTdcToTime
+	- fHodoNegInvAdcOffset[j]
+	- fHodoNegInvAdcAdc[j]/TMath::Sqrt(TMath::Max(20.0*.020,intneg[i]))
+	: tdcneg[i];
+      atimecpos[i] = atimepos[i];
+      atimecneg[i] = atimeneg[i];
+    }
+  } else {		// FADC style
+    for(Int_t i=0;i<nsel;i++) {
+      Int_t j = index[i];
+      timecpos[i] = ((flags[i] & kPos) == kPos) ?
+	tdcpos[i]*fScinTdcToTime -twpos[i] + fHodo_LCoeff[j] : tdcpos[i];
+      timecneg[i] = ((flags[i] & kNeg) == kNeg) ?
+	tdcneg[i]*fScinTdcToTime -twneg[i]- 2*fHodoCableFit[j] + fHodo_LCoeff[j]
+	: tdcneg[i];
+      if((flags[i] & (kPos|kNeg)) == (kPos|kNeg)) {
+	atimecpos[i] = atimepos[i] -twpos[i] + fHodo_LCoeff[j];
+	atimecneg[i] = atimeneg[i] -twneg[i]- 2*fHodoCableFit[j] + fHodo_LCoeff[j];
+      }
+    }
+  }
+
+  // Position, propagation and flight time for paddles with both ends
+  Double_t scint_center=0.5*(fPosLeft+fPosRight);
+  for(Int_t i=0;i<nsel;i++) {
+    if((flags[i] & (kPos|kNeg)) != (kPos|kNeg)) continue;
+    Int_t j = index[i];
+    Double_t TWCorrDiff = walkneg[i] - 2*fHodoCableFit[j] - walkpos[i];
+    calcpos[i] = 0.5*TWCorrDiff*fHodoVelFit[j];
+    //fHodoVelLight read from hodo_cuts.param, where it is set fixed to 15.0
+    Double_t dist_from_center=0.5*(timecneg[i]-timecpos[i])*fHodoVelLight[j];
+    Double_t hit_position=scint_center+dist_from_center;
+    hit_position=TMath::Min(hit_position,fPosLeft);
+    hit_position=TMath::Max(hit_position,fPosRight);
+    if(fTofUsingInvAdc) {
+      timecpos[i] -= (fPosLeft-hit_position)/fHodoPosInvAdcLinear[j];
+      timecneg[i] -= (hit_position-fPosRight)/fHodoNegInvAdcLinear[j];
+      scintime[i] = 0.5*(timecpos[i]+timecneg[i]);
+      postime[i] = timecpos[i] + tofpath[j];
+      negtime[i] = timecneg[i] + tofpath[j];
+      apostime[i] = atimecpos[i];
+      anegtime[i] = atimecneg[i];
+    } else {
+      scintime[i] = 0.5*(timecneg[i]+timecpos[i]);
+      timecpos[i] = scintime[i];
+      timecneg[i] = scintime[i];
+      Double_t adc_time_corrected = 0.5*(atimecpos[i]+atimecneg[i]);
+      postime[i] = scintime[i] + tofpath[j];
+      negtime[i] = scintime[i] + tofpath[j];
+      apostime[i] = adc_time_corrected + tofpath[j];
+      anegtime[i] = adc_time_corrected + tofpath[j];
+    }
+  }
+}
+
 //_____________________________________________________________________________
 Int_t THcScintillatorPlane::AccumulatePedestals(TClonesArray* rawhits, Int_t nexthit)
 {
@@ -1386,6 +1524,22 @@ void THcScintillatorPlane::InitializePedestals( )
     fNegPedLimit[i] = 1000;	// In engine, this are set in parameter file
     fNegPedCount[i] = 0;
   }
+  if(gHcCheckpoint) {		// Accumulators to save for resuming
+    TString prefix = GetPrefix();
+    gHcCheckpoint->Define(prefix+"NPedestalEvents", &fNPedestalEvents);
+    gHcCheckpoint->Define(prefix+"PosPedSum", fPosPedSum, fNelem);
+    gHcCheckpoint->Define(prefix+"PosPedSum2", fPosPedSum2, fNelem);
+    gHcCheckpoint->Define(prefix+"PosPedLimit", fPosPedLimit, fNelem);
+    gHcCheckpoint->Define(prefix+"PosPedCount", fPosPedCount, fNelem);
+    gHcCheckpoint->Define(prefix+"NegPedSum", fNegPedSum, fNelem);
+    gHcCheckpoint->Define(prefix+"NegPedSum2", fNegPedSum2, fNelem);
+    gHcCheckpoint->Define(prefix+"NegPedLimit", fNegPedLimit, fNelem);
+    gHcCheckpoint->Define(prefix+"NegPedCount", fNegPedCount, fNelem);
+    gHcCheckpoint->Define(prefix+"PosPed", fPosPed, fNelem);
+    gHcCheckpoint->Define(prefix+"NegPed", fNegPed, fNelem);
+    gHcCheckpoint->Define(prefix+"PosThresh", fPosThresh, fNelem);
+    gHcCheckpoint->Define(prefix+"NegThresh", fNegThresh, fNelem);
+  }
 }
 //____________________________________________________________________________
 ClassImp(THcScintillatorPlane)
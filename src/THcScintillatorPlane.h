@@ -20,6 +20,7 @@ using namespace std;
 
 class THaEvData;
 class THaSignalHit;
+class THcMemoryReport;
 
 class THcScintillatorPlane : public THaSubDetector {
 
@@ -38,6 +39,7 @@ class THcScintillatorPlane : public THaSubDetector {
   virtual Bool_t   IsPid()      { return kFALSE; }
 
   virtual Int_t ProcessHits(TClonesArray* rawhits, Int_t nexthit);
+  void          AccountMemory(THcMemoryReport& report) const;
 
   virtual Int_t AccumulatePedestals(TClonesArray* rawhits, Int_t nexthit);
   virtual void  CalculatePedestals( );
@@ -181,6 +183,7 @@ class THcScintillatorPlane : public THaSubDetector {
   vector<Double_t>  fGoodDiffDistTrack;
 
   Int_t fDebugAdc;
+  Bool_t fFillRawArrays;	// Fill raw per-hit arrays (only if used)
   Double_t fPosTdcRefTime;
   Double_t fPosAdcRefTime;
   Double_t fNegTdcRefTime;
@@ -258,10 +261,45 @@ class THcScintillatorPlane : public THaSubDetector {
   Double_t* fHodoNeg_c2;
   Double_t  fTdc_Thrs;  
 
-  Double_t tw_corr_pos;
-  Double_t tw_corr_neg;
-
   Double_t *fHodoSigma;
+
+  // Per-paddle calibration constants of this plane, structure of arrays:
+  // one row of fCalibStride doubles per constant, in one 64-byte
+  // aligned block.  The fHodo... pointers above point to its rows.  The
+  // last rows are derived in ReadDatabase: the time-walk correction at
+  // the reference amplitude and the signed flight time to the paddle.
+  enum ECalibRow { kCalPosMinPh, kCalNegMinPh, kCalPosPhcCoeff,
+		   kCalNegPhcCoeff, kCalPosTimeOffset, kCalNegTimeOffset,
+		   kCalVelLight, kCalPosInvAdcOffset, kCalNegInvAdcOffset,
+		   kCalPosAdcTimeWindowMin, kCalPosAdcTimeWindowMax,
+		   kCalNegAdcTimeWindowMin, kCalNegAdcTimeWindowMax,
+		   kCalPosInvAdcLinear, kCalNegInvAdcLinear,
+		   kCalPosInvAdcAdc, kCalNegInvAdcAdc, kCalSigma,
+		   kCalVelFit, kCalCableFit, kCalLCoeff,
+		   kCalPos_c1, kCalNeg_c1, kCalPos_c2, kCalNeg_c2,
+		   kCalPosTwRef, kCalNegTwRef, kCalTofPath, kNCalibRows };
+  Double_t* fCalibBlock;	// Allocation holding fCalib
+  Double_t* fCalib;		// [kNCalibRows][fCalibStride]
+  Int_t     fCalibStride;	// fNelem rounded up to 8
+  Double_t* CalibRow(Int_t row) const { return fCalib+row*fCalibStride; }
+
+  // Paddles selected by ProcessHits in the current event, in the same
+  // layout: the TDC and ADC values chosen for each end, and the
+  // corrected times filled in by CorrectHitTimes.
+  enum ESelRow { kSelTdcPos, kSelTdcNeg, kSelAdcIntPos, kSelAdcIntNeg,
+		 kSelAdcAmpPos, kSelAdcAmpNeg, kSelAdcTimePos, kSelAdcTimeNeg,
+		 kSelWalkPos, kSelWalkNeg, kSelTwCorrPos, kSelTwCorrNeg,
+		 kSelTimecPos, kSelTimecNeg, kSelAdcTimecPos, kSelAdcTimecNeg,
+		 kSelPosTime, kSelNegTime, kSelScinTime,
+		 kSelAdcPosTime, kSelAdcNegTime, kSelCalcPos, kNSelRows };
+  enum { kSelGoodTdcPos = 1, kSelGoodTdcNeg = 2,
+	 kSelGoodAdcPos = 4, kSelGoodAdcNeg = 8 };
+  Double_t* fSelBlock;		// Allocation holding fSel
+  Double_t* fSel;		// [kNSelRows][fCalibStride]
+  Double_t* SelRow(Int_t row) const { return fSel+row*fCalibStride; }
+  std::vector<Int_t> fSelIndex;	// Paddle index of each selected paddle
+  std::vector<Int_t> fSelFlags;	// kSelGood... bits
+  void      CorrectHitTimes(Int_t nsel);
   Double_t fTolerance; /* need this for Focal Plane Time estimation */
   Double_t fFptime;
   /* Pedestal Quantities */
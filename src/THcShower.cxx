@@ -20,6 +20,7 @@
 #include "THaTrackProj.h"
 #include "TMath.h"
 #include "Helper.h"
+#include "THcMemoryReport.h"
 
 #include <cstring>
 #include <cstdio>
@@ -144,7 +145,8 @@ void THcShower::Setup(const char* name, const char* description)
 //_____________________________________________________________________________
 THaAnalysisObject::EStatus THcShower::Init( const TDatime& date )
 {
-  Setup(GetName(), GetTitle());
+  // Planes are kept when re-initialized, e.g. by THcBatchReplay
+  if(!fPlanes) Setup(GetName(), GetTitle());
 
   char EngineDID[] = "xCAL";
   EngineDID[0] = toupper(GetApparatus()->GetName()[0]);
@@ -1302,5 +1304,16 @@ Int_t THcShower::End(THaRunBase* run)
   return 0;
 }
 
+//_____________________________________________________________________________
+void THcShower::AccountMemory( THcMemoryReport& report ) const
+{
+  // Raw hits, the layers and the fly's eye array
+  THcHitList::AccountMemory(report);
+  for(UInt_t ip=0;ip<fNLayers;ip++) {
+    if(fPlanes && fPlanes[ip]) fPlanes[ip]->AccountMemory(report);
+  }
+  if(fArray) fArray->AccountMemory(report);
+}
+
 ClassImp(THcShower)
 ////////////////////////////////////////////////////////////////////////////////
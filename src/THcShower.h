@@ -26,6 +26,7 @@ public:
   virtual EStatus    Init( const TDatime& run_time );
   virtual Int_t      CoarseProcess( TClonesArray& tracks );
   virtual Int_t      FineProcess( TClonesArray& tracks );
+  virtual void       AccountMemory( THcMemoryReport& report ) const;
 
   Double_t GetNormETot();
 
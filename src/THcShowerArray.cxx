@@ -10,6 +10,8 @@
 #include "TClonesArray.h"
 #include "THcSignalHit.h"
 #include "THcGlobals.h"
+#include "THcCheckpoint.h"
+#include "THcMemoryReport.h"
 #include "THcParmList.h"
 #include "THcHitList.h"
 #include "THcShower.h"
@@ -62,6 +64,7 @@ THcShowerArray::~THcShowerArray()
 {
   // Destructor
 
+  if(gHcCheckpoint) gHcCheckpoint->RemovePrefix(GetPrefix());
   Clear(); // deletes allocations in fClusterList
   for (UInt_t i=0; i<fNRows; i++) {
     delete [] fXPos[i];
@@ -385,10 +388,23 @@ Int_t THcShowerArray::ReadDatabase( const TDatime& date )
 
   // Numbers of tracks and hits , for efficiency calculations.
   
-  fStatNumTrk = vector<Int_t> (fNelem, 0);
-  fStatNumHit = vector<Int_t> (fNelem, 0);
-  fTotStatNumTrk = 0;
-  fTotStatNumHit = 0;
+  fStats.Clear();
+  fStatNumTrkId = fStats.DefineCounter("", "Tracks per module", fNelem);
+  fStatNumHitId = fStats.DefineCounter("", "Hits per module", fNelem);
+  fTotStatNumTrkId = fStats.DefineCounter("", "Number of tracks");
+  fTotStatNumHitId = fStats.DefineCounter("", "Number of hits");
+
+  // Register counters for efficiency calculations in gHcParms so that the
+  // variables can be used in end of run reports.  Here, not in
+  // DefineVariables, since Clear removed them and DefineVariables does
+  // nothing on the Init of the following runs.
+
+  fStats.Publish(fTotStatNumTrkId,
+		 Form("%sstat_trksum_array", fParent->GetPrefix()),
+		 "Number of tracks in calo. array");
+  fStats.Publish(fTotStatNumHitId,
+		 Form("%sstat_hitsum_array", fParent->GetPrefix()),
+		 "Number of hits in calo. array");
 
 #ifdef HITPIC
   hitpic = new char*[fNRows];
@@ -418,14 +434,6 @@ Int_t THcShowerArray::DefineVariables( EMode mode )
   if( mode == kDefine && fIsSetup ) return kOK;
   fIsSetup = ( mode == kDefine );
 
-  // Register counters for efficiency calculations in gHcParms so that the
-  // variables can be used in end of run reports.
-
-  gHcParms->Define(Form("%sstat_trksum_array", fParent->GetPrefix()),
-		   "Number of tracks in calo. array", fTotStatNumTrk);
-  gHcParms->Define(Form("%sstat_hitsum_array", fParent->GetPrefix()),
-		   "Number of hits in calo. array", fTotStatNumHit);
-
   // Register variables in global list
   if (fDebugAdc) {
     RVarDef vars[] = {
@@ -1205,6 +1213,17 @@ void THcShowerArray::InitializePedestals( )
     fPedSum2[i] = 0;
     fPedCount[i] = 0;
   }
+  if(gHcCheckpoint) {		// Accumulators to save for resuming
+    TString prefix = GetPrefix();
+    gHcCheckpoint->Define(prefix+"NPedestalEvents", &fNPedestalEvents);
+    gHcCheckpoint->Define(prefix+"PedSum", fPedSum, fNelem);
+    gHcCheckpoint->Define(prefix+"PedSum2", fPedSum2, fNelem);
+    gHcCheckpoint->Define(prefix+"PedLimit", fPedLimit, fNelem);
+    gHcCheckpoint->Define(prefix+"PedCount", fPedCount, fNelem);
+    gHcCheckpoint->Define(prefix+"Sig", fSig, fNelem);
+    gHcCheckpoint->Define(prefix+"Ped", fPed, fNelem);
+    gHcCheckpoint->Define(prefix+"Thresh", fThresh, fNelem);
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -1292,12 +1311,12 @@ Int_t THcShowerArray::AccumulateStat(TClonesArray& tracks )
     if (TMath::Abs(XTrk - fXPos[row][col]) < fStatSlop &&
 	TMath::Abs(YTrk - fYPos[row][col]) < fStatSlop) {
 
-      fStatNumTrk.at(i)++;
-      fTotStatNumTrk++;
+      fStats.Increment(fStatNumTrkId, i);
+      fStats.Increment(fTotStatNumTrkId);
       
       if (fGoodAdcPulseInt.at(i) > 0.) {
-	fStatNumHit.at(i)++;
-	fTotStatNumHit++;
+	fStats.Increment(fStatNumHitId, i);
+	fStats.Increment(fTotStatNumHitId);
       }
       
     }
@@ -1332,3 +1351,26 @@ Int_t THcShowerArray::AccumulateStat(TClonesArray& tracks )
   
   return 1;
 }
+
+//_____________________________________________________________________________
+void THcShowerArray::AccountMemory( THcMemoryReport& report ) const
+{
+  // Called by THcShower::AccountMemory, as for the layers
+  const TClonesArray* signals[] = {
+    fADCHits, frAdcPedRaw, frAdcErrorFlag,
+    frAdcPulseIntRaw, frAdcPulseAmpRaw, frAdcPulseTimeRaw,
+    frAdcPed, frAdcPulseInt, frAdcPulseAmp, frAdcPulseTime
+  };
+  Long64_t bytes = 0;
+  for(UInt_t i=0;i<sizeof(signals)/sizeof(signals[0]);i++) {
+    bytes += THcMemoryReport::Bytes(signals[i]);
+  }
+  report.Add("array signal hits", bytes, THcMemoryReport::kDynamic);
+  bytes = THcMemoryReport::Bytes(fNumGoodAdcHits) + THcMemoryReport::Bytes(fGoodAdcPulseIntRaw)
+    + THcMemoryReport::Bytes(fGoodAdcPed) + THcMemoryReport::Bytes(fGoodAdcMult)
+    + THcMemoryReport::Bytes(fGoodAdcPulseInt) + THcMemoryReport::Bytes(fGoodAdcPulseAmp)
+    + THcMemoryReport::Bytes(fGoodAdcPulseTime) + THcMemoryReport::Bytes(fGoodAdcTdcDiffTime)
+    + THcMemoryReport::Bytes(fE);
+  report.Add("array good hits", bytes, THcMemoryReport::kStatic);
+  report.Add("array", IsA()->Size(), THcMemoryReport::kStatic);
+}
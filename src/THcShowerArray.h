@@ -20,6 +20,7 @@
 #include "THaTrack.h"
 #include "TClonesArray.h"
 #include "THcShowerHit.h"
+#include "THcRunStats.h"
 
 #include <iostream>
 
@@ -28,6 +29,7 @@
 class THaEvData;
 class THaSignalHit;
 class THcHodoscope;
+class THcMemoryReport;
 
 class THcShowerArray : public THaSubDetector {
 
@@ -46,6 +48,7 @@ public:
   virtual Bool_t   IsPid()      { return kFALSE; }
 
   virtual Int_t ProcessHits(TClonesArray* rawhits, Int_t nexthit);
+  void          AccountMemory(THcMemoryReport& report) const;
   virtual Int_t CoarseProcessHits();
   virtual Int_t AccumulatePedestals(TClonesArray* rawhits, Int_t nexthit);
   virtual void  CalculatePedestals( );
@@ -205,10 +208,11 @@ protected:
   Double_t fStatCerMin;
   Double_t fStatSlop;
   Double_t fStatMaxChi2;
-  vector<Int_t> fStatNumTrk;
-  vector<Int_t> fStatNumHit;
-  Int_t fTotStatNumTrk;
-  Int_t fTotStatNumHit;
+  THcRunStats fStats;
+  Int_t fStatNumTrkId;		// Per module
+  Int_t fStatNumHitId;
+  Int_t fTotStatNumTrkId;
+  Int_t fTotStatNumHitId;
 
   virtual Int_t  ReadDatabase( const TDatime& date );
   virtual Int_t  DefineVariables( EMode mode = kDefine );
@@ -10,6 +10,8 @@
 #include "TClonesArray.h"
 #include "THcSignalHit.h"
 #include "THcGlobals.h"
+#include "THcCheckpoint.h"
+#include "THcMemoryReport.h"
 #include "THcParmList.h"
 #include "THcHitList.h"
 #include "THcShower.h"
@@ -19,6 +21,7 @@
 #include "THaTrack.h"
 #include "THaTrackProj.h"
 #include "THcHallCSpectrometer.h"
+#include "THcAnalyzer.h"
 
 #include <cstring>
 #include <cstdio>
@@ -42,6 +45,12 @@ THcShowerPlane::THcShowerPlane( const char* name,
   fPosADCHits = new TClonesArray("THcSignalHit",fNelem);
   fNegADCHits = new TClonesArray("THcSignalHit",fNelem);
 
+  fFillErrorFlags = kTRUE;
+  fFillRawArrays = kTRUE;
+  fFillADC = &THcShowerPlane::FillADC_Standard;
+  fRawHits = 0;
+  fFirstHit = fLastHit = 0;
+
   frPosAdcErrorFlag    = new TClonesArray("THcSignalHit", 16);
   frPosAdcPedRaw       = new TClonesArray("THcSignalHit", 16);
   frPosAdcThreshold    = new TClonesArray("THcSignalHit", 16);
@@ -78,6 +87,7 @@ THcShowerPlane::THcShowerPlane( const char* name,
 THcShowerPlane::~THcShowerPlane()
 {
   // Destructor
+  if(gHcCheckpoint) gHcCheckpoint->RemovePrefix(GetPrefix());
   delete fPosADCHits; fPosADCHits = NULL;
   delete fNegADCHits; fNegADCHits = NULL;
 
@@ -163,6 +173,40 @@ THaAnalysisObject::EStatus THcShowerPlane::Init( const TDatime& date )
   if( (status=THaSubDetector::Init( date )) )
     return fStatus = status;
 
+  // The ADC error flag arrays are only used by global variables
+  fFillErrorFlags =
+    THcAnalyzer::IsOutputRequested(Form("%sposAdcErrorFlag",GetPrefix()))
+    || THcAnalyzer::IsOutputRequested(Form("%snegAdcErrorFlag",GetPrefix()));
+  // The other signal hit arrays too (the counters are from PulseIntRaw)
+  fFillRawArrays = fDebugAdc
+    || THcAnalyzer::IsOutputRequested(Form("%sposAdcCounter",GetPrefix()))
+    || THcAnalyzer::IsOutputRequested(Form("%snegAdcCounter",GetPrefix()));
+
+  // Choose the ADC mode once, and copy the constants of the blocks
+  THcShower* parent = static_cast<THcShower*>(fParent);
+  Int_t ADCMode = parent->GetADCMode();
+  if(ADCMode == kADCDynamicPedestal) {
+    fFillADC = &THcShowerPlane::FillADC_DynamicPedestal;
+  } else if (ADCMode == kADCSampleIntegral) {
+    fFillADC = &THcShowerPlane::FillADC_SampleIntegral;
+  } else if (ADCMode == kADCSampIntDynPed) {
+    fFillADC = &THcShowerPlane::FillADC_SampIntDynPed;
+  } else {
+    fFillADC = &THcShowerPlane::FillADC_Standard;
+  }
+  fBlockGain.resize(2*fNelem);
+  fBlockWindowMin.resize(2*fNelem);
+  fBlockWindowMax.resize(2*fNelem);
+  fBlockPedDefault.resize(2*fNelem);
+  for(Int_t side=0;side<2;side++) {
+    for(Int_t i=0;i<fNelem;i++) {
+      fBlockGain[side*fNelem+i] = parent->GetGain(i,fLayerNum-1,side);
+      fBlockWindowMin[side*fNelem+i] = parent->GetWindowMin(i,fLayerNum-1,side);
+      fBlockWindowMax[side*fNelem+i] = parent->GetWindowMax(i,fLayerNum-1,side);
+      fBlockPedDefault[side*fNelem+i] = (Int_t)parent->GetPedDefault(i,fLayerNum-1,side);
+    }
+  }
+
   return fStatus = kOK;
 
 }
@@ -282,11 +326,28 @@ Int_t THcShowerPlane::ReadDatabase( const TDatime& date )
 
   // Numbers of tracks and hits , for efficiency calculations.
   
-  fStatNumTrk = vector<Int_t> (fNelem, 0);
-  fStatNumHit = vector<Int_t> (fNelem, 0);
-  fTotStatNumTrk = 0;
-  fTotStatNumHit = 0;
-  
+  fStats.Clear();
+  fStatNumTrkId = fStats.DefineCounter("", "Tracks per module", fNelem);
+  fStatNumHitId = fStats.DefineCounter("", "Hits per module", fNelem);
+  fTotStatNumTrkId = fStats.DefineCounter("", "Number of tracks");
+  fTotStatNumHitId = fStats.DefineCounter("", "Number of hits");
+
+  // Register counters for efficiency calculations in gHcParms so that the
+  // variables can be used in end of run reports.  Here, not in
+  // DefineVariables, since Clear removed them and DefineVariables does
+  // nothing on the Init of the following runs.
+
+  fStats.Publish(fTotStatNumTrkId,
+		 Form("%sstat_trksum%d", fParent->GetPrefix(), fLayerNum),
+		 Form("Number of tracks in calo. layer %d",fLayerNum));
+  fStats.Publish(fTotStatNumHitId,
+		 Form("%sstat_hitsum%d", fParent->GetPrefix(), fLayerNum),
+		 Form("Number of hits in calo. layer %d", fLayerNum));
+
+  cout << "THcShowerPlane::ReadDatabase: registered counters "
+       << Form("%sstat_trksum%d",fParent->GetPrefix(),fLayerNum) << " and "
+       << Form("%sstat_hitsum%d",fParent->GetPrefix(),fLayerNum) << endl;
+
   // Debug output.
 
   if (parent->fdbg_init_cal) {
@@ -350,18 +411,6 @@ Int_t THcShowerPlane::DefineVariables( EMode mode )
     DefineVarsFromList( vars, mode);
   } //end debug statement
 
-  // Register counters for efficiency calculations in gHcParms so that the
-  // variables can be used in end of run reports.
-
-  gHcParms->Define(Form("%sstat_trksum%d", fParent->GetPrefix(), fLayerNum),
-	  Form("Number of tracks in calo. layer %d",fLayerNum), fTotStatNumTrk);
-  gHcParms->Define(Form("%sstat_hitsum%d", fParent->GetPrefix(), fLayerNum),
-	 Form("Number of hits in calo. layer %d", fLayerNum), fTotStatNumHit);
-
-  cout << "THcShowerPlane::DefineVariables: registered counters "
-       << Form("%sstat_trksum%d",fParent->GetPrefix(),fLayerNum) << " and "
-       << Form("%sstat_hitsum%d",fParent->GetPrefix(),fLayerNum) << endl;
-  //  getchar();
     
   RVarDef vars[] = {
     {"posAdcErrorFlag",    "List of positive raw ADC Error Flags",  "frPosAdcErrorFlag.THcSignalHit.GetData()"},
@@ -440,6 +489,8 @@ void THcShowerPlane::Clear( Option_t* )
   frNegAdcPulseAmp->Clear();
   frNegAdcPulseTime->Clear();
 
+  fFirstHit = fLastHit = 0;	// No raw hits until ProcessHits
+
   for (UInt_t ielem = 0; ielem < fGoodPosAdcPed.size(); ielem++) {
     fGoodPosAdcPed.at(ielem)              = 0.0;
     fGoodPosAdcPulseIntRaw.at(ielem)      = 0.0;
@@ -574,12 +625,14 @@ Int_t THcShowerPlane::ProcessHits(TClonesArray* rawhits, Int_t nexthit)
   UInt_t nrPosAdcHits = 0;
   UInt_t nrNegAdcHits = 0;
 
-  // Process raw hits. Get ADC hits for the plane, assign variables for each
-  // channel.
+  // Find the raw hits of this layer for CoarseProcessHits.  The signal
+  // hit arrays are only filled for global variables.
 
   Int_t nrawhits = rawhits->GetLast()+1;
 
   Int_t ihit = nexthit;
+  fRawHits = rawhits;
+  fFirstHit = nexthit;
 
   while(ihit < nrawhits) {
     THcRawShowerHit* hit = (THcRawShowerHit *) rawhits->At(ihit);
@@ -593,101 +646,92 @@ Int_t THcShowerPlane::ProcessHits(TClonesArray* rawhits, Int_t nexthit)
     Int_t padnum = hit->fCounter;
 
     THcRawAdcHit& rawPosAdcHit = hit->GetRawAdcHitPos();
-    for (UInt_t thit=0; thit<rawPosAdcHit.GetNPulses(); ++thit) {
-      ((THcSignalHit*) frPosAdcPedRaw->ConstructedAt(nrPosAdcHits))->Set(padnum, rawPosAdcHit.GetPedRaw());
-      ((THcSignalHit*) frPosAdcThreshold->ConstructedAt(nrPosAdcHits))->Set(padnum,rawPosAdcHit.GetPedRaw()*rawPosAdcHit.GetF250_PeakPedestalRatio()+fAdcPosThreshold);
-      ((THcSignalHit*) frPosAdcPed->ConstructedAt(nrPosAdcHits))->Set(padnum, rawPosAdcHit.GetPed());
-
-      ((THcSignalHit*) frPosAdcPulseIntRaw->ConstructedAt(nrPosAdcHits))->Set(padnum, rawPosAdcHit.GetPulseIntRaw(thit));
-      ((THcSignalHit*) frPosAdcPulseInt->ConstructedAt(nrPosAdcHits))->Set(padnum, rawPosAdcHit.GetPulseInt(thit));
-
-      ((THcSignalHit*) frPosAdcPulseAmpRaw->ConstructedAt(nrPosAdcHits))->Set(padnum, rawPosAdcHit.GetPulseAmpRaw(thit));
-      ((THcSignalHit*) frPosAdcPulseAmp->ConstructedAt(nrPosAdcHits))->Set(padnum, rawPosAdcHit.GetPulseAmp(thit));
-
-      ((THcSignalHit*) frPosAdcPulseTimeRaw->ConstructedAt(nrPosAdcHits))->Set(padnum, rawPosAdcHit.GetPulseTimeRaw(thit));
-      ((THcSignalHit*) frPosAdcPulseTime->ConstructedAt(nrPosAdcHits))->Set(padnum, rawPosAdcHit.GetPulseTime(thit)+fAdcTdcOffset);
-
-      if (rawPosAdcHit.GetPulseAmp(thit)>0&&rawPosAdcHit.GetPulseIntRaw(thit)>0) {
-	((THcSignalHit*) frPosAdcErrorFlag->ConstructedAt(nrPosAdcHits))->Set(padnum,0);
-      } else {
-	((THcSignalHit*) frPosAdcErrorFlag->ConstructedAt(nrPosAdcHits))->Set(padnum,1);
-      }
-     if (rawPosAdcHit.GetPulseAmpRaw(thit) <= 0) {
-	Double_t PeakPedRatio= rawPosAdcHit.GetF250_PeakPedestalRatio();
-	Int_t NPedSamples= rawPosAdcHit.GetF250_NPedestalSamples();
-	Double_t AdcToC =  rawPosAdcHit.GetAdcTopC();
-	Double_t AdcToV =  rawPosAdcHit.GetAdcTomV();
-	Int_t PedDefaultTemp = static_cast<THcShower*>(fParent)->GetPedDefault(padnum-1,fLayerNum-1,0);
-	if (PedDefaultTemp !=0) {
-	  Double_t tPulseInt = AdcToC*(rawPosAdcHit.GetPulseIntRaw(thit) - PedDefaultTemp*PeakPedRatio);
-	  ((THcSignalHit*) frPosAdcPulseInt->ConstructedAt(nrPosAdcHits))->Set(padnum, tPulseInt);
-          ((THcSignalHit*) frPosAdcPedRaw->ConstructedAt(nrPosAdcHits))->Set(padnum, PedDefaultTemp);
-          ((THcSignalHit*) frPosAdcPed->ConstructedAt(nrPosAdcHits))->Set(padnum, float(PedDefaultTemp)/float(NPedSamples)*AdcToV);
-	  
-	}
-	((THcSignalHit*) frPosAdcPulseAmp->ConstructedAt(nrPosAdcHits))->Set(padnum, 0.);	
-      }
-      ++nrPosAdcHits;
-      fTotNumAdcHits++;
-      fTotNumPosAdcHits++;
-
+    UInt_t nposPulses = rawPosAdcHit.GetNPulses();
+    if (nposPulses > 0 && (fFillRawArrays || fFillErrorFlags)) {
+      FillRawArrays(rawPosAdcHit, padnum, 0, nrPosAdcHits);
     }
-    THcRawAdcHit& rawNegAdcHit = hit->GetRawAdcHitNeg();
-    for (UInt_t thit=0; thit<rawNegAdcHit.GetNPulses(); ++thit) {
-      ((THcSignalHit*) frNegAdcPedRaw->ConstructedAt(nrNegAdcHits))->Set(padnum, rawNegAdcHit.GetPedRaw());
-      ((THcSignalHit*) frNegAdcThreshold->ConstructedAt(nrNegAdcHits))->Set(padnum,rawNegAdcHit.GetPedRaw()*rawNegAdcHit.GetF250_PeakPedestalRatio()+fAdcNegThreshold);
-      ((THcSignalHit*) frNegAdcPed->ConstructedAt(nrNegAdcHits))->Set(padnum, rawNegAdcHit.GetPed());
-
-      ((THcSignalHit*) frNegAdcPulseIntRaw->ConstructedAt(nrNegAdcHits))->Set(padnum, rawNegAdcHit.GetPulseIntRaw(thit));
-      ((THcSignalHit*) frNegAdcPulseInt->ConstructedAt(nrNegAdcHits))->Set(padnum, rawNegAdcHit.GetPulseInt(thit));
+    nrPosAdcHits += nposPulses;
+    fTotNumAdcHits += nposPulses;
+    fTotNumPosAdcHits += nposPulses;
 
-      ((THcSignalHit*) frNegAdcPulseAmpRaw->ConstructedAt(nrNegAdcHits))->Set(padnum, rawNegAdcHit.GetPulseAmpRaw(thit));
-      ((THcSignalHit*) frNegAdcPulseAmp->ConstructedAt(nrNegAdcHits))->Set(padnum, rawNegAdcHit.GetPulseAmp(thit));
-
-      ((THcSignalHit*) frNegAdcPulseTimeRaw->ConstructedAt(nrNegAdcHits))->Set(padnum, rawNegAdcHit.GetPulseTimeRaw(thit));
-      ((THcSignalHit*) frNegAdcPulseTime->ConstructedAt(nrNegAdcHits))->Set(padnum, rawNegAdcHit.GetPulseTime(thit)+fAdcTdcOffset);
+    THcRawAdcHit& rawNegAdcHit = hit->GetRawAdcHitNeg();
+    UInt_t nnegPulses = rawNegAdcHit.GetNPulses();
+    if (nnegPulses > 0 && (fFillRawArrays || fFillErrorFlags)) {
+      FillRawArrays(rawNegAdcHit, padnum, 1, nrNegAdcHits);
+    }
+    nrNegAdcHits += nnegPulses;
+    fTotNumAdcHits += nnegPulses;
+    fTotNumNegAdcHits += nnegPulses;
+    ihit++;
+  }
+  fLastHit = ihit;
+  return(ihit);
+}
 
-      if (rawNegAdcHit.GetPulseAmp(thit)>0&&rawNegAdcHit.GetPulseIntRaw(thit)>0) {
-	((THcSignalHit*) frNegAdcErrorFlag->ConstructedAt(nrNegAdcHits))->Set(padnum,0);
+//_____________________________________________________________________________
+void THcShowerPlane::FillRawArrays( THcRawAdcHit& raw, Int_t padnum,
+				    Int_t side, Int_t ifirst )
+{
+  // Signal hit arrays of one side of one block, starting at index
+  // ifirst.  The pulse integrals and pedestals without a pulse amplitude
+  // are corrected as in SelectPulseDynPed.
+  TClonesArray* errorFlag    = (side == 0) ? frPosAdcErrorFlag : frNegAdcErrorFlag;
+  TClonesArray* pedRaw       = (side == 0) ? frPosAdcPedRaw : frNegAdcPedRaw;
+  TClonesArray* threshold    = (side == 0) ? frPosAdcThreshold : frNegAdcThreshold;
+  TClonesArray* pulseIntRaw  = (side == 0) ? frPosAdcPulseIntRaw : frNegAdcPulseIntRaw;
+  TClonesArray* pulseAmpRaw  = (side == 0) ? frPosAdcPulseAmpRaw : frNegAdcPulseAmpRaw;
+  TClonesArray* pulseTimeRaw = (side == 0) ? frPosAdcPulseTimeRaw : frNegAdcPulseTimeRaw;
+  TClonesArray* ped          = (side == 0) ? frPosAdcPed : frNegAdcPed;
+  TClonesArray* pulseInt     = (side == 0) ? frPosAdcPulseInt : frNegAdcPulseInt;
+  TClonesArray* pulseAmp     = (side == 0) ? frPosAdcPulseAmp : frNegAdcPulseAmp;
+  TClonesArray* pulseTime    = (side == 0) ? frPosAdcPulseTime : frNegAdcPulseTime;
+  Double_t adcThreshold      = (side == 0) ? fAdcPosThreshold : fAdcNegThreshold;
+
+  for (UInt_t thit=0; thit<raw.GetNPulses(); ++thit) {
+    Int_t i = ifirst+thit;
+    if (fFillErrorFlags) {
+      if (raw.GetPulseAmp(thit)>0&&raw.GetPulseIntRaw(thit)>0) {
+	((THcSignalHit*) errorFlag->ConstructedAt(i))->Set(padnum,0);
       } else {
-	((THcSignalHit*) frNegAdcErrorFlag->ConstructedAt(nrNegAdcHits))->Set(padnum,1);
+	((THcSignalHit*) errorFlag->ConstructedAt(i))->Set(padnum,1);
       }
-     if (rawNegAdcHit.GetPulseAmpRaw(thit) <= 0) {
-	Double_t PeakPedRatio= rawNegAdcHit.GetF250_PeakPedestalRatio();
-	Int_t NPedSamples= rawNegAdcHit.GetF250_NPedestalSamples();
-	Double_t AdcToC =  rawNegAdcHit.GetAdcTopC();
-	Double_t AdcToV =  rawNegAdcHit.GetAdcTomV();
-	Int_t PedDefaultTemp = static_cast<THcShower*>(fParent)->GetPedDefault(padnum-1,fLayerNum-1,1);
-	if (PedDefaultTemp !=0) {
-	  Double_t tPulseInt = AdcToC*(rawNegAdcHit.GetPulseIntRaw(thit) - PedDefaultTemp*PeakPedRatio);
-	  ((THcSignalHit*) frNegAdcPulseInt->ConstructedAt(nrNegAdcHits))->Set(padnum, tPulseInt);
-          ((THcSignalHit*) frNegAdcPedRaw->ConstructedAt(nrNegAdcHits))->Set(padnum, PedDefaultTemp);
-          ((THcSignalHit*) frNegAdcPed->ConstructedAt(nrNegAdcHits))->Set(padnum, float(PedDefaultTemp)/float(NPedSamples)*AdcToV);
-	  
-	}
-	((THcSignalHit*) frNegAdcPulseAmp->ConstructedAt(nrNegAdcHits))->Set(padnum, 0.);	
+    }
+    if (!fFillRawArrays) continue;
+
+    ((THcSignalHit*) pedRaw->ConstructedAt(i))->Set(padnum, raw.GetPedRaw());
+    ((THcSignalHit*) threshold->ConstructedAt(i))->Set(padnum,raw.GetPedRaw()*raw.GetF250_PeakPedestalRatio()+adcThreshold);
+    ((THcSignalHit*) ped->ConstructedAt(i))->Set(padnum, raw.GetPed());
+
+    ((THcSignalHit*) pulseIntRaw->ConstructedAt(i))->Set(padnum, raw.GetPulseIntRaw(thit));
+    ((THcSignalHit*) pulseInt->ConstructedAt(i))->Set(padnum, raw.GetPulseInt(thit));
+
+    ((THcSignalHit*) pulseAmpRaw->ConstructedAt(i))->Set(padnum, raw.GetPulseAmpRaw(thit));
+    ((THcSignalHit*) pulseAmp->ConstructedAt(i))->Set(padnum, raw.GetPulseAmp(thit));
+
+    ((THcSignalHit*) pulseTimeRaw->ConstructedAt(i))->Set(padnum, raw.GetPulseTimeRaw(thit));
+    ((THcSignalHit*) pulseTime->ConstructedAt(i))->Set(padnum, raw.GetPulseTime(thit)+fAdcTdcOffset);
+
+    if (raw.GetPulseAmpRaw(thit) <= 0) {
+      Double_t PeakPedRatio= raw.GetF250_PeakPedestalRatio();
+      Int_t NPedSamples= raw.GetF250_NPedestalSamples();
+      Double_t AdcToC =  raw.GetAdcTopC();
+      Double_t AdcToV =  raw.GetAdcTomV();
+      Int_t PedDefaultTemp = fBlockPedDefault[side*fNelem+padnum-1];
+      if (PedDefaultTemp !=0) {
+	Double_t tPulseInt = AdcToC*(raw.GetPulseIntRaw(thit) - PedDefaultTemp*PeakPedRatio);
+	((THcSignalHit*) pulseInt->ConstructedAt(i))->Set(padnum, tPulseInt);
+	((THcSignalHit*) pedRaw->ConstructedAt(i))->Set(padnum, PedDefaultTemp);
+	((THcSignalHit*) ped->ConstructedAt(i))->Set(padnum, float(PedDefaultTemp)/float(NPedSamples)*AdcToV);
       }
-      ++nrNegAdcHits;
-      fTotNumAdcHits++;
-      fTotNumNegAdcHits++;
+      ((THcSignalHit*) pulseAmp->ConstructedAt(i))->Set(padnum, 0.);
     }
-    ihit++;
   }
-  return(ihit);
 }
 //_____________________________________________________________________________
 Int_t THcShowerPlane::CoarseProcessHits()
 {
-    Int_t ADCMode=static_cast<THcShower*>(fParent)->GetADCMode();
-    if(ADCMode == kADCDynamicPedestal) {
-      FillADC_DynamicPedestal();
-    } else if (ADCMode == kADCSampleIntegral) {
-      FillADC_SampleIntegral();
-    } else if (ADCMode == kADCSampIntDynPed) {
-      FillADC_SampIntDynPed();
-    } else {
-      FillADC_Standard();
-    }
+    // One pass over the raw hits of the layer, see Init for the mode
+    (this->*fFillADC)();
     //
   if (static_cast<THcShower*>(fParent)->fdbg_decoded_cal) {
 
@@ -745,107 +789,117 @@ void THcShowerPlane::FillADC_SampleIntegral()
 //_____________________________________________________________________________
 void THcShowerPlane::FillADC_Standard()
 {
-  for (Int_t ielem=0;ielem<frNegAdcPulseIntRaw->GetEntries();ielem++) {
-    Int_t npad = ((THcSignalHit*) frNegAdcPulseIntRaw->ConstructedAt(ielem))->GetPaddleNumber() - 1;
-    Double_t pulseIntRaw = ((THcSignalHit*) frNegAdcPulseIntRaw->ConstructedAt(ielem))->GetData();
-    fGoodNegAdcPulseIntRaw.at(npad) = pulseIntRaw;
-      if(fGoodNegAdcPulseIntRaw.at(npad) >  fNegThresh[npad]) {
-	fGoodNegAdcPulseInt.at(npad) = pulseIntRaw-fNegPed[npad];
-	fEneg.at(npad) = fGoodNegAdcPulseInt.at(npad)*static_cast<THcShower*>(fParent)->GetGain(npad,fLayerNum-1,1);
-	fEmean.at(npad) += fEneg.at(npad);
-	fEplane_neg += fEneg.at(npad);
-      }
+  // Pulse integrals above the pedestal thresholds of the pedestal
+  // events.  The negative side of each block comes first, so the sums
+  // are the same as with the sides done one after the other.
+  for (Int_t ihit=fFirstHit;ihit<fLastHit;ihit++) {
+    THcRawShowerHit* hit = (THcRawShowerHit*) fRawHits->At(ihit);
+    Int_t npad = hit->fCounter - 1;
+    if (npad < 0 || npad >= fNelem) continue;
+    SelectPulseStandard(hit->GetRawAdcHitNeg(), npad, 1);
+    SelectPulseStandard(hit->GetRawAdcHitPos(), npad, 0);
   }
-  for (Int_t ielem=0;ielem<frPosAdcPulseIntRaw->GetEntries();ielem++) {
-    Int_t npad = ((THcSignalHit*) frPosAdcPulseIntRaw->ConstructedAt(ielem))->GetPaddleNumber() - 1;
-    Double_t pulseIntRaw = ((THcSignalHit*) frPosAdcPulseIntRaw->ConstructedAt(ielem))->GetData();
-    fGoodPosAdcPulseIntRaw.at(npad) =pulseIntRaw;
-    if(fGoodPosAdcPulseIntRaw.at(npad) > fPosThresh[npad]) {
-      fGoodPosAdcPulseInt.at(npad) =pulseIntRaw-fPosPed[npad] ;
-      fEpos.at(npad) =fGoodPosAdcPulseInt.at(npad)*static_cast<THcShower*>(fParent)->GetGain(npad,fLayerNum-1,0);
-      fEmean.at(npad) += fEpos.at(npad);
-      fEplane_pos += fEpos.at(npad);
+  fEplane= fEplane_neg+fEplane_pos;
+}
+//_____________________________________________________________________________
+void THcShowerPlane::SelectPulseStandard( THcRawAdcHit& raw, Int_t npad, Int_t side )
+{
+  vector<Double_t>& goodPulseIntRaw = (side == 0) ? fGoodPosAdcPulseIntRaw : fGoodNegAdcPulseIntRaw;
+  vector<Double_t>& goodPulseInt    = (side == 0) ? fGoodPosAdcPulseInt : fGoodNegAdcPulseInt;
+  vector<Double_t>& e               = (side == 0) ? fEpos : fEneg;
+  Double_t& eplane                  = (side == 0) ? fEplane_pos : fEplane_neg;
+  Float_t thresh = (side == 0) ? fPosThresh[npad] : fNegThresh[npad];
+  Float_t ped    = (side == 0) ? fPosPed[npad] : fNegPed[npad];
+  Double_t gain  = fBlockGain[side*fNelem+npad];
+
+  for (UInt_t thit=0; thit<raw.GetNPulses(); ++thit) {
+    Double_t pulseIntRaw = raw.GetPulseIntRaw(thit);
+    goodPulseIntRaw[npad] = pulseIntRaw;
+    if(pulseIntRaw > thresh) {
+      goodPulseInt[npad] = pulseIntRaw-ped;
+      e[npad] = goodPulseInt[npad]*gain;
+      fEmean[npad] += e[npad];
+      eplane += e[npad];
     }
   }
-  fEplane= fEplane_neg+fEplane_pos;
 }
 //_____________________________________________________________________________
 void THcShowerPlane::FillADC_DynamicPedestal()
 {
+  // The first pulse of each block and side in the time window and above
+  // threshold.  Negative side first, as in FillADC_Standard.
   Double_t StartTime = 0.0;
   if( fglHod ) StartTime = fglHod->GetStartTime();
-   Double_t OffsetTime = 0.0;
-   if( fglHod ) OffsetTime = fglHod->GetOffsetTime();
-  for (Int_t ielem=0;ielem<frNegAdcPulseInt->GetEntries();ielem++) {
-   Int_t    npad         = ((THcSignalHit*) frNegAdcPulseInt->ConstructedAt(ielem))->GetPaddleNumber() - 1;
-   Double_t pulseInt     = ((THcSignalHit*) frNegAdcPulseInt->ConstructedAt(ielem))->GetData();
-    Double_t pulsePed     = ((THcSignalHit*) frNegAdcPed->ConstructedAt(ielem))->GetData();
-    Double_t pulseAmp     = ((THcSignalHit*) frNegAdcPulseAmp->ConstructedAt(ielem))->GetData();
-    Double_t pulseIntRaw  = ((THcSignalHit*) frNegAdcPulseIntRaw->ConstructedAt(ielem))->GetData();
-    Double_t pulseTime    = ((THcSignalHit*) frNegAdcPulseTime->ConstructedAt(ielem))->GetData();
-    Double_t adctdcdiffTime = StartTime-pulseTime+OffsetTime;
-    Double_t threshold    = ((THcSignalHit*) frNegAdcThreshold->ConstructedAt(ielem))->GetData();
-    Bool_t   pulseTimeCut = (adctdcdiffTime > static_cast<THcShower*>(fParent)->GetWindowMin(npad,fLayerNum-1,1)) && (adctdcdiffTime < static_cast<THcShower*>(fParent)->GetWindowMax(npad,fLayerNum-1,1) );
-	fGoodNegAdcMult.at(npad) += 1;
-    if (pulseTimeCut) {
-      fGoodNegAdcPulseIntRaw.at(npad) =pulseIntRaw;
-
-      if(fGoodNegAdcPulseIntRaw.at(npad) >  threshold && fGoodNegAdcPulseInt.at(npad)==0) {
-        fGoodNegAdcPulseInt.at(npad) =pulseInt ;
-	fEneg.at(npad) =  fGoodNegAdcPulseInt.at(npad)*static_cast<THcShower*>(fParent)->GetGain(npad,fLayerNum-1,1);
-	fEmean.at(npad) += fEneg.at(npad);
-	fEplane_neg += fEneg.at(npad);
-
-	fGoodNegAdcPed.at(npad) = pulsePed;
-      fGoodNegAdcPulseAmp.at(npad) = pulseAmp;
-      fGoodNegAdcPulseTime.at(npad) = pulseTime;
-      fGoodNegAdcTdcDiffTime.at(npad) = adctdcdiffTime;
-
-      fTotNumGoodAdcHits++;
-      fTotNumGoodNegAdcHits++;
-      fNumGoodNegAdcHits.at(npad) = npad + 1;
-
+  Double_t OffsetTime = 0.0;
+  if( fglHod ) OffsetTime = fglHod->GetOffsetTime();
+  for (Int_t ihit=fFirstHit;ihit<fLastHit;ihit++) {
+    THcRawShowerHit* hit = (THcRawShowerHit*) fRawHits->At(ihit);
+    Int_t npad = hit->fCounter - 1;
+    if (npad < 0 || npad >= fNelem) continue;
+    SelectPulseDynPed(hit->GetRawAdcHitNeg(), npad, 1, StartTime, OffsetTime);
+    SelectPulseDynPed(hit->GetRawAdcHitPos(), npad, 0, StartTime, OffsetTime);
+  }
+  fEplane= fEplane_neg+fEplane_pos;
+}
+//_____________________________________________________________________________
+void THcShowerPlane::SelectPulseDynPed( THcRawAdcHit& raw, Int_t npad, Int_t side,
+					Double_t StartTime, Double_t OffsetTime )
+{
+  // Pulses without an amplitude (pedestal not measured) get the pulse
+  // integral and pedestal from the default pedestal of the block.
+  vector<Double_t>& goodPulseIntRaw = (side == 0) ? fGoodPosAdcPulseIntRaw : fGoodNegAdcPulseIntRaw;
+  vector<Double_t>& goodPulseInt    = (side == 0) ? fGoodPosAdcPulseInt : fGoodNegAdcPulseInt;
+  vector<Double_t>& goodPed         = (side == 0) ? fGoodPosAdcPed : fGoodNegAdcPed;
+  vector<Double_t>& goodPulseAmp    = (side == 0) ? fGoodPosAdcPulseAmp : fGoodNegAdcPulseAmp;
+  vector<Double_t>& goodPulseTime   = (side == 0) ? fGoodPosAdcPulseTime : fGoodNegAdcPulseTime;
+  vector<Double_t>& goodTdcDiffTime = (side == 0) ? fGoodPosAdcTdcDiffTime : fGoodNegAdcTdcDiffTime;
+  vector<Double_t>& goodMult        = (side == 0) ? fGoodPosAdcMult : fGoodNegAdcMult;
+  vector<Int_t>&    numGood         = (side == 0) ? fNumGoodPosAdcHits : fNumGoodNegAdcHits;
+  vector<Double_t>& e               = (side == 0) ? fEpos : fEneg;
+  Double_t& eplane                  = (side == 0) ? fEplane_pos : fEplane_neg;
+  Int_t& totNumGood                 = (side == 0) ? fTotNumGoodPosAdcHits : fTotNumGoodNegAdcHits;
+  Double_t adcThreshold             = (side == 0) ? fAdcPosThreshold : fAdcNegThreshold;
+  Int_t ib = side*fNelem+npad;
+
+  for (UInt_t thit=0; thit<raw.GetNPulses(); ++thit) {
+    Double_t pulseInt  = raw.GetPulseInt(thit);
+    Double_t pulsePed  = raw.GetPed();
+    Double_t pulseAmp  = raw.GetPulseAmp(thit);
+    Double_t threshold = raw.GetPedRaw()*raw.GetF250_PeakPedestalRatio()+adcThreshold;
+    if (raw.GetPulseAmpRaw(thit) <= 0) {
+      Int_t PedDefaultTemp = fBlockPedDefault[ib];
+      if (PedDefaultTemp != 0) {
+	Double_t PeakPedRatio = raw.GetF250_PeakPedestalRatio();
+	Int_t NPedSamples = raw.GetF250_NPedestalSamples();
+	pulseInt = raw.GetAdcTopC()*(raw.GetPulseIntRaw(thit) - PedDefaultTemp*PeakPedRatio);
+	pulsePed = float(PedDefaultTemp)/float(NPedSamples)*raw.GetAdcTomV();
       }
-
+      pulseAmp = 0.;
     }
-  }
-  //
-  for (Int_t ielem=0;ielem<frPosAdcPulseInt->GetEntries();ielem++) {
-   Int_t    npad         = ((THcSignalHit*) frPosAdcPulseInt->ConstructedAt(ielem))->GetPaddleNumber() - 1;
-      Double_t pulsePed     = ((THcSignalHit*) frPosAdcPed->ConstructedAt(ielem))->GetData();
-    Double_t threshold    = ((THcSignalHit*) frPosAdcThreshold->ConstructedAt(ielem))->GetData();
-    Double_t pulseAmp     = ((THcSignalHit*) frPosAdcPulseAmp->ConstructedAt(ielem))->GetData();
-    Double_t pulseInt     = ((THcSignalHit*) frPosAdcPulseInt->ConstructedAt(ielem))->GetData();
-    Double_t pulseIntRaw  = ((THcSignalHit*) frPosAdcPulseIntRaw->ConstructedAt(ielem))->GetData();
-    Double_t pulseTime    = ((THcSignalHit*) frPosAdcPulseTime->ConstructedAt(ielem))->GetData();
-     Double_t adctdcdiffTime = StartTime-pulseTime+OffsetTime;
-   Bool_t   pulseTimeCut = (adctdcdiffTime > static_cast<THcShower*>(fParent)->GetWindowMin(npad,fLayerNum-1,0)) && (adctdcdiffTime < static_cast<THcShower*>(fParent)->GetWindowMax(npad,fLayerNum-1,0) );
-	fGoodPosAdcMult.at(npad) += 1;
-    if (pulseTimeCut) {
-      fGoodPosAdcPulseIntRaw.at(npad) = pulseIntRaw;
-
-      if(fGoodPosAdcPulseIntRaw.at(npad) >  threshold && fGoodPosAdcPulseInt.at(npad)==0) {
-
-       	fGoodPosAdcPulseInt.at(npad) =pulseInt ;
-	fEpos.at(npad) = fGoodPosAdcPulseInt.at(npad)*static_cast<THcShower*>(fParent)->GetGain(npad,fLayerNum-1,0);
-	fEmean.at(npad) += fEpos[npad];
-	fEplane_pos += fEpos.at(npad);
-
-	fGoodPosAdcPed.at(npad) = pulsePed;
-	fGoodPosAdcPulseAmp.at(npad) = pulseAmp;
-	fGoodPosAdcPulseTime.at(npad) = pulseTime;
-	fGoodPosAdcTdcDiffTime.at(npad) = adctdcdiffTime;
-
-	fTotNumGoodAdcHits++;
-	fTotNumGoodPosAdcHits++;
-	fNumGoodPosAdcHits.at(npad) = npad + 1;
+    Double_t pulseTime = raw.GetPulseTime(thit)+fAdcTdcOffset;
+    Double_t adctdcdiffTime = StartTime-pulseTime+OffsetTime;
+    Bool_t pulseTimeCut = (adctdcdiffTime > fBlockWindowMin[ib]) && (adctdcdiffTime < fBlockWindowMax[ib]);
+    goodMult[npad] += 1;
+    if (!pulseTimeCut) continue;
+
+    Double_t pulseIntRaw = raw.GetPulseIntRaw(thit);
+    goodPulseIntRaw[npad] = pulseIntRaw;
+    if (pulseIntRaw > threshold && goodPulseInt[npad]==0) {
+      goodPulseInt[npad] = pulseInt;
+      e[npad] = goodPulseInt[npad]*fBlockGain[ib];
+      fEmean[npad] += e[npad];
+      eplane += e[npad];
+
+      goodPed[npad] = pulsePed;
+      goodPulseAmp[npad] = pulseAmp;
+      goodPulseTime[npad] = pulseTime;
+      goodTdcDiffTime[npad] = adctdcdiffTime;
 
-      }
+      fTotNumGoodAdcHits++;
+      totNumGood++;
+      numGood[npad] = npad + 1;
     }
   }
-  //
-    fEplane= fEplane_neg+fEplane_pos;
-
 }
 //_____________________________________________________________________________
 Int_t THcShowerPlane::AccumulatePedestals(TClonesArray* rawhits, Int_t nexthit)
@@ -994,6 +1048,24 @@ void THcShowerPlane::InitializePedestals( )
     fNegPedSum2[i] = 0;
     fNegPedCount[i] = 0;
   }
+  if(gHcCheckpoint) {		// Accumulators to save for resuming
+    TString prefix = GetPrefix();
+    gHcCheckpoint->Define(prefix+"NPedestalEvents", &fNPedestalEvents);
+    gHcCheckpoint->Define(prefix+"PosPedSum", fPosPedSum, fNelem);
+    gHcCheckpoint->Define(prefix+"PosPedSum2", fPosPedSum2, fNelem);
+    gHcCheckpoint->Define(prefix+"PosPedLimit", fPosPedLimit, fNelem);
+    gHcCheckpoint->Define(prefix+"PosPedCount", fPosPedCount, fNelem);
+    gHcCheckpoint->Define(prefix+"NegPedSum", fNegPedSum, fNelem);
+    gHcCheckpoint->Define(prefix+"NegPedSum2", fNegPedSum2, fNelem);
+    gHcCheckpoint->Define(prefix+"NegPedLimit", fNegPedLimit, fNelem);
+    gHcCheckpoint->Define(prefix+"NegPedCount", fNegPedCount, fNelem);
+    gHcCheckpoint->Define(prefix+"PosSig", fPosSig, fNelem);
+    gHcCheckpoint->Define(prefix+"NegSig", fNegSig, fNelem);
+    gHcCheckpoint->Define(prefix+"PosPed", fPosPed, fNelem);
+    gHcCheckpoint->Define(prefix+"NegPed", fNegPed, fNelem);
+    gHcCheckpoint->Define(prefix+"PosThresh", fPosThresh, fNelem);
+    gHcCheckpoint->Define(prefix+"NegThresh", fNegThresh, fNelem);
+  }
 }
 
 //_____________________________________________________________________________
@@ -1035,12 +1107,12 @@ Int_t THcShowerPlane::AccumulateStat(TClonesArray& tracks )
 	YTrk > static_cast<THcShower*>(fParent)->GetYPos(fLayerNum-1,1) &&
 	YTrk < static_cast<THcShower*>(fParent)->GetYPos(fLayerNum-1,0) ) {
 
-      fStatNumTrk.at(i)++;
-      fTotStatNumTrk++;
+      fStats.Increment(fStatNumTrkId, i);
+      fStats.Increment(fTotStatNumTrkId);
       
       if (fGoodPosAdcPulseInt.at(i) > 0. || fGoodNegAdcPulseInt.at(i) > 0.) {
-	fStatNumHit.at(i)++;
-	fTotStatNumHit++;
+	fStats.Increment(fStatNumHitId, i);
+	fStats.Increment(fTotStatNumHitId);
       }
       
     }
@@ -1070,3 +1142,35 @@ Int_t THcShowerPlane::AccumulateStat(TClonesArray& tracks )
   
   return 1;
 }
+
+//_____________________________________________________________________________
+void THcShowerPlane::AccountMemory( THcMemoryReport& report ) const
+{
+  // Called by THcShower::AccountMemory.  The signal hit arrays grow
+  // with the largest event, the per block arrays are sized at Init.
+  const TClonesArray* signals[] = {
+    fPosADCHits, fNegADCHits,
+    frPosAdcErrorFlag, frPosAdcPedRaw, frPosAdcThreshold,
+    frPosAdcPulseIntRaw, frPosAdcPulseAmpRaw, frPosAdcPulseTimeRaw,
+    frPosAdcPed, frPosAdcPulseInt, frPosAdcPulseAmp, frPosAdcPulseTime,
+    frNegAdcErrorFlag, frNegAdcPedRaw, frNegAdcThreshold,
+    frNegAdcPulseIntRaw, frNegAdcPulseAmpRaw, frNegAdcPulseTimeRaw,
+    frNegAdcPed, frNegAdcPulseInt, frNegAdcPulseAmp, frNegAdcPulseTime
+  };
+  Long64_t bytes = 0;
+  for(UInt_t i=0;i<sizeof(signals)/sizeof(signals[0]);i++) {
+    bytes += THcMemoryReport::Bytes(signals[i]);
+  }
+  report.Add("layer signal hits", bytes, THcMemoryReport::kDynamic);
+  bytes = THcMemoryReport::Bytes(fNumGoodPosAdcHits) + THcMemoryReport::Bytes(fNumGoodNegAdcHits)
+    + THcMemoryReport::Bytes(fGoodPosAdcPed) + THcMemoryReport::Bytes(fGoodPosAdcPulseInt)
+    + THcMemoryReport::Bytes(fGoodPosAdcPulseAmp) + THcMemoryReport::Bytes(fGoodPosAdcPulseTime)
+    + THcMemoryReport::Bytes(fGoodPosAdcTdcDiffTime) + THcMemoryReport::Bytes(fGoodNegAdcPed)
+    + THcMemoryReport::Bytes(fGoodNegAdcPulseInt) + THcMemoryReport::Bytes(fGoodNegAdcPulseAmp)
+    + THcMemoryReport::Bytes(fGoodNegAdcPulseTime) + THcMemoryReport::Bytes(fGoodNegAdcTdcDiffTime)
+    + THcMemoryReport::Bytes(fGoodPosAdcPulseIntRaw) + THcMemoryReport::Bytes(fGoodNegAdcPulseIntRaw)
+    + THcMemoryReport::Bytes(fGoodPosAdcMult) + THcMemoryReport::Bytes(fGoodNegAdcMult)
+    + THcMemoryReport::Bytes(fEpos) + THcMemoryReport::Bytes(fEneg) + THcMemoryReport::Bytes(fEmean);
+  report.Add("layer good hits", bytes, THcMemoryReport::kStatic);
+  report.Add("layer", IsA()->Size(), THcMemoryReport::kStatic);
+}
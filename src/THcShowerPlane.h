@@ -14,6 +14,7 @@
 
 #include "THaSubDetector.h"
 #include "THcCherenkov.h"
+#include "THcRunStats.h"
 #include "TClonesArray.h"
 
 #include <iostream>
@@ -25,6 +26,8 @@ using namespace std;
 class THaEvData;
 class THaSignalHit;
 class THcHodoscope;
+class THcRawAdcHit;
+class THcMemoryReport;
 
 class THcShowerPlane : public THaSubDetector {
 
@@ -43,6 +46,7 @@ public:
   virtual Bool_t   IsPid()      { return kFALSE; }
 
   virtual Int_t ProcessHits(TClonesArray* rawhits, Int_t nexthit);
+  void          AccountMemory(THcMemoryReport& report) const;
   virtual Int_t CoarseProcessHits();
   virtual Int_t AccumulatePedestals(TClonesArray* rawhits, Int_t nexthit);
   virtual void  CalculatePedestals( );
@@ -129,6 +133,8 @@ protected:
   static const Int_t kADCSampIntDynPed=3;
 
   Int_t fDebugAdc;              // fADC debug flag
+  Bool_t fFillErrorFlags;       // Fill ADC error flag arrays (only if used)
+  Bool_t fFillRawArrays;        // Fill the other fr... signal hit arrays (only if used)
   Int_t fPedSampLow;		// Sample range for
   Int_t fPedSampHigh;		// dynamic pedestal
   Int_t fDataSampLow;		// Sample range for
@@ -234,15 +240,33 @@ protected:
   virtual void  FillADC_SampIntDynPed( );
   virtual void  FillADC_Standard( );
 
+  // CoarseProcessHits works on the raw hits of the layer directly, in
+  // one pass per event with the FillADC_... method of the ADC mode,
+  // chosen at Init.  The constants it needs are copied from the parent
+  // at Init, per block and side: [side*fNelem+block], side 0 positive.
+  void  FillRawArrays( THcRawAdcHit& raw, Int_t padnum, Int_t side, Int_t ifirst );
+  void  SelectPulseStandard( THcRawAdcHit& raw, Int_t npad, Int_t side );
+  void  SelectPulseDynPed( THcRawAdcHit& raw, Int_t npad, Int_t side,
+			   Double_t StartTime, Double_t OffsetTime );
+  void (THcShowerPlane::*fFillADC)();	// FillADC_... of the ADC mode
+  TClonesArray* fRawHits;	// Raw hit list given to ProcessHits
+  Int_t fFirstHit;		// Raw hits of this layer in it
+  Int_t fLastHit;		// (one past the last)
+  vector<Double_t> fBlockGain;
+  vector<Double_t> fBlockWindowMin;
+  vector<Double_t> fBlockWindowMax;
+  vector<Int_t>    fBlockPedDefault;
+
   //Quatitites for efficiency calculations.
 
   Double_t fStatCerMin;
   Double_t fStatSlop;
   Double_t fStatMaxChi2;
-  vector<Int_t> fStatNumTrk;
-  vector<Int_t> fStatNumHit;
-  Int_t fTotStatNumTrk;
-  Int_t fTotStatNumHit;
+  THcRunStats fStats;
+  Int_t fStatNumTrkId;		// Per module
+  Int_t fStatNumHitId;
+  Int_t fTotStatNumTrkId;
+  Int_t fTotStatNumHitId;
 
  THcHodoscope* fglHod;		// Hodoscope to get start time
   
@@ -42,6 +42,7 @@ the next event comes.
 #include "THaGlobals.h"
 #include "THcGlobals.h"
 #include "THcParmList.h"
+#include "THcMemoryReport.h"
 #include "THaCodaFile.h"
 #include "THaRunBase.h"
 #include <cstring>
@@ -600,4 +601,12 @@ Int_t THcTimeSyncEvtHandler::AllTdcsPresent(UInt_t *bank) {
   }
 }
   
+//_____________________________________________________________________________
+void THcTimeSyncEvtHandler::AccountMemory( THcMemoryReport& report ) const
+{
+  // The copies of the last event and of the slipping bank are members
+  report.Add("last event", sizeof(fLastEvent), THcMemoryReport::kInline);
+  report.Add("slipping bank", sizeof(fSlippingBank), THcMemoryReport::kInline);
+}
+
 ClassImp(THcTimeSyncEvtHandler)
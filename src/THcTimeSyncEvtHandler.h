@@ -8,6 +8,7 @@
 /////////////////////////////////////////////////////////////////////
 
 #include "THaEvtTypeHandler.h"
+#include "THcMemoryAccount.h"
 #include "Decoder.h"
 #include <string>
 #include <vector>
@@ -16,7 +17,7 @@
 //class THaRunBase;
 //class THaEvData;
 
-class THcTimeSyncEvtHandler : public THaEvtTypeHandler {
+class THcTimeSyncEvtHandler : public THaEvtTypeHandler, public THcMemoryAccount {
 
 public:
 
@@ -29,6 +30,7 @@ public:
   virtual void SetExpectedOffset(Int_t roc, Int_t offset);
   virtual void AddExpectedOffset(Int_t roc, Int_t offset);
   virtual Int_t End( THaRunBase* r=0 );
+  virtual void AccountMemory( THcMemoryReport& report ) const;
   virtual Int_t SetRewriteFile(const char *filename);
   virtual void SetBadROC(Int_t roc) {fBadROC = roc;}
   virtual void SetResync(Bool_t b) {fResync = b;}
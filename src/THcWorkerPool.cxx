@@ -0,0 +1,198 @@
+/** \class THcWorkerPool
+    \ingroup Base
+
+    \brief Persistent threads that split a task into slices.
+
+    The block and chunk loops (THcCodaSyncScanner::Scan,
+    THcHistBatch::Flush, THcColumnWriter::WriteChunk) run the same task
+    many times per run on a few threads.  Starting and joining new
+    threads for every block costs about as much as the work of a small
+    block, so the threads are started at the first Run and kept, waiting
+    on a condition variable, until the pool is deleted or the number of
+    threads changes.
+
+        pool.Run(&MyClass::FillSlice, this, nslices);
+
+    calls task(arg, islice, nslices) for islice = 0 ... nslices-1 and
+    returns when all slices are done.  The calling thread takes part.
+    With n threads, thread i does slices i, i+n, ..., so a given slice
+    is always done by the same thread when nslices does not change.  The
+    first exception of a slice is passed on by Run, after the other
+    slices are done.  Without C++11 the slices are done in order by the
+    calling thread.
+*/
+
+#include "THcWorkerPool.h"
+#if __cplusplus >= 201103L
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <vector>
+#endif
+
+using namespace std;
+
+#if __cplusplus >= 201103L
+struct THcWorkerPool::Sync {
+  mutex lock;
+  condition_variable start;	// New task or stop
+  condition_variable done;	// A worker finished its slices
+  vector<thread> workers;
+  UInt_t   generation;		// Of the current task
+  Bool_t   stop;
+  Task     task;
+  void*    arg;
+  Int_t    nslices;
+  Int_t    nthreads;		// Taking part in the current task
+  Int_t    npending;		// Workers not done with it
+  exception_ptr error;
+};
+#else
+struct THcWorkerPool::Sync {};
+#endif
+
+//_____________________________________________________________________________
+THcWorkerPool::THcWorkerPool( Int_t nthreads )
+  : fNThreads(nthreads), fSync(new Sync)
+{
+#if __cplusplus >= 201103L
+  fSync->generation = 0;
+  fSync->stop = kFALSE;
+  fSync->task = 0;
+  fSync->arg = 0;
+  fSync->nslices = 0;
+  fSync->nthreads = 0;
+  fSync->npending = 0;
+#endif
+}
+
+//_____________________________________________________________________________
+THcWorkerPool::~THcWorkerPool()
+{
+  Stop();
+  delete fSync;
+}
+
+//_____________________________________________________________________________
+void THcWorkerPool::SetNThreads( Int_t nthreads )
+{
+  // The workers are restarted by the next Run if their number changes
+  if(nthreads == fNThreads) return;
+  Stop();
+  fNThreads = nthreads;
+}
+
+//_____________________________________________________________________________
+Int_t THcWorkerPool::GetNThreads() const
+{
+  Int_t nthreads = fNThreads;
+#if __cplusplus >= 201103L
+  if(nthreads <= 0) nthreads = thread::hardware_concurrency();
+#else
+  nthreads = 1;
+#endif
+  return (nthreads > 0) ? nthreads : 1;
+}
+
+//_____________________________________________________________________________
+void THcWorkerPool::Start( Int_t nworkers )
+{
+#if __cplusplus >= 201103L
+  fSync->stop = kFALSE;
+  for(Int_t i=0;i<nworkers;i++) {
+    fSync->workers.push_back(thread(&THcWorkerPool::Work, this, i+1,
+				    fSync->generation));
+  }
+#endif
+}
+
+//_____________________________________________________________________________
+void THcWorkerPool::Stop()
+{
+#if __cplusplus >= 201103L
+  Sync& s = *fSync;
+  if(s.workers.empty()) return;
+  {
+    lock_guard<mutex> lock(s.lock);
+    s.stop = kTRUE;
+  }
+  s.start.notify_all();
+  for(UInt_t i=0;i<s.workers.size();i++) s.workers[i].join();
+  s.workers.clear();
+#endif
+}
+
+//_____________________________________________________________________________
+void THcWorkerPool::Work( Int_t iworker, UInt_t generation )
+{
+  // Body of worker iworker (1 ... n-1), started when generation was
+  // the last task.  Waits for a new task and does its slices of it, if
+  // it takes part.
+#if __cplusplus >= 201103L
+  Sync& s = *fSync;
+  UInt_t seen = generation;
+  unique_lock<mutex> lock(s.lock);
+  while(1) {
+    s.start.wait(lock, [&s,&seen]{ return s.stop || s.generation != seen; });
+    if(s.stop) break;
+    seen = s.generation;
+    if(iworker >= s.nthreads) continue;
+    Task task = s.task;
+    void* arg = s.arg;
+    Int_t nslices = s.nslices, nthreads = s.nthreads;
+    lock.unlock();
+    try {
+      for(Int_t i=iworker;i<nslices;i+=nthreads) task(arg, i, nslices);
+    } catch(...) {
+      lock_guard<mutex> elock(s.lock);
+      if(!s.error) s.error = current_exception();
+    }
+    lock.lock();
+    if(--s.npending == 0) s.done.notify_one();
+  }
+#endif
+}
+
+//_____________________________________________________________________________
+void THcWorkerPool::Run( Task task, void* arg, Int_t nslices )
+{
+  // Do the nslices slices of task and wait for them
+  if(nslices <= 0) return;
+  Int_t nthreads = GetNThreads();
+  if(nthreads > nslices) nthreads = nslices;
+#if __cplusplus >= 201103L
+  if(nthreads > 1) {
+    Sync& s = *fSync;
+    if(s.workers.empty()) Start(GetNThreads()-1);
+    {
+      lock_guard<mutex> lock(s.lock);
+      s.task = task;
+      s.arg = arg;
+      s.nslices = nslices;
+      s.nthreads = nthreads;
+      s.npending = nthreads-1;
+      s.error = exception_ptr();
+      s.generation++;
+    }
+    s.start.notify_all();
+    exception_ptr error;
+    try {
+      for(Int_t i=0;i<nslices;i+=nthreads) task(arg, i, nslices);
+    } catch(...) {
+      error = current_exception();
+    }
+    {
+      unique_lock<mutex> lock(s.lock);
+      s.done.wait(lock, [&s]{ return s.npending == 0; });
+      if(!error) error = s.error;
+      s.error = exception_ptr();
+    }
+    if(error) rethrow_exception(error);
+    return;
+  }
+#endif
+  for(Int_t i=0;i<nslices;i++) task(arg, i, nslices);
+}
+
+ClassImp(THcWorkerPool)
@@ -0,0 +1,45 @@
+#ifndef ROOT_THcWorkerPool
+#define ROOT_THcWorkerPool
+
+//////////////////////////////////////////////////////////////////////////
+//
+// THcWorkerPool
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "Rtypes.h"
+
+class THcWorkerPool {
+
+public:
+
+  // Work on slice islice of nslices
+  typedef void (*Task)( void* arg, Int_t islice, Int_t nslices );
+
+  THcWorkerPool( Int_t nthreads=0 );
+  virtual ~THcWorkerPool();
+
+  void   SetNThreads( Int_t nthreads );
+  Int_t  GetNThreads() const;	// Including the calling thread
+
+  void   Run( Task task, void* arg, Int_t nslices );
+
+protected:
+
+  void   Start( Int_t nworkers );
+  void   Stop();
+  void   Work( Int_t iworker, UInt_t generation );
+
+  Int_t    fNThreads;		// 0: one per core
+
+  struct Sync;
+  Sync*    fSync;		//! Workers, mutex and exception
+
+private:
+  THcWorkerPool( const THcWorkerPool& );
+  THcWorkerPool& operator=( const THcWorkerPool& );
+
+  ClassDef(THcWorkerPool,0)	// Persistent threads for block and chunk work
+};
+
+#endif